@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "cobs_transport.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+using outpost::comm::CobsTransport;
+
+constexpr size_t CobsTransport::chunkSize;
+
+CobsTransport::CobsTransport(outpost::hal::Serial& serial,
+                             outpost::utils::SharedBufferPoolBase& pool) :
+    mSerial(serial),
+    mPool(pool),
+    mClock(),
+    mTransmitLength(0),
+    mResynchronize(false),
+    mReceivePosition(0),
+    mReceiveLength(0),
+    mFrame(),
+    mDecoder(),
+    mDiscardedFrames(0)
+{
+}
+
+CobsTransport::~CobsTransport()
+{
+}
+
+bool
+CobsTransport::send(outpost::Slice<const uint8_t> packet, outpost::time::Duration timeout)
+{
+    if (packet.getNumberOfElements() == 0)
+    {
+        // Would be encoded as an empty frame, which is indistinguishable
+        // from a sequence of delimiters
+        return false;
+    }
+
+    outpost::time::SpacecraftElapsedTime start = mClock.now();
+    if (mResynchronize)
+    {
+        // Terminate the incomplete frame left by a failed transmission
+        const uint8_t delimiter = 0;
+        if (!append(&delimiter, 1, start, timeout))
+        {
+            return false;
+        }
+        mResynchronize = false;
+    }
+
+    const uint8_t* data = packet.begin();
+    const size_t length = packet.getNumberOfElements();
+    const size_t blockLength = outpost::utils::Cobs::maximumBlockLength;
+
+    // Each block consists of a code byte followed by up to 254 non-zero
+    // bytes. A code byte smaller than 255 replaces the zero following
+    // the block.
+    size_t position = 0;
+    bool moreBlocks = true;
+    while (moreBlocks)
+    {
+        size_t count = std::min(blockLength, length - position);
+        const uint8_t* zero = nullptr;
+        if (count > 0)
+        {
+            zero = static_cast<const uint8_t*>(memchr(&data[position], 0, count));
+        }
+        if (zero != nullptr)
+        {
+            count = static_cast<size_t>(zero - &data[position]);
+        }
+
+        const uint8_t code = static_cast<uint8_t>(count + 1);
+        if (!append(&code, 1, start, timeout) || !append(&data[position], count, start, timeout))
+        {
+            return false;
+        }
+        position += count;
+
+        if (zero != nullptr)
+        {
+            // Skip the zero, a block has to follow even at the end of the
+            // packet to encode it
+            position++;
+        }
+        else
+        {
+            moreBlocks = (position < length);
+        }
+    }
+
+    const uint8_t delimiter = 0;
+    return append(&delimiter, 1, start, timeout) && flush(start, timeout);
+}
+
+bool
+CobsTransport::receive(outpost::utils::SharedChildPointer& packet, outpost::time::Duration timeout)
+{
+    outpost::time::SpacecraftElapsedTime start = mClock.now();
+    while (true)
+    {
+        while (mReceivePosition < mReceiveLength)
+        {
+            if (!mFrame.isValid())
+            {
+                if (!mPool.allocate(mFrame))
+                {
+                    return false;
+                }
+                mDecoder.reset(mFrame.asSlice());
+            }
+
+            mReceivePosition += mDecoder.decode(outpost::Slice<const uint8_t>::unsafe(
+                    &mReceiveBuffer[mReceivePosition], mReceiveLength - mReceivePosition));
+
+            if (mDecoder.isFrameComplete())
+            {
+                if (mDecoder.isValid() && (mDecoder.getLength() > 0))
+                {
+                    mFrame.getChild(packet, 0, 0, mDecoder.getLength());
+                    mFrame = outpost::utils::SharedBufferPointer();
+                    return true;
+                }
+
+                if (!mDecoder.isValid())
+                {
+                    mDiscardedFrames++;
+                }
+
+                // Reuse the buffer for the next frame
+                mDecoder.reset(mFrame.asSlice());
+            }
+        }
+
+        if (!fetch(start, timeout))
+        {
+            return false;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+outpost::time::Duration
+CobsTransport::getRemainingTime(outpost::time::SpacecraftElapsedTime start,
+                                outpost::time::Duration timeout) const
+{
+    if (timeout == outpost::time::Duration::infinity())
+    {
+        return timeout;
+    }
+
+    outpost::time::Duration elapsed = mClock.now() - start;
+    if (elapsed < timeout)
+    {
+        return timeout - elapsed;
+    }
+    return outpost::time::Duration::zero();
+}
+
+bool
+CobsTransport::append(const uint8_t* data,
+                      size_t length,
+                      outpost::time::SpacecraftElapsedTime start,
+                      outpost::time::Duration timeout)
+{
+    while (length > 0)
+    {
+        if (mTransmitLength == chunkSize)
+        {
+            if (!flush(start, timeout))
+            {
+                return false;
+            }
+        }
+
+        size_t count = std::min(length, chunkSize - mTransmitLength);
+        memcpy(&mTransmitBuffer[mTransmitLength], data, count);
+        mTransmitLength += count;
+        data += count;
+        length -= count;
+    }
+    return true;
+}
+
+bool
+CobsTransport::flush(outpost::time::SpacecraftElapsedTime start, outpost::time::Duration timeout)
+{
+    size_t written = 0;
+    while (written < mTransmitLength)
+    {
+        size_t count = mSerial.write(outpost::Slice<const uint8_t>::unsafe(
+                                             &mTransmitBuffer[written], mTransmitLength - written),
+                                     getRemainingTime(start, timeout));
+        if (count == 0)
+        {
+            // Drop the unsent part, the frame is incomplete anyway
+            mTransmitLength = 0;
+            mResynchronize = true;
+            return false;
+        }
+        written += count;
+    }
+    mTransmitLength = 0;
+    return true;
+}
+
+bool
+CobsTransport::fetch(outpost::time::SpacecraftElapsedTime start, outpost::time::Duration timeout)
+{
+    mReceivePosition = 0;
+
+    size_t available = mSerial.getNumberOfBytesAvailable();
+    if (available > 0)
+    {
+        mReceiveLength = mSerial.read(
+                outpost::asSlice(mReceiveBuffer).first(std::min(available, chunkSize)),
+                outpost::time::Duration::zero());
+    }
+    else
+    {
+        // Wait for the first byte only, the serial interface would
+        // otherwise wait for the whole chunk
+        mReceiveLength = mSerial.read(outpost::asSlice(mReceiveBuffer).first(1),
+                                      getRemainingTime(start, timeout));
+    }
+    return (mReceiveLength > 0);
+}
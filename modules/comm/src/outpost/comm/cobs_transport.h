@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_COMM_COBS_TRANSPORT_H
+#define OUTPOST_COMM_COBS_TRANSPORT_H
+
+#include <outpost/hal/serial.h>
+#include <outpost/rtos/clock.h>
+#include <outpost/time/duration.h>
+#include <outpost/utils/coding/cobs.h>
+#include <outpost/utils/container/shared_buffer.h>
+#include <outpost/utils/container/shared_object_pool.h>
+
+#include <stdint.h>
+
+namespace outpost
+{
+namespace comm
+{
+/**
+ * Packet transport over a serial interface using COBS framing.
+ *
+ * Every packet is COBS encoded and terminated by a zero byte. Received
+ * data is decoded incrementally while it arrives, each byte is inspected
+ * once and written directly into a buffer allocated from a shared buffer
+ * pool. Outgoing packets are encoded block by block into a small transmit
+ * buffer which is handed to the serial interface whenever it is full.
+ *
+ * The receiver resynchronizes on the next zero byte after a corrupted
+ * frame. Frames which are invalid or do not fit into a pool buffer are
+ * discarded and counted.
+ *
+ * One thread may receive while another thread sends.
+ */
+class CobsTransport
+{
+public:
+    /// Size of the buffers for the data exchanged with the serial interface
+    static constexpr size_t chunkSize = 128;
+
+    /**
+     * \param serial
+     *      Serial interface carrying the frames.
+     * \param pool
+     *      Pool for the buffers of received packets. The maximum packet
+     *      length is given by the size of the pool elements.
+     */
+    CobsTransport(outpost::hal::Serial& serial, outpost::utils::SharedBufferPoolBase& pool);
+
+    ~CobsTransport();
+
+    /**
+     * Send a packet.
+     *
+     * \param packet
+     *      Packet data, may contain any byte values. Empty packets are
+     *      not supported because the receiver skips empty frames.
+     * \param timeout
+     *      Time to wait for the serial interface to accept the data.
+     *
+     * \retval true     Packet including the frame delimiter was written.
+     * \retval false    Empty packet or timeout. After a timeout the frame
+     *                  may have been sent partially. It is terminated
+     *                  before the next packet and discarded by the
+     *                  receiver.
+     */
+    bool
+    send(outpost::Slice<const uint8_t> packet,
+         outpost::time::Duration timeout = outpost::time::Duration::infinity());
+
+    /**
+     * Receive the next packet.
+     *
+     * \param packet
+     *      Pointer to the decoded packet. The buffer is returned to the
+     *      pool when the last reference is released.
+     * \param timeout
+     *      Time to wait for the packet to be completed.
+     *
+     * \retval true     Packet received.
+     * \retval false    Timeout or no buffer available in the pool. The data
+     *                  received so far is kept for the next call.
+     */
+    bool
+    receive(outpost::utils::SharedChildPointer& packet,
+            outpost::time::Duration timeout = outpost::time::Duration::infinity());
+
+    /**
+     * Number of received frames which have been discarded because they
+     * were corrupted or too long.
+     */
+    inline size_t
+    getNumberOfDiscardedFrames() const
+    {
+        return mDiscardedFrames;
+    }
+
+private:
+    outpost::time::Duration
+    getRemainingTime(outpost::time::SpacecraftElapsedTime start,
+                     outpost::time::Duration timeout) const;
+
+    /**
+     * Append data to the transmit buffer, writing full buffers to the
+     * serial interface.
+     */
+    bool
+    append(const uint8_t* data,
+           size_t length,
+           outpost::time::SpacecraftElapsedTime start,
+           outpost::time::Duration timeout);
+
+    bool
+    flush(outpost::time::SpacecraftElapsedTime start, outpost::time::Duration timeout);
+
+    /**
+     * Read the next chunk of data from the serial interface.
+     *
+     * Takes all available bytes at once and only waits if no data is
+     * available.
+     */
+    bool
+    fetch(outpost::time::SpacecraftElapsedTime start, outpost::time::Duration timeout);
+
+    outpost::hal::Serial& mSerial;
+    outpost::utils::SharedBufferPoolBase& mPool;
+    outpost::rtos::SystemClock mClock;
+
+    uint8_t mTransmitBuffer[chunkSize];
+    size_t mTransmitLength;
+
+    /// A previous frame has been sent partially and must be terminated
+    bool mResynchronize;
+
+    uint8_t mReceiveBuffer[chunkSize];
+    size_t mReceivePosition;
+    size_t mReceiveLength;
+
+    /// Buffer of the frame currently being decoded
+    outpost::utils::SharedBufferPointer mFrame;
+    outpost::utils::CobsStreamDecoder mDecoder;
+
+    size_t mDiscardedFrames;
+};
+
+}  // namespace comm
+}  // namespace outpost
+
+#endif
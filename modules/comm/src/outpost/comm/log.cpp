@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "log.h"
+
+#include <outpost/rtos/clock.h>
+
+using namespace outpost::comm;
+
+constexpr size_t LogBuffer::size;
+
+#if OUTPOST_COMM_LOG_LEVEL > OUTPOST_COMM_LOG_LEVEL_NONE
+outpost::comm::LogBuffer outpost::comm::logBuffer;
+#endif
+
+static outpost::rtos::SystemClock logClock;
+
+LogBuffer::LogBuffer() : mWriteIndex(0), mEntries()
+{
+}
+
+void
+LogBuffer::write(LogLevel level, LogEvent event, uint16_t argument0, uint32_t argument1)
+{
+    uint32_t sequence = mWriteIndex.fetch_add(1, std::memory_order_relaxed) + 1;
+    Entry& entry = mEntries[(sequence - 1) % size];
+
+    // Invalidate the entry while it is written
+    entry.mSequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry.mRecord.mSequence = sequence;
+    entry.mRecord.mTime = logClock.now();
+    entry.mRecord.mLevel = level;
+    entry.mRecord.mEvent = event;
+    entry.mRecord.mArgument0 = argument0;
+    entry.mRecord.mArgument1 = argument1;
+
+    entry.mSequence.store(sequence, std::memory_order_release);
+}
+
+size_t
+LogBuffer::getLatest(outpost::Slice<LogRecord> records) const
+{
+    uint32_t end = mWriteIndex.load(std::memory_order_acquire);
+    uint32_t count = end;
+    if (count > size)
+    {
+        count = size;
+    }
+    if (count > records.getNumberOfElements())
+    {
+        count = static_cast<uint32_t>(records.getNumberOfElements());
+    }
+
+    size_t copied = 0;
+    for (uint32_t sequence = end - count + 1; sequence <= end; sequence++)
+    {
+        const Entry& entry = mEntries[(sequence - 1) % size];
+        if (entry.mSequence.load(std::memory_order_acquire) != sequence)
+        {
+            // Not yet completed or already overwritten
+            continue;
+        }
+
+        LogRecord record = entry.mRecord;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.mSequence.load(std::memory_order_relaxed) == sequence)
+        {
+            records[copied] = record;
+            copied++;
+        }
+    }
+    return copied;
+}
+
+void
+LogBuffer::clear()
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        mEntries[i].mSequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char*
+LogBuffer::getName(LogEvent event)
+{
+    switch (event)
+    {
+        case LogEvent::transactionNotInitiated: return "transactionNotInitiated";
+        case LogEvent::noFreeTransaction: return "noFreeTransaction";
+        case LogEvent::invalidLength: return "invalidLength";
+        case LogEvent::commandSent: return "commandSent";
+        case LogEvent::replyReceived: return "replyReceived";
+        case LogEvent::replyWithError: return "replyWithError";
+        case LogEvent::unexpectedReply: return "unexpectedReply";
+        case LogEvent::lateReply: return "lateReply";
+        case LogEvent::transactionExpired: return "transactionExpired";
+        case LogEvent::commandRepeated: return "commandRepeated";
+        case LogEvent::invalidEndMarker: return "invalidEndMarker";
+        case LogEvent::nonRmapPacket: return "nonRmapPacket";
+        case LogEvent::unknownTargetNode: return "unknownTargetNode";
+        case LogEvent::linkFailover: return "linkFailover";
+        case LogEvent::packetTooLarge: return "packetTooLarge";
+        case LogEvent::packetTooShort: return "packetTooShort";
+        case LogEvent::invalidLogicalAddress: return "invalidLogicalAddress";
+        case LogEvent::invalidProtocolIdentifier: return "invalidProtocolIdentifier";
+        case LogEvent::headerCrcError: return "headerCrcError";
+        case LogEvent::dataLengthMismatch: return "dataLengthMismatch";
+        case LogEvent::dataCrcError: return "dataCrcError";
+        case LogEvent::regionTableFull: return "regionTableFull";
+        case LogEvent::commandHeaderCrcError: return "commandHeaderCrcError";
+        case LogEvent::replyNotSent: return "replyNotSent";
+        case LogEvent::unhandledPacket: return "unhandledPacket";
+        case LogEvent::packetDropped: return "packetDropped";
+        case LogEvent::noReceiveBuffer: return "noReceiveBuffer";
+        case LogEvent::packetDiscarded: return "packetDiscarded";
+    }
+    return "unknown";
+}
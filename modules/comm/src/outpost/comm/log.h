@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_COMM_LOG_H_
+#define OUTPOST_COMM_LOG_H_
+
+#include <outpost/base/slice.h>
+#include <outpost/time/time_point.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/*
+ * Diagnostics of the comm module.
+ *
+ * Messages are filtered at compile time, all messages above
+ * OUTPOST_COMM_LOG_LEVEL compile to nothing, including the evaluation of
+ * their arguments. Enabled messages are stored as binary records in
+ * outpost::comm::logBuffer, no text is formatted while logging.
+ *
+ * The level has to be defined for the whole build, e.g. on the command
+ * line. With the default level OUTPOST_COMM_LOG_LEVEL_NONE the global
+ * buffer is not allocated.
+ *
+ * Usage:
+ *      OUTPOST_COMM_LOG_WARNING(lateReply, transactionId, 0);
+ */
+#define OUTPOST_COMM_LOG_LEVEL_NONE 0
+#define OUTPOST_COMM_LOG_LEVEL_ERROR 1
+#define OUTPOST_COMM_LOG_LEVEL_WARNING 2
+#define OUTPOST_COMM_LOG_LEVEL_INFO 3
+#define OUTPOST_COMM_LOG_LEVEL_DEBUG 4
+
+#ifndef OUTPOST_COMM_LOG_LEVEL
+#define OUTPOST_COMM_LOG_LEVEL OUTPOST_COMM_LOG_LEVEL_NONE
+#endif
+
+// Number of records kept by outpost::comm::logBuffer
+#ifndef OUTPOST_COMM_LOG_BUFFER_SIZE
+#define OUTPOST_COMM_LOG_BUFFER_SIZE 128
+#endif
+
+#define OUTPOST_COMM_LOG(level, event, argument0, argument1)             \
+    outpost::comm::logBuffer.write(outpost::comm::LogLevel::level,       \
+                                   outpost::comm::LogEvent::event,       \
+                                   static_cast<uint16_t>(argument0),     \
+                                   static_cast<uint32_t>(argument1))
+
+#define OUTPOST_COMM_LOG_DISABLED() \
+    do                              \
+    {                               \
+    } while (0)
+
+#if OUTPOST_COMM_LOG_LEVEL >= OUTPOST_COMM_LOG_LEVEL_ERROR
+#define OUTPOST_COMM_LOG_ERROR(event, argument0, argument1) \
+    OUTPOST_COMM_LOG(error, event, argument0, argument1)
+#else
+#define OUTPOST_COMM_LOG_ERROR(event, argument0, argument1) OUTPOST_COMM_LOG_DISABLED()
+#endif
+
+#if OUTPOST_COMM_LOG_LEVEL >= OUTPOST_COMM_LOG_LEVEL_WARNING
+#define OUTPOST_COMM_LOG_WARNING(event, argument0, argument1) \
+    OUTPOST_COMM_LOG(warning, event, argument0, argument1)
+#else
+#define OUTPOST_COMM_LOG_WARNING(event, argument0, argument1) OUTPOST_COMM_LOG_DISABLED()
+#endif
+
+#if OUTPOST_COMM_LOG_LEVEL >= OUTPOST_COMM_LOG_LEVEL_INFO
+#define OUTPOST_COMM_LOG_INFO(event, argument0, argument1) \
+    OUTPOST_COMM_LOG(info, event, argument0, argument1)
+#else
+#define OUTPOST_COMM_LOG_INFO(event, argument0, argument1) OUTPOST_COMM_LOG_DISABLED()
+#endif
+
+#if OUTPOST_COMM_LOG_LEVEL >= OUTPOST_COMM_LOG_LEVEL_DEBUG
+#define OUTPOST_COMM_LOG_DEBUG(event, argument0, argument1) \
+    OUTPOST_COMM_LOG(debug, event, argument0, argument1)
+#else
+#define OUTPOST_COMM_LOG_DEBUG(event, argument0, argument1) OUTPOST_COMM_LOG_DISABLED()
+#endif
+
+namespace outpost
+{
+namespace comm
+{
+enum class LogLevel : uint8_t
+{
+    error = OUTPOST_COMM_LOG_LEVEL_ERROR,
+    warning = OUTPOST_COMM_LOG_LEVEL_WARNING,
+    info = OUTPOST_COMM_LOG_LEVEL_INFO,
+    debug = OUTPOST_COMM_LOG_LEVEL_DEBUG
+};
+
+/**
+ * Events of the comm module. The meaning of the two arguments of a record
+ * is given for each event.
+ */
+enum class LogEvent : uint8_t
+{
+    // RMAP initiator
+    transactionNotInitiated = 1,  ///< target ID, -
+    noFreeTransaction,            ///< target ID, -
+    invalidLength,                ///< target ID, length
+    commandSent,                  ///< transaction ID, target ID
+    replyReceived,                ///< transaction ID, status
+    replyWithError,               ///< transaction ID, status
+    unexpectedReply,              ///< transaction ID, data length
+    lateReply,                    ///< transaction ID, -
+    transactionExpired,           ///< transaction ID, target ID
+    commandRepeated,              ///< target ID, address
+    invalidEndMarker,             ///< packet length, end marker
+    nonRmapPacket,                ///< packet length, -
+    unknownTargetNode,            ///< logical address, -
+    linkFailover,                 ///< target ID, path
+
+    // RMAP packet
+    packetTooLarge,             ///< header length, data length
+    packetTooShort,             ///< packet length, -
+    invalidLogicalAddress,      ///< logical address, -
+    invalidProtocolIdentifier,  ///< protocol identifier, -
+    headerCrcError,             ///< transaction ID, -
+    dataLengthMismatch,         ///< transaction ID, data length
+    dataCrcError,               ///< transaction ID, data length
+
+    // RMAP target
+    regionTableFull,        ///< -, -
+    commandHeaderCrcError,  ///< packet length, -
+    replyNotSent,           ///< transaction ID, status
+
+    // SpaceWire dispatcher
+    unhandledPacket,  ///< protocol identifier, packet length
+    packetDropped,    ///< protocol identifier, packet length
+    noReceiveBuffer,  ///< packet length, -
+    packetDiscarded   ///< -, -
+};
+
+struct LogRecord
+{
+    /// Starts with 1 for the first record, zero marks an unused record
+    uint32_t mSequence;
+    outpost::time::SpacecraftElapsedTime mTime;
+    LogLevel mLevel;
+    LogEvent mEvent;
+    uint16_t mArgument0;
+    uint32_t mArgument1;
+};
+
+/**
+ * Preallocated ring buffer of log records.
+ *
+ * Writing does not block and can be done from any thread. If the buffer is
+ * full the oldest records are overwritten. Records are read as copies,
+ * records which are overwritten while being copied are skipped.
+ */
+class LogBuffer
+{
+public:
+    static constexpr size_t size = OUTPOST_COMM_LOG_BUFFER_SIZE;
+
+    LogBuffer();
+
+    void
+    write(LogLevel level, LogEvent event, uint16_t argument0, uint32_t argument1);
+
+    /**
+     * Copy the latest records, oldest first.
+     *
+     * \return
+     *      Number of records copied.
+     */
+    size_t
+    getLatest(outpost::Slice<LogRecord> records) const;
+
+    /**
+     * \return
+     *      Number of records written since the start, including the
+     *      overwritten ones.
+     */
+    inline uint32_t
+    getNumberOfRecords() const
+    {
+        return mWriteIndex.load(std::memory_order_relaxed);
+    }
+
+    void
+    clear();
+
+    /**
+     * Name of an event for decoding the records.
+     */
+    static const char*
+    getName(LogEvent event);
+
+private:
+    struct Entry
+    {
+        Entry() : mSequence(0), mRecord()
+        {
+        }
+
+        std::atomic<uint32_t> mSequence;
+        LogRecord mRecord;
+    };
+
+    std::atomic<uint32_t> mWriteIndex;
+    Entry mEntries[size];
+};
+
+#if OUTPOST_COMM_LOG_LEVEL > OUTPOST_COMM_LOG_LEVEL_NONE
+extern LogBuffer logBuffer;
+#endif
+
+}  // namespace comm
+}  // namespace outpost
+
+#endif
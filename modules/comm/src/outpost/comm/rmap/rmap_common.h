@@ -29,6 +29,49 @@ static constexpr uint8_t defaultLogicalAddress = 0xFE;
 static constexpr uint8_t defaultExtendedAddress = 0;
 static constexpr uint8_t protocolIdentifier = 0x01;
 
+// Bytes of a command packet in addition to the data and the SpaceWire and
+// reply addresses: 16 bytes header including the header CRC, the data CRC and
+// the reserve required by RmapPacket::constructPacket()
+static constexpr uint8_t commandPacketOverhead = 20;
+
+// Largest data length which can be encoded in a RMAP header
+static constexpr uint32_t maxDataLength = 0xFFFFFF;
+
+// Largest number of bytes modified by a read-modify-write command, the
+// command carries the data followed by a mask of the same length
+static constexpr uint8_t maxReadModifyWriteLength = 4;
+
+// Number of segments of a segmented read or write which are outstanding at
+// the same time. Leaves transactions available for other threads.
+static constexpr uint8_t maxSegmentsInFlight = 4;
+
+// Number of times a failed segment is repeated before giving up
+static constexpr uint8_t defaultSegmentRetries = 2;
+
+// Memory regions which can be registered at a RMAP target
+static constexpr uint8_t maxMemoryRegions = 8;
+
+// Number of commands a RMAP target handles after a wake-up before waiting
+// for the next packet again
+static constexpr uint8_t maxCommandsPerBatch = 16;
+
+// Commands a RMAP target attached to a SpaceWireDispatcher can queue
+static constexpr uint8_t maxQueuedCommands = 8;
+
+// Target nodes for which the initiator collects statistics, same as the
+// number of nodes of a RmapTargetsList
+static constexpr uint8_t maxStatisticsTargets = 12;
+
+// Bins of the round-trip latency histogram. Bin n counts latencies between
+// 2^n and 2^(n+1) microseconds, the last bin all longer latencies.
+static constexpr uint8_t latencyHistogramBins = 20;
+
+// SpaceWire links a RMAP initiator can send commands on
+static constexpr uint8_t maxLinks = 4;
+
+// Paths to a target node: primary and redundant
+static constexpr uint8_t maxPaths = 2;
+
 // Maximum physical output ports that router can have (see ECSS-E-ST-50-12C pg. 98)
 static constexpr uint8_t maxPhysicalRouterOutputPorts = 32;
 
@@ -37,6 +80,11 @@ static constexpr uint8_t maxPhysicalRouterOutputPorts = 32;
 static const uint8_t maxAddressLength = 12;
 static const uint8_t maxNodeNameLength = 20;
 
+// Largest command header including the target SpaceWire address, the reply
+// address and the header CRC
+static constexpr uint8_t maxCommandHeaderLength =
+        maxPhysicalRouterOutputPorts + maxAddressLength + 16;
+
 }  // namespace rmap
 }  // namespace comm
 }  // namespace outpost
@@ -16,6 +16,12 @@
 
 #include "rmap_common.h"
 
+#include <outpost/comm/log.h>
+
+#include <string.h>
+
+#include <algorithm>
+
 using namespace outpost::comm;
 
 outpost::smpc::Topic<outpost::comm::NonRmapDataType> outpost::comm::nonRmapPacketReceived;
@@ -30,26 +36,77 @@ RmapInitiator::RmapInitiator(hal::SpaceWire& spw,
                              outpost::support::parameter::HeartbeatSource heartbeatSource) :
     outpost::rtos::Thread(priority, stackSize, "RMEN"),
     mSpW(spw),
+    mLinks(),
+    mNumberOfLinks(1),
+    mLinkUp(),
     mTargetNodes(list),
+    mClock(),
     mOperationLock(),
+    mFreeTransactions(rmap::maxConcurrentTransactions),
     mInitiatorLogicalAddress(rmap::defaultLogicalAddress),
     mIncrementMode(false),
     mVerifyMode(false),
     mReplyMode(false),
     mStopped(true),
-    mTransactionId(0),
+    mDispatched(false),
     mTransactionsList(),
     mDiscardedPacket(nullptr),
+    mLastDiscardedPacket(),
     mCounters(),
-    mRxData(),
+    mStatistics(),
+    mRetryPolicy(),
     mHeartbeatSource(heartbeatSource)
 {
+    mLinks[0] = &spw;
 }
 
 RmapInitiator::~RmapInitiator()
 {
 }
 
+bool
+RmapInitiator::attachTo(SpaceWireDispatcher& dispatcher)
+{
+    if (!dispatcher.addHandler(rmap::protocolIdentifier, mInitiatorLogicalAddress, *this))
+    {
+        return false;
+    }
+    mDispatched = true;
+    return true;
+}
+
+bool
+RmapInitiator::addLink(hal::SpaceWire& spw, SpaceWireDispatcher& dispatcher)
+{
+    if ((mNumberOfLinks >= rmap::maxLinks)
+        || !dispatcher.addHandler(rmap::protocolIdentifier, mInitiatorLogicalAddress, *this))
+    {
+        return false;
+    }
+    mLinks[mNumberOfLinks] = &spw;
+    mNumberOfLinks++;
+    return true;
+}
+
+bool
+RmapInitiator::handlePacket(const outpost::utils::SharedChildPointer& packet)
+{
+    RmapPacketView view(packet);
+    if (!view.validate(mInitiatorLogicalAddress))
+    {
+        mCounters.mNonRmapPacketReceived++;
+    }
+    else if (view.isReplyPacket())
+    {
+        replyPacketReceived(view);
+    }
+    else
+    {
+        mCounters.mErrorneousReplyPackets++;
+    }
+    return true;
+}
+
 bool
 RmapInitiator::write(const char* targetNodeName,
                      uint32_t memoryAddress,
@@ -78,124 +135,40 @@ RmapInitiator::write(RmapTargetNode& rmapTargetNode,
                      outpost::Slice<const uint8_t> data,
                      outpost::time::Duration timeout)
 {
-    // Guard operation against concurrent accesses
-    outpost::rtos::MutexGuard lock(mOperationLock);
-    bool result = false;
-
-    // Using existing free element from the transaction list
-    RmapTransaction* transaction = mTransactionsList.getFreeTransaction();
-    RmapPacket* cmd = transaction->getCommandPacket();
-
-    // Packet configuration
-    cmd->setInitiatorLogicalAddress(mInitiatorLogicalAddress);
-    cmd->setWrite();
-    cmd->setCommand();
-
-    if (mIncrementMode)
-    {
-        cmd->setIncrementFlag();
-    }
-    else
-    {
-        cmd->unsetIncrementFlag();
-    }
-
-    if (mVerifyMode)
-    {
-        cmd->setVerifyFlag();
-    }
-    else
-    {
-        cmd->unsetVerifyFlag();
-    }
-
-    if (mReplyMode)
-    {
-        // Sets the transaction mode
-        transaction->setBlockingMode(true);
-
-        // Extra block call with zero timeout for acquiring already released lock
-        transaction->blockTransaction(outpost::time::Duration::zero());
-
-        cmd->setReplyFlag();
-    }
-    else
-    {
-        // UnSets the transaction mode
-        transaction->setBlockingMode(false);
-
-        cmd->unsetReplyFlag();
-    }
-    cmd->setExtendedAddress(0x00);
-    cmd->setAddress(memoryAddress);
-    cmd->setDataLength(data.getNumberOfElements());
-    cmd->setTargetInformation(rmapTargetNode);
-    transaction->setTimeoutDuration(timeout);
-
-    // Transaction will be initiated and sent through the SpW interface
-    if (sendPacket(transaction, data))
+    bool replyExpected = mReplyMode;
+    for (uint8_t attempt = 0;; attempt++)
     {
-        // If reply is expected
-        if (mReplyMode)
+        RmapTransaction* transaction =
+                initiateTransaction(rmapTargetNode,
+                                    RmapPacket::InstructionField::write,
+                                    memoryAddress,
+                                    data,
+                                    outpost::Slice<uint8_t>::empty(),
+                                    replyExpected,
+                                    nullptr,
+                                    timeout,
+                                    true);
+        if (!transaction)
         {
-            transaction->setState(RmapTransaction::commandSent);
-
-            // Wait for the RMAP reply
-            transaction->blockTransaction(timeout);
-
-            // Command sent but no reply
-            if (transaction->getState() == RmapTransaction::commandSent)
-            {
-                console_out("RMAP-Initiator: command sent but no reply received for the "
-                            "transaction %u\n",
-                            transaction->getTransactionID());
-
-                result = false;
-            }
-            // Command sent and reply received
-            else if (transaction->getState() == RmapTransaction::replyReceived)
-            {
-                RmapPacket* rply = transaction->getReplyPacket();
-
-                if (rply->getStatus() == RmapReplyStatus::commandExecutedSuccessfully)
-                {
-                    console_out("RMAP-Initiator: reply received with success\n");
-
-                    result = true;
-                }
-                else
-                {
-                    console_out("RMAP-Initiator: reply received with failure\n");
-
-                    RmapReplyStatus::replyStatus(
-                            static_cast<RmapReplyStatus::ErrorStatusCodes>(rply->getStatus()));
+            OUTPOST_COMM_LOG_ERROR(transactionNotInitiated, rmapTargetNode.getId(), 0);
+            return false;
+        }
 
-                    result = false;
-                }
-            }
+        // Command was sent successfully
+        if (!replyExpected)
+        {
+            finishTransaction(transaction);
+            return true;
         }
-        else
+
+        // Wait for the RMAP reply, other transactions may be started meanwhile
+        RmapTransactionHandle::Result result = waitForCompletion(transaction, timeout);
+        if ((result != RmapTransactionHandle::timeout)
+            || !shouldRetry(rmapTargetNode, RmapPacket::InstructionField::write, attempt))
         {
-            if (transaction->getState() == RmapTransaction::initiated)
-            {
-                // Command was sent successfully
-                result = true;
-            }
-            else
-            {
-                // Command was not sent successfully
-                console_out("RMAP-Initiator: transaction could not be initiated\n");
-                result = false;
-            }
+            return (result == RmapTransactionHandle::success);
         }
     }
-
-    // Delete the transaction from the list
-    mTransactionsList.removeTransaction(transaction->getTransactionID());
-    transaction = nullptr;
-    cmd = nullptr;
-
-    return result;
 }
 
 bool
@@ -228,118 +201,415 @@ RmapInitiator::read(RmapTargetNode& rmapTargetNode,
                     uint32_t length,
                     outpost::time::Duration timeout)
 {
-    // Guard operation against concurrent accesses
-    outpost::rtos::MutexGuard lock(mOperationLock);
-    bool result = false;
+    for (uint8_t attempt = 0;; attempt++)
+    {
+        // Read transaction will always be blocking, the receiving thread copies
+        // the reply data directly to the user buffer
+        RmapTransaction* transaction =
+                initiateTransaction(rmapTargetNode,
+                                    RmapPacket::InstructionField::read,
+                                    memoryAddress,
+                                    outpost::Slice<const uint8_t>::empty(),
+                                    outpost::Slice<uint8_t>::unsafe(buffer, length),
+                                    true,
+                                    nullptr,
+                                    timeout,
+                                    false);
+        if (!transaction)
+        {
+            OUTPOST_COMM_LOG_ERROR(transactionNotInitiated, rmapTargetNode.getId(), 0);
+            return false;
+        }
+
+        RmapTransactionHandle::Result result = waitForCompletion(transaction, timeout);
+        if ((result != RmapTransactionHandle::timeout)
+            || !shouldRetry(rmapTargetNode, RmapPacket::InstructionField::read, attempt))
+        {
+            return (result == RmapTransactionHandle::success);
+        }
+    }
+}
 
-    RmapTransaction* transaction = mTransactionsList.getFreeTransaction();
+bool
+RmapInitiator::readModifyWrite(RmapTargetNode& rmapTargetNode,
+                               uint32_t memoryAddress,
+                               outpost::Slice<const uint8_t> data,
+                               outpost::Slice<const uint8_t> mask,
+                               outpost::Slice<uint8_t> previousData,
+                               outpost::time::Duration timeout)
+{
+    size_t length = data.getNumberOfElements();
+    if (length == 0 || length > rmap::maxReadModifyWriteLength
+        || mask.getNumberOfElements() != length || previousData.getNumberOfElements() < length)
+    {
+        OUTPOST_COMM_LOG_ERROR(invalidLength, rmapTargetNode.getId(), length);
+        return false;
+    }
 
+    // The command carries the data followed by the mask
+    uint8_t dataAndMask[2 * rmap::maxReadModifyWriteLength];
+    memcpy(dataAndMask, data.begin(), length);
+    memcpy(dataAndMask + length, mask.begin(), length);
+
+    RmapTransaction* transaction = initiateTransaction(
+            rmapTargetNode,
+            RmapPacket::InstructionField::read,
+            memoryAddress,
+            outpost::Slice<const uint8_t>::unsafe(dataAndMask, 2 * length),
+            previousData.first(length),
+            true,
+            nullptr,
+            timeout,
+            true);
     if (!transaction)
     {
-        console_out("RMAP-Initiator: All transactions are in use\n");
+        OUTPOST_COMM_LOG_ERROR(transactionNotInitiated, rmapTargetNode.getId(), 0);
         return false;
     }
 
-    RmapPacket* cmd = transaction->getCommandPacket();
+    return (waitForCompletion(transaction, timeout) == RmapTransactionHandle::success);
+}
 
-    // Read transaction will always be blocking
-    transaction->setBlockingMode(true);
+bool
+RmapInitiator::readModifyWrite(RmapTargetNode& rmapTargetNode,
+                               uint32_t memoryAddress,
+                               outpost::Slice<const uint8_t> data,
+                               outpost::Slice<const uint8_t> mask,
+                               outpost::time::Duration timeout)
+{
+    uint8_t previousData[rmap::maxReadModifyWriteLength];
+    return readModifyWrite(
+            rmapTargetNode, memoryAddress, data, mask, outpost::asSlice(previousData), timeout);
+}
 
-    // Extra block call with zero timeout for acquiring already released lock
-    transaction->blockTransaction(outpost::time::Duration::zero());
+//-----------------------------------------------------------------------------
+bool
+RmapInitiator::readAsync(RmapTargetNode& rmapTargetNode,
+                         uint32_t memoryAddress,
+                         outpost::Slice<uint8_t> buffer,
+                         RmapTransactionHandle& handle,
+                         outpost::time::Duration timeout)
+{
+    RmapTransaction* transaction = initiateTransaction(rmapTargetNode,
+                                                       RmapPacket::InstructionField::read,
+                                                       memoryAddress,
+                                                       outpost::Slice<const uint8_t>::empty(),
+                                                       buffer,
+                                                       true,
+                                                       nullptr,
+                                                       timeout,
+                                                       false);
+    return connectHandle(transaction, handle);
+}
 
-    // Sets the command packet
-    cmd->setInitiatorLogicalAddress(mInitiatorLogicalAddress);
-    cmd->setRead();
-    cmd->setCommand();
+bool
+RmapInitiator::readAsync(RmapTargetNode& rmapTargetNode,
+                         uint32_t memoryAddress,
+                         outpost::Slice<uint8_t> buffer,
+                         const RmapCompletionCallback& callback,
+                         outpost::time::Duration timeout)
+{
+    RmapTransaction* transaction = initiateTransaction(rmapTargetNode,
+                                                       RmapPacket::InstructionField::read,
+                                                       memoryAddress,
+                                                       outpost::Slice<const uint8_t>::empty(),
+                                                       buffer,
+                                                       true,
+                                                       &callback,
+                                                       timeout,
+                                                       false);
+    return (transaction != nullptr);
+}
+
+bool
+RmapInitiator::writeAsync(RmapTargetNode& rmapTargetNode,
+                          uint32_t memoryAddress,
+                          outpost::Slice<const uint8_t> data,
+                          RmapTransactionHandle& handle,
+                          outpost::time::Duration timeout)
+{
+    RmapTransaction* transaction = initiateTransaction(rmapTargetNode,
+                                                       RmapPacket::InstructionField::write,
+                                                       memoryAddress,
+                                                       data,
+                                                       outpost::Slice<uint8_t>::empty(),
+                                                       true,
+                                                       nullptr,
+                                                       timeout,
+                                                       false);
+    return connectHandle(transaction, handle);
+}
+
+bool
+RmapInitiator::writeAsync(RmapTargetNode& rmapTargetNode,
+                          uint32_t memoryAddress,
+                          outpost::Slice<const uint8_t> data,
+                          const RmapCompletionCallback& callback,
+                          outpost::time::Duration timeout)
+{
+    RmapTransaction* transaction = initiateTransaction(rmapTargetNode,
+                                                       RmapPacket::InstructionField::write,
+                                                       memoryAddress,
+                                                       data,
+                                                       outpost::Slice<uint8_t>::empty(),
+                                                       true,
+                                                       &callback,
+                                                       timeout,
+                                                       false);
+    return (transaction != nullptr);
+}
 
-    if (mIncrementMode)
+RmapTransactionHandle::Result
+RmapInitiator::poll(RmapTransactionHandle& handle)
+{
+    if (handle.mResult != RmapTransactionHandle::pending)
     {
-        cmd->setIncrementFlag();
+        return handle.mResult;
     }
-    else
+
+    bool completed = false;
     {
-        cmd->unsetIncrementFlag();
+        outpost::rtos::MutexGuard lock(mOperationLock);
+        if (!isConnected(handle))
+        {
+            // Copy of a handle whose transaction has already been
+            // completed through another copy, the slot may be in use by
+            // a different transaction
+            disconnectHandle(handle);
+            return handle.mResult;
+        }
+
+        RmapTransaction* transaction = handle.mTransaction;
+        if (transaction->getState() == RmapTransaction::commandSent
+            && isExpired(transaction))
+        {
+            expireTransaction(transaction);
+        }
+
+        if (transaction->getState() != RmapTransaction::commandSent)
+        {
+            completeHandle(transaction, handle);
+            freeTransaction(transaction);
+            completed = true;
+        }
     }
-    if (mVerifyMode)
+
+    if (completed)
     {
-        cmd->setVerifyFlag();
+        mFreeTransactions.release();
     }
-    else
+    return handle.mResult;
+}
+
+RmapTransactionHandle::Result
+RmapInitiator::wait(RmapTransactionHandle& handle, outpost::time::Duration timeout)
+{
+    if (handle.mResult == RmapTransactionHandle::pending)
     {
-        cmd->unsetVerifyFlag();
-    }
+        RmapTransaction* transaction = nullptr;
+        {
+            outpost::rtos::MutexGuard lock(mOperationLock);
+            if (isConnected(handle))
+            {
+                transaction = handle.mTransaction;
+            }
+        }
 
-    cmd->setReplyFlag();
-    cmd->setExtendedAddress(0x00);
-    cmd->setAddress(memoryAddress);
-    cmd->setDataLength(length);
+        if (transaction != nullptr)
+        {
+            // Released by the receiving thread on completion or expiry
+            transaction->blockTransaction(timeout);
+        }
+    }
+    return poll(handle);
+}
 
-    // InitiatorLogicalAddress might be updated in below
-    cmd->setTargetInformation(rmapTargetNode);
-    transaction->setInitiatorLogicalAddress(cmd->getInitiatorLogicalAddress());
-    transaction->setTimeoutDuration(timeout);
-    outpost::Slice<const uint8_t> empty{outpost::Slice<const uint8_t>::empty()};
+bool
+RmapInitiator::waitForAll(outpost::Slice<RmapTransactionHandle> handles,
+                          outpost::time::Duration timeout)
+{
+    bool completed = true;
+    outpost::time::SpacecraftElapsedTime start = mClock.now();
 
-    // Command is read, thus no data bytes available
-    if (sendPacket(transaction, empty))
+    for (size_t i = 0; i < handles.getNumberOfElements(); i++)
     {
-        transaction->setState(RmapTransaction::commandSent);
+        if (wait(handles[i], getRemainingTime(start, timeout)) == RmapTransactionHandle::pending)
+        {
+            completed = false;
+        }
+    }
+    return completed;
+}
 
-        console_out("RMAP-Initiator: Command sent %u, waiting for reply\n",
-                    transaction->getState());
+void
+RmapInitiator::cancel(RmapTransactionHandle& handle)
+{
+    if (handle.mResult == RmapTransactionHandle::pending)
+    {
+        bool connected;
+        {
+            outpost::rtos::MutexGuard lock(mOperationLock);
+            connected = isConnected(handle);
+            if (connected)
+            {
+                freeTransaction(handle.mTransaction);
+            }
+        }
+        if (connected)
+        {
+            mFreeTransactions.release();
+        }
+        disconnectHandle(handle);
+    }
+}
 
-        // Wait for the RMAP reply
-        transaction->blockTransaction(timeout);
+bool
+RmapInitiator::transferBatch(outpost::Slice<BatchItem> items, outpost::time::Duration timeout)
+{
+    outpost::time::SpacecraftElapsedTime start = mClock.now();
+    size_t numberOfItems = items.getNumberOfElements();
+    size_t submitted = 0;
+    size_t completed = 0;
 
-        console_out("RMAP-Initiator: Notified with state: %u\n", transaction->getState());
+    for (size_t i = 0; i < numberOfItems; i++)
+    {
+        items[i].mHandle = RmapTransactionHandle();
+    }
 
-        if (transaction->getState() == RmapTransaction::replyReceived)
+    while (submitted < numberOfItems)
+    {
+        outpost::time::Duration remaining = getRemainingTime(start, timeout);
+        if (completed < submitted)
         {
-            RmapPacket* rply = transaction->getReplyPacket();
-            uint8_t replyStatus = rply->getStatus();
-
-            if (replyStatus != RmapReplyStatus::commandExecutedSuccessfully)
+            // The slots of earlier items are only handed back once their
+            // handles are completed
+            if (wait(items[completed].mHandle, outpost::time::Duration::zero())
+                != RmapTransactionHandle::pending)
             {
-                console_out("RMAP-Initiator: Command not executed successfully: %u\n", replyStatus);
-                result = false;
+                completed++;
+                continue;
             }
-            else
+
+            size_t count = submitBatchItems(
+                    items.skipFirst(submitted), outpost::time::Duration::zero(), remaining);
+            if (count == 0)
             {
-                if (length < rply->getDataLength())
-                {
-                    console_out("RMAP-Initiator: Read reply with insufficient data\n");
-                    result = false;
-                }
-                else
+                if (remaining == outpost::time::Duration::zero())
                 {
-                    // Copy received data to the external buffer
-                    mRxData.getData(buffer);
-
-                    // Release the SpW buffer
-
-                    result = true;
+                    break;
                 }
+                wait(items[completed].mHandle, remaining);
             }
+            submitted += count;
         }
         else
         {
-            console_out("RMAP-Initiator: Timeout\n");
+            size_t count = submitBatchItems(items.skipFirst(submitted), remaining, remaining);
+            if (count == 0)
+            {
+                // All slots are used by other threads
+                break;
+            }
+            submitted += count;
+        }
+    }
+
+    // Collect the remaining replies
+    bool result = true;
+    for (size_t i = 0; i < numberOfItems; i++)
+    {
+        RmapTransactionHandle& handle = items[i].mHandle;
+        if (wait(handle, getRemainingTime(start, timeout)) == RmapTransactionHandle::pending)
+        {
+            cancel(handle);
+            handle.mResult = RmapTransactionHandle::timeout;
+        }
+
+        if (handle.getResult() != RmapTransactionHandle::success)
+        {
             result = false;
         }
     }
-    else
+    return result;
+}
+
+bool
+RmapInitiator::readSegmented(RmapTargetNode& rmapTargetNode,
+                             uint32_t memoryAddress,
+                             outpost::Slice<uint8_t> buffer,
+                             outpost::time::Duration timeout,
+                             uint8_t retries)
+{
+    return transferSegmented(rmapTargetNode,
+                             RmapPacket::InstructionField::read,
+                             memoryAddress,
+                             buffer,
+                             outpost::Slice<const uint8_t>::empty(),
+                             timeout,
+                             retries);
+}
+
+bool
+RmapInitiator::writeSegmented(RmapTargetNode& rmapTargetNode,
+                              uint32_t memoryAddress,
+                              outpost::Slice<const uint8_t> data,
+                              outpost::time::Duration timeout,
+                              uint8_t retries)
+{
+    return transferSegmented(rmapTargetNode,
+                             RmapPacket::InstructionField::write,
+                             memoryAddress,
+                             outpost::Slice<uint8_t>::empty(),
+                             data,
+                             timeout,
+                             retries);
+}
+
+uint32_t
+RmapInitiator::getMaximumSegmentLength(RmapTargetNode& rmapTargetNode)
+{
+    // A segment must fit on every path, it may be moved to the redundant
+    // path if a link fails
+    uint8_t paths = rmapTargetNode.hasRedundantPath() ? rmap::maxPaths : 1;
+    size_t length = rmap::maxDataLength;
+    for (uint8_t path = 0; path < paths; path++)
     {
-        console_out("RMAP-Initiator: Transaction could not be initiated\n");
-        result = false;
+        uint8_t link = rmapTargetNode.getLink(path);
+        if (link >= mNumberOfLinks)
+        {
+            return 0;
+        }
+
+        size_t overhead = rmap::commandPacketOverhead
+                          + rmapTargetNode.getTargetSpaceWireAddress(path).getNumberOfElements()
+                          + rmapTargetNode.getReplyAddress(path).getNumberOfElements();
+
+        size_t packetLength = mLinks[link]->getMaximumPacketLength();
+        if (packetLength <= overhead)
+        {
+            return 0;
+        }
+
+        if ((packetLength - overhead) < length)
+        {
+            length = packetLength - overhead;
+        }
     }
 
-    // Delete the transaction from the list
-    mTransactionsList.removeTransaction(transaction->getTransactionID());
-    transaction = nullptr;
-    cmd = nullptr;
+    uint32_t targetLength = rmapTargetNode.getMaximumTransactionLength();
+    if ((targetLength != 0) && (targetLength < length))
+    {
+        length = targetLength;
+    }
+    // Limited by the maximum data length of RMAP
+    return static_cast<uint32_t>(length);
+}
 
-    return result;
+void
+RmapInitiator::resetStatistics()
+{
+    outpost::rtos::MutexGuard lock(mOperationLock);
+    mStatistics.reset();
 }
 
 //=============================================================================
@@ -347,24 +617,36 @@ RmapInitiator::read(RmapTargetNode& rmapTargetNode,
 void
 RmapInitiator::run()
 {
-    static RmapPacket packet;
-
     mStopped = false;
     while (!mStopped)
     {
         outpost::support::Heartbeat::send(mHeartbeatSource, receiveTimeout * 2);
-        if (receivePacket(&packet))
+
+        hal::SpaceWire::ReceiveBuffer rxBuffer;
+        RmapPacketView packet;
+        if (mDispatched)
+        {
+            // Replies are handled by the thread of the dispatcher
+            outpost::rtos::Thread::sleep(getReceiveTimeout());
+        }
+        else if (receivePacket(packet, rxBuffer, getReceiveTimeout()))
         {
             // Only handling reply packet, no command packets
             if (packet.isReplyPacket())
             {
-                replyPacketReceived(&packet);
+                replyPacketReceived(packet);
             }
             else
             {
                 mCounters.mErrorneousReplyPackets++;
             }
+
+            // The reply data has been copied to its destination, the
+            // packet must not be accessed afterwards
+            mSpW.releaseBuffer(rxBuffer);
         }
+        checkLinks();
+        expireTransactions();
     }
     outpost::support::Heartbeat::suspend(mHeartbeatSource);
     mStopped = true;
@@ -374,111 +656,81 @@ bool
 RmapInitiator::sendPacket(RmapTransaction* transaction, outpost::Slice<const uint8_t> data)
 {
     RmapPacket* cmd = transaction->getCommandPacket();
-    hal::SpaceWire::TransmitBuffer* txBuffer = 0;
-    uint16_t transactionID;
     bool result = false;
 
-    transactionID = getNextAvailableTransactionID();
+    uint8_t link = transaction->getLink();
+    if (link >= mNumberOfLinks)
+    {
+        return false;
+    }
+    hal::SpaceWire& spw = *mLinks[link];
 
-    transaction->setTransactionID(transactionID);
-    cmd->setTransactionID(transactionID);
+    // Transaction ID has been assigned together with the slot
+    cmd->setTransactionID(transaction->getTransactionID());
 
     // It is assumed that the transaction is already in the list and in case of
     // required reply corresponding transaction will found and freed accordingly
     // therefore transmit can directly begin
 
-    // Request TX buffer
-    if (mSpW.requestBuffer(txBuffer, transaction->getTimeoutDuration())
-        == hal::SpaceWire::Result::success)
+    // Only the header is serialized, the data of write commands is sent
+    // directly from the memory of the caller
+    uint8_t header[rmap::maxCommandHeaderLength];
+    size_t headerLength = cmd->constructHeader(outpost::asSlice(header), data);
+    if (headerLength == 0)
     {
-        // Serialize the packet content to the SpW buffer
-        if (cmd->constructPacket(txBuffer->getData(), data))
-        {
-            // Total packet length varies with command type
-            if (cmd->isWrite())
-            {
-                // Header length + Data length + Header CRC + Data CRC
-                txBuffer->setLength(cmd->getHeaderLength() + cmd->getDataLength() + 2);
-            }
-            else if (cmd->isRead())
-            {
-                // Header length Header CRC
-                txBuffer->setLength(cmd->getHeaderLength() + 1);
-            }
+        return false;
+    }
 
-            txBuffer->setEndMarker(outpost::hal::SpaceWire::eop);
+    hal::SpaceWire::TransmitDescriptor packet;
+    packet.addSegment(outpost::Slice<const uint8_t>::unsafe(header, headerLength));
 
-#ifdef DEBUG_EN
-            outpost::Slice<uint8_t> txData = txBuffer->getData();
-            console_out("TX-Data length: %zu\n", txData.getNumberOfElements());
-            for (uint16_t i = 0; i < txData.getNumberOfElements(); i++)
-            {
-                console_out("%02X ", txData[i]);
-                if (i % 30 == 29)
-                {
-                    console_out("\n");
-                }
-            }
-            console_out("\n");
-#endif
+    uint8_t dataCrc = cmd->getDataCRC();
+    if (cmd->isWrite() || cmd->isReadModifyWrite())
+    {
+        packet.addSegment(data);
+        packet.addSegment(outpost::Slice<const uint8_t>::unsafe(&dataCrc, 1));
+    }
+    packet.setEndMarker(outpost::hal::SpaceWire::eop);
 
-            if (mSpW.send(txBuffer, transaction->getTimeoutDuration())
-                == hal::SpaceWire::Result::success)
-            {
-                transaction->setState(RmapTransaction::initiated);
+    if (packet.getLength() > spw.getMaximumPacketLength())
+    {
+        OUTPOST_COMM_LOG_ERROR(packetTooLarge, headerLength, cmd->getDataLength());
+        return false;
+    }
 
-                result = true;
-            }
-        }
+    if (spw.sendSegments(packet, transaction->getTimeoutDuration())
+        == hal::SpaceWire::Result::success)
+    {
+        transaction->setState(RmapTransaction::initiated);
+        result = true;
     }
     return result;
 }
 
 bool
-RmapInitiator::receivePacket(RmapPacket* rxedPacket)
+RmapInitiator::receivePacket(RmapPacketView& packet,
+                             hal::SpaceWire::ReceiveBuffer& rxBuffer,
+                             outpost::time::Duration timeout)
 {
-    hal::SpaceWire::ReceiveBuffer rxBuffer;
     bool result = false;
 
     // Receive response
-    if (mSpW.receive(rxBuffer, receiveTimeout) == hal::SpaceWire::Result::success)
+    if (mSpW.receive(rxBuffer, timeout) == hal::SpaceWire::Result::success)
     {
         if (rxBuffer.getEndMarker() == hal::SpaceWire::eop)
         {
             outpost::Slice<const uint8_t> rxData = rxBuffer.getData();
 
-#ifdef DEBUG_EN
-            console_out("RX-Data length: %zu\n", rxData.getNumberOfElements());
-            for (uint16_t i = 0; i < rxData.getNumberOfElements(); i++)
-            {
-                console_out("%02X ", rxData[i]);
-                if (i % 30 == 29)
-                {
-                    console_out("\n");
-                }
-            }
-            console_out("\n");
-#endif
-
-            rxedPacket->reset();
-
-            if (rxedPacket->extractPacket(rxData, mInitiatorLogicalAddress))
+            packet = RmapPacketView(rxData);
+            if (packet.validate(mInitiatorLogicalAddress))
             {
-                if (mRxData.addData(rxedPacket->getData(), rxedPacket->getDataLength()))
-                {
-                    result = true;
-                }
-                else
-                {
-                    mCounters.mErrorInStoringReplyPacket++;
-                }
-                mSpW.releaseBuffer(rxBuffer);
+                // The packet refers to the receive buffer, which is released
+                // by the caller
+                result = true;
             }
             else
             {
-                console_out("RMAP-Initiator: packet interpretation failed, could be "
-                            "non-rmap"
-                            "packet\n");
+                OUTPOST_COMM_LOG_INFO(nonRmapPacket, rxData.getNumberOfElements(), 0);
                 nonRmapPacketReceived.publish(rxData);
                 mCounters.mNonRmapPacketReceived++;
                 mSpW.releaseBuffer(rxBuffer);
@@ -487,7 +739,9 @@ RmapInitiator::receivePacket(RmapPacket* rxedPacket)
         }
         else
         {
-            console_out("RMAP-Initiator: Wrong end of packet\n");
+            OUTPOST_COMM_LOG_WARNING(invalidEndMarker,
+                                     rxBuffer.getData().getNumberOfElements(),
+                                     rxBuffer.getEndMarker());
             mSpW.releaseBuffer(rxBuffer);
             result = false;
         }
@@ -496,66 +750,863 @@ RmapInitiator::receivePacket(RmapPacket* rxedPacket)
 }
 
 void
-RmapInitiator::replyPacketReceived(RmapPacket* packet)
+RmapInitiator::replyPacketReceived(const RmapPacketView& packet)
 {
-    // Find a corresponding command packet
-    RmapTransaction* transaction = resolveTransaction(packet);
+    RmapTransactionHandle handle;
+    RmapCompletionCallback callback;
+    bool executeCallback = false;
 
-    if (!transaction)
-    {
-        // If not found, increment error counter
-        mCounters.mDiscardedReceivedPackets++;
-        mDiscardedPacket = packet;
-        console_out("RMAP Reply packet (dataLength %lu bytes) was received but "
-                    "no corresponding transaction was found.\n",
-                    packet->getDataLength());
-    }
-    else
     {
-        // Register reply packet to the resolved transaction
-        transaction->setReplyPacket(packet);
+        // Transactions are allocated and freed by the calling threads
+        outpost::rtos::MutexGuard lock(mOperationLock);
+
+        // Find a corresponding command packet
+        RmapTransaction* transaction = resolveTransaction(packet);
+
+        if (!transaction
+            && mTransactionsList.isExpiredTransactionId(packet.getTransactionID()))
+        {
+            // The slot may already be used by another transaction
+            mCounters.mLateReplies++;
+            OUTPOST_COMM_LOG_WARNING(lateReply, packet.getTransactionID(), 0);
+            return;
+        }
+        else if (!transaction)
+        {
+            // If not found, increment error counter
+            mCounters.mDiscardedReceivedPackets++;
+
+            // Only materialized for diagnostics
+            if (packet.toPacket(mLastDiscardedPacket))
+            {
+                mDiscardedPacket = &mLastDiscardedPacket;
+            }
+            OUTPOST_COMM_LOG_WARNING(
+                    unexpectedReply, packet.getTransactionID(), packet.getDataLength());
+            return;
+        }
+
+        // Register reply status to the resolved transaction
+        mTransactionsList.removePending(transaction);
+        transaction->setReply(packet.getStatus(), packet.getDataLength());
+        mStatistics.replyReceived(transaction->getTargetId(),
+                                  mClock.now() - transaction->getSendTime(),
+                                  packet.getStatus(),
+                                  packet.isRead() ? packet.getDataLength() : 0);
+
+        // Copy the read data directly from the receive buffer to the
+        // buffer of the user, this is the only copy of the data
+        outpost::Slice<uint8_t> replyBuffer = transaction->getReplyBuffer();
+        if (packet.isRead() && packet.getDataLength() <= replyBuffer.getNumberOfElements())
+        {
+            memcpy(replyBuffer.begin(), packet.getData().begin(), packet.getDataLength());
+        }
+        else if (packet.isRead())
+        {
+            mCounters.mErrorInStoringReplyPacket++;
+        }
 
         // Update transaction state
         transaction->setState(RmapTransaction::replyReceived);
 
-        console_out("RMAP-Initiator: Reply received, thus notifying blocking thread\n");
+        if (packet.getStatus() == RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            OUTPOST_COMM_LOG_DEBUG(replyReceived, packet.getTransactionID(), packet.getStatus());
+        }
+        else
+        {
+            OUTPOST_COMM_LOG_WARNING(
+                    replyWithError, packet.getTransactionID(), packet.getStatus());
+        }
 
-        if (transaction->isBlockingMode())
+        if (transaction->hasCompletionCallback())
+        {
+            // Nobody waits for the transaction, hand it back to the pipeline
+            completeHandle(transaction, handle);
+            callback = transaction->getCompletionCallback();
+            freeTransaction(transaction);
+            executeCallback = true;
+        }
+        else if (transaction->isBlockingMode())
         {
-            console_out("RMAP-Initiator: Transaction with TID %u is blocking, thus "
-                        "releasing lock...\n",
-                        transaction->getTransactionID());
             transaction->releaseTransaction();
         }
     }
+
+    if (executeCallback)
+    {
+        // Executed without the lock, the callback may start new transactions
+        mFreeTransactions.release();
+        callback(handle);
+    }
 }
 
 RmapTransaction*
-RmapInitiator::resolveTransaction(RmapPacket* packet)
+RmapInitiator::resolveTransaction(const RmapPacketView& packet)
 {
-    uint16_t transactionID = packet->getTransactionID();
+    uint16_t transactionID = packet.getTransactionID();
     RmapTransaction* transaction = mTransactionsList.getTransaction(transactionID);
 
+    // Only transactions waiting for a reply can be completed
+    if (transaction && transaction->getState() != RmapTransaction::commandSent)
+    {
+        transaction = nullptr;
+    }
+    return transaction;
+}
+
+RmapTransactionHandle::Result
+RmapInitiator::waitForCompletion(RmapTransaction* transaction, outpost::time::Duration timeout)
+{
+    // Wait for the RMAP reply, other transactions may be started meanwhile
+    transaction->blockTransaction(timeout);
+
+    RmapTransactionHandle handle;
+    {
+        outpost::rtos::MutexGuard lock(mOperationLock);
+
+        // The receiving thread may not have reached the deadline yet
+        if (transaction->getState() == RmapTransaction::commandSent)
+        {
+            expireTransaction(transaction);
+        }
+
+        completeHandle(transaction, handle);
+        freeTransaction(transaction);
+    }
+    mFreeTransactions.release();
+
+    return handle.getResult();
+}
+
+bool
+RmapInitiator::shouldRetry(RmapTargetNode& rmapTargetNode,
+                           RmapPacket::InstructionField::Operation operation,
+                           uint8_t attempt)
+{
+    if ((attempt >= mRetryPolicy.mRetries)
+        || ((operation == RmapPacket::InstructionField::write) && !mRetryPolicy.mRetryWrites))
+    {
+        return false;
+    }
+
+    outpost::rtos::MutexGuard lock(mOperationLock);
+    OUTPOST_COMM_LOG_WARNING(commandRepeated, rmapTargetNode.getId(), 0);
+    mCounters.mRetries++;
+    mStatistics.commandRepeated(rmapTargetNode.getId());
+    return true;
+}
+
+RmapTransaction*
+RmapInitiator::initiateTransaction(RmapTargetNode& rmapTargetNode,
+                                   RmapPacket::InstructionField::Operation operation,
+                                   uint32_t memoryAddress,
+                                   outpost::Slice<const uint8_t> data,
+                                   outpost::Slice<uint8_t> replyBuffer,
+                                   bool reply,
+                                   const RmapCompletionCallback* callback,
+                                   outpost::time::Duration timeout,
+                                   bool dataRetained)
+{
+    // Wait for a free slot in the transaction pipeline
+    outpost::time::SpacecraftElapsedTime queued = mClock.now();
+    if (!mFreeTransactions.acquire(timeout))
+    {
+        OUTPOST_COMM_LOG_WARNING(noFreeTransaction, rmapTargetNode.getId(), 0);
+        return nullptr;
+    }
+
+    // Guard slot allocation and transmission against concurrent accesses
+    outpost::rtos::MutexGuard lock(mOperationLock);
+    mStatistics.slotAcquired(rmapTargetNode.getId(), mClock.now() - queued);
+    return startTransaction(rmapTargetNode,
+                            operation,
+                            memoryAddress,
+                            data,
+                            replyBuffer,
+                            reply,
+                            callback,
+                            timeout,
+                            dataRetained);
+}
+
+RmapTransaction*
+RmapInitiator::startTransaction(RmapTargetNode& rmapTargetNode,
+                                RmapPacket::InstructionField::Operation operation,
+                                uint32_t memoryAddress,
+                                outpost::Slice<const uint8_t> data,
+                                outpost::Slice<uint8_t> replyBuffer,
+                                bool reply,
+                                const RmapCompletionCallback* callback,
+                                outpost::time::Duration timeout,
+                                bool dataRetained)
+{
+    // The data length field of the command has 24 bits
+    size_t length = std::max(data.getNumberOfElements(), replyBuffer.getNumberOfElements());
+    if (length > rmap::maxDataLength)
+    {
+        OUTPOST_COMM_LOG_ERROR(invalidLength, rmapTargetNode.getId(), length);
+        mFreeTransactions.release();
+        return nullptr;
+    }
+
+    // Always available as long as mFreeTransactions has been acquired
+    RmapTransaction* transaction = mTransactionsList.allocateTransaction();
     if (!transaction)
     {
-        // TID is not in use
-        console_out("RMAP-Initiator: Unexpected RMAP Reply Packet Was Received\n");
-        return NULL;
+        mFreeTransactions.release();
+        return nullptr;
+    }
+    RmapPacket* cmd = transaction->getCommandPacket();
+
+    // Packet configuration
+    bool readModifyWrite =
+            (operation == RmapPacket::InstructionField::read) && (data.getNumberOfElements() > 0);
+
+    cmd->setInitiatorLogicalAddress(mInitiatorLogicalAddress);
+    if (operation == RmapPacket::InstructionField::write)
+    {
+        cmd->setWrite();
+        cmd->setDataLength(static_cast<uint32_t>(data.getNumberOfElements()));
+    }
+    else
+    {
+        cmd->setRead();
+        cmd->setDataLength(static_cast<uint32_t>(readModifyWrite
+                                                         ? data.getNumberOfElements()
+                                                         : replyBuffer.getNumberOfElements()));
+    }
+    cmd->setCommand();
+
+    if (mIncrementMode || readModifyWrite)
+    {
+        cmd->setIncrementFlag();
+    }
+    else
+    {
+        cmd->unsetIncrementFlag();
+    }
+
+    // A read command with verify flag would be a read-modify-write
+    // command, the verify mode therefore only applies to writes
+    if ((mVerifyMode && (operation == RmapPacket::InstructionField::write)) || readModifyWrite)
+    {
+        cmd->setVerifyFlag();
+    }
+    else
+    {
+        cmd->unsetVerifyFlag();
+    }
+
+    if (reply)
+    {
+        // Sets the transaction mode, the completion is signaled through
+        // the callback if one is registered
+        transaction->setBlockingMode(callback == nullptr);
+
+        // Extra block call with zero timeout for acquiring already released lock
+        transaction->blockTransaction(outpost::time::Duration::zero());
+
+        cmd->setReplyFlag();
+    }
+    else
+    {
+        // UnSets the transaction mode
+        transaction->setBlockingMode(false);
+
+        cmd->unsetReplyFlag();
+    }
+
+    if (callback)
+    {
+        transaction->setCompletionCallback(*callback);
+    }
+
+    cmd->setExtendedAddress(0x00);
+    cmd->setAddress(memoryAddress);
+
+    // InitiatorLogicalAddress might be updated in below
+    uint8_t path = selectPath(rmapTargetNode);
+    cmd->setTargetInformation(rmapTargetNode, path);
+    transaction->setTargetNode(&rmapTargetNode, path);
+    transaction->setInitiatorLogicalAddress(cmd->getInitiatorLogicalAddress());
+    transaction->setTargetId(rmapTargetNode.getId());
+    transaction->setTimeoutDuration(timeout);
+    transaction->setReplyBuffer(replyBuffer);
+    if (dataRetained)
+    {
+        transaction->setCommandData(data);
+    }
+
+    // Transaction will be initiated and sent through the SpW interface
+    bool sent = sendPacket(transaction, data);
+    if (!sent && rmapTargetNode.hasRedundantPath())
+    {
+        // Nothing has been sent, the command can be tried on the other path
+        path = (path == RmapTargetNode::primaryPath) ? RmapTargetNode::redundantPath
+                                                     : RmapTargetNode::primaryPath;
+        cmd->setTargetInformation(rmapTargetNode, path);
+        transaction->setTargetNode(&rmapTargetNode, path);
+        sent = sendPacket(transaction, data);
+        if (sent)
+        {
+            mCounters.mFailovers++;
+            OUTPOST_COMM_LOG_WARNING(linkFailover, rmapTargetNode.getId(), path);
+        }
+    }
+
+    if (!sent || transaction->getState() != RmapTransaction::initiated)
+    {
+        freeTransaction(transaction);
+        mFreeTransactions.release();
+        return nullptr;
+    }
+
+    mStatistics.commandSent(rmapTargetNode.getId(),
+                            (operation == RmapPacket::InstructionField::write)
+                                    ? static_cast<uint32_t>(data.getNumberOfElements())
+                                    : 0,
+                            reply);
+
+    if (reply)
+    {
+        // Must be set before the lock is released, otherwise a fast
+        // reply could not be matched to this transaction
+        outpost::time::SpacecraftElapsedTime now = mClock.now();
+        transaction->setSendTime(now);
+        if (timeout >= (outpost::time::SpacecraftElapsedTime::endOfEpoch() - now))
+        {
+            // Covers the infinite timeout, the transaction never expires
+            transaction->setDeadline(outpost::time::SpacecraftElapsedTime::endOfEpoch());
+        }
+        else
+        {
+            transaction->setDeadline(now + timeout);
+        }
+        mTransactionsList.addPending(transaction);
+        transaction->setState(RmapTransaction::commandSent);
+
+        OUTPOST_COMM_LOG_DEBUG(
+                commandSent, transaction->getTransactionID(), rmapTargetNode.getId());
     }
+
     return transaction;
 }
 
-uint16_t
-RmapInitiator::getNextAvailableTransactionID()
+bool
+RmapInitiator::transferSegmented(RmapTargetNode& rmapTargetNode,
+                                 RmapPacket::InstructionField::Operation operation,
+                                 uint32_t memoryAddress,
+                                 outpost::Slice<uint8_t> readBuffer,
+                                 outpost::Slice<const uint8_t> writeData,
+                                 outpost::time::Duration timeout,
+                                 uint8_t retries)
+{
+    size_t length = (operation == RmapPacket::InstructionField::read)
+                            ? readBuffer.getNumberOfElements()
+                            : writeData.getNumberOfElements();
+    uint32_t segmentLength = getMaximumSegmentLength(rmapTargetNode);
+
+    // Exit if trying to transfer zero length
+    if ((length == 0) || (segmentLength == 0))
+    {
+        return false;
+    }
+
+    // Outstanding segments are kept in a ring buffer in order of their
+    // position in the memory region
+    Segment segments[rmap::maxSegmentsInFlight];
+    size_t first = 0;
+    size_t inFlight = 0;
+    size_t nextOffset = 0;
+    bool result = true;
+
+    while (result && ((nextOffset < length) || (inFlight > 0)))
+    {
+        // Keep the pipeline filled
+        while (result && (nextOffset < length) && (inFlight < rmap::maxSegmentsInFlight))
+        {
+            Segment& segment = segments[(first + inFlight) % rmap::maxSegmentsInFlight];
+            // RMAP memory addresses are 32 bit wide, so are the offsets
+            segment.mOffset = static_cast<uint32_t>(nextOffset);
+            segment.mLength = ((length - nextOffset) < segmentLength)
+                                      ? static_cast<uint32_t>(length - nextOffset)
+                                      : segmentLength;
+            segment.mAttempts = 0;
+
+            if (startSegment(rmapTargetNode,
+                             operation,
+                             memoryAddress,
+                             readBuffer,
+                             writeData,
+                             timeout,
+                             segment))
+            {
+                nextOffset += segment.mLength;
+                inFlight++;
+            }
+            else
+            {
+                result = false;
+            }
+        }
+
+        if (result && (inFlight > 0))
+        {
+            // Segments are completed in order, later segments are processed
+            // by the receiving thread meanwhile
+            Segment& segment = segments[first];
+
+            RmapTransactionHandle::Result segmentResult = wait(segment.mHandle, timeout);
+            while (segmentResult == RmapTransactionHandle::pending)
+            {
+                // Expired by the receiving thread or the next poll
+                segmentResult = wait(segment.mHandle, timeout);
+            }
+
+            if (segmentResult == RmapTransactionHandle::success)
+            {
+                first = (first + 1) % rmap::maxSegmentsInFlight;
+                inFlight--;
+            }
+            else if (segment.mAttempts < retries)
+            {
+                segment.mAttempts++;
+                {
+                    outpost::rtos::MutexGuard lock(mOperationLock);
+                    OUTPOST_COMM_LOG_WARNING(commandRepeated,
+                                             rmapTargetNode.getId(),
+                                             memoryAddress + segment.mOffset);
+                    mStatistics.commandRepeated(rmapTargetNode.getId());
+                }
+                result = startSegment(rmapTargetNode,
+                                      operation,
+                                      memoryAddress,
+                                      readBuffer,
+                                      writeData,
+                                      timeout,
+                                      segment);
+            }
+            else
+            {
+                result = false;
+            }
+        }
+    }
+
+    if (!result)
+    {
+        // Abandon all outstanding segments, the buffer is not accessed afterwards
+        for (size_t i = 0; i < inFlight; i++)
+        {
+            cancel(segments[(first + i) % rmap::maxSegmentsInFlight].mHandle);
+        }
+    }
+    return result;
+}
+
+bool
+RmapInitiator::startSegment(RmapTargetNode& rmapTargetNode,
+                            RmapPacket::InstructionField::Operation operation,
+                            uint32_t memoryAddress,
+                            outpost::Slice<uint8_t> readBuffer,
+                            outpost::Slice<const uint8_t> writeData,
+                            outpost::time::Duration timeout,
+                            Segment& segment)
+{
+    if (operation == RmapPacket::InstructionField::read)
+    {
+        return readAsync(rmapTargetNode,
+                         memoryAddress + segment.mOffset,
+                         readBuffer.subSlice(segment.mOffset, segment.mLength),
+                         segment.mHandle,
+                         timeout);
+    }
+    else
+    {
+        // The data stays valid until all segments are completed or
+        // cancelled, so the segment can be moved to another link
+        RmapTransaction* transaction =
+                initiateTransaction(rmapTargetNode,
+                                    RmapPacket::InstructionField::write,
+                                    memoryAddress + segment.mOffset,
+                                    writeData.subSlice(segment.mOffset, segment.mLength),
+                                    outpost::Slice<uint8_t>::empty(),
+                                    true,
+                                    nullptr,
+                                    timeout,
+                                    true);
+        return connectHandle(transaction, segment.mHandle);
+    }
+}
+
+size_t
+RmapInitiator::submitBatchItems(outpost::Slice<BatchItem> items,
+                                outpost::time::Duration waitTime,
+                                outpost::time::Duration timeout)
+{
+    if (items.getNumberOfElements() == 0 || !mFreeTransactions.acquire(waitTime))
+    {
+        return 0;
+    }
+
+    // Collect all other free slots without waiting
+    size_t slots = 1;
+    while (slots < items.getNumberOfElements()
+           && mFreeTransactions.acquire(outpost::time::Duration::zero()))
+    {
+        slots++;
+    }
+
+    // Send all commands back-to-back with a single lock acquisition, the
+    // remaining time of the batch is used as timeout for the replies
+    outpost::rtos::MutexGuard lock(mOperationLock);
+    for (size_t i = 0; i < slots; i++)
+    {
+        BatchItem& item = items[i];
+        RmapTransaction* transaction = nullptr;
+        if (item.mTargetNode)
+        {
+            bool isRead = (item.mOperation == operationRead);
+            transaction = startTransaction(*item.mTargetNode,
+                                           isRead ? RmapPacket::InstructionField::read
+                                                  : RmapPacket::InstructionField::write,
+                                           item.mAddress,
+                                           isRead ? outpost::Slice<const uint8_t>::empty()
+                                                  : item.mWriteData,
+                                           isRead ? item.mReadBuffer
+                                                  : outpost::Slice<uint8_t>::empty(),
+                                           true,
+                                           nullptr,
+                                           timeout,
+                                           true);
+        }
+        else
+        {
+            mFreeTransactions.release();
+        }
+
+        // Items which could not be sent keep an invalid handle
+        connectHandle(transaction, item.mHandle);
+    }
+    return slots;
+}
+
+void
+RmapInitiator::finishTransaction(RmapTransaction* transaction)
+{
+    {
+        outpost::rtos::MutexGuard lock(mOperationLock);
+        freeTransaction(transaction);
+    }
+    mFreeTransactions.release();
+}
+
+bool
+RmapInitiator::connectHandle(RmapTransaction* transaction, RmapTransactionHandle& handle)
+{
+    handle = RmapTransactionHandle();
+    if (transaction)
+    {
+        handle.mTransaction = transaction;
+        handle.mTransactionId = transaction->getTransactionID();
+        handle.mResult = RmapTransactionHandle::pending;
+    }
+    return (transaction != nullptr);
+}
+
+void
+RmapInitiator::completeHandle(RmapTransaction* transaction, RmapTransactionHandle& handle)
+{
+    handle.mTransaction = nullptr;
+    handle.mTransactionId = transaction->getTransactionID();
+
+    if (transaction->getState() == RmapTransaction::replyReceived)
+    {
+        bool isRead = transaction->getCommandPacket()->isRead();
+        handle.mReplyStatus = transaction->getReplyStatus();
+        handle.mDataLength = isRead ? transaction->getReplyDataLength() : 0;
+
+        if (transaction->getReplyStatus() != RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            handle.mResult = RmapTransactionHandle::failure;
+        }
+        else if (isRead
+                 && (transaction->getReplyDataLength()
+                     > transaction->getReplyBuffer().getNumberOfElements()))
+        {
+            // Reply data did not fit into the buffer of the user
+            handle.mResult = RmapTransactionHandle::failure;
+        }
+        else
+        {
+            handle.mResult = RmapTransactionHandle::success;
+        }
+    }
+    else if (transaction->getState() == RmapTransaction::linkFailed)
+    {
+        handle.mResult = RmapTransactionHandle::linkFailed;
+    }
+    else
+    {
+        handle.mResult = RmapTransactionHandle::timeout;
+    }
+}
+
+bool
+RmapInitiator::isConnected(const RmapTransactionHandle& handle) const
+{
+    // The slot is reused with a new transaction ID once it is freed
+    return (handle.mTransaction != nullptr)
+           && (handle.mTransaction->getTransactionID() == handle.mTransactionId)
+           && (handle.mTransaction->getState() != RmapTransaction::notInitiated);
+}
+
+void
+RmapInitiator::disconnectHandle(RmapTransactionHandle& handle)
+{
+    handle.mTransaction = nullptr;
+    handle.mResult = RmapTransactionHandle::invalid;
+}
+
+bool
+RmapInitiator::isExpired(RmapTransaction* transaction) const
+{
+    return (mClock.now() >= transaction->getDeadline());
+}
+
+void
+RmapInitiator::expireTransaction(RmapTransaction* transaction)
+{
+    transaction->setState(RmapTransaction::timeout);
+    mTransactionsList.markExpired(transaction);
+    mCounters.mExpiredTransactions++;
+    mStatistics.transactionExpired(transaction->getTargetId());
+    OUTPOST_COMM_LOG_WARNING(
+            transactionExpired, transaction->getTransactionID(), transaction->getTargetId());
+}
+
+outpost::time::Duration
+RmapInitiator::getReceiveTimeout()
+{
+    outpost::rtos::MutexGuard lock(mOperationLock);
+
+    RmapTransaction* transaction = mTransactionsList.getEarliestPending();
+    if (!transaction)
+    {
+        return receiveTimeout;
+    }
+
+    outpost::time::SpacecraftElapsedTime now = mClock.now();
+    if (transaction->getDeadline() <= now)
+    {
+        return outpost::time::Duration::zero();
+    }
+
+    outpost::time::Duration remaining = transaction->getDeadline() - now;
+    return (remaining < receiveTimeout) ? remaining : receiveTimeout;
+}
+
+outpost::time::Duration
+RmapInitiator::getRemainingTime(outpost::time::SpacecraftElapsedTime start,
+                                outpost::time::Duration timeout) const
+{
+    if (timeout == outpost::time::Duration::infinity())
+    {
+        return timeout;
+    }
+
+    outpost::time::Duration elapsed = mClock.now() - start;
+    if (elapsed < timeout)
+    {
+        return timeout - elapsed;
+    }
+    return outpost::time::Duration::zero();
+}
+
+void
+RmapInitiator::expireTransactions()
+{
+    RmapTransactionHandle handles[rmap::maxConcurrentTransactions];
+    RmapCompletionCallback callbacks[rmap::maxConcurrentTransactions];
+    size_t expired = 0;
+
+    {
+        outpost::rtos::MutexGuard lock(mOperationLock);
+
+        // Pending transactions are ordered by their deadline
+        RmapTransaction* transaction = mTransactionsList.getEarliestPending();
+        while (transaction && isExpired(transaction))
+        {
+            if (abortTransaction(transaction,
+                                 RmapTransaction::timeout,
+                                 handles[expired],
+                                 callbacks[expired]))
+            {
+                expired++;
+            }
+            transaction = mTransactionsList.getEarliestPending();
+        }
+    }
+
+    for (size_t i = 0; i < expired; i++)
+    {
+        mFreeTransactions.release();
+        callbacks[i](handles[i]);
+    }
+}
+
+bool
+RmapInitiator::abortTransaction(RmapTransaction* transaction,
+                                RmapTransaction::State state,
+                                RmapTransactionHandle& handle,
+                                RmapCompletionCallback& callback)
+{
+    expireTransaction(transaction);
+    transaction->setState(state);
+
+    if (transaction->hasCompletionCallback())
+    {
+        completeHandle(transaction, handle);
+        callback = transaction->getCompletionCallback();
+        freeTransaction(transaction);
+        return true;
+    }
+
+    // Wake up the thread waiting for this transaction
+    transaction->releaseTransaction();
+    return false;
+}
+
+uint8_t
+RmapInitiator::selectPath(RmapTargetNode& rmapTargetNode)
+{
+    if (!rmapTargetNode.hasRedundantPath())
+    {
+        return RmapTargetNode::primaryPath;
+    }
+
+    uint8_t primaryLink = rmapTargetNode.getLink(RmapTargetNode::primaryPath);
+    uint8_t redundantLink = rmapTargetNode.getLink(RmapTargetNode::redundantPath);
+    bool primaryUsable = isLinkUsable(primaryLink);
+    bool redundantUsable = isLinkUsable(redundantLink);
+
+    if (primaryUsable && redundantUsable && (primaryLink != redundantLink))
+    {
+        // Balance the load, the primary path is preferred if equal
+        return (getPendingOnLink(redundantLink) < getPendingOnLink(primaryLink))
+                       ? RmapTargetNode::redundantPath
+                       : RmapTargetNode::primaryPath;
+    }
+    else if (!primaryUsable && redundantUsable)
+    {
+        return RmapTargetNode::redundantPath;
+    }
+    return RmapTargetNode::primaryPath;
+}
+
+uint8_t
+RmapInitiator::getPendingOnLink(uint8_t link)
+{
+    uint8_t pending = 0;
+    for (uint8_t i = 0; i < mTransactionsList.getNumberOfPending(); i++)
+    {
+        if (mTransactionsList.getPending(i)->getLink() == link)
+        {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+void
+RmapInitiator::checkLinks()
+{
+    for (uint8_t link = 0; link < mNumberOfLinks; link++)
+    {
+        bool up = mLinks[link]->isUp();
+        if (mLinkUp[link] && !up)
+        {
+            failLink(link);
+        }
+        mLinkUp[link] = up;
+    }
+}
+
+void
+RmapInitiator::failLink(uint8_t link)
 {
-    // Check in the current transaction list that the TID is not in use
-    for (uint32_t i = 0; i < rmap::maxTransactionIds; i++)
+    RmapTransactionHandle handles[rmap::maxConcurrentTransactions];
+    RmapCompletionCallback callbacks[rmap::maxConcurrentTransactions];
+    size_t aborted = 0;
+
     {
-        if (!mTransactionsList.isTransactionIdUsed(i))
+        outpost::rtos::MutexGuard lock(mOperationLock);
+
+        // The pending list changes while transactions are aborted
+        RmapTransaction* affected[rmap::maxConcurrentTransactions];
+        uint8_t numberOfAffected = 0;
+        for (uint8_t i = 0; i < mTransactionsList.getNumberOfPending(); i++)
+        {
+            RmapTransaction* transaction = mTransactionsList.getPending(i);
+            if (transaction->getLink() == link)
+            {
+                affected[numberOfAffected++] = transaction;
+            }
+        }
+
+        for (uint8_t i = 0; i < numberOfAffected; i++)
         {
-            mTransactionId = i;
-            break;
+            RmapTransaction* transaction = affected[i];
+            RmapTargetNode* node = transaction->getTargetNode();
+            RmapPacket* cmd = transaction->getCommandPacket();
+            uint8_t path = (transaction->getPath() == RmapTargetNode::primaryPath)
+                                   ? RmapTargetNode::redundantPath
+                                   : RmapTargetNode::primaryPath;
+
+            // Writes and read-modify-writes can only be sent again if
+            // their data is still available
+            bool hasData = cmd->isWrite() || cmd->isReadModifyWrite();
+            if (node && node->hasRedundantPath() && (node->getLink(path) != link)
+                && isLinkUsable(node->getLink(path))
+                && (!hasData || transaction->hasCommandData()))
+            {
+                cmd->setTargetInformation(*node, path);
+                transaction->setTargetNode(node, path);
+                if (sendPacket(transaction, transaction->getCommandData()))
+                {
+                    transaction->setState(RmapTransaction::commandSent);
+                    mCounters.mFailovers++;
+                    mStatistics.commandRepeated(transaction->getTargetId());
+                    OUTPOST_COMM_LOG_WARNING(linkFailover, transaction->getTargetId(), path);
+                    continue;
+                }
+            }
+
+            if (abortTransaction(transaction,
+                                 RmapTransaction::linkFailed,
+                                 handles[aborted],
+                                 callbacks[aborted]))
+            {
+                aborted++;
+            }
         }
     }
-    return mTransactionId;
+
+    for (size_t i = 0; i < aborted; i++)
+    {
+        mFreeTransactions.release();
+        callbacks[i](handles[i]);
+    }
+}
+
+void
+RmapInitiator::freeTransaction(RmapTransaction* transaction)
+{
+    if (transaction->getState() == RmapTransaction::commandSent)
+    {
+        // Abandoned while waiting for the reply
+        mStatistics.transactionCancelled(transaction->getTargetId());
+    }
+    mTransactionsList.freeTransaction(transaction);
 }
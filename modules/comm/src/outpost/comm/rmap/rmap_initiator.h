@@ -17,9 +17,12 @@
 #define OUTPOST_COMM_RMAP_INITIATOR_H_
 
 #include "rmap_packet.h"
+#include "rmap_packet_view.h"
+#include "rmap_statistics.h"
 #include "rmap_status.h"
 #include "rmap_transaction.h"
 
+#include <outpost/comm/spacewire_dispatcher.h>
 #include <outpost/hal/spacewire.h>
 #include <outpost/rtos.h>
 #include <outpost/smpc.h>
@@ -42,13 +45,51 @@ namespace comm
  * The reception of RMAP packet is handled by separate thread being supplied by
  * the initiator for any asynchronous incoming packets due to some delayed transport.
  *
+ * Transactions are pipelined: the operation lock only covers the allocation
+ * of a transaction slot and the transmission of the command. Afterwards the
+ * calling thread waits for its reply without holding the lock, so up to
+ * rmap::maxConcurrentTransactions transactions from different threads can be
+ * outstanding at the same time. The receiving thread completes each
+ * transaction independently. Callers which find all slots in use wait for a
+ * free slot until their timeout expires.
+ *
+ * Besides the blocking read() and write() operations, transactions can be
+ * started asynchronously with readAsync() and writeAsync(). These return
+ * after the command has been sent and report the outcome either through a
+ * RmapTransactionHandle, which can be polled or waited for, or through a
+ * completion callback. Callbacks are executed by the receiving thread and
+ * must therefore not block. Asynchronous transactions which do not receive a
+ * reply within their timeout are expired by the receiving thread.
+ *
+ * Each transaction waiting for a reply has a deadline. The receiving thread
+ * wakes up at the earliest deadline at the latest, expires the transaction
+ * and hands its slot back to the pipeline. Replies arriving afterwards are
+ * counted as late replies. Blocking reads and writes can be repeated after
+ * a missing reply according to the RetryPolicy.
+ *
+ * By default the initiator receives directly from its SpaceWire link. If the
+ * link is shared with other protocols the initiator can be attached to a
+ * SpaceWireDispatcher instead, replies are then handled by the thread of the
+ * dispatcher and the thread of the initiator only expires transactions.
+ *
+ * Additional links can be added together with the dispatcher receiving their
+ * replies. Each command is sent on the primary or the redundant path of its
+ * target node. If both paths are available, the path whose link has fewer
+ * replies outstanding is used, so independent transactions are spread over
+ * the links. If a link goes down, pending commands are sent again on the
+ * redundant path with their transaction ID and deadline unchanged. Writes
+ * and read-modify-writes are only sent again if the caller still holds
+ * their data, which is the case for all blocking operations. Asynchronous
+ * writes are completed with RmapTransactionHandle::linkFailed instead.
+ *
  * \author  Muhammad Bassam
  */
-class RmapInitiator : public outpost::rtos::Thread
+class RmapInitiator : public outpost::rtos::Thread, public SpaceWireProtocolHandler
 {
     friend class TestingRmap;
 
-    static constexpr outpost::time::Duration receiveTimeout = outpost::time::Seconds(5);
+    /// Upper limit for waiting on a packet if no deadline is earlier
+    static constexpr outpost::time::Duration receiveTimeout = outpost::time::Milliseconds(100);
 
 public:
     enum Operation
@@ -63,7 +104,11 @@ public:
             mDiscardedReceivedPackets(0),
             mNonRmapPacketReceived(0),
             mErrorneousReplyPackets(0),
-            mErrorInStoringReplyPacket(0)
+            mErrorInStoringReplyPacket(0),
+            mExpiredTransactions(0),
+            mLateReplies(0),
+            mRetries(0),
+            mFailovers(0)
         {
         }
 
@@ -71,53 +116,141 @@ public:
         size_t mNonRmapPacketReceived;
         size_t mErrorneousReplyPackets;
         size_t mErrorInStoringReplyPacket;
+
+        /// Transactions without reply before their deadline
+        size_t mExpiredTransactions;
+
+        /// Replies received after their transaction has expired, not
+        /// included in mDiscardedReceivedPackets
+        size_t mLateReplies;
+
+        /// Commands sent again because of a missing reply
+        size_t mRetries;
+
+        /// Commands sent on the redundant path because their link failed
+        size_t mFailovers;
     };
 
     /**
-     * Buffer handling for providing data to the user for received reply
-     * packets.
+     * Repetition of blocking reads and writes whose reply did not arrive
+     * before their timeout.
      *
-     * TODO: Extend this to partial data buffering for storing multiple received
-     * data on the single buffer with the help of data indexing
-     * */
-    struct Buffer
+     * Commands answered with an error status are never repeated.
+     * Read-modify-write commands and asynchronous transactions are not
+     * repeated either.
+     */
+    struct RetryPolicy
     {
-        Buffer() : mLength(0)
+        RetryPolicy() : mRetries(0), mRetryWrites(false)
         {
-            memset(mData, 0, sizeof(mData));
         }
 
-        bool
-        addData(uint8_t* buffer, uint16_t len)
+        RetryPolicy(uint8_t retries, bool retryWrites) :
+            mRetries(retries), mRetryWrites(retryWrites)
         {
-            bool result = false;
+        }
 
-            if (len < sizeof(mData))
-            {
-                mLength = len;
-                memcpy(mData, buffer, mLength);
-                result = true;
-            }
-            return result;
+        /// Number of times a command is sent again, each attempt uses the
+        /// full timeout of the operation
+        uint8_t mRetries;
+
+        /// Writes might have been executed even if the reply got lost,
+        /// they are therefore only repeated if enabled
+        bool mRetryWrites;
+    };
+
+    /**
+     * Read or write within a batch, see transferBatch().
+     */
+    struct BatchItem
+    {
+        BatchItem() :
+            mTargetNode(nullptr),
+            mOperation(operationRead),
+            mAddress(0),
+            mReadBuffer(outpost::Slice<uint8_t>::empty()),
+            mWriteData(outpost::Slice<const uint8_t>::empty()),
+            mHandle()
+        {
         }
 
-        void
-        getData(uint8_t* buffer)
+        static inline BatchItem
+        read(RmapTargetNode& targetNode, uint32_t address, outpost::Slice<uint8_t> buffer)
         {
-            memcpy(buffer, mData, mLength);
-            memset(mData, 0, sizeof(mData));
-            mLength = 0;
+            BatchItem item;
+            item.mTargetNode = &targetNode;
+            item.mOperation = operationRead;
+            item.mAddress = address;
+            item.mReadBuffer = buffer;
+            return item;
         }
 
-    private:
-        uint8_t mData[1024];
-        uint16_t mLength;
+        static inline BatchItem
+        write(RmapTargetNode& targetNode, uint32_t address, outpost::Slice<const uint8_t> data)
+        {
+            BatchItem item;
+            item.mTargetNode = &targetNode;
+            item.mOperation = operationWrite;
+            item.mAddress = address;
+            item.mWriteData = data;
+            return item;
+        }
+
+        RmapTargetNode* mTargetNode;
+        Operation mOperation;
+        uint32_t mAddress;
+
+        /// Destination of a read, its size defines the read length
+        outpost::Slice<uint8_t> mReadBuffer;
+        outpost::Slice<const uint8_t> mWriteData;
+
+        /// Outcome of the item once the batch has been processed. Items
+        /// which could not be sent are marked as invalid.
+        RmapTransactionHandle mHandle;
     };
 
+    /**
+     * Table of the transactions of the initiator.
+     *
+     * The transaction ID encodes the index of the slot in the lower bits
+     * and a per slot generation counter in the upper bits. Allocation,
+     * release and the lookup of a reply are therefore constant time. The
+     * generation advances with every allocation, so a late reply to an
+     * earlier transaction in the same slot is rejected. Transaction ID 0
+     * is never allocated and marks a free slot.
+     *
+     * Transactions waiting for a reply are additionally kept ordered by
+     * their deadline, so the receiving thread only has to check the
+     * earliest deadline to find expired transactions. The ID of the last
+     * expired transaction of each slot is kept to recognize late replies.
+     */
     struct TransactionsList
     {
-        TransactionsList() : mTransactions(), mIndex(0)
+        static constexpr uint8_t slotBits = 4;
+        static constexpr uint16_t slotMask = (1 << slotBits) - 1;
+        static constexpr uint16_t maxGeneration = (rmap::maxTransactionIds >> slotBits) - 1;
+
+        static_assert(rmap::maxConcurrentTransactions <= (1 << slotBits),
+                      "Transaction slot index does not fit into the transaction ID");
+
+        TransactionsList() :
+            mTransactions(),
+            mGenerations(),
+            mFreeSlots(),
+            mNumberOfFreeSlots(0),
+            mPendingSlots(),
+            mNumberOfPendingSlots(0),
+            mExpiredTransactionIds()
         {
+            for (uint8_t i = 0; i < rmap::maxConcurrentTransactions; i++)
+            {
+                mGenerations[i] = 0;
+                mExpiredTransactionIds[i] = 0;
+
+                // Lowest slot is allocated first
+                mFreeSlots[i] = rmap::maxConcurrentTransactions - 1 - i;
+            }
+            mNumberOfFreeSlots = rmap::maxConcurrentTransactions;
         }
 
         ~TransactionsList()
@@ -127,96 +260,169 @@ public:
         uint8_t
         getActiveTransactions()
         {
-            uint8_t active = 0;
+            return rmap::maxConcurrentTransactions - mNumberOfFreeSlots;
+        }
 
-            for (uint8_t i = 0; i < rmap::maxConcurrentTransactions; i++)
+        /**
+         * Take a free slot and assign a new transaction ID to it.
+         *
+         * \return
+         *      Transaction or nullptr if all slots are in use.
+         */
+        RmapTransaction*
+        allocateTransaction()
+        {
+            if (mNumberOfFreeSlots == 0)
             {
-                if (mTransactions[i].getTransactionID() != 0)
-                {
-                    active++;
-                }
+                return nullptr;
             }
-            return active;
-        }
 
-        void
-        addTransaction(RmapTransaction* trans)
-        {
-            mTransactions[mIndex] = *trans;
-            mIndex = (mIndex == (rmap::maxConcurrentTransactions - 1) ? 0 : mIndex + 1);
+            uint8_t slot = mFreeSlots[--mNumberOfFreeSlots];
+
+            // Generation zero is skipped to keep the ID 0 unused
+            mGenerations[slot] = (mGenerations[slot] >= maxGeneration) ? 1 : mGenerations[slot] + 1;
+
+            RmapTransaction* transaction = &mTransactions[slot];
+            transaction->setTransactionID((mGenerations[slot] << slotBits) | slot);
+            return transaction;
         }
 
+        /**
+         * Reset the transaction and hand its slot back.
+         */
         void
-        removeTransaction(uint16_t tid)
+        freeTransaction(RmapTransaction* transaction)
         {
-            for (uint8_t i = 0; i < rmap::maxConcurrentTransactions; i++)
+            size_t slot = transaction - mTransactions;
+            if ((slot < rmap::maxConcurrentTransactions)
+                && (transaction->getTransactionID() != 0))
             {
-                if (mTransactions[i].getTransactionID() == tid)
-                {
-                    mTransactions[i].reset();
-                    break;
-                }
+                removePending(transaction);
+                transaction->reset();
+                mFreeSlots[mNumberOfFreeSlots++] = static_cast<uint8_t>(slot);
             }
         }
 
         RmapTransaction*
         getTransaction(uint16_t tid)
         {
-            bool found = false;
-            uint8_t i;
-
-            for (i = 0; i < rmap::maxConcurrentTransactions; i++)
-            {
-                if (mTransactions[i].getTransactionID() == tid)
-                {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (found)
+            uint16_t slot = tid & slotMask;
+            if ((tid == 0) || (slot >= rmap::maxConcurrentTransactions)
+                || (mTransactions[slot].getTransactionID() != tid))
             {
-                return &mTransactions[i];
-            }
-            else
-            {
-                return NULL;
+                return nullptr;
             }
+            return &mTransactions[slot];
         }
 
         bool
         isTransactionIdUsed(uint16_t tid)
         {
-            bool used = false;
-            uint8_t i;
+            return (getTransaction(tid) != nullptr);
+        }
+
+        /**
+         * Insert a transaction waiting for its reply, its deadline must
+         * already be set.
+         */
+        void
+        addPending(RmapTransaction* transaction)
+        {
+            uint8_t position = mNumberOfPendingSlots;
+            while ((position > 0)
+                   && (mTransactions[mPendingSlots[position - 1]].getDeadline()
+                       > transaction->getDeadline()))
+            {
+                mPendingSlots[position] = mPendingSlots[position - 1];
+                position--;
+            }
+            mPendingSlots[position] = static_cast<uint8_t>(transaction - mTransactions);
+            mNumberOfPendingSlots++;
+        }
 
-            for (i = 0; i < rmap::maxConcurrentTransactions; i++)
+        /**
+         * Remove a transaction from the pending transactions, does nothing
+         * if the transaction is not waiting for a reply.
+         */
+        void
+        removePending(RmapTransaction* transaction)
+        {
+            uint8_t slot = static_cast<uint8_t>(transaction - mTransactions);
+            for (uint8_t i = 0; i < mNumberOfPendingSlots; i++)
             {
-                if (mTransactions[i].getTransactionID() == tid)
+                if (mPendingSlots[i] == slot)
                 {
-                    used = true;
-                    break;
+                    mNumberOfPendingSlots--;
+                    for (uint8_t k = i; k < mNumberOfPendingSlots; k++)
+                    {
+                        mPendingSlots[k] = mPendingSlots[k + 1];
+                    }
+                    return;
                 }
             }
+        }
 
-            return used;
+        inline uint8_t
+        getNumberOfPending() const
+        {
+            return mNumberOfPendingSlots;
         }
 
+        /**
+         * Pending transaction at the given position, ordered by deadline.
+         */
+        inline RmapTransaction*
+        getPending(uint8_t position)
+        {
+            return &mTransactions[mPendingSlots[position]];
+        }
+
+        /**
+         * \return
+         *      Pending transaction with the earliest deadline or nullptr
+         *      if no transaction waits for a reply.
+         */
         RmapTransaction*
-        getFreeTransaction()
+        getEarliestPending()
         {
-            for (uint8_t i = 0; i < rmap::maxConcurrentTransactions; i++)
+            if (mNumberOfPendingSlots == 0)
             {
-                if (mTransactions[i].getState() == RmapTransaction::notInitiated)
-                {
-                    return &mTransactions[i];
-                }
+                return nullptr;
             }
-            return NULL;
+            return &mTransactions[mPendingSlots[0]];
+        }
+
+        /**
+         * Remove the transaction from the pending transactions and keep its
+         * ID to recognize a late reply.
+         */
+        void
+        markExpired(RmapTransaction* transaction)
+        {
+            removePending(transaction);
+            mExpiredTransactionIds[transaction - mTransactions] = transaction->getTransactionID();
+        }
+
+        bool
+        isExpiredTransactionId(uint16_t tid)
+        {
+            uint16_t slot = tid & slotMask;
+            return (tid != 0) && (slot < rmap::maxConcurrentTransactions)
+                   && (mExpiredTransactionIds[slot] == tid);
         }
 
         RmapTransaction mTransactions[rmap::maxConcurrentTransactions];
-        uint8_t mIndex;
+
+    private:
+        uint16_t mGenerations[rmap::maxConcurrentTransactions];
+        uint8_t mFreeSlots[rmap::maxConcurrentTransactions];
+        uint8_t mNumberOfFreeSlots;
+
+        /// Slots of the transactions waiting for a reply, earliest deadline first
+        uint8_t mPendingSlots[rmap::maxConcurrentTransactions];
+        uint8_t mNumberOfPendingSlots;
+
+        uint16_t mExpiredTransactionIds[rmap::maxConcurrentTransactions];
     };
 
     //--------------------------------------------------------------------------
@@ -227,6 +433,51 @@ public:
                   outpost::support::parameter::HeartbeatSource heartbeatSource);
     ~RmapInitiator();
 
+    /**
+     * Receive the replies through a dispatcher instead of directly from the
+     * SpaceWire link.
+     *
+     * Registers the initiator for RMAP packets addressed to its logical
+     * address. Must be called before the initiator and the dispatcher are
+     * started, the logical address must not be changed afterwards.
+     *
+     * \return
+     *      True if the initiator was registered, false if the handler table
+     *      of the dispatcher is full.
+     */
+    bool
+    attachTo(SpaceWireDispatcher& dispatcher);
+
+    /**
+     * Handle a packet forwarded by the dispatcher.
+     *
+     * The reply data is copied to the destination of its transaction, the
+     * packet is not referenced afterwards.
+     */
+    virtual bool
+    handlePacket(const outpost::utils::SharedChildPointer& packet) override;
+
+    /**
+     * Add a SpaceWire link on which commands can be sent.
+     *
+     * The link gets the next free index, the link given to the constructor
+     * has index 0. The replies on the link are received by the dispatcher,
+     * the initiator is registered for them. Must be called before the
+     * initiator and the dispatcher are started.
+     *
+     * \return
+     *      True if the link was added, false if the maximum number of links
+     *      is reached or the handler table of the dispatcher is full.
+     */
+    bool
+    addLink(hal::SpaceWire& spw, SpaceWireDispatcher& dispatcher);
+
+    inline uint8_t
+    getNumberOfLinks() const
+    {
+        return mNumberOfLinks;
+    }
+
     /**
      * Writes remote memory. For blocking write, the method blocks the current
      * thread and waits for the desired reply until specific time interval. For
@@ -352,6 +603,279 @@ public:
          uint32_t length,
          outpost::time::Duration timeout = outpost::time::Duration::maximum());
 
+    /**
+     * Atomically modify remote memory.
+     *
+     * Sends a read-modify-write command, the target replaces the bits
+     * selected by the mask with the given data and returns the previous
+     * content of the memory. The method blocks the current thread until
+     * the reply has been received or the timeout has expired.
+     *
+     * Read-modify-write commands always increment the address and request
+     * a reply, independent of the increment and reply mode.
+     *
+     * @param rmapTargetNode
+     *      Reference to the target node object found from the list
+     *
+     * @param memoryAddress
+     *      Remote memory address which is modified
+     *
+     * @param data
+     *      New values of the bits selected by the mask, 1 to 4 bytes
+     *
+     * @param mask
+     *      Bits to modify, must have the same length as the data
+     *
+     * @param previousData
+     *      Buffer for the content of the memory before the modification,
+     *      must have at least the length of the data.
+     *
+     * @param timeout
+     *      Timeout for the reply
+     *
+     * @return
+     *      True in case of successful operations, false for any errors encountered
+     */
+    bool
+    readModifyWrite(RmapTargetNode& rmapTargetNode,
+                    uint32_t memoryAddress,
+                    outpost::Slice<const uint8_t> data,
+                    outpost::Slice<const uint8_t> mask,
+                    outpost::Slice<uint8_t> previousData,
+                    outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Atomically modify remote memory and discard its previous content.
+     *
+     * \see readModifyWrite
+     */
+    bool
+    readModifyWrite(RmapTargetNode& rmapTargetNode,
+                    uint32_t memoryAddress,
+                    outpost::Slice<const uint8_t> data,
+                    outpost::Slice<const uint8_t> mask,
+                    outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Start a read from remote memory without waiting for the reply.
+     *
+     * The reply data is copied to the given buffer by the receiving thread,
+     * the buffer must therefore stay valid until the transaction has
+     * completed or has been cancelled.
+     *
+     * @param rmapTargetNode
+     *      Reference to the target node object found from the list
+     *
+     * @param memoryAddress
+     *      Remote memory address from which the data is read
+     *
+     * @param buffer
+     *      Buffer for the received data, its size defines the read length
+     *
+     * @param handle
+     *      Handle which is connected to the started transaction
+     *
+     * @param timeout
+     *      Timeout for acquiring a transaction slot and for the reply
+     *
+     * @return
+     *      True if the command was sent, false otherwise. The handle is
+     *      invalid in the latter case.
+     */
+    bool
+    readAsync(RmapTargetNode& rmapTargetNode,
+              uint32_t memoryAddress,
+              outpost::Slice<uint8_t> buffer,
+              RmapTransactionHandle& handle,
+              outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Start a read from remote memory and signal its completion
+     * through a callback.
+     *
+     * The callback is executed by the receiving thread once the reply
+     * has been received or the transaction has expired.
+     *
+     * @return
+     *      True if the command was sent, false otherwise. The callback is
+     *      not executed in the latter case.
+     */
+    bool
+    readAsync(RmapTargetNode& rmapTargetNode,
+              uint32_t memoryAddress,
+              outpost::Slice<uint8_t> buffer,
+              const RmapCompletionCallback& callback,
+              outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Start a write to remote memory without waiting for the reply.
+     *
+     * Asynchronous writes always request a reply from the target,
+     * otherwise their completion could not be reported. The data is
+     * serialized before the function returns. It can therefore not be
+     * sent again if the link fails while waiting for the reply, the
+     * transaction completes with RmapTransactionHandle::linkFailed in
+     * that case.
+     *
+     * @return
+     *      True if the command was sent, false otherwise. The handle is
+     *      invalid in the latter case.
+     */
+    bool
+    writeAsync(RmapTargetNode& rmapTargetNode,
+               uint32_t memoryAddress,
+               outpost::Slice<const uint8_t> data,
+               RmapTransactionHandle& handle,
+               outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Start a write to remote memory and signal its completion
+     * through a callback.
+     *
+     * \see writeAsync
+     */
+    bool
+    writeAsync(RmapTargetNode& rmapTargetNode,
+               uint32_t memoryAddress,
+               outpost::Slice<const uint8_t> data,
+               const RmapCompletionCallback& callback,
+               outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Check the state of an asynchronous transaction without blocking.
+     *
+     * Once a result other than RmapTransactionHandle::pending is returned
+     * the transaction slot has been handed back and the handle keeps the
+     * result of the transaction.
+     *
+     * Copies of a handle share the transaction, only the first copy which
+     * is polled after the completion receives the result. All other copies
+     * return RmapTransactionHandle::invalid.
+     */
+    RmapTransactionHandle::Result
+    poll(RmapTransactionHandle& handle);
+
+    /**
+     * Wait until an asynchronous transaction has completed.
+     *
+     * @return
+     *      RmapTransactionHandle::pending if the transaction did not
+     *      complete within the given time.
+     */
+    RmapTransactionHandle::Result
+    wait(RmapTransactionHandle& handle, outpost::time::Duration timeout);
+
+    /**
+     * Wait until all given asynchronous transactions have completed.
+     *
+     * @param timeout
+     *      Overall time to wait for all transactions
+     *
+     * @return
+     *      True if no transaction is pending anymore.
+     */
+    bool
+    waitForAll(outpost::Slice<RmapTransactionHandle> handles, outpost::time::Duration timeout);
+
+    /**
+     * Abandon a pending asynchronous transaction.
+     *
+     * A reply received later on is discarded. The buffer given to
+     * readAsync() is no longer accessed after this call.
+     */
+    void
+    cancel(RmapTransactionHandle& handle);
+
+    /**
+     * Execute a batch of reads and writes.
+     *
+     * The commands are sent back-to-back, all commands for which a
+     * transaction slot is available are configured and sent with a single
+     * acquisition of the operation lock. Afterwards the replies are
+     * collected. If the batch has more items than free transaction slots,
+     * further items are sent as soon as earlier items have completed.
+     *
+     * All items request a reply. The outcome of each item is stored in its
+     * handle, items which did not complete in time are marked with
+     * RmapTransactionHandle::timeout.
+     *
+     * @param items
+     *      Reads and writes, the read buffers must stay valid until the
+     *      function returns.
+     *
+     * @param timeout
+     *      Time for the complete batch
+     *
+     * @return
+     *      True if all items have been executed successfully.
+     */
+    bool
+    transferBatch(outpost::Slice<BatchItem> items,
+                  outpost::time::Duration timeout = outpost::time::Seconds(1));
+
+    /**
+     * Read a memory region of arbitrary size.
+     *
+     * The region is split into segments of at most
+     * getMaximumSegmentLength() bytes. Up to rmap::maxSegmentsInFlight
+     * segments are outstanding at the same time, each segment is written
+     * to its position in the buffer. A failed segment is repeated up to
+     * the given number of retries.
+     *
+     * @param rmapTargetNode
+     *      Reference to the target node object found from the list
+     *
+     * @param memoryAddress
+     *      Remote memory address of the first byte
+     *
+     * @param buffer
+     *      Buffer for the received data, its size defines the read length
+     *
+     * @param timeout
+     *      Timeout for each single segment
+     *
+     * @param retries
+     *      Number of times a failed segment is repeated
+     *
+     * @return
+     *      True if all segments have been read successfully. The buffer
+     *      content is undefined otherwise.
+     */
+    bool
+    readSegmented(RmapTargetNode& rmapTargetNode,
+                  uint32_t memoryAddress,
+                  outpost::Slice<uint8_t> buffer,
+                  outpost::time::Duration timeout = outpost::time::Seconds(1),
+                  uint8_t retries = rmap::defaultSegmentRetries);
+
+    /**
+     * Write a memory region of arbitrary size.
+     *
+     * Each segment requests a reply from the target to be able to detect
+     * and repeat failed segments.
+     *
+     * \see readSegmented
+     */
+    bool
+    writeSegmented(RmapTargetNode& rmapTargetNode,
+                   uint32_t memoryAddress,
+                   outpost::Slice<const uint8_t> data,
+                   outpost::time::Duration timeout = outpost::time::Seconds(1),
+                   uint8_t retries = rmap::defaultSegmentRetries);
+
+    /**
+     * Get the largest data length of a single transaction to the target.
+     *
+     * Limited by the maximum packet length of the SpaceWire interface and
+     * the maximum transaction length of the target node.
+     *
+     * @return
+     *      Maximum data length, zero if the SpaceWire packets are too
+     *      short to carry any data.
+     */
+    uint32_t
+    getMaximumSegmentLength(RmapTargetNode& rmapTargetNode);
+
     //--------------------------------------------------------------------------
     inline bool
     isReplyModeSet() const
@@ -413,6 +937,22 @@ public:
         mInitiatorLogicalAddress = initiatorLogicalAddress;
     }
 
+    /**
+     * Set the repetition of blocking reads and writes without reply,
+     * by default no command is repeated.
+     */
+    inline void
+    setRetryPolicy(const RetryPolicy& policy)
+    {
+        mRetryPolicy = policy;
+    }
+
+    inline RetryPolicy
+    getRetryPolicy() const
+    {
+        return mRetryPolicy;
+    }
+
     inline size_t
     getActiveTransactions()
     {
@@ -425,6 +965,24 @@ public:
         return mCounters;
     }
 
+    /**
+     * Statistics of the transactions per target node, keyed by
+     * RmapTargetNode::getId(). Snapshots can be taken from any thread
+     * without blocking the initiator.
+     */
+    inline const RmapStatistics&
+    getStatistics() const
+    {
+        return mStatistics;
+    }
+
+    void
+    resetStatistics();
+
+    /**
+     * Latest reply without matching transaction. Its data refers to the
+     * receive buffer of the reply, which has already been released.
+     */
     inline RmapPacket*
     getLatestDiscardedPacket() const
     {
@@ -459,28 +1017,280 @@ private:
     bool
     sendPacket(RmapTransaction* transaction, outpost::Slice<const uint8_t> data);
 
+    /**
+     * Receive and validate the next packet, the packet is interpreted
+     * in place.
+     *
+     * \retval true    Valid RMAP packet received. The packet view refers to
+     *                  rxBuffer, which has to be released by the caller
+     *                  once the packet has been processed.
+     * \retval false   No or invalid packet, no buffer is held.
+     */
     bool
-    receivePacket(RmapPacket* rxedPacket);
+    receivePacket(RmapPacketView& packet,
+                  hal::SpaceWire::ReceiveBuffer& rxBuffer,
+                  outpost::time::Duration timeout = receiveTimeout);
 
     void
-    replyPacketReceived(RmapPacket* packet);
+    replyPacketReceived(const RmapPacketView& packet);
 
     RmapTransaction*
-    resolveTransaction(RmapPacket* packet);
+    resolveTransaction(const RmapPacketView& packet);
+
+    /**
+     * Part of a segmented read or write.
+     */
+    struct Segment
+    {
+        RmapTransactionHandle mHandle;
+        uint32_t mOffset;
+        uint32_t mLength;
+        uint8_t mAttempts;
+    };
+
+    bool
+    transferSegmented(RmapTargetNode& rmapTargetNode,
+                      RmapPacket::InstructionField::Operation operation,
+                      uint32_t memoryAddress,
+                      outpost::Slice<uint8_t> readBuffer,
+                      outpost::Slice<const uint8_t> writeData,
+                      outpost::time::Duration timeout,
+                      uint8_t retries);
 
-    uint16_t
-    getNextAvailableTransactionID();
+    bool
+    startSegment(RmapTargetNode& rmapTargetNode,
+                 RmapPacket::InstructionField::Operation operation,
+                 uint32_t memoryAddress,
+                 outpost::Slice<uint8_t> readBuffer,
+                 outpost::Slice<const uint8_t> writeData,
+                 outpost::time::Duration timeout,
+                 Segment& segment);
+
+    /**
+     * Wait for the reply of a blocking transaction, evaluate it and free
+     * the transaction.
+     *
+     * @return
+     *      RmapTransactionHandle::success if the reply was received with
+     *      success and its data fitted into the reply buffer.
+     */
+    RmapTransactionHandle::Result
+    waitForCompletion(RmapTransaction* transaction, outpost::time::Duration timeout);
+
+    /**
+     * Check whether a blocking operation is repeated after a missing
+     * reply according to the retry policy.
+     *
+     * @param attempt
+     *      Number of the failed attempt, starting with zero
+     */
+    bool
+    shouldRetry(RmapTargetNode& rmapTargetNode,
+                RmapPacket::InstructionField::Operation operation,
+                uint8_t attempt);
+
+    /**
+     * Acquire a transaction slot, configure the command and send it.
+     *
+     * Read commands which carry data are sent as read-modify-write
+     * commands, the data then contains the data followed by the mask.
+     *
+     * @param dataRetained
+     *      True if the caller keeps the data valid until the transaction is
+     *      completed. Only then a write or read-modify-write can be sent
+     *      again on the redundant path after a link failure.
+     *
+     * @return
+     *      Transaction in state commandSent (initiated if no reply is
+     *      requested) or nullptr if the command could not be sent.
+     */
+    RmapTransaction*
+    initiateTransaction(RmapTargetNode& rmapTargetNode,
+                        RmapPacket::InstructionField::Operation operation,
+                        uint32_t memoryAddress,
+                        outpost::Slice<const uint8_t> data,
+                        outpost::Slice<uint8_t> replyBuffer,
+                        bool reply,
+                        const RmapCompletionCallback* callback,
+                        outpost::time::Duration timeout,
+                        bool dataRetained);
+
+    /**
+     * Configure the command of a new transaction and send it.
+     *
+     * Must be called with the operation lock held and a slot acquired from
+     * mFreeTransactions. The slot is handed back if the command could not
+     * be sent.
+     *
+     * \see initiateTransaction
+     */
+    RmapTransaction*
+    startTransaction(RmapTargetNode& rmapTargetNode,
+                     RmapPacket::InstructionField::Operation operation,
+                     uint32_t memoryAddress,
+                     outpost::Slice<const uint8_t> data,
+                     outpost::Slice<uint8_t> replyBuffer,
+                     bool reply,
+                     const RmapCompletionCallback* callback,
+                     outpost::time::Duration timeout,
+                     bool dataRetained);
+
+    /**
+     * Send as many items of a batch as transaction slots are available.
+     *
+     * @param waitTime
+     *      Time to wait for the first free slot
+     *
+     * @param timeout
+     *      Timeout of the transactions
+     *
+     * @return
+     *      Number of items which have been handled, including items which
+     *      could not be sent.
+     */
+    size_t
+    submitBatchItems(outpost::Slice<BatchItem> items,
+                     outpost::time::Duration waitTime,
+                     outpost::time::Duration timeout);
+
+    /**
+     * Free the transaction and hand its slot back to the pipeline.
+     */
+    void
+    finishTransaction(RmapTransaction* transaction);
+
+    bool
+    connectHandle(RmapTransaction* transaction, RmapTransactionHandle& handle);
+
+    /**
+     * Store the outcome of the transaction in the handle. Must be called
+     * with the operation lock held.
+     */
+    void
+    completeHandle(RmapTransaction* transaction, RmapTransactionHandle& handle);
+
+    /**
+     * Check that the transaction slot referenced by a pending handle still
+     * belongs to its transaction. Must be called with the operation lock
+     * held.
+     */
+    bool
+    isConnected(const RmapTransactionHandle& handle) const;
+
+    void
+    disconnectHandle(RmapTransactionHandle& handle);
+
+    bool
+    isExpired(RmapTransaction* transaction) const;
+
+    /**
+     * Mark a transaction waiting for its reply as expired. Must be called
+     * with the operation lock held.
+     */
+    void
+    expireTransaction(RmapTransaction* transaction);
+
+    /**
+     * Time until the earliest deadline of the pending transactions,
+     * limited to receiveTimeout.
+     */
+    outpost::time::Duration
+    getReceiveTimeout();
+
+    /**
+     * Time left of an operation started at the given time.
+     */
+    outpost::time::Duration
+    getRemainingTime(outpost::time::SpacecraftElapsedTime start,
+                     outpost::time::Duration timeout) const;
+
+    /**
+     * Complete all transactions whose reply did not arrive before their
+     * deadline. Only the pending transactions with the earliest deadlines
+     * are checked.
+     */
+    void
+    expireTransactions();
+
+    /**
+     * Expire the transaction and either wake up the waiting thread or hand
+     * the transaction back. Must be called with the operation lock held.
+     *
+     * \param state
+     *      Final state of the transaction, RmapTransaction::timeout or
+     *      RmapTransaction::linkFailed.
+     *
+     * \return
+     *      True if the transaction has been freed, its callback has to be
+     *      executed and mFreeTransactions released without the lock held.
+     */
+    bool
+    abortTransaction(RmapTransaction* transaction,
+                     RmapTransaction::State state,
+                     RmapTransactionHandle& handle,
+                     RmapCompletionCallback& callback);
+
+    inline bool
+    isLinkUsable(uint8_t link)
+    {
+        return (link < mNumberOfLinks) && mLinks[link]->isUp();
+    }
+
+    /**
+     * Select the path for a command to the target. Must be called with the
+     * operation lock held.
+     */
+    uint8_t
+    selectPath(RmapTargetNode& rmapTargetNode);
+
+    /**
+     * Number of transactions on the link which wait for their reply.
+     */
+    uint8_t
+    getPendingOnLink(uint8_t link);
+
+    /**
+     * Detect links which went down and move their pending transactions.
+     */
+    void
+    checkLinks();
+
+    /**
+     * Send the pending transactions of a failed link on the redundant
+     * path of their targets, abort those which cannot be sent again.
+     */
+    void
+    failLink(uint8_t link);
+
+    /**
+     * Remove the transaction from the list. Must be called with the
+     * operation lock held, the slot has to be handed back to the pipeline
+     * afterwards by releasing mFreeTransactions.
+     */
+    void
+    freeTransaction(RmapTransaction* transaction);
 
     //--------------------------------------------------------------------------
     hal::SpaceWire& mSpW;
+    hal::SpaceWire* mLinks[rmap::maxLinks];
+    uint8_t mNumberOfLinks;
+
+    /// Link state seen by the last checkLinks()
+    bool mLinkUp[rmap::maxLinks];
     RmapTargetsList* mTargetNodes;
+    outpost::rtos::SystemClock mClock;
     outpost::rtos::Mutex mOperationLock;
+
+    /// Counts the free transaction slots, limits the pipeline depth
+    outpost::rtos::Semaphore mFreeTransactions;
     uint8_t mInitiatorLogicalAddress;
     bool mIncrementMode;
     bool mVerifyMode;
     bool mReplyMode;
     bool mStopped;
-    uint16_t mTransactionId;
+
+    /// Replies are received through a SpaceWireDispatcher
+    bool mDispatched;
     TransactionsList mTransactionsList;
 
     /**
@@ -488,12 +1298,15 @@ private:
      * found with valid transaction ID for the received packet. It is made
      * available for the user in case its needed for being inspected. Discarded
      * packet will be invalidated as soon as there is new incoming packet at the
-     * reception node.
+     * reception node. Only the header fields are available, the data of the
+     * packet refers to an already released receive buffer.
      * */
     RmapPacket* mDiscardedPacket;
+    RmapPacket mLastDiscardedPacket;
 
     ErrorCounters mCounters;
-    Buffer mRxData;
+    RmapStatistics mStatistics;
+    RetryPolicy mRetryPolicy;
 
     const outpost::support::parameter::HeartbeatSource mHeartbeatSource;
 };
@@ -17,32 +17,60 @@
 #include "rmap_packet.h"
 #include "rmap_status.h"
 
+#include <outpost/comm/log.h>
+
 using namespace outpost::comm;
 
+constexpr uint8_t RmapHeaderTemplate::maxLength;
+constexpr uint8_t RmapHeaderTemplate::numberOfInstructionVariants;
+constexpr uint8_t RmapHeaderTemplate::fixedInstructionMask;
+
 //------------------------------------------------------------------------------
-RmapTargetNode::RmapTargetNode() :
+RmapHeaderTemplate::RmapHeaderTemplate() :
+    mPrefix(),
+    mLength(0),
+    mInstructionOffset(0),
+    mFixedInstructionBits(0),
+    mPartialCrc(),
+    mValid(false)
+{
+}
+
+//------------------------------------------------------------------------------
+constexpr uint8_t RmapTargetNode::primaryPath;
+constexpr uint8_t RmapTargetNode::redundantPath;
+
+RmapTargetNode::Path::Path() :
+    mLink(0),
     mTargetSpaceWireAddressLength(0),
     mTargetSpaceWireAddress(),
     mReplyAddressLength(0),
     mReplyAddress(),
+    mHeaderTemplate()
+{
+}
+
+RmapTargetNode::RmapTargetNode() :
+    mPaths(),
+    mHasRedundantPath(false),
     mTargetLogicalAddress(rmap::defaultLogicalAddress),
     mKey(0),
-    mId(0)
+    mId(0),
+    mMaximumTransactionLength(0)
 {
     strcpy(mName, "Default");
-    memset(mTargetSpaceWireAddress, 0, sizeof(mTargetSpaceWireAddress));
-    memset(mReplyAddress, 0, sizeof(mReplyAddress));
 }
 
 RmapTargetNode::RmapTargetNode(const char* name,
                                uint8_t id,
                                uint8_t targetLogicalAddress,
                                uint8_t key) :
-    mTargetSpaceWireAddressLength(0),
-    mReplyAddressLength(0),
+    mPaths(),
+    mHasRedundantPath(false),
     mTargetLogicalAddress(targetLogicalAddress),
     mKey(key),
-    mId(id)
+    mId(id),
+    mMaximumTransactionLength(0)
 {
     if (strlen(name) < rmap::maxNodeNameLength)
     {
@@ -52,9 +80,6 @@ RmapTargetNode::RmapTargetNode(const char* name,
     {
         strcpy(mName, "Default");
     }
-
-    memset(mTargetSpaceWireAddress, 0, sizeof(mTargetSpaceWireAddress));
-    memset(mReplyAddress, 0, sizeof(mReplyAddress));
 }
 
 RmapTargetNode::~RmapTargetNode()
@@ -63,32 +88,78 @@ RmapTargetNode::~RmapTargetNode()
 
 bool
 RmapTargetNode::setReplyAddress(outpost::Slice<uint8_t> replyAddress)
+{
+    return setReplyAddress(primaryPath, replyAddress);
+}
+
+bool
+RmapTargetNode::setTargetSpaceWireAddress(outpost::Slice<uint8_t> targetSpaceWireAddress)
+{
+    return setTargetSpaceWireAddress(primaryPath, targetSpaceWireAddress);
+}
+
+bool
+RmapTargetNode::setReplyAddress(uint8_t path, outpost::Slice<uint8_t> replyAddress)
 {
     bool result = false;
-    if (replyAddress.getNumberOfElements() <= sizeof(mReplyAddress))
+    if ((path < rmap::maxPaths)
+        && (replyAddress.getNumberOfElements() <= sizeof(mPaths[path].mReplyAddress)))
     {
-        memcpy(mReplyAddress, replyAddress.begin(), replyAddress.getNumberOfElements());
-        mReplyAddressLength = replyAddress.getNumberOfElements();
+        memcpy(mPaths[path].mReplyAddress,
+               replyAddress.begin(),
+               replyAddress.getNumberOfElements());
+        mPaths[path].mReplyAddressLength = replyAddress.getNumberOfElements();
+        mPaths[path].mHeaderTemplate.invalidate();
         result = true;
     }
     return result;
 }
 
 bool
-RmapTargetNode::setTargetSpaceWireAddress(outpost::Slice<uint8_t> targetSpaceWireAddress)
+RmapTargetNode::setTargetSpaceWireAddress(uint8_t path,
+                                          outpost::Slice<uint8_t> targetSpaceWireAddress)
 {
     bool result = false;
-    if (targetSpaceWireAddress.getNumberOfElements() <= sizeof(mTargetSpaceWireAddress))
+    if ((path < rmap::maxPaths)
+        && (targetSpaceWireAddress.getNumberOfElements()
+            <= sizeof(mPaths[path].mTargetSpaceWireAddress)))
     {
-        memcpy(mTargetSpaceWireAddress,
+        memcpy(mPaths[path].mTargetSpaceWireAddress,
                targetSpaceWireAddress.begin(),
                targetSpaceWireAddress.getNumberOfElements());
-        mTargetSpaceWireAddressLength = targetSpaceWireAddress.getNumberOfElements();
+        mPaths[path].mTargetSpaceWireAddressLength = targetSpaceWireAddress.getNumberOfElements();
+        mPaths[path].mHeaderTemplate.invalidate();
         result = true;
     }
     return result;
 }
 
+bool
+RmapTargetNode::setRedundantPath(uint8_t link,
+                                 outpost::Slice<uint8_t> targetSpaceWireAddress,
+                                 outpost::Slice<uint8_t> replyAddress)
+{
+    if (!setTargetSpaceWireAddress(redundantPath, targetSpaceWireAddress)
+        || !setReplyAddress(redundantPath, replyAddress))
+    {
+        return false;
+    }
+    mPaths[redundantPath].mLink = link;
+    mHasRedundantPath = true;
+    return true;
+}
+
+const RmapHeaderTemplate&
+RmapTargetNode::getHeaderTemplate(uint8_t path)
+{
+    RmapHeaderTemplate& headerTemplate = mPaths[path].mHeaderTemplate;
+    if (!headerTemplate.isValid())
+    {
+        RmapPacket::buildHeaderTemplate(*this, path, headerTemplate);
+    }
+    return headerTemplate;
+}
+
 //------------------------------------------------------------------------------
 RmapTargetsList::RmapTargetsList() : mNodes(), mSize(0)
 {
@@ -114,6 +185,12 @@ RmapTargetsList::addTargetNode(RmapTargetNode* node)
 
     if (mSize < rmap::maxAddressLength)
     {
+        // Prepare the command headers while the node is registered
+        node->getHeaderTemplate(RmapTargetNode::primaryPath);
+        if (node->hasRedundantPath())
+        {
+            node->getHeaderTemplate(RmapTargetNode::redundantPath);
+        }
         mNodes[mSize++] = node;
         result = true;
     }
@@ -170,7 +247,7 @@ RmapTargetsList::getTargetNode(uint8_t logicalAddress)
 
     if (!rt)
     {
-        console_out("Error: No such RMAP target node\n");
+        OUTPOST_COMM_LOG_WARNING(unknownTargetNode, logicalAddress, 0);
     }
 
     return rt;
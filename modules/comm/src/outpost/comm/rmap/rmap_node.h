@@ -26,16 +26,105 @@ namespace outpost
 {
 namespace comm
 {
+/**
+ * Pre-serialized constant part of the RMAP command header of a target.
+ *
+ * Holds the bytes from the target SpaceWire address up to and including
+ * the reply address. The instruction field is patched for each command.
+ * For every combination of the operation, verify, reply and increment
+ * bits the CRC over these bytes is precalculated, so only the remaining
+ * header fields have to be processed for a command.
+ *
+ * Built by RmapPacket::buildHeaderTemplate().
+ */
+class RmapHeaderTemplate
+{
+    friend class RmapPacket;
+
+public:
+    /// SpaceWire address, logical address, protocol ID, instruction, key
+    /// and reply address
+    static constexpr uint8_t maxLength = rmap::maxAddressLength + 4 + rmap::maxAddressLength;
+
+    /// Number of combinations of the variable instruction bits
+    static constexpr uint8_t numberOfInstructionVariants = 16;
+
+    RmapHeaderTemplate();
+
+    inline bool
+    isValid() const
+    {
+        return mValid;
+    }
+
+    inline void
+    invalidate()
+    {
+        mValid = false;
+    }
+
+    inline outpost::Slice<const uint8_t>
+    getPrefix() const
+    {
+        return outpost::Slice<const uint8_t>::unsafe(mPrefix, mLength);
+    }
+
+    inline uint8_t
+    getInstructionOffset() const
+    {
+        return mInstructionOffset;
+    }
+
+    /**
+     * Check that the template can be used for the given instruction, i.e.
+     * the packet type and the reply address length match.
+     */
+    inline bool
+    matches(uint8_t instruction) const
+    {
+        return mValid && ((instruction & fixedInstructionMask) == mFixedInstructionBits);
+    }
+
+    /**
+     * CRC over the template with the given instruction field, continued
+     * with the remaining header fields.
+     */
+    inline uint8_t
+    getPartialCrc(uint8_t instruction) const
+    {
+        return mPartialCrc[(instruction >> 2) & (numberOfInstructionVariants - 1)];
+    }
+
+private:
+    /// Packet type and reply address length bits of the instruction
+    static constexpr uint8_t fixedInstructionMask = 0xC3;
+
+    uint8_t mPrefix[maxLength];
+    uint8_t mLength;
+    uint8_t mInstructionOffset;
+    uint8_t mFixedInstructionBits;
+    uint8_t mPartialCrc[numberOfInstructionVariants];
+    bool mValid;
+};
+
 /**
  * RMAP target node.
  *
  * Provides the RMAP object level information for the listed RMAP targets.
  *
+ * A target can be reached on a primary and optionally on a redundant path.
+ * Each path consists of the SpaceWire link of the initiator, the target
+ * SpaceWire address and the reply address. The addresses set without a
+ * path refer to the primary path, which uses link 0 by default.
+ *
  * \author  Muhammad Bassam
  */
 class RmapTargetNode
 {
 public:
+    static constexpr uint8_t primaryPath = 0;
+    static constexpr uint8_t redundantPath = 1;
+
     RmapTargetNode();
     RmapTargetNode(const char* name, uint8_t id, uint8_t targetLogicalAddress, uint8_t key);
     ~RmapTargetNode();
@@ -66,6 +155,51 @@ public:
     bool
     setTargetSpaceWireAddress(outpost::Slice<uint8_t> targetSpaceWireAddress);
 
+    bool
+    setReplyAddress(uint8_t path, outpost::Slice<uint8_t> replyAddress);
+
+    bool
+    setTargetSpaceWireAddress(uint8_t path, outpost::Slice<uint8_t> targetSpaceWireAddress);
+
+    /**
+     * Configure the redundant path to the target.
+     *
+     * \param link
+     *      Index of the link of the initiator used for this path
+     * \param targetSpaceWireAddress
+     *      SpaceWire address of the target on this path
+     * \param replyAddress
+     *      Reply address for commands sent on this path
+     *
+     * \return
+     *      True for successful, false for wrong size parameter
+     */
+    bool
+    setRedundantPath(uint8_t link,
+                     outpost::Slice<uint8_t> targetSpaceWireAddress,
+                     outpost::Slice<uint8_t> replyAddress);
+
+    /**
+     * Set the link of the initiator used for the given path.
+     */
+    inline void
+    setLink(uint8_t path, uint8_t link)
+    {
+        mPaths[path].mLink = link;
+    }
+
+    inline uint8_t
+    getLink(uint8_t path) const
+    {
+        return mPaths[path].mLink;
+    }
+
+    inline bool
+    hasRedundantPath() const
+    {
+        return mHasRedundantPath;
+    }
+
     //--------------------------------------------------------------------------
     inline uint8_t
     getKey() const
@@ -74,9 +208,10 @@ public:
     }
 
     inline outpost::Slice<uint8_t>
-    getReplyAddress()
+    getReplyAddress(uint8_t path = primaryPath)
     {
-        return outpost::Slice<uint8_t>::unsafe(mReplyAddress, mReplyAddressLength);
+        return outpost::Slice<uint8_t>::unsafe(mPaths[path].mReplyAddress,
+                                               mPaths[path].mReplyAddressLength);
     }
 
     inline uint8_t
@@ -86,24 +221,35 @@ public:
     }
 
     inline outpost::Slice<uint8_t>
-    getTargetSpaceWireAddress()
+    getTargetSpaceWireAddress(uint8_t path = primaryPath)
     {
-        return outpost::Slice<uint8_t>::unsafe(mTargetSpaceWireAddress,
-                                               mTargetSpaceWireAddressLength);
+        return outpost::Slice<uint8_t>::unsafe(mPaths[path].mTargetSpaceWireAddress,
+                                               mPaths[path].mTargetSpaceWireAddressLength);
     }
 
     inline void
     setKey(uint8_t defaultKey)
     {
         mKey = defaultKey;
+        invalidateHeaderTemplates();
     }
 
     inline void
     setTargetLogicalAddress(uint8_t targetLogicalAddress)
     {
         mTargetLogicalAddress = targetLogicalAddress;
+        invalidateHeaderTemplates();
     }
 
+    /**
+     * Get the header template for commands to this target on the given path.
+     *
+     * The template is rebuilt if the addressing information of the node
+     * has been changed since it was last used.
+     */
+    const RmapHeaderTemplate&
+    getHeaderTemplate(uint8_t path = primaryPath);
+
     inline const char*
     getName() const
     {
@@ -116,17 +262,55 @@ public:
         return mId;
     }
 
+    /**
+     * Limit the data length of a single transaction to this target.
+     *
+     * Used to split segmented reads and writes. Zero (the default) means
+     * that transactions are only limited by the SpaceWire packet length.
+     */
+    inline void
+    setMaximumTransactionLength(uint32_t length)
+    {
+        mMaximumTransactionLength = length;
+    }
+
+    inline uint32_t
+    getMaximumTransactionLength() const
+    {
+        return mMaximumTransactionLength;
+    }
+
 private:
-    // TODO Replace with bounded array
-    uint8_t mTargetSpaceWireAddressLength;
-    uint8_t mTargetSpaceWireAddress[rmap::maxAddressLength];
-    // TODO Replace with bounded array
-    uint8_t mReplyAddressLength;
-    uint8_t mReplyAddress[rmap::maxAddressLength];
+    struct Path
+    {
+        Path();
+
+        uint8_t mLink;
+        // TODO Replace with bounded array
+        uint8_t mTargetSpaceWireAddressLength;
+        uint8_t mTargetSpaceWireAddress[rmap::maxAddressLength];
+        // TODO Replace with bounded array
+        uint8_t mReplyAddressLength;
+        uint8_t mReplyAddress[rmap::maxAddressLength];
+        RmapHeaderTemplate mHeaderTemplate;
+    };
+
+    inline void
+    invalidateHeaderTemplates()
+    {
+        for (uint8_t i = 0; i < rmap::maxPaths; i++)
+        {
+            mPaths[i].mHeaderTemplate.invalidate();
+        }
+    }
+
+    Path mPaths[rmap::maxPaths];
+    bool mHasRedundantPath;
     uint8_t mTargetLogicalAddress;
     uint8_t mKey;
     char mName[rmap::maxNodeNameLength];
     uint8_t mId;
+    uint32_t mMaximumTransactionLength;
 };
 
 //------------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 
 #include "rmap_packet.h"
 
+#include <outpost/comm/log.h>
 #include <outpost/utils/coding/crc.h>
 
 using namespace outpost::comm;
@@ -32,7 +33,8 @@ RmapPacket::RmapPacket() :
     mHeaderLength(0),
     mData(0),
     mHeaderCRC(0),
-    mDataCRC(0)
+    mDataCRC(0),
+    mHeaderTemplate(nullptr)
 
 {
     memset(mSpwTargets, 0, sizeof(mSpwTargets));
@@ -60,7 +62,8 @@ RmapPacket::RmapPacket(outpost::Slice<uint8_t> spwTargets,
     mHeaderLength(0),
     mData(0),
     mHeaderCRC(0),
-    mDataCRC(0)
+    mDataCRC(0),
+    mHeaderTemplate(nullptr)
 
 {
     if (spwTargets.getNumberOfElements() <= sizeof(mSpwTargets))
@@ -91,7 +94,8 @@ RmapPacket::RmapPacket(uint8_t targetLogicalAddress,
     mHeaderLength(0),
     mData(0),
     mHeaderCRC(0),
-    mDataCRC(0)
+    mDataCRC(0),
+    mHeaderTemplate(nullptr)
 {
     memset(mSpwTargets, 0, sizeof(mSpwTargets));
     memset(mReplyAddress, 0, sizeof(mReplyAddress));
@@ -120,13 +124,12 @@ RmapPacket::constructPacket(outpost::Slice<uint8_t> buffer, outpost::Slice<const
     if ((buffer.getNumberOfElements() - 4)
         < static_cast<size_t>(stream.getPosition() + mDataLength))
     {
-        console_out("RMAP-Packet: Trying to send larger packet than available buffer "
-                    "space\n");
+        OUTPOST_COMM_LOG_ERROR(packetTooLarge, stream.getPosition(), mDataLength);
         return false;
     }
 
-    // Append data and CRC only if packet is write command
-    if (isWrite())
+    // Append data and CRC only if packet is write or read-modify-write command
+    if (isWrite() || isReadModifyWrite())
     {
         mDataCRC = outpost::Crc8CcittReversed::calculate(data);
         mData = const_cast<uint8_t*>(data.begin());
@@ -138,12 +141,32 @@ RmapPacket::constructPacket(outpost::Slice<uint8_t> buffer, outpost::Slice<const
     return true;
 }
 
+size_t
+RmapPacket::constructHeader(outpost::Slice<uint8_t> buffer, outpost::Slice<const uint8_t> data)
+{
+    if (buffer.getNumberOfElements() < rmap::maxCommandHeaderLength)
+    {
+        OUTPOST_COMM_LOG_ERROR(packetTooLarge, buffer.getNumberOfElements(), 0);
+        return 0;
+    }
+
+    outpost::Serialize stream(buffer);
+    constructHeader(stream);
+
+    if (isWrite() || isReadModifyWrite())
+    {
+        mDataCRC = outpost::Crc8CcittReversed::calculate(data);
+        mData = const_cast<uint8_t*>(data.begin());
+    }
+    return stream.getPosition();
+}
+
 bool
 RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiatorLogicalAddress)
 {
     if (data.getNumberOfElements() < rmap::minimumReplySize)
     {
-        console_out("RMAP-Packet: packet size less then minimum\n");
+        OUTPOST_COMM_LOG_WARNING(packetTooShort, data.getNumberOfElements(), 0);
         return false;
     }
 
@@ -180,7 +203,7 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
 
     if (initiatoraLogicalAddress != initiatorLogicalAddress)
     {
-        console_out("RMAP-Packet: Initiator logical address doesn't match\n");
+        OUTPOST_COMM_LOG_WARNING(invalidLogicalAddress, initiatoraLogicalAddress, 0);
         return false;
     }
 
@@ -188,7 +211,7 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
 
     if (protocolIdentifiter != rmap::protocolIdentifier)
     {
-        console_out("RMAP-Packet: Protocol ID is not RMAP\n");
+        OUTPOST_COMM_LOG_INFO(invalidProtocolIdentifier, protocolIdentifiter, 0);
         return false;
     }
 
@@ -217,7 +240,7 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
 
             if (calculatedHeaderCRC != packetHeaderCRC)
             {
-                console_out("RMAP-Packet: invalid packet header CRC\n");
+                OUTPOST_COMM_LOG_WARNING(headerCrcError, mTransactionIdentifier, 0);
                 return false;
             }
             mHeaderCRC = packetHeaderCRC;
@@ -241,7 +264,7 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
 
             if (calculatedHeaderCRC != packetHeaderCRC)
             {
-                console_out("RMAP-Packet: Invalid packet header CRC\n");
+                OUTPOST_COMM_LOG_WARNING(headerCrcError, mTransactionIdentifier, 0);
                 return false;
             }
             mHeaderCRC = packetHeaderCRC;
@@ -252,7 +275,8 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
             if (static_cast<size_t>(stream.getPosition() + mDataLength + 1)
                 != data.getNumberOfElements())
             {
-                console_out("RMAP-Packet: data length mismatch\n");
+                OUTPOST_COMM_LOG_WARNING(
+                        dataLengthMismatch, mTransactionIdentifier, mDataLength);
                 return false;
             }
 
@@ -265,7 +289,7 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
                     outpost::Slice<uint8_t>::unsafe(dataStartPointer, mDataLength));
             if (packetDataCRC != calculatedDataCRC)
             {
-                console_out("RMAP-Packet: Invalid packet data CRC\n");
+                OUTPOST_COMM_LOG_WARNING(dataCrcError, mTransactionIdentifier, mDataLength);
                 return false;
             }
             mDataCRC = packetDataCRC;
@@ -277,19 +301,59 @@ RmapPacket::extractPacket(outpost::Slice<const uint8_t>& data, uint8_t initiator
 }
 
 void
-RmapPacket::setTargetInformation(RmapTargetNode& rmapTargetNode)
+RmapPacket::setTargetInformation(RmapTargetNode& rmapTargetNode, uint8_t path)
+{
+    copyTargetInformation(rmapTargetNode, path);
+    mHeaderTemplate = &rmapTargetNode.getHeaderTemplate(path);
+}
+
+void
+RmapPacket::buildHeaderTemplate(RmapTargetNode& rmapTargetNode,
+                                uint8_t path,
+                                RmapHeaderTemplate& headerTemplate)
+{
+    RmapPacket packet;
+    packet.setCommand();
+    packet.copyTargetInformation(rmapTargetNode, path);
+
+    outpost::Serialize stream(outpost::asSlice(headerTemplate.mPrefix));
+    packet.constructHeaderPrefix(stream);
+
+    // Limited by the size of the prefix buffer
+    headerTemplate.mLength = static_cast<uint8_t>(stream.getPosition());
+    headerTemplate.mInstructionOffset = packet.mNumOfSpwTargets + 2;
+    headerTemplate.mFixedInstructionBits =
+            packet.mInstruction.getRaw() & RmapHeaderTemplate::fixedInstructionMask;
+
+    // The CRC starts after the target SpaceWire address
+    for (uint8_t variant = 0; variant < RmapHeaderTemplate::numberOfInstructionVariants;
+         variant++)
+    {
+        headerTemplate.mPrefix[headerTemplate.mInstructionOffset] =
+                headerTemplate.mFixedInstructionBits | (variant << 2);
+
+        headerTemplate.mPartialCrc[variant] = outpost::Crc8CcittReversed::calculate(
+                outpost::Slice<const uint8_t>::unsafe(
+                        headerTemplate.mPrefix + packet.mNumOfSpwTargets,
+                        headerTemplate.mLength - packet.mNumOfSpwTargets));
+    }
+    headerTemplate.mValid = true;
+}
+
+void
+RmapPacket::copyTargetInformation(RmapTargetNode& rmapTargetNode, uint8_t path)
 {
     // Set packet target logical address field according to the RMAP target node
     mTargetLogicalAddress = rmapTargetNode.getTargetLogicalAddress();
 
     // Set packet reply address field according to the RMAP target node
-    outpost::Slice<uint8_t> rplyAddr = rmapTargetNode.getReplyAddress();
+    outpost::Slice<uint8_t> rplyAddr = rmapTargetNode.getReplyAddress(path);
     memcpy(mReplyAddress, &rplyAddr[0], rplyAddr.getNumberOfElements());
     mInstruction.setReplyAddressLength(
             static_cast<InstructionField::ReplyAddressLength>(rplyAddr.getNumberOfElements() / 4));
 
     // Set packet target path SpW address field according to the RMAP target node
-    setTargetSpaceWireAddress(rmapTargetNode.getTargetSpaceWireAddress());
+    setTargetSpaceWireAddress(rmapTargetNode.getTargetSpaceWireAddress(path));
 
     // Set packet key field according to the RMAP target node
     setKey(rmapTargetNode.getKey());
@@ -316,6 +380,7 @@ RmapPacket::operator=(const RmapPacket& rhs)
 
     mHeaderCRC = rhs.mHeaderCRC;
     mDataCRC = rhs.mDataCRC;
+    mHeaderTemplate = rhs.mHeaderTemplate;
     return *this;
 }
 
@@ -323,26 +388,39 @@ RmapPacket::operator=(const RmapPacket& rhs)
 void
 RmapPacket::constructHeader(outpost::Serialize& stream)
 {
-    // Only handling command packets
-    if (isCommandPacket())
+    if (isCommandPacket() && mHeaderTemplate && mHeaderTemplate->matches(mInstruction.getRaw()))
     {
-        for (uint8_t i = 0; i < mNumOfSpwTargets; i++)
-        {
-            stream.store<uint8_t>(mSpwTargets[i]);
-        }
+        // Copy the constant part of the header and patch the instruction
+        ptrdiff_t start = stream.getPosition();
+        stream.store(mHeaderTemplate->getPrefix());
+        stream.getPointer()[start + mHeaderTemplate->getInstructionOffset()] =
+                mInstruction.getRaw();
+
+        ptrdiff_t variableStart = stream.getPosition();
+        stream.store<uint8_t>(mInitiatorLogicalAddress);
+        stream.store<uint16_t>(mTransactionIdentifier);
+        stream.store<uint8_t>(mExtendedAddress);
+        stream.store<uint32_t>(mAddress);
+        stream.store24(mDataLength);
 
-        stream.store<uint8_t>(mTargetLogicalAddress);
-        stream.store<uint8_t>(rmap::protocolIdentifier);
-        stream.store<uint8_t>(mInstruction.getRaw());
-        stream.store<uint8_t>(mDestKey);
-        if (mInstruction.getReplyAddressLength() > InstructionField::zeroBytes)
+        // Continue the CRC of the template over the variable fields only
+        outpost::Crc8CcittReversed crc(mHeaderTemplate->getPartialCrc(mInstruction.getRaw()));
+        for (ptrdiff_t i = variableStart; i < stream.getPosition(); i++)
         {
-            for (size_t i = 0; i < mInstruction.getReplyAddressLength(); i++)
-            {
-                stream.store<uint32_t>(mReplyAddress[i]);
-            }
+            crc.update(stream.getPointer()[i]);
         }
 
+        mHeaderLength = static_cast<uint32_t>(stream.getPosition());
+        mHeaderCRC = crc.getValue();
+        stream.store<uint8_t>(mHeaderCRC);
+        return;
+    }
+
+    // Only handling command packets
+    if (isCommandPacket())
+    {
+        constructHeaderPrefix(stream);
+
         stream.store<uint8_t>(mInitiatorLogicalAddress);
         stream.store<uint16_t>(mTransactionIdentifier);
         stream.store<uint8_t>(mExtendedAddress);
@@ -356,3 +434,24 @@ RmapPacket::constructHeader(outpost::Serialize& stream)
             stream.getPointer() + mNumOfSpwTargets, stream.getPosition() - mNumOfSpwTargets));
     stream.store<uint8_t>(mHeaderCRC);
 }
+
+void
+RmapPacket::constructHeaderPrefix(outpost::Serialize& stream)
+{
+    for (uint8_t i = 0; i < mNumOfSpwTargets; i++)
+    {
+        stream.store<uint8_t>(mSpwTargets[i]);
+    }
+
+    stream.store<uint8_t>(mTargetLogicalAddress);
+    stream.store<uint8_t>(rmap::protocolIdentifier);
+    stream.store<uint8_t>(mInstruction.getRaw());
+    stream.store<uint8_t>(mDestKey);
+    if (mInstruction.getReplyAddressLength() > InstructionField::zeroBytes)
+    {
+        for (size_t i = 0; i < mInstruction.getReplyAddressLength(); i++)
+        {
+            stream.store<uint32_t>(mReplyAddress[i]);
+        }
+    }
+}
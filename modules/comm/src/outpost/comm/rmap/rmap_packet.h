@@ -242,9 +242,10 @@ public:
      *      SpW buffer provided by the RMAP initiator
      *
      * \param data
-     *      Reference to the user data for write commands, for read commands
-     *      this object will be outpost::Slice<uint8_t>::empty() and will
-     *      be ignored
+     *      Reference to the user data for write commands, data followed by
+     *      the mask for read-modify-write commands. For read commands this
+     *      object will be outpost::Slice<uint8_t>::empty() and will be
+     *      ignored
      *
      * \return
      *      True for successful integration of packet into the buffer, false for
@@ -254,6 +255,27 @@ public:
     bool
     constructPacket(outpost::Slice<uint8_t> buffer, outpost::Slice<const uint8_t>& data);
 
+    /**
+     * Construct only the header of a command packet.
+     *
+     * Used to transmit the data directly from the memory of the caller
+     * instead of copying it behind the header. The data CRC is calculated
+     * and available through getDataCRC() afterwards.
+     *
+     * \param buffer
+     *      Buffer for the header, should provide rmap::maxCommandHeaderLength
+     *      bytes.
+     * \param data
+     *      User data for write commands, data followed by the mask for
+     *      read-modify-write commands.
+     *
+     * \return
+     *      Length of the header including the header CRC, zero if the
+     *      buffer is too small.
+     */
+    size_t
+    constructHeader(outpost::Slice<uint8_t> buffer, outpost::Slice<const uint8_t> data);
+
     /**
      * Extract the received RMAP packet according to the given standard by
      * checking it's content and verifying particular CRC's for packet data
@@ -280,9 +302,32 @@ public:
      * \param rmapTargetNode
      *      Reference to the RMAP target node
      *
+     * \param path
+     *      Path on which the target is addressed
+     *
      * */
     void
-    setTargetInformation(RmapTargetNode& rmapTargetNode);
+    setTargetInformation(RmapTargetNode& rmapTargetNode,
+                         uint8_t path = RmapTargetNode::primaryPath);
+
+    /**
+     * Serialize the constant part of the command header for the given
+     * target and path into the template and precalculate its CRC.
+     *
+     * \param rmapTargetNode
+     *      Reference to the RMAP target node
+     *
+     * \param path
+     *      Path on which the target is addressed
+     *
+     * \param headerTemplate
+     *      Template to be filled
+     *
+     * */
+    static void
+    buildHeaderTemplate(RmapTargetNode& rmapTargetNode,
+                        uint8_t path,
+                        RmapHeaderTemplate& headerTemplate);
 
     RmapPacket&
     operator=(const RmapPacket& rhs);
@@ -298,6 +343,7 @@ public:
                targetSpaceWireAddress.begin(),
                targetSpaceWireAddress.getNumberOfElements());
         mNumOfSpwTargets = targetSpaceWireAddress.getNumberOfElements();
+        mHeaderTemplate = nullptr;
     }
 
     inline outpost::Slice<uint8_t>
@@ -317,6 +363,7 @@ public:
     setReplyPathAddressLength(InstructionField::ReplyAddressLength pathAddressLength)
     {
         mInstruction.setReplyAddressLength(pathAddressLength);
+        mHeaderTemplate = nullptr;
     }
 
     inline uint8_t
@@ -329,6 +376,7 @@ public:
     setTargetLogicalAddress(uint8_t targetLogicalAddress)
     {
         mTargetLogicalAddress = targetLogicalAddress;
+        mHeaderTemplate = nullptr;
     }
 
     inline uint8_t
@@ -403,6 +451,25 @@ public:
         mInstruction.setOperation(InstructionField::read);
     }
 
+    /**
+     * Read-modify-write is a read command with the verify flag set. Reply
+     * and increment flags are mandatory for this command.
+     */
+    inline bool
+    isReadModifyWrite()
+    {
+        return isRead() && mInstruction.isVerifyEnabled();
+    }
+
+    inline void
+    setReadModifyWrite()
+    {
+        mInstruction.setOperation(InstructionField::read);
+        mInstruction.enableVerify();
+        mInstruction.enableReply();
+        mInstruction.enableIncrement();
+    }
+
     inline bool
     isVerifyFlagSet()
     {
@@ -509,6 +576,7 @@ public:
     setKey(uint8_t key)
     {
         mDestKey = key;
+        mHeaderTemplate = nullptr;
     }
 
     inline uint8_t
@@ -564,6 +632,19 @@ private:
     void
     constructHeader(outpost::Serialize& stream);
 
+    /**
+     * Serialize the header fields from the target SpaceWire address up to
+     * and including the reply address.
+     */
+    void
+    constructHeaderPrefix(outpost::Serialize& stream);
+
+    /**
+     * Copy the target information without using its header template.
+     */
+    void
+    copyTargetInformation(RmapTargetNode& rmapTargetNode, uint8_t path);
+
     //--------------------------------------------------------------------------
     uint8_t mNumOfSpwTargets;
     uint8_t mSpwTargets[rmap::maxPhysicalRouterOutputPorts];
@@ -582,6 +663,9 @@ private:
 
     uint8_t mHeaderCRC;
     uint8_t mDataCRC;
+
+    /// Header template of the target, used if it matches the instruction
+    const RmapHeaderTemplate* mHeaderTemplate;
 };
 }  // namespace comm
 }  // namespace outpost
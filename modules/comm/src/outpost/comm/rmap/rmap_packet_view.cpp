@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "rmap_packet_view.h"
+
+#include <outpost/comm/log.h>
+#include <outpost/utils/coding/crc.h>
+
+using namespace outpost::comm;
+
+constexpr size_t RmapPacketView::readReplyHeaderLength;
+constexpr size_t RmapPacketView::writeReplyHeaderLength;
+constexpr uint8_t RmapPacketView::writeFlag;
+
+RmapPacketView::RmapPacketView() :
+    mPacket(outpost::Slice<const uint8_t>::empty()),
+    mPathAddress(outpost::Slice<const uint8_t>::empty()),
+    mHeader(outpost::Slice<const uint8_t>::empty()),
+    mData(outpost::Slice<const uint8_t>::empty()),
+    mValid(false)
+{
+}
+
+RmapPacketView::RmapPacketView(outpost::Slice<const uint8_t> data) :
+    mPacket(data),
+    mPathAddress(outpost::Slice<const uint8_t>::empty()),
+    mHeader(outpost::Slice<const uint8_t>::empty()),
+    mData(outpost::Slice<const uint8_t>::empty()),
+    mValid(false)
+{
+}
+
+bool
+RmapPacketView::validate(uint8_t initiatorLogicalAddress)
+{
+    mValid = false;
+    mData = outpost::Slice<const uint8_t>::empty();
+
+    size_t length = mPacket.getNumberOfElements();
+    if (length < rmap::minimumReplySize)
+    {
+        OUTPOST_COMM_LOG_WARNING(packetTooShort, length, 0);
+        return false;
+    }
+
+    // SpaceWire path addresses are below 32
+    size_t pathLength = 0;
+    while ((pathLength < rmap::maxPhysicalRouterOutputPorts) && (pathLength < length)
+           && (mPacket[pathLength] != initiatorLogicalAddress) && (mPacket[pathLength] < 32))
+    {
+        pathLength++;
+    }
+    mPathAddress = mPacket.first(pathLength);
+    mHeader = mPacket.skipFirst(pathLength);
+
+    if ((mHeader.getNumberOfElements() < 3) || (mHeader[0] != initiatorLogicalAddress))
+    {
+        OUTPOST_COMM_LOG_WARNING(invalidLogicalAddress,
+                                 mHeader.getNumberOfElements() > 0 ? mHeader[0] : 0,
+                                 0);
+        return false;
+    }
+
+    if (mHeader[1] != rmap::protocolIdentifier)
+    {
+        OUTPOST_COMM_LOG_INFO(invalidProtocolIdentifier, mHeader[1], 0);
+        return false;
+    }
+
+    if (!isReplyPacket())
+    {
+        // Only the packet type is of interest for other packets
+        mValid = true;
+        return true;
+    }
+
+    size_t headerLength = isWrite() ? writeReplyHeaderLength : readReplyHeaderLength;
+    if (mHeader.getNumberOfElements() < headerLength + 1)
+    {
+        OUTPOST_COMM_LOG_WARNING(packetTooShort, length, 0);
+        return false;
+    }
+
+    if (outpost::Crc8CcittReversed::calculate(mHeader.first(headerLength))
+        != mHeader[headerLength])
+    {
+        OUTPOST_COMM_LOG_WARNING(headerCrcError, getTransactionID(), 0);
+        return false;
+    }
+
+    if (isRead())
+    {
+        uint32_t dataLength = outpost::Deserialize(mHeader).peek24(8);
+        if (mHeader.getNumberOfElements() != headerLength + 1 + dataLength + 1)
+        {
+            OUTPOST_COMM_LOG_WARNING(dataLengthMismatch, getTransactionID(), dataLength);
+            return false;
+        }
+
+        outpost::Slice<const uint8_t> data = mHeader.subSlice(headerLength + 1, dataLength);
+        if (outpost::Crc8CcittReversed::calculate(data) != mHeader[headerLength + 1 + dataLength])
+        {
+            OUTPOST_COMM_LOG_WARNING(dataCrcError, getTransactionID(), dataLength);
+            return false;
+        }
+        mData = data;
+    }
+
+    mValid = true;
+    return true;
+}
+
+bool
+RmapPacketView::toPacket(RmapPacket& packet) const
+{
+    if (!mValid)
+    {
+        return false;
+    }
+
+    outpost::Slice<const uint8_t> header = mHeader;
+    packet.reset();
+    return packet.extractPacket(header, getInitiatorLogicalAddress());
+}
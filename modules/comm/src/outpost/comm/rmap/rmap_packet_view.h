@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_COMM_RMAP_PACKET_VIEW_H_
+#define OUTPOST_COMM_RMAP_PACKET_VIEW_H_
+
+#include "rmap_packet.h"
+
+#include <outpost/base/slice.h>
+#include <outpost/utils/storage/serialize.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace outpost
+{
+namespace comm
+{
+/**
+ * Received RMAP packet interpreted in place.
+ *
+ * The view refers to the received bytes, no field is copied. validate()
+ * checks the packet with a single pass over the header and data for the
+ * CRCs, afterwards the header fields are loaded from the buffer when they
+ * are accessed. A RmapPacket is only filled if required by toPacket().
+ *
+ * The view is only valid as long as the receive buffer is not released.
+ */
+class RmapPacketView
+{
+public:
+    /// Header of a read reply without the header CRC
+    static constexpr size_t readReplyHeaderLength = 11;
+
+    /// Header of a write reply without the header CRC
+    static constexpr size_t writeReplyHeaderLength = 7;
+
+    RmapPacketView();
+
+    explicit RmapPacketView(outpost::Slice<const uint8_t> data);
+
+    /**
+     * Check the packet.
+     *
+     * Leading SpaceWire path address bytes are skipped. Checks the
+     * initiator logical address and the protocol identifier. For replies
+     * additionally the header CRC, and for read replies the data length and
+     * the data CRC are checked. Command packets are not checked further.
+     *
+     * \return
+     *      True if the fields of the packet can be accessed.
+     */
+    bool
+    validate(uint8_t initiatorLogicalAddress);
+
+    inline bool
+    isValid() const
+    {
+        return mValid;
+    }
+
+    /**
+     * Path address bytes in front of the RMAP header.
+     */
+    inline outpost::Slice<const uint8_t>
+    getPathAddress() const
+    {
+        return mPathAddress;
+    }
+
+    inline uint8_t
+    getInitiatorLogicalAddress() const
+    {
+        return mHeader[0];
+    }
+
+    inline uint8_t
+    getInstruction() const
+    {
+        return mHeader[2];
+    }
+
+    inline bool
+    isReplyPacket() const
+    {
+        return (getInstruction() >> 6) == RmapPacket::InstructionField::replyPacket;
+    }
+
+    inline bool
+    isWrite() const
+    {
+        return (getInstruction() & writeFlag) != 0;
+    }
+
+    inline bool
+    isRead() const
+    {
+        return !isWrite();
+    }
+
+    inline uint8_t
+    getStatus() const
+    {
+        return mHeader[3];
+    }
+
+    inline uint8_t
+    getTargetLogicalAddress() const
+    {
+        return mHeader[4];
+    }
+
+    inline uint16_t
+    getTransactionID() const
+    {
+        return outpost::Deserialize(mHeader).peek<uint16_t>(5);
+    }
+
+    /**
+     * \return
+     *      Data length of a read reply, zero for write replies.
+     */
+    inline uint32_t
+    getDataLength() const
+    {
+        // Taken from the 24 bit data length field of the reply
+        return static_cast<uint32_t>(mData.getNumberOfElements());
+    }
+
+    /**
+     * Data of a read reply, refers to the receive buffer.
+     */
+    inline outpost::Slice<const uint8_t>
+    getData() const
+    {
+        return mData;
+    }
+
+    /**
+     * Fill a packet object from a validated reply. Only required if the
+     * packet has to be kept beyond the lifetime of the view, the data still
+     * refers to the receive buffer. Path address bytes are not copied.
+     *
+     * \return
+     *      False if the view has not been validated.
+     */
+    bool
+    toPacket(RmapPacket& packet) const;
+
+private:
+    static constexpr uint8_t writeFlag = 0x20;
+
+    outpost::Slice<const uint8_t> mPacket;
+    outpost::Slice<const uint8_t> mPathAddress;
+    outpost::Slice<const uint8_t> mHeader;
+    outpost::Slice<const uint8_t> mData;
+    bool mValid;
+};
+
+}  // namespace comm
+}  // namespace outpost
+
+#endif
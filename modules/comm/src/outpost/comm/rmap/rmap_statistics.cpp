@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "rmap_statistics.h"
+
+#include "rmap_status.h"
+
+using namespace outpost::comm;
+
+RmapTargetStatistics::RmapTargetStatistics() :
+    mTargetId(0),
+    mCommands(0),
+    mReplies(0),
+    mFailedReplies(0),
+    mCrcErrors(0),
+    mTimeouts(0),
+    mRetries(0),
+    mBytesWritten(0),
+    mBytesRead(0),
+    mInFlight(0),
+    mMaxInFlight(0),
+    mMaxQueueingDelay(outpost::time::Duration::zero()),
+    mLatency()
+{
+}
+
+//-----------------------------------------------------------------------------
+RmapStatistics::RmapStatistics() :
+    mSequence(0), mTargets(), mNumberOfTargets(0), mUntrackedEvents(0)
+{
+}
+
+void
+RmapStatistics::commandSent(uint8_t targetId, uint32_t bytesWritten, bool replyExpected)
+{
+    RmapTargetStatistics* target = beginUpdate(targetId);
+    if (target)
+    {
+        target->mCommands++;
+        target->mBytesWritten += bytesWritten;
+        if (replyExpected)
+        {
+            target->mInFlight++;
+            if (target->mInFlight > target->mMaxInFlight)
+            {
+                target->mMaxInFlight = target->mInFlight;
+            }
+        }
+        endUpdate();
+    }
+}
+
+void
+RmapStatistics::slotAcquired(uint8_t targetId, outpost::time::Duration queueingDelay)
+{
+    RmapTargetStatistics* target = beginUpdate(targetId);
+    if (target)
+    {
+        if (queueingDelay > target->mMaxQueueingDelay)
+        {
+            target->mMaxQueueingDelay = queueingDelay;
+        }
+        endUpdate();
+    }
+}
+
+void
+RmapStatistics::replyReceived(uint8_t targetId,
+                              outpost::time::Duration latency,
+                              uint8_t status,
+                              uint32_t bytesRead)
+{
+    RmapTargetStatistics* target = beginUpdate(targetId);
+    if (target)
+    {
+        target->mReplies++;
+        target->mInFlight--;
+        target->mLatency[getLatencyBin(latency)]++;
+
+        if (status == RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            target->mBytesRead += bytesRead;
+        }
+        else
+        {
+            target->mFailedReplies++;
+            if (status == RmapReplyStatus::invalidDataCrc)
+            {
+                target->mCrcErrors++;
+            }
+        }
+        endUpdate();
+    }
+}
+
+void
+RmapStatistics::transactionExpired(uint8_t targetId)
+{
+    RmapTargetStatistics* target = beginUpdate(targetId);
+    if (target)
+    {
+        target->mTimeouts++;
+        target->mInFlight--;
+        endUpdate();
+    }
+}
+
+void
+RmapStatistics::transactionCancelled(uint8_t targetId)
+{
+    RmapTargetStatistics* target = beginUpdate(targetId);
+    if (target)
+    {
+        target->mInFlight--;
+        endUpdate();
+    }
+}
+
+void
+RmapStatistics::commandRepeated(uint8_t targetId)
+{
+    RmapTargetStatistics* target = beginUpdate(targetId);
+    if (target)
+    {
+        target->mRetries++;
+        endUpdate();
+    }
+}
+
+void
+RmapStatistics::reset()
+{
+    uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+    mSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint8_t i = 0; i < mNumberOfTargets; i++)
+    {
+        // Transactions in flight are still completed afterwards
+        uint8_t targetId = mTargets[i].mTargetId;
+        uint8_t inFlight = mTargets[i].mInFlight;
+        mTargets[i] = RmapTargetStatistics();
+        mTargets[i].mTargetId = targetId;
+        mTargets[i].mInFlight = inFlight;
+        mTargets[i].mMaxInFlight = inFlight;
+    }
+    mUntrackedEvents = 0;
+
+    mSequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool
+RmapStatistics::getSnapshot(uint8_t targetId, RmapTargetStatistics& statistics) const
+{
+    bool found;
+    uint32_t sequence;
+    do
+    {
+        found = false;
+        sequence = mSequence.load(std::memory_order_acquire);
+        if ((sequence & 1) == 0)
+        {
+            for (uint8_t i = 0; (i < mNumberOfTargets) && (i < rmap::maxStatisticsTargets); i++)
+            {
+                if (mTargets[i].mTargetId == targetId)
+                {
+                    statistics = mTargets[i];
+                    found = true;
+                    break;
+                }
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (((sequence & 1) != 0) || (mSequence.load(std::memory_order_relaxed) != sequence));
+
+    return found;
+}
+
+uint8_t
+RmapStatistics::getNumberOfTargets() const
+{
+    return mNumberOfTargets;
+}
+
+bool
+RmapStatistics::getSnapshotByIndex(uint8_t index, RmapTargetStatistics& statistics) const
+{
+    bool found;
+    uint32_t sequence;
+    do
+    {
+        found = false;
+        sequence = mSequence.load(std::memory_order_acquire);
+        if (((sequence & 1) == 0) && (index < mNumberOfTargets)
+            && (index < rmap::maxStatisticsTargets))
+        {
+            statistics = mTargets[index];
+            found = true;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (((sequence & 1) != 0) || (mSequence.load(std::memory_order_relaxed) != sequence));
+
+    return found;
+}
+
+uint8_t
+RmapStatistics::getLatencyBin(outpost::time::Duration latency)
+{
+    int64_t microseconds = latency.microseconds();
+    uint8_t bin = 0;
+    while ((microseconds > 1) && (bin < (rmap::latencyHistogramBins - 1)))
+    {
+        microseconds >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+RmapTargetStatistics*
+RmapStatistics::findTarget(uint8_t targetId)
+{
+    for (uint8_t i = 0; i < mNumberOfTargets; i++)
+    {
+        if (mTargets[i].mTargetId == targetId)
+        {
+            return &mTargets[i];
+        }
+    }
+    return nullptr;
+}
+
+RmapTargetStatistics*
+RmapStatistics::beginUpdate(uint8_t targetId)
+{
+    RmapTargetStatistics* target = findTarget(targetId);
+    if (!target && (mNumberOfTargets >= rmap::maxStatisticsTargets))
+    {
+        mUntrackedEvents++;
+        return nullptr;
+    }
+
+    uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+    mSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (!target)
+    {
+        target = &mTargets[mNumberOfTargets];
+        *target = RmapTargetStatistics();
+        target->mTargetId = targetId;
+        mNumberOfTargets++;
+    }
+    return target;
+}
+
+void
+RmapStatistics::endUpdate()
+{
+    mSequence.store(mSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_COMM_RMAP_STATISTICS_H_
+#define OUTPOST_COMM_RMAP_STATISTICS_H_
+
+#include "rmap_common.h"
+
+#include <outpost/time/duration.h>
+
+#include <atomic>
+#include <stdint.h>
+
+namespace outpost
+{
+namespace comm
+{
+/**
+ * Statistics of the transactions to a single RMAP target node.
+ */
+struct RmapTargetStatistics
+{
+    RmapTargetStatistics();
+
+    /// ID of the target node, see RmapTargetNode::getId()
+    uint8_t mTargetId;
+
+    /// Transactions started for the target. Commands repeated after a
+    /// missing reply start a new transaction and are included. Commands
+    /// moved to the redundant path after a link failure keep their
+    /// transaction and are only counted in mRetries.
+    uint32_t mCommands;
+
+    /// Replies received before the deadline of their transaction
+    uint32_t mReplies;
+
+    /// Replies with a status other than commandExecutedSuccessfully
+    uint32_t mFailedReplies;
+
+    /// Replies with the status invalidDataCrc, i.e. commands corrupted on
+    /// the way to the target
+    uint32_t mCrcErrors;
+
+    /// Transactions without reply before their deadline
+    uint32_t mTimeouts;
+
+    /// Commands sent again after a missing reply or on the redundant path
+    /// after a link failure
+    uint32_t mRetries;
+
+    uint64_t mBytesWritten;
+    uint64_t mBytesRead;
+
+    /// Transactions currently waiting for a reply and the largest number
+    /// observed since the last reset
+    uint8_t mInFlight;
+    uint8_t mMaxInFlight;
+
+    /// Longest time a caller waited for a free transaction slot
+    outpost::time::Duration mMaxQueueingDelay;
+
+    /// Round-trip latency from sending the command to receiving the reply,
+    /// see rmap::latencyHistogramBins
+    uint32_t mLatency[rmap::latencyHistogramBins];
+};
+
+/**
+ * Per-target statistics of a RMAP initiator.
+ *
+ * The statistics are updated by a single writer, the RMAP initiator calls
+ * all update functions with its operation lock held. Readers get a
+ * consistent snapshot without taking this lock: every update increments a
+ * sequence counter before and after modifying the statistics, a reader
+ * repeats the copy if the counter changed meanwhile.
+ *
+ * Targets are registered on their first transaction. Events of targets
+ * which do not fit into the table are only counted in
+ * getUntrackedEvents().
+ */
+class RmapStatistics
+{
+public:
+    RmapStatistics();
+
+    void
+    commandSent(uint8_t targetId, uint32_t bytesWritten, bool replyExpected);
+
+    /**
+     * Time the caller had to wait for a free transaction slot.
+     */
+    void
+    slotAcquired(uint8_t targetId, outpost::time::Duration queueingDelay);
+
+    void
+    replyReceived(uint8_t targetId,
+                  outpost::time::Duration latency,
+                  uint8_t status,
+                  uint32_t bytesRead);
+
+    /**
+     * Transaction without reply before its deadline.
+     */
+    void
+    transactionExpired(uint8_t targetId);
+
+    /**
+     * Transaction abandoned by the caller while waiting for its reply.
+     */
+    void
+    transactionCancelled(uint8_t targetId);
+
+    void
+    commandRepeated(uint8_t targetId);
+
+    void
+    reset();
+
+    /**
+     * Get a consistent copy of the statistics of a target.
+     *
+     * \return
+     *      False if no transaction to the target has been recorded.
+     */
+    bool
+    getSnapshot(uint8_t targetId, RmapTargetStatistics& statistics) const;
+
+    /**
+     * \return
+     *      Number of targets in the table, the statistics can be accessed
+     *      with getSnapshotByIndex().
+     */
+    uint8_t
+    getNumberOfTargets() const;
+
+    bool
+    getSnapshotByIndex(uint8_t index, RmapTargetStatistics& statistics) const;
+
+    inline uint32_t
+    getUntrackedEvents() const
+    {
+        return mUntrackedEvents;
+    }
+
+    /**
+     * Bin of the latency histogram for the given latency.
+     */
+    static uint8_t
+    getLatencyBin(outpost::time::Duration latency);
+
+private:
+    RmapTargetStatistics*
+    findTarget(uint8_t targetId);
+
+    /**
+     * Start an update of the target statistics, registers the target
+     * if required.
+     *
+     * \return
+     *      Statistics of the target, nullptr if the table is full. Must be
+     *      followed by endUpdate() if not nullptr.
+     */
+    RmapTargetStatistics*
+    beginUpdate(uint8_t targetId);
+
+    void
+    endUpdate();
+
+    std::atomic<uint32_t> mSequence;
+    RmapTargetStatistics mTargets[rmap::maxStatisticsTargets];
+    uint8_t mNumberOfTargets;
+    uint32_t mUntrackedEvents;
+};
+
+}  // namespace comm
+}  // namespace outpost
+
+#endif
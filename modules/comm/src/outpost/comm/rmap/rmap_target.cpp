@@ -0,0 +1,569 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "rmap_target.h"
+
+#include <outpost/comm/log.h>
+#include <outpost/utils/coding/crc.h>
+#include <outpost/utils/storage/serialize.h>
+
+#include <string.h>
+
+using namespace outpost::comm;
+
+constexpr outpost::time::Duration RmapTarget::receiveTimeout;
+constexpr outpost::time::Duration RmapTarget::transmitTimeout;
+
+namespace
+{
+// Bits of the instruction field (see ECSS-E-ST-50-52C pg. 27)
+static constexpr uint8_t instructionReserved = 0x80;
+static constexpr uint8_t instructionCommand = 0x40;
+static constexpr uint8_t instructionWrite = 0x20;
+static constexpr uint8_t instructionVerify = 0x10;
+static constexpr uint8_t instructionReply = 0x08;
+static constexpr uint8_t instructionIncrement = 0x04;
+static constexpr uint8_t instructionReplyAddressLength = 0x03;
+
+// Command code of a read-modify-write command (read, verify, reply and
+// increment bits set)
+static constexpr uint8_t readModifyWriteCommand = instructionVerify | instructionReply
+                                                  | instructionIncrement;
+static constexpr uint8_t commandCodeMask = instructionWrite | readModifyWriteCommand;
+
+// Command header without the reply address, including the header CRC
+static constexpr size_t commandHeaderLength = 16;
+
+// Read reply header including the header CRC
+static constexpr size_t readReplyHeaderLength = 12;
+
+static bool
+isValidCommandCode(uint8_t instruction)
+{
+    uint8_t code = instruction & commandCodeMask;
+    if (code & instructionWrite)
+    {
+        return true;
+    }
+    // Reads require a reply, a read with verify flag is only valid as
+    // read-modify-write
+    return (code == instructionReply) || (code == (instructionReply | instructionIncrement))
+           || (code == readModifyWriteCommand);
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+RmapMemoryRegion::RmapMemoryRegion(uint32_t address,
+                                   outpost::Slice<uint8_t> memory,
+                                   uint8_t access,
+                                   uint8_t extendedAddress) :
+    mAddress(address),
+    mLength(static_cast<uint32_t>(memory.getNumberOfElements())),
+    mMemory(memory.begin()),
+    mHandler(nullptr),
+    mAccess(access),
+    mExtendedAddress(extendedAddress)
+{
+}
+
+RmapMemoryRegion::RmapMemoryRegion(uint32_t address,
+                                   uint32_t length,
+                                   RmapMemoryHandler& handler,
+                                   uint8_t access,
+                                   uint8_t extendedAddress) :
+    mAddress(address),
+    mLength(length),
+    mMemory(nullptr),
+    mHandler(&handler),
+    mAccess(access),
+    mExtendedAddress(extendedAddress)
+{
+}
+
+bool
+RmapMemoryRegion::contains(uint8_t extendedAddress, uint32_t address, uint32_t length) const
+{
+    if (extendedAddress != mExtendedAddress || address < mAddress)
+    {
+        return false;
+    }
+
+    // Written to avoid an overflow at the end of the address space
+    uint32_t offset = address - mAddress;
+    return (offset <= mLength) && (length <= (mLength - offset));
+}
+
+uint8_t
+RmapMemoryRegion::readData(uint32_t address, outpost::Slice<uint8_t> data, bool increment)
+{
+    if (mHandler)
+    {
+        return mHandler->read(address, data, increment);
+    }
+    else if (!increment)
+    {
+        return RmapReplyStatus::rmapCommandNotImplemented;
+    }
+
+    memcpy(data.begin(), &mMemory[address - mAddress], data.getNumberOfElements());
+    return RmapReplyStatus::commandExecutedSuccessfully;
+}
+
+uint8_t
+RmapMemoryRegion::writeData(uint32_t address, outpost::Slice<const uint8_t> data, bool increment)
+{
+    if (mHandler)
+    {
+        return mHandler->write(address, data, increment);
+    }
+    else if (!increment)
+    {
+        return RmapReplyStatus::rmapCommandNotImplemented;
+    }
+
+    memcpy(&mMemory[address - mAddress], data.begin(), data.getNumberOfElements());
+    return RmapReplyStatus::commandExecutedSuccessfully;
+}
+
+//-----------------------------------------------------------------------------
+RmapTarget::RmapTarget(hal::SpaceWire& spw,
+                       uint8_t logicalAddress,
+                       uint8_t key,
+                       uint8_t priority,
+                       size_t stackSize,
+                       outpost::support::parameter::HeartbeatSource heartbeatSource) :
+    outpost::rtos::Thread(priority, stackSize, "RMTG"),
+    mSpW(spw),
+    mLogicalAddress(logicalAddress),
+    mKey(key),
+    mRegions(),
+    mNumberOfRegions(0),
+    mDispatched(false),
+    mCommandQueue(),
+    mCounters(),
+    mHeartbeatSource(heartbeatSource)
+{
+}
+
+RmapTarget::~RmapTarget()
+{
+}
+
+bool
+RmapTarget::addMemoryRegion(RmapMemoryRegion* region)
+{
+    if (mNumberOfRegions >= rmap::maxMemoryRegions)
+    {
+        OUTPOST_COMM_LOG_ERROR(regionTableFull, 0, 0);
+        return false;
+    }
+
+    mRegions[mNumberOfRegions] = region;
+    mNumberOfRegions++;
+    return true;
+}
+
+bool
+RmapTarget::attachTo(SpaceWireDispatcher& dispatcher)
+{
+    if (!dispatcher.addHandler(rmap::protocolIdentifier, mLogicalAddress, *this))
+    {
+        return false;
+    }
+    mDispatched = true;
+    return true;
+}
+
+bool
+RmapTarget::handlePacket(const outpost::utils::SharedChildPointer& packet)
+{
+    return mCommandQueue.handlePacket(packet);
+}
+
+size_t
+RmapTarget::processCommands(outpost::time::Duration timeout)
+{
+    size_t received = 0;
+
+    if (mDispatched)
+    {
+        // The dispatcher only forwards packets terminated with an EOP
+        outpost::utils::SharedBufferPointer packet;
+        while ((received < rmap::maxCommandsPerBatch) && mCommandQueue.receive(packet, timeout))
+        {
+            received++;
+            handlePacket(packet, hal::SpaceWire::eop);
+            packet = outpost::utils::SharedBufferPointer();
+            timeout = outpost::time::Duration::zero();
+        }
+        return received;
+    }
+
+    hal::SpaceWire::ReceiveBuffer rxBuffer;
+
+    // Only the first packet is waited for, afterwards everything which is
+    // already queued is handled without blocking again
+    while ((received < rmap::maxCommandsPerBatch)
+           && (mSpW.receive(rxBuffer, timeout) == hal::SpaceWire::Result::success))
+    {
+        received++;
+        handlePacket(rxBuffer.getData(), rxBuffer.getEndMarker());
+
+        // The written data has been copied to its destination and the reply
+        // is sent, the packet must not be accessed afterwards
+        mSpW.releaseBuffer(rxBuffer);
+        timeout = outpost::time::Duration::zero();
+    }
+    return received;
+}
+
+void
+RmapTarget::run()
+{
+    // Runs until the thread is destroyed, like the thread of the
+    // SpaceWireDispatcher
+    while (1)
+    {
+        outpost::support::Heartbeat::send(mHeartbeatSource, receiveTimeout * 2);
+        processCommands(receiveTimeout);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+RmapTarget::handlePacket(outpost::Slice<const uint8_t> packet, hal::SpaceWire::EndMarker end)
+{
+    // Skip path address bytes not removed by the routers
+    size_t start = 0;
+    while ((start < packet.getNumberOfElements()) && (packet[start] < 32)
+           && (start < rmap::maxPhysicalRouterOutputPorts))
+    {
+        start++;
+    }
+    packet = packet.skipFirst(start);
+
+    if (packet.getNumberOfElements() < commandHeaderLength || packet[1] != rmap::protocolIdentifier
+        || (packet[2] & instructionCommand) == 0)
+    {
+        // Not a RMAP command, e.g. a reply for a local initiator
+        mCounters.mDiscardedPackets++;
+        return;
+    }
+
+    Command command;
+    command.mInstruction = packet[2];
+
+    size_t replyAddressLength = 4 * (command.mInstruction & instructionReplyAddressLength);
+    size_t headerLength = commandHeaderLength + replyAddressLength;
+    if (packet.getNumberOfElements() < headerLength)
+    {
+        mCounters.mDiscardedPackets++;
+        return;
+    }
+
+    if (outpost::Crc8CcittReversed::calculate(packet.first(headerLength - 1))
+        != packet[headerLength - 1])
+    {
+        // The header can not be trusted, therefore no reply is possible
+        OUTPOST_COMM_LOG_WARNING(commandHeaderCrcError, packet.getNumberOfElements(), 0);
+        mCounters.mHeaderCrcErrors++;
+        return;
+    }
+
+    outpost::Deserialize stream(packet);
+    command.mTargetLogicalAddress = stream.read<uint8_t>();
+    stream.skip(2);
+    command.mKey = stream.read<uint8_t>();
+
+    // Leading zeros of the reply address are not part of the path
+    outpost::Slice<const uint8_t> replyAddress = packet.subSlice(4, replyAddressLength);
+    size_t zeros = 0;
+    while ((zeros < replyAddressLength) && (replyAddress[zeros] == 0))
+    {
+        zeros++;
+    }
+    command.mReplyAddress = replyAddress.skipFirst(zeros);
+    stream.skip(replyAddressLength);
+
+    command.mInitiatorLogicalAddress = stream.read<uint8_t>();
+    command.mTransactionId = stream.read<uint16_t>();
+    command.mExtendedAddress = stream.read<uint8_t>();
+    command.mAddress = stream.read<uint32_t>();
+    command.mDataLength = stream.readUnsigned24();
+
+    RmapMemoryRegion* region = nullptr;
+    uint8_t status = validateCommand(command, packet, headerLength, end, region);
+    if (status == RmapReplyStatus::commandExecutedSuccessfully
+        && (command.mInstruction & (instructionWrite | instructionVerify)))
+    {
+        command.mData = packet.subSlice(headerLength, command.mDataLength);
+    }
+
+    executeCommand(command, status, region);
+}
+
+uint8_t
+RmapTarget::validateCommand(const Command& command,
+                            outpost::Slice<const uint8_t> packet,
+                            size_t headerLength,
+                            hal::SpaceWire::EndMarker end,
+                            RmapMemoryRegion*& region)
+{
+    if ((command.mInstruction & instructionReserved) || !isValidCommandCode(command.mInstruction))
+    {
+        return RmapReplyStatus::unusedRmapPacketType;
+    }
+
+    if (command.mTargetLogicalAddress != mLogicalAddress)
+    {
+        return RmapReplyStatus::invalidTargetLogicalAddress;
+    }
+
+    if (command.mKey != mKey)
+    {
+        return RmapReplyStatus::invalidKey;
+    }
+
+    bool isWrite = (command.mInstruction & instructionWrite) != 0;
+    bool isReadModifyWrite =
+            !isWrite && ((command.mInstruction & commandCodeMask) == readModifyWriteCommand);
+
+    // Length of the data in the memory
+    uint32_t accessLength = command.mDataLength;
+    if (isWrite || isReadModifyWrite)
+    {
+        if (isReadModifyWrite
+            && ((command.mDataLength > 2 * rmap::maxReadModifyWriteLength)
+                || (command.mDataLength & 1)))
+        {
+            return RmapReplyStatus::rmwDataLengthError;
+        }
+
+        // Data and data CRC
+        size_t expectedLength = headerLength + command.mDataLength + 1;
+        if (packet.getNumberOfElements() < expectedLength)
+        {
+            return (end == hal::SpaceWire::eep) ? static_cast<uint8_t>(RmapReplyStatus::eep)
+                                                : static_cast<uint8_t>(RmapReplyStatus::earlyEOP);
+        }
+        if (packet.getNumberOfElements() > expectedLength)
+        {
+            return RmapReplyStatus::tooMuchData;
+        }
+        if (end == hal::SpaceWire::eep)
+        {
+            return RmapReplyStatus::eep;
+        }
+
+        outpost::Slice<const uint8_t> data = packet.subSlice(headerLength, command.mDataLength);
+        if (outpost::Crc8CcittReversed::calculate(data) != packet[expectedLength - 1])
+        {
+            return RmapReplyStatus::invalidDataCrc;
+        }
+
+        if (isReadModifyWrite)
+        {
+            // The data field contains the data followed by the mask
+            accessLength = command.mDataLength / 2;
+        }
+    }
+    else
+    {
+        if (end == hal::SpaceWire::eep)
+        {
+            return RmapReplyStatus::eep;
+        }
+        if (packet.getNumberOfElements() > headerLength)
+        {
+            return RmapReplyStatus::tooMuchData;
+        }
+
+        // Reply path, reply header, data and data CRC must fit into a
+        // single SpaceWire packet
+        if ((command.mReplyAddress.getNumberOfElements() + readReplyHeaderLength
+             + command.mDataLength + 1)
+            > mSpW.getMaximumPacketLength())
+        {
+            return RmapReplyStatus::generalErrorCode;
+        }
+    }
+
+    region = findRegion(command.mExtendedAddress, command.mAddress, accessLength);
+    if (region == nullptr)
+    {
+        return RmapReplyStatus::rmapCommandNotImplemented;
+    }
+
+    RmapMemoryRegion::Access access = RmapMemoryRegion::read;
+    if (isWrite)
+    {
+        access = RmapMemoryRegion::write;
+    }
+    else if (isReadModifyWrite)
+    {
+        access = RmapMemoryRegion::readModifyWrite;
+    }
+    if (!region->isAllowed(access))
+    {
+        return RmapReplyStatus::rmapCommandNotImplemented;
+    }
+
+    return RmapReplyStatus::commandExecutedSuccessfully;
+}
+
+void
+RmapTarget::executeCommand(const Command& command, uint8_t status, RmapMemoryRegion* region)
+{
+    bool isWrite = (command.mInstruction & instructionWrite) != 0;
+    bool increment = (command.mInstruction & instructionIncrement) != 0;
+    bool replyRequested = (command.mInstruction & instructionReply) != 0;
+
+    if (isWrite && status == RmapReplyStatus::commandExecutedSuccessfully)
+    {
+        status = region->writeData(command.mAddress, command.mData, increment);
+    }
+
+    if (!replyRequested)
+    {
+        if (status == RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            mCounters.mExecutedCommands++;
+        }
+        else
+        {
+            mCounters.mRejectedCommands++;
+        }
+        return;
+    }
+
+    hal::SpaceWire::TransmitBuffer* txBuffer = nullptr;
+    if (mSpW.requestBuffer(txBuffer, transmitTimeout) != hal::SpaceWire::Result::success)
+    {
+        OUTPOST_COMM_LOG_WARNING(replyNotSent, command.mTransactionId, status);
+        mCounters.mRepliesNotSent++;
+        if (isWrite)
+        {
+            // The command itself has been executed
+            if (status == RmapReplyStatus::commandExecutedSuccessfully)
+            {
+                mCounters.mExecutedCommands++;
+            }
+            else
+            {
+                mCounters.mRejectedCommands++;
+            }
+        }
+        else
+        {
+            // Neither reads nor read-modify-writes are executed without a reply
+            mCounters.mRejectedCommands++;
+        }
+        return;
+    }
+
+    outpost::Slice<uint8_t> buffer = txBuffer->getData();
+    outpost::Serialize stream(buffer);
+    stream.store(command.mReplyAddress);
+
+    size_t headerStart = stream.getPosition();
+    stream.store<uint8_t>(command.mInitiatorLogicalAddress);
+    stream.store<uint8_t>(rmap::protocolIdentifier);
+    stream.store<uint8_t>(command.mInstruction & ~(instructionCommand | instructionReserved));
+    size_t statusPosition = stream.getPosition();
+    stream.store<uint8_t>(status);
+    stream.store<uint8_t>(mLogicalAddress);
+    stream.store<uint16_t>(command.mTransactionId);
+
+    if (isWrite)
+    {
+        stream.store<uint8_t>(outpost::Crc8CcittReversed::calculate(
+                buffer.subSlice(headerStart, stream.getPosition() - headerStart)));
+    }
+    else
+    {
+        bool isReadModifyWrite = (command.mInstruction & commandCodeMask) == readModifyWriteCommand;
+        uint32_t length = isReadModifyWrite ? command.mDataLength / 2 : command.mDataLength;
+
+        // The transmit buffer may be smaller than the maximum packet
+        // length checked before, the reply header, data and data CRC
+        // have to fit
+        if ((headerStart + readReplyHeaderLength + length + 1) > buffer.getNumberOfElements())
+        {
+            status = RmapReplyStatus::generalErrorCode;
+        }
+
+        // Data is read directly behind the reply header
+        outpost::Slice<uint8_t> data = buffer.subSlice(
+                headerStart + readReplyHeaderLength,
+                (status == RmapReplyStatus::commandExecutedSuccessfully) ? length : 0);
+
+        if (status == RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            status = region->readData(command.mAddress, data, increment);
+        }
+
+        if (isReadModifyWrite && status == RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            uint8_t modified[rmap::maxReadModifyWriteLength];
+            for (size_t i = 0; i < length; i++)
+            {
+                uint8_t mask = command.mData[length + i];
+                modified[i] = (command.mData[i] & mask) | (data[i] & ~mask);
+            }
+            status = region->writeData(command.mAddress,
+                                       outpost::Slice<const uint8_t>::unsafe(modified, length),
+                                       increment);
+        }
+
+        if (status != RmapReplyStatus::commandExecutedSuccessfully)
+        {
+            data = data.first(0);
+            buffer[statusPosition] = status;
+        }
+
+        // Reserved byte
+        stream.store<uint8_t>(0);
+        stream.store24(static_cast<uint32_t>(data.getNumberOfElements()));
+        stream.store<uint8_t>(outpost::Crc8CcittReversed::calculate(
+                buffer.subSlice(headerStart, stream.getPosition() - headerStart)));
+
+        stream.skip(data.getNumberOfElements());
+        stream.store<uint8_t>(outpost::Crc8CcittReversed::calculate(data));
+    }
+
+    if (status == RmapReplyStatus::commandExecutedSuccessfully)
+    {
+        mCounters.mExecutedCommands++;
+    }
+    else
+    {
+        mCounters.mRejectedCommands++;
+    }
+
+    txBuffer->setLength(stream.getPosition());
+    txBuffer->setEndMarker(outpost::hal::SpaceWire::eop);
+    if (mSpW.send(txBuffer, transmitTimeout) != hal::SpaceWire::Result::success)
+    {
+        mCounters.mRepliesNotSent++;
+    }
+}
+
+RmapMemoryRegion*
+RmapTarget::findRegion(uint8_t extendedAddress, uint32_t address, uint32_t length)
+{
+    for (uint8_t i = 0; i < mNumberOfRegions; i++)
+    {
+        if (mRegions[i]->contains(extendedAddress, address, length))
+        {
+            return mRegions[i];
+        }
+    }
+    return nullptr;
+}
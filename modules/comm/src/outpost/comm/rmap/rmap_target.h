@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_COMM_RMAP_TARGET_H_
+#define OUTPOST_COMM_RMAP_TARGET_H_
+
+#include "rmap_common.h"
+#include "rmap_status.h"
+
+#include <outpost/base/slice.h>
+#include <outpost/comm/spacewire_dispatcher.h>
+#include <outpost/hal/spacewire.h>
+#include <outpost/rtos.h>
+#include <outpost/support/heartbeat.h>
+#include <outpost/time/duration.h>
+
+#include <stdint.h>
+
+namespace outpost
+{
+namespace comm
+{
+/**
+ * Memory accessed through callbacks.
+ *
+ * Used for memory regions of a RMAP target which can not be accessed
+ * directly, e.g. registers of a peripheral or FIFOs.
+ */
+class RmapMemoryHandler
+{
+public:
+    virtual ~RmapMemoryHandler() = default;
+
+    /**
+     * Read from the memory.
+     *
+     * \param address
+     *      Address of the first byte
+     * \param data
+     *      Buffer for the data, its size defines the number of bytes to read.
+     *      Points directly into the transmit buffer of the reply.
+     * \param increment
+     *      False if all bytes have to be read from the same address
+     *
+     * \return
+     *      RMAP status code, RmapReplyStatus::commandExecutedSuccessfully
+     *      if the data could be read.
+     */
+    virtual uint8_t
+    read(uint32_t address, outpost::Slice<uint8_t> data, bool increment) = 0;
+
+    /**
+     * Write to the memory.
+     *
+     * \param data
+     *      Data to write, points directly into the receive buffer
+     *      of the command.
+     *
+     * \return
+     *      RMAP status code
+     */
+    virtual uint8_t
+    write(uint32_t address, outpost::Slice<const uint8_t> data, bool increment) = 0;
+};
+
+/**
+ * Memory region served by a RMAP target.
+ *
+ * The region is either backed by memory which is accessed directly or by a
+ * RmapMemoryHandler. Directly accessed memory supports only incrementing
+ * accesses.
+ */
+class RmapMemoryRegion
+{
+public:
+    enum Access : uint8_t
+    {
+        read = 0x01,
+        write = 0x02,
+        readModifyWrite = 0x04,
+        readWrite = read | write,
+        all = read | write | readModifyWrite
+    };
+
+    RmapMemoryRegion(uint32_t address,
+                     outpost::Slice<uint8_t> memory,
+                     uint8_t access,
+                     uint8_t extendedAddress = rmap::defaultExtendedAddress);
+
+    RmapMemoryRegion(uint32_t address,
+                     uint32_t length,
+                     RmapMemoryHandler& handler,
+                     uint8_t access,
+                     uint8_t extendedAddress = rmap::defaultExtendedAddress);
+
+    /**
+     * Check whether an access is completely located inside of the region.
+     */
+    bool
+    contains(uint8_t extendedAddress, uint32_t address, uint32_t length) const;
+
+    inline bool
+    isAllowed(Access access) const
+    {
+        return (mAccess & access) != 0;
+    }
+
+    inline uint32_t
+    getAddress() const
+    {
+        return mAddress;
+    }
+
+    inline uint32_t
+    getLength() const
+    {
+        return mLength;
+    }
+
+    inline uint8_t
+    getExtendedAddress() const
+    {
+        return mExtendedAddress;
+    }
+
+    uint8_t
+    readData(uint32_t address, outpost::Slice<uint8_t> data, bool increment);
+
+    uint8_t
+    writeData(uint32_t address, outpost::Slice<const uint8_t> data, bool increment);
+
+private:
+    uint32_t mAddress;
+    uint32_t mLength;
+    uint8_t* mMemory;
+    RmapMemoryHandler* mHandler;
+    uint8_t mAccess;
+    uint8_t mExtendedAddress;
+};
+
+/**
+ * RMAP target.
+ *
+ * Receives RMAP commands from a SpaceWire link, executes them on the
+ * registered memory regions and sends the replies. Supports reads, writes
+ * with and without verification and read-modify-write commands (see
+ * ECSS-E-ST-50-52C).
+ *
+ * Commands are interpreted in place inside of the receive buffer, the data of
+ * a write command is copied directly from the receive buffer to its
+ * destination. Read data is copied directly from the memory region into the
+ * transmit buffer of the reply. After a wake-up all commands which are
+ * already available are processed before waiting again.
+ *
+ * The data of a write command is always checked before it is written, even
+ * for commands without the verify flag.
+ *
+ * If the link is shared with other protocols the target can be attached to a
+ * SpaceWireDispatcher. The dispatcher then queues the commands for the thread
+ * of the target, the replies are still sent directly on the link.
+ */
+class RmapTarget : public outpost::rtos::Thread, public SpaceWireProtocolHandler
+{
+    friend class TestingRmapTarget;
+
+    static constexpr outpost::time::Duration receiveTimeout = outpost::time::Milliseconds(100);
+    static constexpr outpost::time::Duration transmitTimeout = outpost::time::Milliseconds(10);
+
+public:
+    struct Counters
+    {
+        Counters() :
+            mExecutedCommands(0),
+            mRejectedCommands(0),
+            mDiscardedPackets(0),
+            mHeaderCrcErrors(0),
+            mRepliesNotSent(0)
+        {
+        }
+
+        /// Commands executed successfully
+        size_t mExecutedCommands;
+
+        /// Commands answered with an error status or dropped because of an
+        /// error which can only be reported in a reply
+        size_t mRejectedCommands;
+
+        /// Packets which are not RMAP commands or are truncated
+        size_t mDiscardedPackets;
+        size_t mHeaderCrcErrors;
+        size_t mRepliesNotSent;
+    };
+
+    RmapTarget(hal::SpaceWire& spw,
+               uint8_t logicalAddress,
+               uint8_t key,
+               uint8_t priority,
+               size_t stackSize,
+               outpost::support::parameter::HeartbeatSource heartbeatSource);
+
+    ~RmapTarget();
+
+    /**
+     * Register a memory region. The region must not be destroyed while the
+     * target is running.
+     *
+     * \return
+     *      True if the region was added, false if the table is full.
+     */
+    bool
+    addMemoryRegion(RmapMemoryRegion* region);
+
+    /**
+     * Receive the commands through a dispatcher instead of directly from the
+     * SpaceWire link.
+     *
+     * Registers the target for RMAP packets addressed to its logical
+     * address. Must be called before the target and the dispatcher are
+     * started.
+     *
+     * \return
+     *      True if the target was registered, false if the handler table of
+     *      the dispatcher is full.
+     */
+    bool
+    attachTo(SpaceWireDispatcher& dispatcher);
+
+    /**
+     * Queue a command forwarded by the dispatcher.
+     *
+     * \retval false   Queue is full, the command is dropped.
+     */
+    virtual bool
+    handlePacket(const outpost::utils::SharedChildPointer& packet) override;
+
+    /**
+     * Wait for commands and process all commands available afterwards.
+     *
+     * Used by the thread of the target, can also be called directly if the
+     * thread is not started.
+     *
+     * \param timeout
+     *      Time to wait for the first command
+     *
+     * \return
+     *      Number of received packets.
+     */
+    size_t
+    processCommands(outpost::time::Duration timeout);
+
+    inline Counters
+    getCounters() const
+    {
+        return mCounters;
+    }
+
+    inline uint8_t
+    getLogicalAddress() const
+    {
+        return mLogicalAddress;
+    }
+
+    inline uint8_t
+    getKey() const
+    {
+        return mKey;
+    }
+
+private:
+    /**
+     * Header fields of a received command. The slices refer to the
+     * receive buffer.
+     */
+    struct Command
+    {
+        Command() :
+            mTargetLogicalAddress(0),
+            mInstruction(0),
+            mKey(0),
+            mReplyAddress(outpost::Slice<const uint8_t>::empty()),
+            mInitiatorLogicalAddress(0),
+            mTransactionId(0),
+            mExtendedAddress(0),
+            mAddress(0),
+            mDataLength(0),
+            mData(outpost::Slice<const uint8_t>::empty())
+        {
+        }
+
+        uint8_t mTargetLogicalAddress;
+        uint8_t mInstruction;
+        uint8_t mKey;
+        outpost::Slice<const uint8_t> mReplyAddress;
+        uint8_t mInitiatorLogicalAddress;
+        uint16_t mTransactionId;
+        uint8_t mExtendedAddress;
+        uint32_t mAddress;
+        uint32_t mDataLength;
+        outpost::Slice<const uint8_t> mData;
+    };
+
+    virtual void
+    run() override;
+
+    void
+    handlePacket(outpost::Slice<const uint8_t> packet, hal::SpaceWire::EndMarker end);
+
+    /**
+     * Check the command and find the region it accesses.
+     *
+     * \return
+     *      RMAP status code.
+     */
+    uint8_t
+    validateCommand(const Command& command,
+                    outpost::Slice<const uint8_t> packet,
+                    size_t headerLength,
+                    hal::SpaceWire::EndMarker end,
+                    RmapMemoryRegion*& region);
+
+    /**
+     * Execute the command and send the reply if requested.
+     *
+     * For read and read-modify-write commands the data of the reply is
+     * read directly into the transmit buffer. Commands which failed the
+     * validation are only answered with their status.
+     */
+    void
+    executeCommand(const Command& command, uint8_t status, RmapMemoryRegion* region);
+
+    RmapMemoryRegion*
+    findRegion(uint8_t extendedAddress, uint32_t address, uint32_t length);
+
+    //--------------------------------------------------------------------------
+    hal::SpaceWire& mSpW;
+    const uint8_t mLogicalAddress;
+    const uint8_t mKey;
+
+    RmapMemoryRegion* mRegions[rmap::maxMemoryRegions];
+    uint8_t mNumberOfRegions;
+
+    /// Commands are received through a SpaceWireDispatcher
+    bool mDispatched;
+    SpaceWireProtocolQueue<rmap::maxQueuedCommands> mCommandQueue;
+
+    Counters mCounters;
+    const outpost::support::parameter::HeartbeatSource mHeartbeatSource;
+};
+
+}  // namespace comm
+}  // namespace outpost
+
+#endif
@@ -17,13 +17,24 @@ using namespace outpost::comm;
 
 RmapTransaction::RmapTransaction() :
     mTargetLogicalAddress(0),
+    mTargetId(0),
+    mTargetNode(nullptr),
+    mPath(RmapTargetNode::primaryPath),
     mInitiatorLogicalAddress(0),
     mTransactionID(0),
     mTimeoutDuration(outpost::time::Duration::zero()),
     mState(notInitiated),
     mBlockingMode(false),
-    mReplyPacket(),
+    mReplyStatus(RmapReplyStatus::unknown),
+    mReplyDataLength(0),
     mCommandPacket(),
+    mReplyBuffer(outpost::Slice<uint8_t>::empty()),
+    mCommandData(outpost::Slice<const uint8_t>::empty()),
+    mHasCommandData(false),
+    mCallback(),
+    mHasCallback(false),
+    mSendTime(outpost::time::SpacecraftElapsedTime::startOfEpoch()),
+    mDeadline(outpost::time::SpacecraftElapsedTime::startOfEpoch()),
     mReplyLock(outpost::rtos::BinarySemaphore::State::released)
 {
 }
@@ -36,11 +47,22 @@ void
 RmapTransaction::reset()
 {
     mTargetLogicalAddress = 0;
+    mTargetId = 0;
+    mTargetNode = nullptr;
+    mPath = RmapTargetNode::primaryPath;
     mInitiatorLogicalAddress = 0;
     mTransactionID = 0;
     mTimeoutDuration = outpost::time::Duration::zero();
     mState = notInitiated;
     mBlockingMode = false;
-    mReplyPacket.reset();
+    mReplyStatus = RmapReplyStatus::unknown;
+    mReplyDataLength = 0;
     mCommandPacket.reset();
+    mReplyBuffer = outpost::Slice<uint8_t>::empty();
+    mCommandData = outpost::Slice<const uint8_t>::empty();
+    mHasCommandData = false;
+    mCallback = RmapCompletionCallback();
+    mHasCallback = false;
+    mSendTime = outpost::time::SpacecraftElapsedTime::startOfEpoch();
+    mDeadline = outpost::time::SpacecraftElapsedTime::startOfEpoch();
 }
@@ -15,14 +15,111 @@
 #define OUTPOST_COMM_RMAP_TRANSACTION_H_
 
 #include "rmap_packet.h"
+#include "rmap_status.h"
 
 #include <outpost/rtos.h>
 #include <outpost/time/duration.h>
+#include <outpost/time/time_point.h>
+#include <outpost/utils/functor.h>
 
 namespace outpost
 {
 namespace comm
 {
+class RmapTransaction;
+
+/**
+ * Handle of an asynchronous RMAP transaction.
+ *
+ * Returned by the asynchronous operations of the RMAP initiator and used to
+ * poll or wait for the completion of the transaction. Once the transaction
+ * is completed the handle holds its result and the transaction slot is
+ * handed back to the initiator.
+ */
+class RmapTransactionHandle
+{
+    friend class RmapInitiator;
+
+public:
+    enum Result : uint8_t
+    {
+        /// Handle is not connected to a transaction
+        invalid = 0,
+        /// Transaction is waiting for its reply
+        pending = 1,
+        /// Reply received, command executed successfully
+        success = 2,
+        /// Reply received with an error status or with unexpected data
+        failure = 3,
+        /// No reply received within the transaction timeout
+        timeout = 4,
+        /// Link failed after the command was sent and the command could
+        /// not be sent again on the redundant path
+        linkFailed = 5
+    };
+
+    RmapTransactionHandle() :
+        mTransaction(nullptr),
+        mTransactionId(0),
+        mResult(invalid),
+        mReplyStatus(RmapReplyStatus::unknown),
+        mDataLength(0)
+    {
+    }
+
+    inline Result
+    getResult() const
+    {
+        return mResult;
+    }
+
+    inline bool
+    isPending() const
+    {
+        return (mResult == pending);
+    }
+
+    inline uint16_t
+    getTransactionId() const
+    {
+        return mTransactionId;
+    }
+
+    /**
+     * Status field of the received reply, RmapReplyStatus::unknown if no
+     * reply has been received.
+     */
+    inline uint8_t
+    getReplyStatus() const
+    {
+        return mReplyStatus;
+    }
+
+    /**
+     * Number of data bytes received with a read reply.
+     */
+    inline uint32_t
+    getDataLength() const
+    {
+        return mDataLength;
+    }
+
+private:
+    RmapTransaction* mTransaction;
+    uint16_t mTransactionId;
+    Result mResult;
+    uint8_t mReplyStatus;
+    uint32_t mDataLength;
+};
+
+/**
+ * Completion callback for asynchronous RMAP transactions.
+ *
+ * Executed by the receiving thread of the RMAP initiator, the callback
+ * must not block.
+ */
+typedef outpost::Functor1<void(const RmapTransactionHandle&)> RmapCompletionCallback;
+
 /**
  * RMAP transaction.
  *
@@ -40,7 +137,8 @@ public:
         initiated = 0x01,
         commandSent = 0x02,
         replyReceived = 0x03,
-        timeout = 0x04
+        timeout = 0x04,
+        linkFailed = 0x05
     };
 
     RmapTransaction();
@@ -81,6 +179,53 @@ public:
         return mTargetLogicalAddress;
     }
 
+    /**
+     * ID of the target node, used to collect the statistics of the target.
+     */
+    inline void
+    setTargetId(uint8_t id)
+    {
+        mTargetId = id;
+    }
+
+    inline uint8_t
+    getTargetId() const
+    {
+        return mTargetId;
+    }
+
+    /**
+     * Target node and path on which the command has been sent, used to
+     * repeat the command on the redundant path.
+     */
+    inline void
+    setTargetNode(RmapTargetNode* targetNode, uint8_t path)
+    {
+        mTargetNode = targetNode;
+        mPath = path;
+    }
+
+    inline RmapTargetNode*
+    getTargetNode() const
+    {
+        return mTargetNode;
+    }
+
+    inline uint8_t
+    getPath() const
+    {
+        return mPath;
+    }
+
+    /**
+     * Link on which the command has been sent.
+     */
+    inline uint8_t
+    getLink() const
+    {
+        return mTargetNode ? mTargetNode->getLink(mPath) : 0;
+    }
+
     inline void
     setState(State state)
     {
@@ -135,16 +280,132 @@ public:
         return &mCommandPacket;
     }
 
-    inline RmapPacket*
-    getReplyPacket()
+    /**
+     * Register the reply for this transaction.
+     *
+     * Only the status and the data length are stored, the data itself is
+     * copied by the initiator directly into the reply buffer. The reply
+     * packet may refer to a receive buffer which is released afterwards.
+     */
+    inline void
+    setReply(uint8_t status, uint32_t dataLength)
     {
-        return &mReplyPacket;
+        mReplyStatus = status;
+        mReplyDataLength = dataLength;
     }
 
+    inline uint8_t
+    getReplyStatus() const
+    {
+        return mReplyStatus;
+    }
+
+    inline uint32_t
+    getReplyDataLength() const
+    {
+        return mReplyDataLength;
+    }
+
+    /**
+     * Register the buffer into which the data of a read reply is copied
+     * by the receiving thread.
+     */
     inline void
-    setReplyPacket(RmapPacket* replyPacket)
+    setReplyBuffer(outpost::Slice<uint8_t> buffer)
+    {
+        mReplyBuffer = buffer;
+    }
+
+    inline outpost::Slice<uint8_t>
+    getReplyBuffer() const
+    {
+        return mReplyBuffer;
+    }
+
+    /**
+     * Register the data of a write or read-modify-write command.
+     *
+     * The data is only referenced and sent again if the command is moved
+     * to the redundant path after a link failure. It must stay valid
+     * until the transaction is completed.
+     */
+    inline void
+    setCommandData(outpost::Slice<const uint8_t> data)
+    {
+        mCommandData = data;
+        mHasCommandData = true;
+    }
+
+    /**
+     * eturn
+     *      False for writes and read-modify-writes whose data is not
+     *      available anymore after the command has been sent.
+     */
+    inline bool
+    hasCommandData() const
+    {
+        return mHasCommandData;
+    }
+
+    inline outpost::Slice<const uint8_t>
+    getCommandData() const
+    {
+        return mCommandData;
+    }
+
+    /**
+     * Register a callback which is executed by the receiving thread when
+     * the transaction is completed.
+     */
+    inline void
+    setCompletionCallback(const RmapCompletionCallback& callback)
+    {
+        mCallback = callback;
+        mHasCallback = true;
+    }
+
+    inline bool
+    hasCompletionCallback() const
+    {
+        return mHasCallback;
+    }
+
+    inline const RmapCompletionCallback&
+    getCompletionCallback() const
+    {
+        return mCallback;
+    }
+
+    /**
+     * Time at which the command was sent, used to measure the round-trip
+     * latency.
+     */
+    inline void
+    setSendTime(outpost::time::SpacecraftElapsedTime sendTime)
+    {
+        mSendTime = sendTime;
+    }
+
+    inline outpost::time::SpacecraftElapsedTime
+    getSendTime() const
+    {
+        return mSendTime;
+    }
+
+    /**
+     * Time after which the transaction is expired if no reply has been
+     * received.
+     */
+    inline void
+    setDeadline(outpost::time::SpacecraftElapsedTime deadline)
+    {
+        mDeadline = deadline;
+    }
+
+    inline outpost::time::SpacecraftElapsedTime
+    getDeadline() const
     {
-        mReplyPacket = *replyPacket;
+        return mDeadline;
     }
 
     /**
@@ -181,13 +442,24 @@ public:
     operator=(const RmapTransaction& rhs)
     {
         mTargetLogicalAddress = rhs.mTargetLogicalAddress;
+        mTargetId = rhs.mTargetId;
+        mTargetNode = rhs.mTargetNode;
+        mPath = rhs.mPath;
         mInitiatorLogicalAddress = rhs.mInitiatorLogicalAddress;
         mTransactionID = rhs.mTransactionID;
         mTimeoutDuration = rhs.mTimeoutDuration;
         mState = rhs.mState;
         mBlockingMode = rhs.mBlockingMode;
         mCommandPacket = rhs.mCommandPacket;
-        mReplyPacket = rhs.mReplyPacket;
+        mReplyStatus = rhs.mReplyStatus;
+        mReplyDataLength = rhs.mReplyDataLength;
+        mReplyBuffer = rhs.mReplyBuffer;
+        mCommandData = rhs.mCommandData;
+        mHasCommandData = rhs.mHasCommandData;
+        mCallback = rhs.mCallback;
+        mHasCallback = rhs.mHasCallback;
+        mSendTime = rhs.mSendTime;
+        mDeadline = rhs.mDeadline;
         return *this;
     }
 
@@ -196,14 +468,25 @@ public:
 
 private:
     uint8_t mTargetLogicalAddress;
+    uint8_t mTargetId;
+    RmapTargetNode* mTargetNode;
+    uint8_t mPath;
     uint8_t mInitiatorLogicalAddress;
     uint16_t mTransactionID;
     outpost::time::Duration mTimeoutDuration;
     State mState;
 
     bool mBlockingMode;
-    RmapPacket mReplyPacket;
+    uint8_t mReplyStatus;
+    uint32_t mReplyDataLength;
     RmapPacket mCommandPacket;
+    outpost::Slice<uint8_t> mReplyBuffer;
+    outpost::Slice<const uint8_t> mCommandData;
+    bool mHasCommandData;
+    RmapCompletionCallback mCallback;
+    bool mHasCallback;
+    outpost::time::SpacecraftElapsedTime mSendTime;
+    outpost::time::SpacecraftElapsedTime mDeadline;
     outpost::rtos::BinarySemaphore mReplyLock;
 };
 }  // namespace comm
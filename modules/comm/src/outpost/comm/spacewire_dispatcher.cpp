@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spacewire_dispatcher.h"
+
+#include <outpost/comm/log.h>
+
+#include <string.h>
+
+using namespace outpost::comm;
+
+constexpr uint8_t SpaceWireDispatcher::maxHandlers;
+constexpr uint8_t SpaceWireDispatcher::protocolRmap;
+constexpr uint8_t SpaceWireDispatcher::protocolCcsdsPacketTransfer;
+constexpr outpost::time::Duration SpaceWireDispatcher::receiveTimeout;
+constexpr size_t SpaceWireDispatcher::maxPacketsPerBatch;
+constexpr uint8_t SpaceWireDispatcher::noHandler;
+
+namespace
+{
+/// Path address bytes which have not been removed by the routers
+static constexpr uint8_t maxPathAddress = 31;
+
+/**
+ * Find the logical address, the protocol identifier follows it.
+ *
+ * \return
+ *      Offset of the logical address or the length of the packet if the
+ *      packet does not contain a protocol identifier.
+ */
+size_t
+findHeader(outpost::Slice<const uint8_t> packet)
+{
+    size_t length = packet.getNumberOfElements();
+    size_t start = 0;
+    while ((start < length) && (packet[start] <= maxPathAddress))
+    {
+        start++;
+    }
+
+    if ((start + 2) > length)
+    {
+        start = length;
+    }
+    return start;
+}
+}  // namespace
+
+SpaceWireProtocolHandler::~SpaceWireProtocolHandler()
+{
+}
+
+//------------------------------------------------------------------------------
+SpaceWireDispatcher::SpaceWireDispatcher(
+        hal::SpaceWire& spw,
+        outpost::utils::SharedBufferPoolBase& pool,
+        uint8_t priority,
+        size_t stackSize,
+        outpost::support::parameter::HeartbeatSource heartbeatSource) :
+    outpost::rtos::Thread(priority, stackSize, "SPWD"),
+    mSpW(spw),
+    mPool(pool),
+    mFirstEntry(),
+    mEntries(),
+    mNumberOfEntries(0),
+    mDefaultHandler(nullptr),
+    mCounters(),
+    mHeartbeatSource(heartbeatSource)
+{
+    memset(mFirstEntry, noHandler, sizeof(mFirstEntry));
+    mSpW.setReceiveBufferPool(mPool);
+}
+
+SpaceWireDispatcher::~SpaceWireDispatcher()
+{
+}
+
+bool
+SpaceWireDispatcher::addHandler(uint8_t protocolIdentifier, SpaceWireProtocolHandler& handler)
+{
+    Entry entry = {protocolIdentifier, 0, true, &handler};
+    return insertHandler(entry);
+}
+
+bool
+SpaceWireDispatcher::addHandler(uint8_t protocolIdentifier,
+                                uint8_t logicalAddress,
+                                SpaceWireProtocolHandler& handler)
+{
+    Entry entry = {protocolIdentifier, logicalAddress, false, &handler};
+    return insertHandler(entry);
+}
+
+bool
+SpaceWireDispatcher::insertHandler(const Entry& entry)
+{
+    if (mNumberOfEntries >= maxHandlers)
+    {
+        return false;
+    }
+
+    // Keep the entries of one protocol together, handlers for a specific
+    // logical address before the handlers for all addresses
+    uint8_t position = 0;
+    while ((position < mNumberOfEntries)
+           && ((mEntries[position].mProtocolIdentifier < entry.mProtocolIdentifier)
+               || ((mEntries[position].mProtocolIdentifier == entry.mProtocolIdentifier)
+                   && (!mEntries[position].mAnyAddress || entry.mAnyAddress))))
+    {
+        position++;
+    }
+
+    for (uint8_t i = mNumberOfEntries; i > position; i--)
+    {
+        mEntries[i] = mEntries[i - 1];
+    }
+    mEntries[position] = entry;
+    mNumberOfEntries++;
+
+    memset(mFirstEntry, noHandler, sizeof(mFirstEntry));
+    for (uint8_t i = mNumberOfEntries; i > 0; i--)
+    {
+        mFirstEntry[mEntries[i - 1].mProtocolIdentifier] = i - 1;
+    }
+    return true;
+}
+
+SpaceWireProtocolHandler*
+SpaceWireDispatcher::findHandler(outpost::Slice<const uint8_t> packet) const
+{
+    size_t start = findHeader(packet);
+    if (start >= packet.getNumberOfElements())
+    {
+        return nullptr;
+    }
+
+    uint8_t logicalAddress = packet[start];
+    uint8_t protocolIdentifier = packet[start + 1];
+
+    for (uint8_t i = mFirstEntry[protocolIdentifier];
+         (i < mNumberOfEntries) && (mEntries[i].mProtocolIdentifier == protocolIdentifier);
+         i++)
+    {
+        if (mEntries[i].mAnyAddress || (mEntries[i].mLogicalAddress == logicalAddress))
+        {
+            return mEntries[i].mHandler;
+        }
+    }
+    return mDefaultHandler;
+}
+
+size_t
+SpaceWireDispatcher::dispatchPackets(outpost::time::Duration timeout)
+{
+    size_t received = 0;
+    while (received < maxPacketsPerBatch)
+    {
+        outpost::utils::SharedChildPointer packet;
+        hal::SpaceWire::EndMarker end;
+        hal::SpaceWire::Result::Type result = mSpW.receiveShared(packet, end, timeout);
+        if (result == hal::SpaceWire::Result::success)
+        {
+            dispatchPacket(packet, end);
+        }
+        else if ((result == hal::SpaceWire::Result::failure) && mSpW.isUp())
+        {
+            // The driver could not store the packet and has discarded it
+            if (mPool.numberOfFreeElements() == 0)
+            {
+                mCounters.mNoBufferAvailable++;
+                OUTPOST_COMM_LOG_WARNING(noReceiveBuffer, 0, 0);
+            }
+            else
+            {
+                mCounters.mInvalidPackets++;
+                OUTPOST_COMM_LOG_WARNING(packetDiscarded, 0, 0);
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        // Only the first packet is waited for, afterwards everything which is
+        // already queued is handled without blocking again
+        received++;
+        timeout = outpost::time::Duration::zero();
+    }
+    return received;
+}
+
+void
+SpaceWireDispatcher::run()
+{
+    while (1)
+    {
+        outpost::support::Heartbeat::send(mHeartbeatSource, receiveTimeout * 2);
+        dispatchPackets(receiveTimeout);
+    }
+}
+
+//------------------------------------------------------------------------------
+void
+SpaceWireDispatcher::dispatchPacket(const outpost::utils::SharedChildPointer& received,
+                                    hal::SpaceWire::EndMarker end)
+{
+    outpost::Slice<const uint8_t> data = received.asSlice();
+    size_t length = data.getNumberOfElements();
+
+    size_t start = findHeader(data);
+    if ((end != hal::SpaceWire::eop) || (start >= length))
+    {
+        mCounters.mInvalidPackets++;
+        OUTPOST_COMM_LOG_WARNING(invalidEndMarker, length, end);
+        return;
+    }
+
+    uint8_t protocolIdentifier = data[start + 1];
+    SpaceWireProtocolHandler* handler = findHandler(data);
+    if (!handler)
+    {
+        mCounters.mUnhandledPackets++;
+        OUTPOST_COMM_LOG_INFO(unhandledPacket, protocolIdentifier, length);
+        return;
+    }
+
+    // The handler gets a reference to the received buffer, the packet is
+    // not copied
+    outpost::utils::SharedChildPointer packet;
+    received.getChild(packet, protocolIdentifier, 0, length);
+
+    if (handler->handlePacket(packet))
+    {
+        mCounters.mDispatchedPackets++;
+    }
+    else
+    {
+        mCounters.mDroppedPackets++;
+        OUTPOST_COMM_LOG_WARNING(packetDropped, protocolIdentifier, length);
+    }
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_COMM_SPACEWIRE_DISPATCHER_H_
+#define OUTPOST_COMM_SPACEWIRE_DISPATCHER_H_
+
+#include <outpost/hal/spacewire.h>
+#include <outpost/rtos.h>
+#include <outpost/support/heartbeat.h>
+#include <outpost/time/duration.h>
+#include <outpost/utils/container/shared_buffer.h>
+#include <outpost/utils/container/shared_buffer_queue.h>
+#include <outpost/utils/container/shared_object_pool.h>
+
+#include <stdint.h>
+
+namespace outpost
+{
+namespace comm
+{
+/**
+ * Receiver of the packets classified by a SpaceWireDispatcher.
+ */
+class SpaceWireProtocolHandler
+{
+public:
+    virtual ~SpaceWireProtocolHandler();
+
+    /**
+     * Handle a received packet.
+     *
+     * Called by the thread of the dispatcher and must therefore not block.
+     * The packet includes the leading path address bytes, its type is set
+     * to the protocol identifier. The handler may keep references to the
+     * packet beyond the call, the buffer is returned to the pool of the
+     * dispatcher when the last reference is released.
+     *
+     * \retval true     Packet was accepted.
+     * \retval false    Packet was dropped, e.g. because a queue is full.
+     */
+    virtual bool
+    handlePacket(const outpost::utils::SharedChildPointer& packet) = 0;
+};
+
+/**
+ * Protocol handler forwarding the packets to a consumer thread.
+ *
+ * \tparam N
+ *      Number of packets which can be queued.
+ */
+template <size_t N>
+class SpaceWireProtocolQueue : public SpaceWireProtocolHandler
+{
+public:
+    SpaceWireProtocolQueue() : mQueue()
+    {
+    }
+
+    virtual bool
+    handlePacket(const outpost::utils::SharedChildPointer& packet) override
+    {
+        outpost::utils::SharedBufferPointer pointer(packet);
+        return mQueue.send(pointer);
+    }
+
+    /**
+     * Wait for the next packet.
+     *
+     * \retval true     Packet received.
+     * \retval false    No packet received within the timeout.
+     */
+    inline bool
+    receive(outpost::utils::SharedBufferPointer& packet, outpost::time::Duration timeout)
+    {
+        return mQueue.receive(packet, timeout);
+    }
+
+    inline size_t
+    getNumberOfItems()
+    {
+        return mQueue.getNumberOfItems();
+    }
+
+private:
+    outpost::utils::SharedBufferQueue<N> mQueue;
+};
+
+/**
+ * SpaceWire receive dispatcher.
+ *
+ * Single receiver of a SpaceWire link which distributes the packets to the
+ * protocol handlers registered for the protocol identifier and the logical
+ * address of the packet. This allows several protocols, e.g. RMAP and
+ * CCSDS packet transfer, to share one link without every consumer having
+ * to inspect every packet.
+ *
+ * The given pool is assigned to the SpaceWire driver as its receive buffer
+ * pool. Packets are received into shared buffers from this pool, handlers
+ * receive a reference to these buffers without any further copy. Drivers
+ * without direct support for shared buffers copy each packet once into a
+ * pool buffer.
+ *
+ * The protocol identifier is used as index into a lookup table, the
+ * handlers for one protocol are then searched for the logical address.
+ * Handlers registered for a specific logical address take precedence over
+ * handlers registered for all addresses of the protocol. Packets without a
+ * matching handler are passed to the default handler if one is set.
+ *
+ * Handlers must be registered before the thread of the dispatcher is started.
+ */
+class SpaceWireDispatcher : public outpost::rtos::Thread
+{
+public:
+    /// Maximum number of registered handlers
+    static constexpr uint8_t maxHandlers = 8;
+
+    /// Protocol identifiers assigned by ECSS-E-ST-50-51C
+    static constexpr uint8_t protocolRmap = 0x01;
+    static constexpr uint8_t protocolCcsdsPacketTransfer = 0x02;
+
+    /// Upper limit for waiting on a packet before the heartbeat is sent
+    static constexpr outpost::time::Duration receiveTimeout = outpost::time::Milliseconds(100);
+
+    struct Counters
+    {
+        Counters() :
+            mDispatchedPackets(0),
+            mDroppedPackets(0),
+            mUnhandledPackets(0),
+            mInvalidPackets(0),
+            mNoBufferAvailable(0)
+        {
+        }
+
+        /// Packets accepted by a handler
+        size_t mDispatchedPackets;
+
+        /// Packets rejected by their handler
+        size_t mDroppedPackets;
+
+        /// Packets without a matching handler and without a default handler
+        size_t mUnhandledPackets;
+
+        /// Packets with an error end marker, too short or too long for the pool
+        size_t mInvalidPackets;
+
+        /// Packets dropped because all buffers of the pool are in use
+        size_t mNoBufferAvailable;
+    };
+
+    SpaceWireDispatcher(hal::SpaceWire& spw,
+                        outpost::utils::SharedBufferPoolBase& pool,
+                        uint8_t priority,
+                        size_t stackSize,
+                        outpost::support::parameter::HeartbeatSource heartbeatSource);
+
+    ~SpaceWireDispatcher();
+
+    /**
+     * Register a handler for all packets of a protocol.
+     *
+     * \return
+     *      True if the handler was added, false if the table is full.
+     */
+    bool
+    addHandler(uint8_t protocolIdentifier, SpaceWireProtocolHandler& handler);
+
+    /**
+     * Register a handler for the packets of a protocol which are addressed
+     * to the given logical address.
+     *
+     * \return
+     *      True if the handler was added, false if the table is full.
+     */
+    bool
+    addHandler(uint8_t protocolIdentifier,
+               uint8_t logicalAddress,
+               SpaceWireProtocolHandler& handler);
+
+    /**
+     * Set the handler for packets which no other handler is registered for.
+     *
+     * \param handler
+     *      Handler or nullptr to discard these packets.
+     */
+    inline void
+    setDefaultHandler(SpaceWireProtocolHandler* handler)
+    {
+        mDefaultHandler = handler;
+    }
+
+    /**
+     * Wait for packets and dispatch all packets available afterwards.
+     *
+     * Used by the thread of the dispatcher, can also be called directly if
+     * the thread is not started.
+     *
+     * \param timeout
+     *      Time to wait for the first packet
+     *
+     * \return
+     *      Number of received packets.
+     */
+    size_t
+    dispatchPackets(outpost::time::Duration timeout);
+
+    /**
+     * Find the handler responsible for a packet.
+     *
+     * \return
+     *      Handler or nullptr if neither a matching nor a default handler
+     *      is registered.
+     */
+    SpaceWireProtocolHandler*
+    findHandler(outpost::Slice<const uint8_t> packet) const;
+
+    inline Counters
+    getCounters() const
+    {
+        return mCounters;
+    }
+
+private:
+    /// Maximum number of packets handled before the heartbeat is sent again
+    static constexpr size_t maxPacketsPerBatch = 16;
+
+    /// Marks protocol identifiers without a handler in the lookup table
+    static constexpr uint8_t noHandler = 0xFF;
+
+    struct Entry
+    {
+        uint8_t mProtocolIdentifier;
+        uint8_t mLogicalAddress;
+        bool mAnyAddress;
+        SpaceWireProtocolHandler* mHandler;
+    };
+
+    virtual void
+    run() override;
+
+    bool
+    insertHandler(const Entry& entry);
+
+    void
+    dispatchPacket(const outpost::utils::SharedChildPointer& received,
+                   hal::SpaceWire::EndMarker end);
+
+    hal::SpaceWire& mSpW;
+    outpost::utils::SharedBufferPoolBase& mPool;
+
+    /// Index of the first entry of each protocol identifier
+    uint8_t mFirstEntry[256];
+
+    /// Entries ordered by protocol identifier, specific addresses first
+    Entry mEntries[maxHandlers];
+    uint8_t mNumberOfEntries;
+    SpaceWireProtocolHandler* mDefaultHandler;
+
+    Counters mCounters;
+    const outpost::support::parameter::HeartbeatSource mHeartbeatSource;
+};
+
+}  // namespace comm
+}  // namespace outpost
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/comm/cobs_transport.h>
+
+#include <unittest/hal/serial_stub.h>
+#include <unittest/harness.h>
+
+#include <vector>
+
+using outpost::comm::CobsTransport;
+
+class CobsTransportTest : public testing::Test
+{
+public:
+    static constexpr size_t bufferSize = 300;
+    static constexpr size_t numberOfBuffers = 2;
+
+    CobsTransportTest() : mSerial(), mPool(), mTransport(mSerial, mPool)
+    {
+    }
+
+    bool
+    send(std::vector<uint8_t> packet)
+    {
+        return mTransport.send(
+                outpost::Slice<const uint8_t>::unsafe(packet.data(), packet.size()),
+                outpost::time::Duration::zero());
+    }
+
+    std::vector<uint8_t>
+    receive()
+    {
+        outpost::utils::SharedChildPointer packet;
+        if (!mTransport.receive(packet, outpost::time::Duration::zero()))
+        {
+            return std::vector<uint8_t>();
+        }
+        outpost::Slice<const uint8_t> data = packet;
+        return std::vector<uint8_t>(data.begin(), data.end());
+    }
+
+    /**
+     * Feed the transmitted data back into the receive path.
+     */
+    void
+    loopback()
+    {
+        mSerial.mDataToReceive.insert(mSerial.mDataToReceive.end(),
+                                      mSerial.mDataToTransmit.begin(),
+                                      mSerial.mDataToTransmit.end());
+        mSerial.mDataToTransmit.clear();
+    }
+
+    unittest::hal::SerialStub mSerial;
+    outpost::utils::SharedBufferPool<bufferSize, numberOfBuffers> mPool;
+    CobsTransport mTransport;
+};
+
+constexpr size_t CobsTransportTest::bufferSize;
+constexpr size_t CobsTransportTest::numberOfBuffers;
+
+// ----------------------------------------------------------------------------
+TEST_F(CobsTransportTest, shouldEncodeAndTerminateFrame)
+{
+    EXPECT_TRUE(send({0x11, 0x22, 0x00, 0x33}));
+    EXPECT_EQ(std::vector<uint8_t>({0x03, 0x11, 0x22, 0x02, 0x33, 0x00}),
+              mSerial.mDataToTransmit);
+}
+
+TEST_F(CobsTransportTest, shouldEncodeTrailingZero)
+{
+    EXPECT_TRUE(send({0x11, 0x00}));
+    EXPECT_EQ(std::vector<uint8_t>({0x02, 0x11, 0x01, 0x00}), mSerial.mDataToTransmit);
+}
+
+TEST_F(CobsTransportTest, shouldRejectEmptyPacket)
+{
+    EXPECT_FALSE(send({}));
+    EXPECT_TRUE(mSerial.mDataToTransmit.empty());
+
+    // Following packets are not affected
+    EXPECT_TRUE(send({0x11}));
+    EXPECT_EQ(std::vector<uint8_t>({0x02, 0x11, 0x00}), mSerial.mDataToTransmit);
+}
+
+TEST_F(CobsTransportTest, shouldMatchBlockEncoder)
+{
+    std::vector<uint8_t> packet(600);
+    for (size_t i = 0; i < packet.size(); ++i)
+    {
+        packet[i] = static_cast<uint8_t>(i % 251);
+    }
+    EXPECT_TRUE(send(packet));
+
+    std::vector<uint8_t> expected(outpost::utils::Cobs::getMaximumSizeOfEncodedData(600));
+    size_t length = outpost::utils::Cobs::encode(
+            outpost::Slice<const uint8_t>::unsafe(packet.data(), packet.size()),
+            outpost::asSlice(expected));
+    expected.resize(length);
+    expected.push_back(0);
+    EXPECT_EQ(expected, mSerial.mDataToTransmit);
+}
+
+TEST_F(CobsTransportTest, shouldReceiveFramesSentBefore)
+{
+    std::vector<uint8_t> first = {1, 0, 2, 0, 0, 3};
+    std::vector<uint8_t> second(280, 0x5A);
+    EXPECT_TRUE(send(first));
+    EXPECT_TRUE(send(second));
+    loopback();
+
+    EXPECT_EQ(first, receive());
+    EXPECT_EQ(second, receive());
+    EXPECT_EQ(std::vector<uint8_t>(), receive());
+}
+
+TEST_F(CobsTransportTest, shouldContinuePartiallyReceivedFrame)
+{
+    EXPECT_TRUE(send({1, 2, 3, 4}));
+    std::vector<uint8_t> encoded = mSerial.mDataToTransmit;
+    mSerial.mDataToTransmit.clear();
+
+    mSerial.mDataToReceive.assign(encoded.begin(), encoded.begin() + 3);
+    EXPECT_EQ(std::vector<uint8_t>(), receive());
+
+    mSerial.mDataToReceive.assign(encoded.begin() + 3, encoded.end());
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}), receive());
+}
+
+TEST_F(CobsTransportTest, shouldDiscardCorruptedAndOversizedFrames)
+{
+    std::vector<uint8_t> oversized(bufferSize + 1, 0x01);
+    EXPECT_TRUE(send(oversized));
+    loopback();
+
+    // Truncated block followed by a valid frame
+    mSerial.mDataToReceive.insert(mSerial.mDataToReceive.end(), {0x05, 0x01, 0x00});
+    EXPECT_TRUE(send({7}));
+    loopback();
+
+    EXPECT_EQ(std::vector<uint8_t>({7}), receive());
+    EXPECT_EQ(2U, mTransport.getNumberOfDiscardedFrames());
+}
+
+TEST_F(CobsTransportTest, shouldWaitForFreeBuffer)
+{
+    EXPECT_TRUE(send({1}));
+    EXPECT_TRUE(send({2}));
+    EXPECT_TRUE(send({3}));
+    loopback();
+
+    outpost::utils::SharedChildPointer first;
+    outpost::utils::SharedChildPointer second;
+    outpost::utils::SharedChildPointer third;
+    ASSERT_TRUE(mTransport.receive(first, outpost::time::Duration::zero()));
+    ASSERT_TRUE(mTransport.receive(second, outpost::time::Duration::zero()));
+    EXPECT_FALSE(mTransport.receive(third, outpost::time::Duration::zero()));
+
+    first = outpost::utils::SharedChildPointer();
+    ASSERT_TRUE(mTransport.receive(third, outpost::time::Duration::zero()));
+    EXPECT_EQ(3, third[0]);
+}
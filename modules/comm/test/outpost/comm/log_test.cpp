@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/comm/log.h>
+
+#include <unittest/harness.h>
+
+using namespace outpost::comm;
+
+TEST(LogBufferTest, shouldBeEmptyInitially)
+{
+    LogBuffer buffer;
+    LogRecord records[4];
+    EXPECT_EQ(0U, buffer.getLatest(outpost::asSlice(records)));
+    EXPECT_EQ(0U, buffer.getNumberOfRecords());
+}
+
+TEST(LogBufferTest, shouldStoreBinaryRecords)
+{
+    LogBuffer buffer;
+    buffer.write(LogLevel::warning, LogEvent::lateReply, 0x1234, 0);
+    buffer.write(LogLevel::debug, LogEvent::commandSent, 0x1235, 7);
+
+    LogRecord records[4];
+    ASSERT_EQ(2U, buffer.getLatest(outpost::asSlice(records)));
+
+    EXPECT_EQ(1U, records[0].mSequence);
+    EXPECT_EQ(LogLevel::warning, records[0].mLevel);
+    EXPECT_EQ(LogEvent::lateReply, records[0].mEvent);
+    EXPECT_EQ(0x1234, records[0].mArgument0);
+
+    EXPECT_EQ(2U, records[1].mSequence);
+    EXPECT_EQ(LogEvent::commandSent, records[1].mEvent);
+    EXPECT_EQ(7U, records[1].mArgument1);
+    EXPECT_LE(records[0].mTime, records[1].mTime);
+}
+
+TEST(LogBufferTest, shouldOverwriteOldestRecords)
+{
+    LogBuffer buffer;
+    for (uint32_t i = 0; i < LogBuffer::size + 3; i++)
+    {
+        buffer.write(LogLevel::error, LogEvent::noFreeTransaction, 0, i);
+    }
+    EXPECT_EQ(LogBuffer::size + 3, buffer.getNumberOfRecords());
+
+    // Only the latest records are copied if the slice is smaller
+    LogRecord records[2];
+    ASSERT_EQ(2U, buffer.getLatest(outpost::asSlice(records)));
+    EXPECT_EQ(LogBuffer::size + 1, records[0].mArgument1);
+    EXPECT_EQ(LogBuffer::size + 2, records[1].mArgument1);
+
+    LogRecord all[LogBuffer::size + 8];
+    ASSERT_EQ(LogBuffer::size, buffer.getLatest(outpost::asSlice(all)));
+    EXPECT_EQ(3U, all[0].mArgument1);
+}
+
+TEST(LogBufferTest, shouldSkipClearedRecords)
+{
+    LogBuffer buffer;
+    buffer.write(LogLevel::error, LogEvent::regionTableFull, 0, 0);
+    buffer.clear();
+
+    LogRecord records[4];
+    EXPECT_EQ(0U, buffer.getLatest(outpost::asSlice(records)));
+}
+
+TEST(LogBufferTest, shouldProvideEventNames)
+{
+    EXPECT_STREQ("lateReply", LogBuffer::getName(LogEvent::lateReply));
+    EXPECT_STREQ("replyNotSent", LogBuffer::getName(LogEvent::replyNotSent));
+}
+
+// The build of the tests enables messages up to warnings
+#if OUTPOST_COMM_LOG_LEVEL == OUTPOST_COMM_LOG_LEVEL_WARNING
+TEST(LogBufferTest, shouldFilterMessagesAtCompileTime)
+{
+    uint32_t start = logBuffer.getNumberOfRecords();
+    int evaluated = 0;
+
+    OUTPOST_COMM_LOG_ERROR(transactionNotInitiated, 1, 0);
+    OUTPOST_COMM_LOG_WARNING(lateReply, 2, 0);
+
+    // Arguments of disabled messages are not evaluated
+    OUTPOST_COMM_LOG_INFO(nonRmapPacket, ++evaluated, 0);
+    OUTPOST_COMM_LOG_DEBUG(commandSent, ++evaluated, 0);
+
+    EXPECT_EQ(0, evaluated);
+    EXPECT_EQ(start + 2, logBuffer.getNumberOfRecords());
+
+    LogRecord records[2];
+    ASSERT_EQ(2U, logBuffer.getLatest(outpost::asSlice(records)));
+    EXPECT_EQ(LogEvent::transactionNotInitiated, records[0].mEvent);
+    EXPECT_EQ(LogLevel::warning, records[1].mLevel);
+    EXPECT_EQ(2, records[1].mArgument0);
+}
+#endif
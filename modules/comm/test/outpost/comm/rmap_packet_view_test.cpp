@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/comm/rmap/rmap_packet_view.h>
+#include <outpost/utils/coding/crc.h>
+
+#include <unittest/harness.h>
+
+#include <vector>
+
+using namespace outpost::comm;
+
+namespace
+{
+static constexpr uint8_t initiatorAddress = rmap::defaultLogicalAddress;
+
+std::vector<uint8_t>
+createReadReply(uint16_t transactionId, std::vector<uint8_t> data)
+{
+    std::vector<uint8_t> reply = {initiatorAddress,
+                                  rmap::protocolIdentifier,
+                                  0x0C,  // Read reply with increment
+                                  0x00,  // Status
+                                  0x22,  // Target logical address
+                                  static_cast<uint8_t>(transactionId >> 8),
+                                  static_cast<uint8_t>(transactionId),
+                                  0x00,
+                                  0x00,
+                                  0x00,
+                                  static_cast<uint8_t>(data.size())};
+    reply.push_back(outpost::Crc8CcittReversed::calculate(outpost::asSlice(reply)));
+    reply.insert(reply.end(), data.begin(), data.end());
+    reply.push_back(outpost::Crc8CcittReversed::calculate(outpost::asSlice(data)));
+    return reply;
+}
+
+std::vector<uint8_t>
+createWriteReply(uint16_t transactionId, uint8_t status)
+{
+    std::vector<uint8_t> reply = {initiatorAddress,
+                                  rmap::protocolIdentifier,
+                                  0x28,  // Write reply
+                                  status,
+                                  0x22,
+                                  static_cast<uint8_t>(transactionId >> 8),
+                                  static_cast<uint8_t>(transactionId)};
+    reply.push_back(outpost::Crc8CcittReversed::calculate(outpost::asSlice(reply)));
+    return reply;
+}
+}  // namespace
+
+TEST(RmapPacketViewTest, shouldDecodeReadReplyInPlace)
+{
+    std::vector<uint8_t> reply = createReadReply(0x1234, {1, 2, 3, 4});
+    RmapPacketView view(outpost::asSlice(reply));
+
+    ASSERT_TRUE(view.validate(initiatorAddress));
+    EXPECT_TRUE(view.isReplyPacket());
+    EXPECT_TRUE(view.isRead());
+    EXPECT_EQ(0, view.getStatus());
+    EXPECT_EQ(0x22, view.getTargetLogicalAddress());
+    EXPECT_EQ(0x1234, view.getTransactionID());
+    EXPECT_EQ(4U, view.getDataLength());
+    EXPECT_EQ(&reply[12], view.getData().begin());
+    EXPECT_EQ(0U, view.getPathAddress().getNumberOfElements());
+}
+
+TEST(RmapPacketViewTest, shouldDecodeWriteReply)
+{
+    std::vector<uint8_t> reply = createWriteReply(7, RmapReplyStatus::invalidKey);
+    RmapPacketView view(outpost::asSlice(reply));
+
+    ASSERT_TRUE(view.validate(initiatorAddress));
+    EXPECT_TRUE(view.isWrite());
+    EXPECT_EQ(RmapReplyStatus::invalidKey, view.getStatus());
+    EXPECT_EQ(7, view.getTransactionID());
+    EXPECT_EQ(0U, view.getDataLength());
+}
+
+TEST(RmapPacketViewTest, shouldSkipPathAddress)
+{
+    std::vector<uint8_t> reply = createWriteReply(7, 0);
+    reply.insert(reply.begin(), {3, 5});
+    RmapPacketView view(outpost::asSlice(reply));
+
+    ASSERT_TRUE(view.validate(initiatorAddress));
+    ASSERT_EQ(2U, view.getPathAddress().getNumberOfElements());
+    EXPECT_EQ(5, view.getPathAddress()[1]);
+    EXPECT_EQ(7, view.getTransactionID());
+}
+
+TEST(RmapPacketViewTest, shouldRejectCorruptedReplies)
+{
+    std::vector<uint8_t> reply = createReadReply(1, {1, 2, 3, 4});
+
+    std::vector<uint8_t> headerError = reply;
+    headerError[4] ^= 0x01;
+    EXPECT_FALSE(RmapPacketView(outpost::asSlice(headerError)).validate(initiatorAddress));
+
+    std::vector<uint8_t> dataError = reply;
+    dataError[13] ^= 0x01;
+    EXPECT_FALSE(RmapPacketView(outpost::asSlice(dataError)).validate(initiatorAddress));
+
+    std::vector<uint8_t> truncated(reply.begin(), reply.end() - 1);
+    EXPECT_FALSE(RmapPacketView(outpost::asSlice(truncated)).validate(initiatorAddress));
+
+    EXPECT_FALSE(RmapPacketView(outpost::asSlice(reply)).validate(0x20));
+
+    std::vector<uint8_t> wrongProtocol = reply;
+    wrongProtocol[1] = 0x02;
+    EXPECT_FALSE(RmapPacketView(outpost::asSlice(wrongProtocol)).validate(initiatorAddress));
+}
+
+TEST(RmapPacketViewTest, shouldRejectTooShortPacket)
+{
+    std::vector<uint8_t> packet = {initiatorAddress, rmap::protocolIdentifier, 0x0C};
+    RmapPacketView view(outpost::asSlice(packet));
+    EXPECT_FALSE(view.validate(initiatorAddress));
+    EXPECT_FALSE(view.isValid());
+}
+
+TEST(RmapPacketViewTest, shouldAcceptCommandPacketWithoutFurtherChecks)
+{
+    std::vector<uint8_t> packet = {
+            initiatorAddress, rmap::protocolIdentifier, 0x4C, 0, 0, 0, 0, 0, 0, 0};
+    RmapPacketView view(outpost::asSlice(packet));
+    ASSERT_TRUE(view.validate(initiatorAddress));
+    EXPECT_FALSE(view.isReplyPacket());
+}
+
+TEST(RmapPacketViewTest, shouldMaterializePacketOnDemand)
+{
+    std::vector<uint8_t> reply = createReadReply(0x0102, {9, 8});
+    RmapPacketView view(outpost::asSlice(reply));
+
+    RmapPacket packet;
+    EXPECT_FALSE(view.toPacket(packet));
+
+    ASSERT_TRUE(view.validate(initiatorAddress));
+    ASSERT_TRUE(view.toPacket(packet));
+    EXPECT_TRUE(packet.isReplyPacket());
+    EXPECT_EQ(0x0102, packet.getTransactionID());
+    EXPECT_EQ(2U, packet.getDataLength());
+    EXPECT_EQ(9, packet.getData()[0]);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/comm/rmap/rmap_statistics.h>
+#include <outpost/comm/rmap/rmap_status.h>
+
+#include <unittest/harness.h>
+
+using namespace outpost::comm;
+
+TEST(RmapStatisticsTest, shouldSortLatenciesIntoLogarithmicBins)
+{
+    EXPECT_EQ(0, RmapStatistics::getLatencyBin(outpost::time::Duration::zero()));
+    EXPECT_EQ(0, RmapStatistics::getLatencyBin(outpost::time::Microseconds(1)));
+    EXPECT_EQ(1, RmapStatistics::getLatencyBin(outpost::time::Microseconds(2)));
+    EXPECT_EQ(1, RmapStatistics::getLatencyBin(outpost::time::Microseconds(3)));
+    EXPECT_EQ(9, RmapStatistics::getLatencyBin(outpost::time::Milliseconds(1)));
+    EXPECT_EQ(rmap::latencyHistogramBins - 1,
+              RmapStatistics::getLatencyBin(outpost::time::Seconds(10)));
+}
+
+TEST(RmapStatisticsTest, shouldNotFindUnknownTarget)
+{
+    RmapStatistics statistics;
+    RmapTargetStatistics snapshot;
+    EXPECT_FALSE(statistics.getSnapshot(1, snapshot));
+    EXPECT_EQ(0, statistics.getNumberOfTargets());
+}
+
+TEST(RmapStatisticsTest, shouldCollectStatisticsPerTarget)
+{
+    RmapStatistics statistics;
+    statistics.commandSent(1, 16, true);
+    statistics.commandSent(1, 0, true);
+    statistics.commandSent(2, 8, false);
+    statistics.slotAcquired(1, outpost::time::Milliseconds(3));
+    statistics.slotAcquired(1, outpost::time::Milliseconds(2));
+
+    statistics.replyReceived(1, outpost::time::Microseconds(100), 0, 4);
+    statistics.replyReceived(
+            1, outpost::time::Microseconds(100), RmapReplyStatus::invalidDataCrc, 4);
+
+    RmapTargetStatistics snapshot;
+    ASSERT_TRUE(statistics.getSnapshot(1, snapshot));
+    EXPECT_EQ(1, snapshot.mTargetId);
+    EXPECT_EQ(2U, snapshot.mCommands);
+    EXPECT_EQ(2U, snapshot.mReplies);
+    EXPECT_EQ(1U, snapshot.mFailedReplies);
+    EXPECT_EQ(1U, snapshot.mCrcErrors);
+    EXPECT_EQ(16U, snapshot.mBytesWritten);
+    EXPECT_EQ(4U, snapshot.mBytesRead);
+    EXPECT_EQ(0, snapshot.mInFlight);
+    EXPECT_EQ(2, snapshot.mMaxInFlight);
+    EXPECT_EQ(outpost::time::Milliseconds(3), snapshot.mMaxQueueingDelay);
+    uint8_t bin = RmapStatistics::getLatencyBin(outpost::time::Microseconds(100));
+    EXPECT_EQ(2U, snapshot.mLatency[bin]);
+
+    ASSERT_TRUE(statistics.getSnapshot(2, snapshot));
+    EXPECT_EQ(1U, snapshot.mCommands);
+    EXPECT_EQ(8U, snapshot.mBytesWritten);
+    EXPECT_EQ(0, snapshot.mMaxInFlight);
+    EXPECT_EQ(2, statistics.getNumberOfTargets());
+}
+
+TEST(RmapStatisticsTest, shouldCountTimeoutsAndRetries)
+{
+    RmapStatistics statistics;
+    statistics.commandSent(1, 0, true);
+    statistics.transactionExpired(1);
+    statistics.commandRepeated(1);
+    statistics.commandSent(1, 0, true);
+    statistics.transactionCancelled(1);
+
+    RmapTargetStatistics snapshot;
+    ASSERT_TRUE(statistics.getSnapshot(1, snapshot));
+    EXPECT_EQ(2U, snapshot.mCommands);
+    EXPECT_EQ(1U, snapshot.mTimeouts);
+    EXPECT_EQ(1U, snapshot.mRetries);
+    EXPECT_EQ(0, snapshot.mInFlight);
+    EXPECT_EQ(1, snapshot.mMaxInFlight);
+}
+
+TEST(RmapStatisticsTest, shouldCountEventsOfTargetsNotFittingIntoTheTable)
+{
+    RmapStatistics statistics;
+    for (uint8_t i = 0; i < rmap::maxStatisticsTargets; i++)
+    {
+        statistics.commandSent(i, 0, false);
+    }
+    statistics.commandSent(rmap::maxStatisticsTargets, 0, false);
+
+    RmapTargetStatistics snapshot;
+    EXPECT_FALSE(statistics.getSnapshot(rmap::maxStatisticsTargets, snapshot));
+    EXPECT_EQ(1U, statistics.getUntrackedEvents());
+
+    ASSERT_TRUE(statistics.getSnapshotByIndex(rmap::maxStatisticsTargets - 1, snapshot));
+    EXPECT_EQ(rmap::maxStatisticsTargets - 1, snapshot.mTargetId);
+    EXPECT_FALSE(statistics.getSnapshotByIndex(rmap::maxStatisticsTargets, snapshot));
+}
+
+TEST(RmapStatisticsTest, shouldKeepTransactionsInFlightOnReset)
+{
+    RmapStatistics statistics;
+    statistics.commandSent(1, 4, true);
+    statistics.reset();
+
+    RmapTargetStatistics snapshot;
+    ASSERT_TRUE(statistics.getSnapshot(1, snapshot));
+    EXPECT_EQ(0U, snapshot.mCommands);
+    EXPECT_EQ(0U, snapshot.mBytesWritten);
+    EXPECT_EQ(1, snapshot.mInFlight);
+
+    statistics.replyReceived(1, outpost::time::Microseconds(10), 0, 0);
+    ASSERT_TRUE(statistics.getSnapshot(1, snapshot));
+    EXPECT_EQ(0, snapshot.mInFlight);
+    EXPECT_EQ(1U, snapshot.mReplies);
+}
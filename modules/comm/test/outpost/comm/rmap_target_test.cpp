@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/comm/rmap/rmap_target.h>
+#include <outpost/utils/coding/crc.h>
+
+#include <unittest/hal/spacewire_stub.h>
+#include <unittest/harness.h>
+
+#include <vector>
+
+using outpost::hal::SpaceWire;
+
+using namespace outpost::comm;
+
+namespace
+{
+class MemoryHandlerTest : public RmapMemoryHandler
+{
+public:
+    MemoryHandlerTest() : mLastAddress(0), mLastIncrement(true), mWrites(0), mValue(0x5A)
+    {
+    }
+
+    virtual uint8_t
+    read(uint32_t address, outpost::Slice<uint8_t> data, bool increment) override
+    {
+        mLastAddress = address;
+        mLastIncrement = increment;
+        for (size_t i = 0; i < data.getNumberOfElements(); i++)
+        {
+            data[i] = mValue;
+        }
+        return RmapReplyStatus::commandExecutedSuccessfully;
+    }
+
+    virtual uint8_t
+    write(uint32_t address, outpost::Slice<const uint8_t> data, bool increment) override
+    {
+        mLastAddress = address;
+        mLastIncrement = increment;
+        mWrites++;
+        if (data.getNumberOfElements() > 0)
+        {
+            mValue = data[data.getNumberOfElements() - 1];
+        }
+        return RmapReplyStatus::commandExecutedSuccessfully;
+    }
+
+    uint32_t mLastAddress;
+    bool mLastIncrement;
+    size_t mWrites;
+    uint8_t mValue;
+};
+
+/**
+ * Build a command packet without target SpaceWire address.
+ */
+static std::vector<uint8_t>
+createCommand(uint8_t instruction,
+              uint8_t key,
+              uint32_t address,
+              std::vector<uint8_t> data,
+              uint32_t dataLength,
+              uint8_t targetLogicalAddress = 0xFE)
+{
+    std::vector<uint8_t> packet = {targetLogicalAddress,
+                                   rmap::protocolIdentifier,
+                                   instruction,
+                                   key,
+                                   0x67,
+                                   0x00,
+                                   0x2A,
+                                   0x00,
+                                   static_cast<uint8_t>(address >> 24),
+                                   static_cast<uint8_t>(address >> 16),
+                                   static_cast<uint8_t>(address >> 8),
+                                   static_cast<uint8_t>(address),
+                                   static_cast<uint8_t>(dataLength >> 16),
+                                   static_cast<uint8_t>(dataLength >> 8),
+                                   static_cast<uint8_t>(dataLength)};
+    packet.push_back(outpost::Crc8CcittReversed::calculate(
+            outpost::Slice<const uint8_t>::unsafe(packet.data(), packet.size())));
+
+    if (instruction & 0x30)
+    {
+        packet.insert(packet.end(), data.begin(), data.end());
+        packet.push_back(outpost::Crc8CcittReversed::calculate(
+                outpost::Slice<const uint8_t>::unsafe(data.data(), data.size())));
+    }
+    return packet;
+}
+
+// Command codes including the command packet type
+static constexpr uint8_t readCommand = 0x4C;
+static constexpr uint8_t writeCommand = 0x6C;
+static constexpr uint8_t verifiedWriteCommand = 0x7C;
+static constexpr uint8_t readModifyWriteCommand = 0x5C;
+}  // namespace
+
+class RmapTargetTest : public testing::Test
+{
+public:
+    static const uint8_t logicalAddress = 0xFE;
+    static const uint8_t key = 0x20;
+
+    RmapTargetTest() :
+        mSpaceWire(100),
+        mTarget(mSpaceWire,
+                logicalAddress,
+                key,
+                100,
+                4096,
+                outpost::support::parameter::HeartbeatSource::default0),
+        mMemory(),
+        mRegion(0x1000, outpost::asSlice(mMemory), RmapMemoryRegion::readWrite)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        mSpaceWire.open();
+        mSpaceWire.up(outpost::time::Duration::zero());
+        for (size_t i = 0; i < sizeof(mMemory); i++)
+        {
+            mMemory[i] = i;
+        }
+        mTarget.addMemoryRegion(&mRegion);
+    }
+
+    void
+    receive(std::vector<uint8_t> packet, SpaceWire::EndMarker end = SpaceWire::eop)
+    {
+        mSpaceWire.mPacketsToReceive.emplace_back(
+                unittest::hal::SpaceWireStub::Packet{packet, end});
+    }
+
+    size_t
+    process()
+    {
+        return mTarget.processCommands(outpost::time::Duration::zero());
+    }
+
+    std::vector<uint8_t>
+    takeReply()
+    {
+        std::vector<uint8_t> reply;
+        if (!mSpaceWire.mSentPackets.empty())
+        {
+            reply = mSpaceWire.mSentPackets.front().data;
+            mSpaceWire.mSentPackets.pop_front();
+        }
+        return reply;
+    }
+
+    unittest::hal::SpaceWireStub mSpaceWire;
+    RmapTarget mTarget;
+    uint8_t mMemory[32];
+    RmapMemoryRegion mRegion;
+};
+
+const uint8_t RmapTargetTest::logicalAddress;
+const uint8_t RmapTargetTest::key;
+
+TEST_F(RmapTargetTest, shouldAnswerReadCommand)
+{
+    receive(createCommand(readCommand, key, 0x1004, {}, 4));
+    EXPECT_EQ(1U, process());
+
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(12U + 4 + 1, reply.size());
+    EXPECT_EQ(0x67, reply[0]);
+    EXPECT_EQ(rmap::protocolIdentifier, reply[1]);
+    EXPECT_EQ(readCommand & ~0x40, reply[2]);
+    EXPECT_EQ(RmapReplyStatus::commandExecutedSuccessfully, reply[3]);
+    EXPECT_EQ(logicalAddress, reply[4]);
+    EXPECT_EQ(0x00, reply[5]);
+    EXPECT_EQ(0x2A, reply[6]);
+    EXPECT_EQ(4, reply[10]);
+    EXPECT_EQ(outpost::Crc8CcittReversed::calculate(
+                      outpost::Slice<const uint8_t>::unsafe(reply.data(), 11)),
+              reply[11]);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(4 + i, reply[12 + i]);
+    }
+    EXPECT_EQ(outpost::Crc8CcittReversed::calculate(
+                      outpost::Slice<const uint8_t>::unsafe(&reply[12], 4)),
+              reply[16]);
+
+    EXPECT_EQ(1U, mTarget.getCounters().mExecutedCommands);
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+    EXPECT_TRUE(mSpaceWire.noUsedTransmitBuffers());
+}
+
+TEST_F(RmapTargetTest, shouldExecuteWriteCommand)
+{
+    receive(createCommand(writeCommand, key, 0x1010, {0xA1, 0xA2, 0xA3}, 3));
+    EXPECT_EQ(1U, process());
+
+    EXPECT_EQ(0xA1, mMemory[0x10]);
+    EXPECT_EQ(0xA2, mMemory[0x11]);
+    EXPECT_EQ(0xA3, mMemory[0x12]);
+    EXPECT_EQ(0x13, mMemory[0x13]);
+
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(8U, reply.size());
+    EXPECT_EQ(RmapReplyStatus::commandExecutedSuccessfully, reply[3]);
+    EXPECT_EQ(outpost::Crc8CcittReversed::calculate(
+                      outpost::Slice<const uint8_t>::unsafe(reply.data(), 7)),
+              reply[7]);
+}
+
+TEST_F(RmapTargetTest, shouldExecuteVerifiedWriteWithoutReply)
+{
+    // Reply flag cleared
+    receive(createCommand(verifiedWriteCommand & ~0x08, key, 0x1000, {0x55, 0x66}, 2));
+    EXPECT_EQ(1U, process());
+
+    EXPECT_EQ(0x55, mMemory[0]);
+    EXPECT_EQ(0x66, mMemory[1]);
+    EXPECT_TRUE(mSpaceWire.mSentPackets.empty());
+    EXPECT_EQ(1U, mTarget.getCounters().mExecutedCommands);
+}
+
+TEST_F(RmapTargetTest, shouldProcessAllQueuedCommands)
+{
+    receive(createCommand(writeCommand, key, 0x1000, {0x01}, 1));
+    receive(createCommand(writeCommand, key, 0x1001, {0x02}, 1));
+    receive(createCommand(readCommand, key, 0x1000, {}, 2));
+
+    EXPECT_EQ(3U, process());
+    EXPECT_EQ(3U, mSpaceWire.mSentPackets.size());
+    takeReply();
+    takeReply();
+
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(12U + 2 + 1, reply.size());
+    EXPECT_EQ(0x01, reply[12]);
+    EXPECT_EQ(0x02, reply[13]);
+}
+
+TEST_F(RmapTargetTest, shouldRejectInvalidKey)
+{
+    receive(createCommand(writeCommand, key + 1, 0x1000, {0xFF}, 1));
+    process();
+
+    EXPECT_EQ(0x00, mMemory[0]);
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(8U, reply.size());
+    EXPECT_EQ(RmapReplyStatus::invalidKey, reply[3]);
+    EXPECT_EQ(1U, mTarget.getCounters().mRejectedCommands);
+}
+
+TEST_F(RmapTargetTest, shouldRejectInvalidTargetLogicalAddress)
+{
+    receive(createCommand(readCommand, key, 0x1000, {}, 1, 0x40));
+    process();
+
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(12U + 1, reply.size());
+    EXPECT_EQ(RmapReplyStatus::invalidTargetLogicalAddress, reply[3]);
+    EXPECT_EQ(0, reply[10]);
+}
+
+TEST_F(RmapTargetTest, shouldRejectInvalidDataCrc)
+{
+    std::vector<uint8_t> command = createCommand(writeCommand, key, 0x1000, {0x11, 0x22}, 2);
+    command.back() ^= 0xFF;
+    receive(command);
+    process();
+
+    EXPECT_EQ(0x00, mMemory[0]);
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(8U, reply.size());
+    EXPECT_EQ(RmapReplyStatus::invalidDataCrc, reply[3]);
+}
+
+TEST_F(RmapTargetTest, shouldRejectMissingData)
+{
+    std::vector<uint8_t> command = createCommand(writeCommand, key, 0x1000, {0x11, 0x22}, 2);
+    command.pop_back();
+    receive(command);
+    process();
+
+    EXPECT_EQ(RmapReplyStatus::earlyEOP, takeReply()[3]);
+
+    receive(createCommand(writeCommand, key, 0x1000, {0x11, 0x22}, 2), SpaceWire::eep);
+    process();
+    EXPECT_EQ(RmapReplyStatus::eep, takeReply()[3]);
+}
+
+TEST_F(RmapTargetTest, shouldDiscardPacketWithInvalidHeaderCrc)
+{
+    std::vector<uint8_t> command = createCommand(readCommand, key, 0x1000, {}, 4);
+    command[15] ^= 0x01;
+    receive(command);
+    process();
+
+    EXPECT_TRUE(mSpaceWire.mSentPackets.empty());
+    EXPECT_EQ(1U, mTarget.getCounters().mHeaderCrcErrors);
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+}
+
+TEST_F(RmapTargetTest, shouldRejectAccessOutsideOfRegions)
+{
+    receive(createCommand(readCommand, key, 0x101E, {}, 4));
+    process();
+    EXPECT_EQ(RmapReplyStatus::rmapCommandNotImplemented, takeReply()[3]);
+
+    // Plain memory does not support non-incrementing accesses
+    receive(createCommand(readCommand & ~0x04, key, 0x1000, {}, 4));
+    process();
+    EXPECT_EQ(RmapReplyStatus::rmapCommandNotImplemented, takeReply()[3]);
+
+    // Region does not allow read-modify-write
+    receive(createCommand(readModifyWriteCommand, key, 0x1000, {0x00, 0xFF}, 2));
+    process();
+    EXPECT_EQ(RmapReplyStatus::rmapCommandNotImplemented, takeReply()[3]);
+}
+
+TEST_F(RmapTargetTest, shouldExecuteReadModifyWrite)
+{
+    uint8_t memory[4] = {0xF0, 0xF0, 0xF0, 0xF0};
+    RmapMemoryRegion region(0x2000, outpost::asSlice(memory), RmapMemoryRegion::all);
+    ASSERT_TRUE(mTarget.addMemoryRegion(&region));
+
+    receive(createCommand(readModifyWriteCommand, key, 0x2001, {0x0F, 0xAA, 0x0F, 0x0F}, 4));
+    process();
+
+    EXPECT_EQ(0xF0, memory[0]);
+    EXPECT_EQ(0xFF, memory[1]);
+    EXPECT_EQ(0xFA, memory[2]);
+    EXPECT_EQ(0xF0, memory[3]);
+
+    // The reply contains the previous content
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(12U + 2 + 1, reply.size());
+    EXPECT_EQ(RmapReplyStatus::commandExecutedSuccessfully, reply[3]);
+    EXPECT_EQ(0xF0, reply[12]);
+    EXPECT_EQ(0xF0, reply[13]);
+
+    receive(createCommand(readModifyWriteCommand, key, 0x2000, {0x01, 0x02, 0x03}, 3));
+    process();
+    EXPECT_EQ(RmapReplyStatus::rmwDataLengthError, takeReply()[3]);
+}
+
+TEST_F(RmapTargetTest, shouldAccessHandlerRegion)
+{
+    MemoryHandlerTest handler;
+    RmapMemoryRegion region(0x80000000, 16, handler, RmapMemoryRegion::readWrite, 0x00);
+    ASSERT_TRUE(mTarget.addMemoryRegion(&region));
+
+    receive(createCommand(writeCommand & ~0x04, key, 0x80000004, {0x11, 0x22}, 2));
+    process();
+    EXPECT_EQ(RmapReplyStatus::commandExecutedSuccessfully, takeReply()[3]);
+    EXPECT_EQ(1U, handler.mWrites);
+    EXPECT_EQ(0x80000004, handler.mLastAddress);
+    EXPECT_FALSE(handler.mLastIncrement);
+
+    receive(createCommand(readCommand & ~0x04, key, 0x80000004, {}, 3));
+    process();
+    std::vector<uint8_t> reply = takeReply();
+    ASSERT_EQ(12U + 3 + 1, reply.size());
+    EXPECT_EQ(0x22, reply[12]);
+    EXPECT_EQ(0x22, reply[14]);
+}
+
+namespace
+{
+/// Transmit buffers are smaller than the announced maximum packet length
+class SmallBufferSpaceWireStub : public unittest::hal::SpaceWireStub
+{
+public:
+    SmallBufferSpaceWireStub() : unittest::hal::SpaceWireStub(20)
+    {
+    }
+
+    virtual size_t
+    getMaximumPacketLength() const override
+    {
+        return 100;
+    }
+};
+}  // namespace
+
+TEST(RmapTargetBufferTest, shouldRejectReadExceedingTransmitBuffer)
+{
+    SmallBufferSpaceWireStub spaceWire;
+    RmapTarget target(spaceWire,
+                      RmapTargetTest::logicalAddress,
+                      RmapTargetTest::key,
+                      100,
+                      4096,
+                      outpost::support::parameter::HeartbeatSource::default0);
+    uint8_t memory[32] = {0};
+    RmapMemoryRegion region(0x1000, outpost::asSlice(memory), RmapMemoryRegion::readWrite);
+    target.addMemoryRegion(&region);
+    spaceWire.open();
+    spaceWire.up(outpost::time::Duration::zero());
+
+    spaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createCommand(readCommand, RmapTargetTest::key, 0x1000, {}, 16), SpaceWire::eop});
+    EXPECT_EQ(1U, target.processCommands(outpost::time::Duration::zero()));
+
+    // Error reply without data instead of a truncated data field
+    ASSERT_EQ(1U, spaceWire.mSentPackets.size());
+    std::vector<uint8_t> reply = spaceWire.mSentPackets.front().data;
+    ASSERT_EQ(12U + 1, reply.size());
+    EXPECT_EQ(RmapReplyStatus::generalErrorCode, reply[3]);
+    EXPECT_EQ(0, reply[10]);
+    EXPECT_EQ(1U, target.getCounters().mRejectedCommands);
+    EXPECT_TRUE(spaceWire.noUsedTransmitBuffers());
+}
+
+TEST_F(RmapTargetTest, shouldLimitNumberOfMemoryRegions)
+{
+    uint8_t memory[1];
+    std::vector<RmapMemoryRegion> regions(
+            rmap::maxMemoryRegions,
+            RmapMemoryRegion(0x3000, outpost::asSlice(memory), RmapMemoryRegion::read));
+
+    // One region has already been added by the fixture
+    for (size_t i = 1; i < rmap::maxMemoryRegions; i++)
+    {
+        EXPECT_TRUE(mTarget.addMemoryRegion(&regions[i]));
+    }
+    EXPECT_FALSE(mTarget.addMemoryRegion(&regions[0]));
+}
@@ -14,6 +14,7 @@
 
 #include <outpost/base/slice.h>
 #include <outpost/comm/rmap/rmap_initiator.h>
+#include <outpost/comm/rmap/rmap_target.h>
 #include <outpost/smpc/subscription.h>
 #include <outpost/utils/coding/crc.h>
 #include <outpost/utils/storage/bit_access.h>
@@ -21,6 +22,10 @@
 #include <unittest/hal/spacewire_stub.h>
 #include <unittest/harness.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace outpost
 {
 namespace comm
@@ -34,16 +39,16 @@ public:
         return init.mTransactionsList.getActiveTransactions();
     }
 
-    void
-    addTransaction(RmapInitiator& init, RmapTransaction* trans)
+    RmapTransaction*
+    allocateTransaction(RmapInitiator& init)
     {
-        init.mTransactionsList.addTransaction(trans);
+        return init.mTransactionsList.allocateTransaction();
     }
 
     void
-    removeTransaction(RmapInitiator& init, uint16_t tid)
+    freeTransaction(RmapInitiator& init, RmapTransaction* trans)
     {
-        init.mTransactionsList.removeTransaction(tid);
+        init.mTransactionsList.freeTransaction(trans);
     }
 
     RmapTransaction*
@@ -65,15 +70,119 @@ public:
     }
 
     bool
-    receivePacket(RmapInitiator& init, RmapPacket* pkt)
+    receivePacket(RmapInitiator& init,
+                  RmapPacketView& packet,
+                  hal::SpaceWire::ReceiveBuffer& buffer)
     {
-        return init.receivePacket(pkt);
+        return init.receivePacket(packet, buffer);
     }
 
     void
-    getRxData(RmapInitiator& init, uint8_t* buffer)
+    releaseBuffer(RmapInitiator& init, hal::SpaceWire::ReceiveBuffer& buffer)
+    {
+        init.mSpW.releaseBuffer(buffer);
+    }
+
+    /**
+     * Receive the next packet and process it as a reply in the same way
+     * as the receiving thread does.
+     */
+    bool
+    receiveReply(RmapInitiator& init)
     {
-        init.mRxData.getData(buffer);
+        hal::SpaceWire::ReceiveBuffer buffer;
+        RmapPacketView packet;
+        if (!init.receivePacket(packet, buffer))
+        {
+            return false;
+        }
+        init.replyPacketReceived(packet);
+        init.mSpW.releaseBuffer(buffer);
+        return true;
+    }
+
+    void
+    replyPacketReceived(RmapInitiator& init, const RmapPacketView& packet)
+    {
+        init.replyPacketReceived(packet);
+    }
+
+    /**
+     * Take the oldest packet sent by the initiator, may be used while
+     * other threads start transactions.
+     */
+    bool
+    takeSentPacket(RmapInitiator& init,
+                   unittest::hal::SpaceWireStub& spaceWire,
+                   std::vector<uint8_t>& packet)
+    {
+        outpost::rtos::MutexGuard lock(init.mOperationLock);
+        if (spaceWire.mSentPackets.empty())
+        {
+            return false;
+        }
+        packet = spaceWire.mSentPackets.front().data;
+        spaceWire.mSentPackets.pop_front();
+        return true;
+    }
+
+    /**
+     * Forward the oldest command of the initiator to the target and its
+     * reply back to the initiator.
+     *
+     * The reply starts with the path address from the reply address of
+     * the target node, which is removed as a router would do.
+     */
+    bool
+    forwardToTarget(RmapInitiator& init,
+                    unittest::hal::SpaceWireStub& initiatorSpaceWire,
+                    RmapTarget& target,
+                    unittest::hal::SpaceWireStub& targetSpaceWire)
+    {
+        std::vector<uint8_t> packet;
+        if (!takeSentPacket(init, initiatorSpaceWire, packet))
+        {
+            return false;
+        }
+        targetSpaceWire.mPacketsToReceive.emplace_back(
+                unittest::hal::SpaceWireStub::Packet{packet, hal::SpaceWire::eop});
+        target.processCommands(outpost::time::Duration::zero());
+
+        if (targetSpaceWire.mSentPackets.empty())
+        {
+            return false;
+        }
+        unittest::hal::SpaceWireStub::Packet reply = targetSpaceWire.mSentPackets.front();
+        targetSpaceWire.mSentPackets.pop_front();
+        reply.data.erase(reply.data.begin());
+        initiatorSpaceWire.mPacketsToReceive.push_back(reply);
+
+        return receiveReply(init);
+    }
+
+    uint8_t
+    getActiveTransactionsLocked(RmapInitiator& init)
+    {
+        outpost::rtos::MutexGuard lock(init.mOperationLock);
+        return init.mTransactionsList.getActiveTransactions();
+    }
+
+    void
+    expireTransactions(RmapInitiator& init)
+    {
+        init.expireTransactions();
+    }
+
+    void
+    checkLinks(RmapInitiator& init)
+    {
+        init.checkLinks();
+    }
+
+    outpost::time::Duration
+    getReceiveTimeout(RmapInitiator& init)
+    {
+        return init.getReceiveTimeout();
     }
 
     void
@@ -108,6 +217,43 @@ public:
     bool mDataReceived;
 };
 
+class CompletionReceiverTest : public outpost::Callable
+{
+public:
+    CompletionReceiverTest() : mHandle(), mCalls(0)
+    {
+    }
+
+    void
+    onCompletion(const outpost::comm::RmapTransactionHandle& handle)
+    {
+        mHandle = handle;
+        mCalls++;
+    }
+
+    outpost::comm::RmapTransactionHandle mHandle;
+    size_t mCalls;
+};
+
+class HandlerTest : public outpost::comm::SpaceWireProtocolHandler
+{
+public:
+    HandlerTest() : mCalls(0), mLastPacket()
+    {
+    }
+
+    virtual bool
+    handlePacket(const outpost::utils::SharedChildPointer& packet) override
+    {
+        mCalls++;
+        mLastPacket = packet;
+        return true;
+    }
+
+    size_t mCalls;
+    outpost::utils::SharedChildPointer mLastPacket;
+};
+
 using outpost::hal::SpaceWire;
 
 using namespace outpost::comm;
@@ -163,6 +309,89 @@ uint8_t RmapTest::targetSpwAddress[numberOfTargetSpwAddresses] = {0};
 uint8_t RmapTest::replyAddress[replyAddressLength] = {0, 0, 0, 2};
 const char* RmapTest::targetName = "SpWR";
 
+static std::vector<uint8_t>
+createReadReply(uint16_t transactionId, outpost::Slice<const uint8_t> data)
+{
+    // Header with CRC, data and data CRC
+    std::vector<uint8_t> reply(12 + data.getNumberOfElements() + 1);
+    outpost::Serialize stream{outpost::asSlice(reply)};
+
+    RmapPacket::InstructionField instr;
+    instr.setPacketType(RmapPacket::InstructionField::replyPacket);
+    instr.setOperation(RmapPacket::InstructionField::read);
+
+    stream.store<uint8_t>(rmap::defaultLogicalAddress);  // Initiator logical address field
+    stream.store<uint8_t>(rmap::protocolIdentifier);     // RMAP protocol ID field
+    stream.store<uint8_t>(instr.getRaw());               // Instruction field
+    stream.store<uint8_t>(0);                            // Status field
+    stream.store<uint8_t>(rmap::defaultLogicalAddress);  // Target logical address field
+    stream.store<uint16_t>(transactionId);               // Transaction ID
+    stream.store<uint8_t>(0);                            // Reserved byte
+    stream.store24(data.getNumberOfElements());          // Data length
+
+    uint8_t crc = outpost::Crc8CcittReversed::calculate(
+            outpost::Slice<uint8_t>::unsafe(stream.getPointer(), stream.getPosition()));
+    stream.store<uint8_t>(crc);  // Header CRC
+    stream.store(data);          // Data bytes
+    stream.store<uint8_t>(outpost::Crc8CcittReversed::calculate(data));  // Data CRC
+
+    return reply;
+}
+
+static std::vector<uint8_t>
+createWriteReply(uint16_t transactionId, uint8_t status)
+{
+    uint8_t reply[16];
+    outpost::Serialize stream{outpost::asSlice(reply)};
+
+    RmapPacket::InstructionField instr;
+    instr.setPacketType(RmapPacket::InstructionField::replyPacket);
+    instr.setOperation(RmapPacket::InstructionField::write);
+
+    stream.store<uint8_t>(rmap::defaultLogicalAddress);  // Initiator logical address field
+    stream.store<uint8_t>(rmap::protocolIdentifier);     // RMAP protocol ID field
+    stream.store<uint8_t>(instr.getRaw());               // Instruction field
+    stream.store<uint8_t>(status);                       // Status field
+    stream.store<uint8_t>(rmap::defaultLogicalAddress);  // Target logical address field
+    stream.store<uint16_t>(transactionId);               // Transaction ID
+
+    uint8_t crc = outpost::Crc8CcittReversed::calculate(
+            outpost::Slice<uint8_t>::unsafe(stream.getPointer(), stream.getPosition()));
+    stream.store<uint8_t>(crc);  // Header CRC
+
+    return std::vector<uint8_t>(reply, reply + stream.getPosition());
+}
+
+/**
+ * Fields of a command sent to the test target, which uses a single byte
+ * SpaceWire address and a four byte reply address.
+ */
+struct SentCommand
+{
+    explicit SentCommand(const std::vector<uint8_t>& packet)
+    {
+        outpost::Deserialize stream(outpost::asSlice(packet));
+        stream.skip(3);
+        RmapPacket::InstructionField instr;
+        instr.setAllRaw(stream.read<uint8_t>());
+        isWrite = (instr.getOperation() == RmapPacket::InstructionField::write);
+        stream.skip(6);
+        transactionId = stream.read<uint16_t>();
+        stream.skip(1);
+        address = stream.read<uint32_t>();
+        length = stream.readUnsigned24();
+        stream.skip(1);
+        data = std::vector<uint8_t>(packet.begin() + stream.getPosition(),
+                                    packet.begin() + stream.getPosition() + (isWrite ? length : 0));
+    }
+
+    bool isWrite;
+    uint16_t transactionId;
+    uint32_t address;
+    uint32_t length;
+    std::vector<uint8_t> data;
+};
+
 // ----------------------------------------------------------------------------
 TEST_F(RmapTest, shouldGetEmptyRmapTargetList)
 {
@@ -184,30 +413,62 @@ TEST_F(RmapTest, shouldGetEmptyTransactionsList)
 
 TEST_F(RmapTest, shouldAddAndRemoveEmptyTransactionInList)
 {
-    RmapTransaction transaction;
-    transaction.setTransactionID(50);
-    mTestingRmap.addTransaction(mRmapInitiator, &transaction);
+    RmapTransaction* transaction = mTestingRmap.allocateTransaction(mRmapInitiator);
+    ASSERT_NE(nullptr, transaction);
+    EXPECT_NE(0, transaction->getTransactionID());
     EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
-    mTestingRmap.removeTransaction(mRmapInitiator, 50);
+    mTestingRmap.freeTransaction(mRmapInitiator, transaction);
     EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
 }
 
 TEST_F(RmapTest, shouldGetAddedTransactionFromList)
 {
-    RmapTransaction transaction;
-    transaction.setTransactionID(60);
-    mTestingRmap.addTransaction(mRmapInitiator, &transaction);
+    RmapTransaction* transaction = mTestingRmap.allocateTransaction(mRmapInitiator);
+    uint16_t tid = transaction->getTransactionID();
     EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
-    EXPECT_EQ(60, mTestingRmap.getTransaction(mRmapInitiator, 60)->getTransactionID());
+    EXPECT_EQ(transaction, mTestingRmap.getTransaction(mRmapInitiator, tid));
+    EXPECT_EQ(nullptr, mTestingRmap.getTransaction(mRmapInitiator, 0));
 }
 
 TEST_F(RmapTest, shouldGetUsedTransactionFromList)
 {
-    RmapTransaction transaction;
-    transaction.setTransactionID(80);
-    mTestingRmap.addTransaction(mRmapInitiator, &transaction);
+    RmapTransaction* transaction = mTestingRmap.allocateTransaction(mRmapInitiator);
+    uint16_t tid = transaction->getTransactionID();
     EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
-    EXPECT_TRUE(mTestingRmap.isUsedTransaction(mRmapInitiator, 80));
+    EXPECT_TRUE(mTestingRmap.isUsedTransaction(mRmapInitiator, tid));
+
+    mTestingRmap.freeTransaction(mRmapInitiator, transaction);
+    EXPECT_FALSE(mTestingRmap.isUsedTransaction(mRmapInitiator, tid));
+}
+
+TEST_F(RmapTest, shouldAssignNewTransactionIdWhenSlotIsReused)
+{
+    RmapTransaction* transaction = mTestingRmap.allocateTransaction(mRmapInitiator);
+    uint16_t previousTid = transaction->getTransactionID();
+    mTestingRmap.freeTransaction(mRmapInitiator, transaction);
+
+    // Same slot is used again but a stale ID does not resolve to it
+    RmapTransaction* reused = mTestingRmap.allocateTransaction(mRmapInitiator);
+    EXPECT_EQ(transaction, reused);
+    EXPECT_NE(previousTid, reused->getTransactionID());
+    EXPECT_EQ(nullptr, mTestingRmap.getTransaction(mRmapInitiator, previousTid));
+    EXPECT_EQ(reused, mTestingRmap.getTransaction(mRmapInitiator, reused->getTransactionID()));
+}
+
+TEST_F(RmapTest, shouldAllocateAllTransactionSlotsWithDistinctIds)
+{
+    RmapTransaction* transactions[rmap::maxConcurrentTransactions];
+    for (uint8_t i = 0; i < rmap::maxConcurrentTransactions; i++)
+    {
+        transactions[i] = mTestingRmap.allocateTransaction(mRmapInitiator);
+        ASSERT_NE(nullptr, transactions[i]);
+        for (uint8_t k = 0; k < i; k++)
+        {
+            EXPECT_NE(transactions[k]->getTransactionID(), transactions[i]->getTransactionID());
+        }
+    }
+    EXPECT_EQ(nullptr, mTestingRmap.allocateTransaction(mRmapInitiator));
+    EXPECT_EQ(rmap::maxConcurrentTransactions, mTestingRmap.getActiveTransactions(mRmapInitiator));
 }
 
 TEST_F(RmapTest, shouldSetReplyPacketType)
@@ -238,6 +499,21 @@ TEST_F(RmapTest, shouldSetReadOperationType)
     EXPECT_EQ(RmapPacket::InstructionField::read, instruction.getOperation());
 }
 
+TEST_F(RmapTest, shouldSetReadModifyWriteOperation)
+{
+    RmapPacket packet;
+    packet.setCommand();
+    packet.setReadModifyWrite();
+
+    EXPECT_TRUE(packet.isReadModifyWrite());
+    EXPECT_TRUE(packet.isRead());
+    EXPECT_TRUE(packet.isReplyFlagSet());
+    EXPECT_TRUE(packet.isIncrementFlagSet());
+
+    packet.unsetVerifyFlag();
+    EXPECT_FALSE(packet.isReadModifyWrite());
+}
+
 TEST_F(RmapTest, shouldSetZeroReplyAddressLength)
 {
     RmapPacket::InstructionField instruction;
@@ -289,6 +565,60 @@ TEST_F(RmapTest, shouldBuildVerifyPacketHeaderCRC)
     EXPECT_EQ(calculatedCrc, send.getHeaderCRC());
 }
 
+TEST_F(RmapTest, shouldBuildSameHeaderFromTemplate)
+{
+    EXPECT_TRUE(mTargetNodes.addTargetNode(&mRmapTarget));
+    EXPECT_TRUE(mRmapTarget.getHeaderTemplate().isValid());
+
+    for (uint8_t variant = 0; variant < RmapHeaderTemplate::numberOfInstructionVariants; variant++)
+    {
+        RmapPacket packets[2];
+        for (RmapPacket& packet : packets)
+        {
+            packet.setCommand();
+            (variant & 0x08) ? packet.setWrite() : packet.setRead();
+            (variant & 0x04) ? packet.setVerifyFlag() : packet.unsetVerifyFlag();
+            (variant & 0x02) ? packet.setReplyFlag() : packet.unsetReplyFlag();
+            (variant & 0x01) ? packet.setIncrementFlag() : packet.unsetIncrementFlag();
+            packet.setTransactionID(0x1234 + variant);
+            packet.setExtendedAddress(rmap::defaultExtendedAddress);
+            packet.setAddress(0x40001000);
+            packet.setDataLength(0x10203);
+            packet.setTargetInformation(mRmapTarget);
+        }
+
+        // Setting a target field drops the template, the header is then
+        // built field by field
+        packets[1].setKey(mRmapTarget.getKey());
+
+        uint8_t buffers[2][50] = {{0}};
+        mTestingRmap.constructPacketHeader(packets[0], buffers[0]);
+        mTestingRmap.constructPacketHeader(packets[1], buffers[1]);
+
+        ASSERT_EQ(packets[1].getHeaderLength(), packets[0].getHeaderLength());
+        EXPECT_EQ(packets[1].getHeaderCRC(), packets[0].getHeaderCRC());
+        EXPECT_EQ(0, memcmp(buffers[0], buffers[1], packets[0].getHeaderLength() + 1));
+    }
+}
+
+TEST_F(RmapTest, shouldRebuildHeaderTemplateAfterTargetChange)
+{
+    EXPECT_TRUE(mTargetNodes.addTargetNode(&mRmapTarget));
+
+    mRmapTarget.setKey(0x42);
+
+    RmapPacket packet;
+    packet.setCommand();
+    packet.setRead();
+    packet.setTargetInformation(mRmapTarget);
+
+    uint8_t buffer[50] = {0};
+    mTestingRmap.constructPacketHeader(packet, buffer);
+
+    // Key follows the target logical address, protocol ID and instruction
+    EXPECT_EQ(0x42, buffer[mRmapTarget.getTargetSpaceWireAddress().getNumberOfElements() + 3]);
+}
+
 TEST_F(RmapTest, shouldSendWriteCommandPacket)
 {
     // Register RMAP target
@@ -348,10 +678,14 @@ TEST_F(RmapTest, shouldReceiveReplyOfWriteCommandPacket)
     mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
             std::vector<uint8_t>(reply, reply + stream.getPosition()), SpaceWire::eop});
 
-    RmapPacket receivedPacket;
-    EXPECT_TRUE(mTestingRmap.receivePacket(mRmapInitiator, &receivedPacket));
+    RmapPacketView receivedPacket;
+    SpaceWire::ReceiveBuffer rxBuffer;
+    EXPECT_TRUE(mTestingRmap.receivePacket(mRmapInitiator, receivedPacket, rxBuffer));
     EXPECT_TRUE(receivedPacket.isReplyPacket());
     EXPECT_TRUE(receivedPacket.isWrite());
+    EXPECT_EQ(1, receivedPacket.getTransactionID());
+    EXPECT_EQ(0U, receivedPacket.getDataLength());
+    mTestingRmap.releaseBuffer(mRmapInitiator, rxBuffer);
 
     EXPECT_TRUE(mSpaceWire.mPacketsToReceive.empty());
     EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
@@ -426,16 +760,19 @@ TEST_F(RmapTest, shouldReceiveReplyOfReadCommandPacket)
     mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
             std::vector<uint8_t>(reply, reply + stream.getPosition()), SpaceWire::eop});
 
-    RmapPacket rxedPacket;
-    EXPECT_TRUE(mTestingRmap.receivePacket(mRmapInitiator, &rxedPacket));
+    RmapPacketView rxedPacket;
+    SpaceWire::ReceiveBuffer rxBuffer;
+    EXPECT_TRUE(mTestingRmap.receivePacket(mRmapInitiator, rxedPacket, rxBuffer));
     EXPECT_TRUE(rxedPacket.isReplyPacket());
 
-    uint8_t rxbuffer[10];
-    mTestingRmap.getRxData(mRmapInitiator, rxbuffer);
+    // Packet data refers to the receive buffer until it is released
+    ASSERT_EQ(sizeof(data), rxedPacket.getDataLength());
+    EXPECT_EQ(rxBuffer.getData().begin() + 12, rxedPacket.getData().begin());
     for (uint8_t i = 0; i < rxedPacket.getDataLength(); i++)
     {
-        EXPECT_EQ(rxbuffer[i], data[i]);
+        EXPECT_EQ(rxedPacket.getData()[i], data[i]);
     }
+    mTestingRmap.releaseBuffer(mRmapInitiator, rxBuffer);
 
     EXPECT_TRUE(mSpaceWire.mPacketsToReceive.empty());
     EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
@@ -456,8 +793,9 @@ TEST_F(RmapTest, shouldReceiveAndPublishNonRmapPacket)
     mSpaceWire.mPacketsToReceive.emplace_back(
             unittest::hal::SpaceWireStub::Packet{rply, SpaceWire::eop});
 
-    RmapPacket rxedPacket;
-    EXPECT_FALSE(mTestingRmap.receivePacket(mRmapInitiator, &rxedPacket));
+    RmapPacketView rxedPacket;
+    SpaceWire::ReceiveBuffer rxBuffer;
+    EXPECT_FALSE(mTestingRmap.receivePacket(mRmapInitiator, rxedPacket, rxBuffer));
     EXPECT_TRUE(mNonRmapReceiver.mDataReceived);
 
     for (uint8_t i = 0; i < 4; i++)
@@ -492,3 +830,1057 @@ TEST_F(RmapTest, shouldSendHigherLevelWriteCommandPacket)
     EXPECT_EQ(expectedSize, mSpaceWire.mSentPackets.size());
     EXPECT_TRUE(mSpaceWire.noUsedTransmitBuffers());
 }
+
+TEST_F(RmapTest, shouldNotBlockOtherTransactionsWhileWaitingForReply)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t dataToSend[4] = {0x01, 0x02, 0x03, 0x04};
+    uint8_t readBuffer[4] = {0};
+
+    EXPECT_TRUE(mTargetNodes.addTargetNode(&mRmapTarget));
+    mRmapInitiator.unsetReplyMode();
+
+    bool readResult = false;
+    std::thread reader([&]() {
+        readResult = mRmapInitiator.read(
+                mRmapTarget, 0x1000, readBuffer, sizeof(readBuffer), outpost::time::Seconds(10));
+    });
+
+    // Wait until the read command is outstanding
+    while (mTestingRmap.getActiveTransactionsLocked(mRmapInitiator) == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    // A second transaction can be issued while the first one waits for its reply
+    EXPECT_TRUE(mRmapInitiator.write(mRmapTarget, 0x2000, outpost::asSlice(dataToSend)));
+    EXPECT_EQ(1, mTestingRmap.getActiveTransactionsLocked(mRmapInitiator));
+
+    // Reply to the read command, which has been sent first
+    SentCommand command(mSpaceWire.mSentPackets.front().data);
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(command.transactionId, outpost::asSlice(expected)), SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    reader.join();
+
+    EXPECT_TRUE(readResult);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+    EXPECT_EQ(2U, mSpaceWire.mSentPackets.size());
+    for (uint8_t i = 0; i < sizeof(expected); i++)
+    {
+        EXPECT_EQ(expected[i], readBuffer[i]);
+    }
+}
+
+TEST_F(RmapTest, shouldCompleteAsynchronousReadOnPoll)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handle;
+    EXPECT_EQ(RmapTransactionHandle::invalid, handle.getResult());
+
+    EXPECT_TRUE(
+            mRmapInitiator.readAsync(mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handle));
+    EXPECT_EQ(1U, mSpaceWire.mSentPackets.size());
+    EXPECT_EQ(RmapTransactionHandle::pending, mRmapInitiator.poll(handle));
+    EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(handle.getTransactionId(), outpost::asSlice(expected)),
+            SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(handle));
+    EXPECT_EQ(sizeof(expected), handle.getDataLength());
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+    for (uint8_t i = 0; i < sizeof(expected); i++)
+    {
+        EXPECT_EQ(expected[i], readBuffer[i]);
+    }
+
+    // Result is kept after the transaction slot has been released
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(handle));
+}
+
+TEST_F(RmapTest, shouldCompleteAsynchronousReadThroughDispatcher)
+{
+    outpost::utils::SharedBufferPool<64, 2> pool;
+    SpaceWireDispatcher dispatcher(
+            mSpaceWire, pool, 100, 4096, outpost::support::parameter::HeartbeatSource::default0);
+    HandlerTest other;
+    EXPECT_TRUE(mRmapInitiator.attachTo(dispatcher));
+    EXPECT_TRUE(dispatcher.addHandler(SpaceWireDispatcher::protocolCcsdsPacketTransfer, other));
+
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+    RmapTransactionHandle handle;
+    EXPECT_TRUE(
+            mRmapInitiator.readAsync(mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handle));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            {rmap::defaultLogicalAddress, SpaceWireDispatcher::protocolCcsdsPacketTransfer, 0x00},
+            SpaceWire::eop});
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(handle.getTransactionId(), outpost::asSlice(expected)),
+            SpaceWire::eop});
+    EXPECT_EQ(2U, dispatcher.dispatchPackets(outpost::time::Duration::zero()));
+
+    EXPECT_EQ(1U, other.mCalls);
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(handle));
+    for (uint8_t i = 0; i < sizeof(expected); i++)
+    {
+        EXPECT_EQ(expected[i], readBuffer[i]);
+    }
+    EXPECT_EQ(0U, mRmapInitiator.getErrorCounters().mNonRmapPacketReceived);
+
+    // The initiator does not keep a reference to the packet
+    other.mLastPacket = outpost::utils::SharedChildPointer();
+    EXPECT_EQ(2U, pool.numberOfFreeElements());
+}
+
+class RmapRedundantLinkTest : public RmapTest
+{
+public:
+    RmapRedundantLinkTest() :
+        mRedundantSpaceWire(100),
+        mPool(),
+        mDispatcher(mRedundantSpaceWire,
+                    mPool,
+                    100,
+                    4096,
+                    outpost::support::parameter::HeartbeatSource::default0)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        RmapTest::SetUp();
+        mRedundantSpaceWire.open();
+        mRedundantSpaceWire.up(outpost::time::Duration::zero());
+
+        uint8_t targetAddress[1] = {5};
+        uint8_t redundantReplyAddress[4] = {0, 0, 0, 3};
+        ASSERT_TRUE(mRmapTarget.setRedundantPath(
+                1, outpost::asSlice(targetAddress), outpost::asSlice(redundantReplyAddress)));
+        ASSERT_TRUE(mRmapInitiator.addLink(mRedundantSpaceWire, mDispatcher));
+    }
+
+    void
+    receiveRedundant(std::vector<uint8_t> packet)
+    {
+        mRedundantSpaceWire.mPacketsToReceive.emplace_back(
+                unittest::hal::SpaceWireStub::Packet{packet, SpaceWire::eop});
+        EXPECT_EQ(1U, mDispatcher.dispatchPackets(outpost::time::Duration::zero()));
+    }
+
+    unittest::hal::SpaceWireStub mRedundantSpaceWire;
+    outpost::utils::SharedBufferPool<64, 4> mPool;
+    SpaceWireDispatcher mDispatcher;
+};
+
+TEST_F(RmapRedundantLinkTest, shouldBalanceTransactionsOverLinks)
+{
+    EXPECT_EQ(2, mRmapInitiator.getNumberOfLinks());
+
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[2][4] = {};
+    RmapTransactionHandle handles[2];
+    EXPECT_TRUE(mRmapInitiator.readAsync(
+            mRmapTarget, 0x1000, outpost::asSlice(readBuffer[0]), handles[0]));
+    EXPECT_TRUE(mRmapInitiator.readAsync(
+            mRmapTarget, 0x1000, outpost::asSlice(readBuffer[1]), handles[1]));
+
+    ASSERT_EQ(1U, mSpaceWire.mSentPackets.size());
+    ASSERT_EQ(1U, mRedundantSpaceWire.mSentPackets.size());
+    EXPECT_EQ(0, mSpaceWire.mSentPackets.front().data[0]);
+    EXPECT_EQ(5, mRedundantSpaceWire.mSentPackets.front().data[0]);
+
+    // Reply address field differs only in the last address byte
+    const std::vector<uint8_t>& primary = mSpaceWire.mSentPackets.front().data;
+    const std::vector<uint8_t>& redundant = mRedundantSpaceWire.mSentPackets.front().data;
+    std::vector<uint8_t> primaryReply(primary.begin() + 5, primary.begin() + 9);
+    std::vector<uint8_t> redundantReply(redundant.begin() + 5, redundant.begin() + 9);
+    std::replace(primaryReply.begin(), primaryReply.end(), 2, 3);
+    EXPECT_EQ(primaryReply, redundantReply);
+
+    SentCommand command(mRedundantSpaceWire.mSentPackets.front().data);
+    EXPECT_EQ(handles[1].getTransactionId(), command.transactionId);
+
+    receiveRedundant(createReadReply(command.transactionId, outpost::asSlice(expected)));
+    EXPECT_EQ(RmapTransactionHandle::pending, mRmapInitiator.poll(handles[0]));
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(handles[1]));
+    EXPECT_EQ(0x44, readBuffer[1][3]);
+
+    mRmapInitiator.cancel(handles[0]);
+}
+
+TEST_F(RmapRedundantLinkTest, shouldUseRedundantPathIfLinkIsDown)
+{
+    mSpaceWire.down(outpost::time::Duration::zero());
+
+    uint8_t readBuffer[4] = {};
+    RmapTransactionHandle handle;
+    EXPECT_TRUE(
+            mRmapInitiator.readAsync(mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handle));
+
+    EXPECT_TRUE(mSpaceWire.mSentPackets.empty());
+    EXPECT_EQ(1U, mRedundantSpaceWire.mSentPackets.size());
+    mRmapInitiator.cancel(handle);
+}
+
+TEST_F(RmapRedundantLinkTest, shouldMovePendingReadsOnLinkFailure)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {};
+    uint8_t dataToSend[4] = {0x01, 0x02, 0x03, 0x04};
+    RmapTransactionHandle readHandle;
+    RmapTransactionHandle writeHandle;
+
+    // Both transactions are sent on the primary link
+    mRedundantSpaceWire.down(outpost::time::Duration::zero());
+    EXPECT_TRUE(mRmapInitiator.readAsync(
+            mRmapTarget, 0x1000, outpost::asSlice(readBuffer), readHandle));
+    EXPECT_TRUE(mRmapInitiator.writeAsync(
+            mRmapTarget, 0x2000, outpost::asSlice(dataToSend), writeHandle));
+    EXPECT_EQ(2U, mSpaceWire.mSentPackets.size());
+
+    mRedundantSpaceWire.up(outpost::time::Duration::zero());
+    mTestingRmap.checkLinks(mRmapInitiator);
+    EXPECT_TRUE(mRedundantSpaceWire.mSentPackets.empty());
+
+    mSpaceWire.down(outpost::time::Duration::zero());
+    mTestingRmap.checkLinks(mRmapInitiator);
+
+    // The read is sent again with the same transaction ID, the data of
+    // the asynchronous write is not available anymore
+    ASSERT_EQ(1U, mRedundantSpaceWire.mSentPackets.size());
+    SentCommand command(mRedundantSpaceWire.mSentPackets.front().data);
+    EXPECT_FALSE(command.isWrite);
+    EXPECT_EQ(readHandle.getTransactionId(), command.transactionId);
+    EXPECT_EQ(RmapTransactionHandle::linkFailed, mRmapInitiator.poll(writeHandle));
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mFailovers);
+
+    receiveRedundant(createReadReply(command.transactionId, outpost::asSlice(expected)));
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(readHandle));
+    EXPECT_EQ(0x11, readBuffer[0]);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapRedundantLinkTest, shouldMovePendingWriteOnLinkFailure)
+{
+    uint8_t dataToSend[4] = {0x01, 0x02, 0x03, 0x04};
+    mRmapInitiator.setReplyMode();
+    mRmapInitiator.setVerifyMode();
+
+    mRedundantSpaceWire.down(outpost::time::Duration::zero());
+    bool writeResult = false;
+    std::thread writer([&]() {
+        writeResult = mRmapInitiator.write(
+                mRmapTarget, 0x2000, outpost::asSlice(dataToSend), outpost::time::Seconds(10));
+    });
+    while (mTestingRmap.getActiveTransactionsLocked(mRmapInitiator) == 0)
+    {
+        std::this_thread::yield();
+    }
+    ASSERT_EQ(1U, mSpaceWire.mSentPackets.size());
+    SentCommand original(mSpaceWire.mSentPackets.front().data);
+
+    mRedundantSpaceWire.up(outpost::time::Duration::zero());
+    mTestingRmap.checkLinks(mRmapInitiator);
+    mSpaceWire.down(outpost::time::Duration::zero());
+    mTestingRmap.checkLinks(mRmapInitiator);
+
+    // Same command including the data on the redundant path
+    ASSERT_EQ(1U, mRedundantSpaceWire.mSentPackets.size());
+    SentCommand command(mRedundantSpaceWire.mSentPackets.front().data);
+    EXPECT_TRUE(command.isWrite);
+    EXPECT_EQ(original.transactionId, command.transactionId);
+    EXPECT_EQ(std::vector<uint8_t>(dataToSend, dataToSend + 4), command.data);
+    const std::vector<uint8_t>& packet = mRedundantSpaceWire.mSentPackets.front().data;
+    EXPECT_EQ(outpost::Crc8CcittReversed::calculate(outpost::asSlice(dataToSend)),
+              packet.back());
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mFailovers);
+
+    receiveRedundant(createWriteReply(command.transactionId, 0));
+    writer.join();
+    EXPECT_TRUE(writeResult);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+
+    // The moved command keeps its transaction and is only counted as retry
+    RmapTargetStatistics statistics;
+    ASSERT_TRUE(mRmapInitiator.getStatistics().getSnapshot(mRmapTarget.getId(), statistics));
+    EXPECT_EQ(1U, statistics.mCommands);
+    EXPECT_EQ(1U, statistics.mRetries);
+    EXPECT_EQ(1U, statistics.mReplies);
+    EXPECT_EQ(0, statistics.mInFlight);
+}
+
+TEST_F(RmapRedundantLinkTest, shouldMovePendingReadModifyWriteOnLinkFailure)
+{
+    uint8_t data[2] = {0xA5, 0x5A};
+    uint8_t mask[2] = {0xF0, 0x0F};
+    uint8_t previousData[2] = {};
+    uint8_t expected[2] = {0x11, 0x22};
+
+    mRedundantSpaceWire.down(outpost::time::Duration::zero());
+    bool result = false;
+    std::thread writer([&]() {
+        result = mRmapInitiator.readModifyWrite(mRmapTarget,
+                                                0x3000,
+                                                outpost::asSlice(data),
+                                                outpost::asSlice(mask),
+                                                outpost::asSlice(previousData),
+                                                outpost::time::Seconds(10));
+    });
+    while (mTestingRmap.getActiveTransactionsLocked(mRmapInitiator) == 0)
+    {
+        std::this_thread::yield();
+    }
+    ASSERT_EQ(1U, mSpaceWire.mSentPackets.size());
+    std::vector<uint8_t> original = mSpaceWire.mSentPackets.front().data;
+
+    mRedundantSpaceWire.up(outpost::time::Duration::zero());
+    mTestingRmap.checkLinks(mRmapInitiator);
+    mSpaceWire.down(outpost::time::Duration::zero());
+    mTestingRmap.checkLinks(mRmapInitiator);
+
+    // Only the path differs, data and mask are sent again
+    ASSERT_EQ(1U, mRedundantSpaceWire.mSentPackets.size());
+    const std::vector<uint8_t>& packet = mRedundantSpaceWire.mSentPackets.front().data;
+    SentCommand command(packet);
+    EXPECT_EQ(SentCommand(original).transactionId, command.transactionId);
+    EXPECT_EQ(4U, command.length);
+    ASSERT_EQ(original.size(), packet.size());
+    EXPECT_TRUE(std::equal(original.end() - 5, original.end(), packet.end() - 5));
+
+    receiveRedundant(createReadReply(command.transactionId, outpost::asSlice(expected)));
+    writer.join();
+    EXPECT_TRUE(result);
+    EXPECT_EQ(0x22, previousData[1]);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapRedundantLinkTest, shouldLimitSegmentLengthToAllPaths)
+{
+    // Stub links have the same maximum packet length, the redundant path
+    // has a longer target address
+    uint8_t targetAddress[3] = {5, 6, 7};
+    uint8_t redundantReplyAddress[4] = {0, 0, 0, 3};
+    ASSERT_TRUE(mRmapTarget.setRedundantPath(
+            1, outpost::asSlice(targetAddress), outpost::asSlice(redundantReplyAddress)));
+
+    EXPECT_EQ(100U - rmap::commandPacketOverhead - 3 - 4,
+              mRmapInitiator.getMaximumSegmentLength(mRmapTarget));
+}
+
+TEST_F(RmapTest, shouldExecuteCompletionCallbackForAsynchronousWrite)
+{
+    uint8_t dataToSend[4] = {0x01, 0x02, 0x03, 0x04};
+    CompletionReceiverTest receiver;
+    RmapCompletionCallback callback(receiver, &CompletionReceiverTest::onCompletion);
+
+    EXPECT_TRUE(
+            mRmapInitiator.writeAsync(mRmapTarget, 0x2000, outpost::asSlice(dataToSend), callback));
+    EXPECT_EQ(1U, mSpaceWire.mSentPackets.size());
+
+    // Asynchronous writes always request a reply, the instruction field
+    // follows the target SpaceWire address, logical address and protocol ID
+    RmapPacket::InstructionField instr;
+    instr.setAllRaw(mSpaceWire.mSentPackets.front().data[3]);
+    EXPECT_TRUE(instr.isReplyEnabled());
+
+    SentCommand command(mSpaceWire.mSentPackets.front().data);
+    std::vector<uint8_t> replyData =
+            createWriteReply(command.transactionId, RmapReplyStatus::commandExecutedSuccessfully);
+    RmapPacketView reply(outpost::asSlice(replyData));
+    ASSERT_TRUE(reply.validate(rmap::defaultLogicalAddress));
+    mTestingRmap.replyPacketReceived(mRmapInitiator, reply);
+
+    EXPECT_EQ(1U, receiver.mCalls);
+    EXPECT_EQ(RmapTransactionHandle::success, receiver.mHandle.getResult());
+    EXPECT_EQ(command.transactionId, receiver.mHandle.getTransactionId());
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldExpireAsynchronousTransactionWithoutReply)
+{
+    uint8_t readBuffer[4] = {0};
+    CompletionReceiverTest receiver;
+    RmapCompletionCallback callback(receiver, &CompletionReceiverTest::onCompletion);
+
+    RmapTransactionHandle handles[2];
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x1000,
+                                         outpost::asSlice(readBuffer),
+                                         handles[0],
+                                         outpost::time::Milliseconds(1)));
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x2000,
+                                         outpost::asSlice(readBuffer),
+                                         callback,
+                                         outpost::time::Milliseconds(1)));
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x3000,
+                                         outpost::asSlice(readBuffer),
+                                         handles[1],
+                                         outpost::time::Milliseconds(1)));
+    EXPECT_EQ(3, mTestingRmap.getActiveTransactions(mRmapInitiator));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    mTestingRmap.expireTransactions(mRmapInitiator);
+
+    EXPECT_EQ(1U, receiver.mCalls);
+    EXPECT_EQ(RmapTransactionHandle::timeout, receiver.mHandle.getResult());
+
+    EXPECT_TRUE(mRmapInitiator.waitForAll(outpost::asSlice(handles), outpost::time::Seconds(1)));
+    EXPECT_EQ(RmapTransactionHandle::timeout, handles[0].getResult());
+    EXPECT_EQ(RmapTransactionHandle::timeout, handles[1].getResult());
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldDiscardReplyOfCancelledTransaction)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handle;
+    EXPECT_TRUE(
+            mRmapInitiator.readAsync(mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handle));
+    uint16_t transactionId = handle.getTransactionId();
+
+    mRmapInitiator.cancel(handle);
+    EXPECT_EQ(RmapTransactionHandle::invalid, handle.getResult());
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(transactionId, outpost::asSlice(expected)), SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mDiscardedReceivedPackets);
+    EXPECT_EQ(0, readBuffer[0]);
+}
+
+TEST_F(RmapTest, shouldNotCompleteCopiedHandleAfterSlotReuse)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handle;
+    EXPECT_TRUE(
+            mRmapInitiator.readAsync(mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handle));
+    RmapTransactionHandle copy = handle;
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(handle.getTransactionId(), outpost::asSlice(expected)),
+            SpaceWire::eop});
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(handle));
+
+    // Reuses the slot of the completed transaction
+    RmapTransactionHandle next;
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget, 0x2000, outpost::asSlice(readBuffer), next));
+    EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
+
+    // The copy must neither complete nor free the new transaction
+    EXPECT_EQ(RmapTransactionHandle::invalid, mRmapInitiator.poll(copy));
+    EXPECT_EQ(RmapTransactionHandle::invalid, mRmapInitiator.wait(copy, outpost::time::Seconds(1)));
+    mRmapInitiator.cancel(copy);
+    EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
+    EXPECT_EQ(RmapTransactionHandle::pending, mRmapInitiator.poll(next));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(next.getTransactionId(), outpost::asSlice(expected)), SpaceWire::eop});
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(next));
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldFailReadWithReplyExceedingTheBuffer)
+{
+    uint8_t expected[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handle;
+    EXPECT_TRUE(
+            mRmapInitiator.readAsync(mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handle));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(handle.getTransactionId(), outpost::asSlice(expected)),
+            SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    EXPECT_EQ(RmapTransactionHandle::failure, mRmapInitiator.poll(handle));
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mErrorInStoringReplyPacket);
+    EXPECT_EQ(0, readBuffer[0]);
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+}
+
+TEST_F(RmapTest, shouldLimitSegmentLengthByPacketLengthAndTarget)
+{
+    // 100 byte packets minus SpaceWire and reply address and the RMAP overhead
+    EXPECT_EQ(75U, mRmapInitiator.getMaximumSegmentLength(mRmapTarget));
+
+    mRmapTarget.setMaximumTransactionLength(16);
+    EXPECT_EQ(16U, mRmapInitiator.getMaximumSegmentLength(mRmapTarget));
+}
+
+TEST_F(RmapTest, shouldReadLargeRegionInPipelinedSegments)
+{
+    uint8_t memory[400];
+    for (size_t i = 0; i < sizeof(memory); i++)
+    {
+        memory[i] = static_cast<uint8_t>(i * 7);
+    }
+    uint8_t readBuffer[sizeof(memory)] = {0};
+    const uint32_t baseAddress = 0x10000;
+
+    bool readResult = false;
+    std::thread reader([&]() {
+        readResult = mRmapInitiator.readSegmented(
+                mRmapTarget, baseAddress, outpost::asSlice(readBuffer), outpost::time::Seconds(10));
+    });
+
+    // 400 bytes are split into five segments with 75 bytes and one with 25 bytes
+    size_t commands = 0;
+    size_t maximumOutstanding = 0;
+    std::vector<uint8_t> packet;
+    while (commands < 6)
+    {
+        if (!mTestingRmap.takeSentPacket(mRmapInitiator, mSpaceWire, packet))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        commands++;
+
+        size_t outstanding = mTestingRmap.getActiveTransactionsLocked(mRmapInitiator);
+        maximumOutstanding = std::max(maximumOutstanding, outstanding);
+
+        SentCommand command(packet);
+        ASSERT_FALSE(command.isWrite);
+        ASSERT_LE(command.address - baseAddress + command.length, sizeof(memory));
+        EXPECT_EQ((commands < 6) ? 75U : 25U, command.length);
+
+        mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+                createReadReply(command.transactionId,
+                                outpost::Slice<const uint8_t>::unsafe(
+                                        &memory[command.address - baseAddress], command.length)),
+                SpaceWire::eop});
+
+        EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+    }
+
+    reader.join();
+
+    EXPECT_TRUE(readResult);
+    EXPECT_LE(maximumOutstanding, rmap::maxSegmentsInFlight);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+    EXPECT_EQ(0, memcmp(memory, readBuffer, sizeof(memory)));
+}
+
+TEST_F(RmapTest, shouldRepeatFailedSegmentOfLargeWrite)
+{
+    uint8_t dataToSend[150];
+    for (size_t i = 0; i < sizeof(dataToSend); i++)
+    {
+        dataToSend[i] = static_cast<uint8_t>(i);
+    }
+    uint8_t memory[sizeof(dataToSend)] = {0};
+    mRmapTarget.setMaximumTransactionLength(50);
+
+    bool writeResult = false;
+    std::thread writer([&]() {
+        writeResult = mRmapInitiator.writeSegmented(
+                mRmapTarget, 0, outpost::asSlice(dataToSend), outpost::time::Seconds(10));
+    });
+
+    // Three segments, the second one is rejected once by the target
+    size_t commands = 0;
+    bool rejected = false;
+    std::vector<uint8_t> packet;
+    while (commands < 4)
+    {
+        if (!mTestingRmap.takeSentPacket(mRmapInitiator, mSpaceWire, packet))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        commands++;
+
+        SentCommand command(packet);
+        ASSERT_TRUE(command.isWrite);
+        ASSERT_EQ(50U, command.length);
+
+        uint8_t status = RmapReplyStatus::commandExecutedSuccessfully;
+        if (command.address == 50 && !rejected)
+        {
+            status = RmapReplyStatus::generalErrorCode;
+            rejected = true;
+        }
+        else
+        {
+            memcpy(&memory[command.address], command.data.data(), command.length);
+        }
+
+        mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+                createWriteReply(command.transactionId, status), SpaceWire::eop});
+
+        EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+    }
+
+    writer.join();
+
+    EXPECT_TRUE(rejected);
+    EXPECT_TRUE(writeResult);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+    EXPECT_EQ(0, memcmp(memory, dataToSend, sizeof(memory)));
+}
+
+TEST_F(RmapTest, shouldExchangeCommandsWithRmapTarget)
+{
+    unittest::hal::SpaceWireStub targetSpaceWire(100);
+    targetSpaceWire.open();
+    targetSpaceWire.up(outpost::time::Duration::zero());
+
+    uint8_t memory[16] = {0};
+    RmapMemoryRegion region(0x4000, outpost::asSlice(memory), RmapMemoryRegion::readWrite);
+    RmapTarget target(targetSpaceWire,
+                      targetLogicalAddress,
+                      key,
+                      100,
+                      4096,
+                      outpost::support::parameter::HeartbeatSource::default0);
+    ASSERT_TRUE(target.addMemoryRegion(&region));
+
+    mRmapInitiator.setIncrementMode();
+
+    uint8_t dataToSend[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+    RmapTransactionHandle writeHandle;
+    ASSERT_TRUE(mRmapInitiator.writeAsync(
+            mRmapTarget, 0x4002, outpost::asSlice(dataToSend), writeHandle));
+    EXPECT_TRUE(mTestingRmap.forwardToTarget(mRmapInitiator, mSpaceWire, target, targetSpaceWire));
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(writeHandle));
+    EXPECT_EQ(0, memcmp(&memory[2], dataToSend, sizeof(dataToSend)));
+
+    uint8_t readBuffer[6] = {0};
+    RmapTransactionHandle readHandle;
+    ASSERT_TRUE(mRmapInitiator.readAsync(
+            mRmapTarget, 0x4002, outpost::asSlice(readBuffer), readHandle));
+    EXPECT_TRUE(mTestingRmap.forwardToTarget(mRmapInitiator, mSpaceWire, target, targetSpaceWire));
+    EXPECT_EQ(RmapTransactionHandle::success, mRmapInitiator.poll(readHandle));
+    EXPECT_EQ(sizeof(readBuffer), readHandle.getDataLength());
+    EXPECT_EQ(0, memcmp(readBuffer, dataToSend, sizeof(readBuffer)));
+
+    EXPECT_EQ(2U, target.getCounters().mExecutedCommands);
+    EXPECT_TRUE(targetSpaceWire.noUsedReceiveBuffers());
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+}
+
+TEST_F(RmapTest, shouldModifyTargetMemoryWithReadModifyWrite)
+{
+    unittest::hal::SpaceWireStub targetSpaceWire(100);
+    targetSpaceWire.open();
+    targetSpaceWire.up(outpost::time::Duration::zero());
+
+    uint8_t memory[4] = {0xF0, 0xF0, 0xF0, 0xF0};
+    RmapMemoryRegion region(0x4000, outpost::asSlice(memory), RmapMemoryRegion::all);
+    RmapTarget target(targetSpaceWire,
+                      targetLogicalAddress,
+                      key,
+                      100,
+                      4096,
+                      outpost::support::parameter::HeartbeatSource::default0);
+    ASSERT_TRUE(target.addMemoryRegion(&region));
+
+    // Increment mode is not required for read-modify-write
+    mRmapInitiator.unsetIncrementMode();
+
+    uint8_t data[2] = {0x05, 0xA0};
+    uint8_t mask[2] = {0x0F, 0xF0};
+    uint8_t previousData[2] = {0};
+    bool result = false;
+    std::thread modifier([&]() {
+        result = mRmapInitiator.readModifyWrite(mRmapTarget,
+                                                0x4001,
+                                                outpost::asSlice(data),
+                                                outpost::asSlice(mask),
+                                                outpost::asSlice(previousData),
+                                                outpost::time::Seconds(10));
+    });
+
+    std::vector<uint8_t> packet;
+    while (!mTestingRmap.takeSentPacket(mRmapInitiator, mSpaceWire, packet))
+    {
+        std::this_thread::yield();
+    }
+
+    // Data and mask are sent together
+    SentCommand command(packet);
+    EXPECT_FALSE(command.isWrite);
+    EXPECT_EQ(4U, command.length);
+
+    targetSpaceWire.mPacketsToReceive.emplace_back(
+            unittest::hal::SpaceWireStub::Packet{packet, SpaceWire::eop});
+    EXPECT_EQ(1U, target.processCommands(outpost::time::Duration::zero()));
+
+    // Remove the path address of the reply
+    ASSERT_EQ(1U, targetSpaceWire.mSentPackets.size());
+    unittest::hal::SpaceWireStub::Packet reply = targetSpaceWire.mSentPackets.front();
+    reply.data.erase(reply.data.begin());
+    mSpaceWire.mPacketsToReceive.push_back(reply);
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    modifier.join();
+
+    EXPECT_TRUE(result);
+    EXPECT_EQ(0xF0, previousData[0]);
+    EXPECT_EQ(0xF0, previousData[1]);
+    EXPECT_EQ(0xF0, memory[0]);
+    EXPECT_EQ(0xF5, memory[1]);
+    EXPECT_EQ(0xA0, memory[2]);
+    EXPECT_EQ(0xF0, memory[3]);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldRejectInvalidReadModifyWriteLength)
+{
+    uint8_t data[5] = {0};
+    uint8_t mask[5] = {0};
+
+    EXPECT_FALSE(mRmapInitiator.readModifyWrite(
+            mRmapTarget, 0x4000, outpost::asSlice(data), outpost::asSlice(mask)));
+    EXPECT_FALSE(mRmapInitiator.readModifyWrite(mRmapTarget,
+                                                0x4000,
+                                                outpost::asSlice(data).first(2),
+                                                outpost::asSlice(mask).first(1)));
+    EXPECT_TRUE(mSpaceWire.mSentPackets.empty());
+}
+
+TEST_F(RmapTest, shouldExecuteBatchWithMoreItemsThanTransactionSlots)
+{
+    unittest::hal::SpaceWireStub targetSpaceWire(100);
+    targetSpaceWire.open();
+    targetSpaceWire.up(outpost::time::Duration::zero());
+
+    uint8_t memory[64];
+    for (uint8_t i = 0; i < sizeof(memory); i++)
+    {
+        memory[i] = i;
+    }
+    RmapMemoryRegion region(0x4000, outpost::asSlice(memory), RmapMemoryRegion::readWrite);
+    RmapTarget target(targetSpaceWire,
+                      targetLogicalAddress,
+                      key,
+                      100,
+                      4096,
+                      outpost::support::parameter::HeartbeatSource::default0);
+    ASSERT_TRUE(target.addMemoryRegion(&region));
+    mRmapInitiator.setIncrementMode();
+
+    static constexpr size_t numberOfReads = rmap::maxConcurrentTransactions + 4;
+    uint8_t readBuffers[numberOfReads][2] = {};
+    uint8_t dataToSend[2] = {0xAA, 0xBB};
+
+    RmapInitiator::BatchItem items[numberOfReads + 1];
+    for (size_t i = 0; i < numberOfReads; i++)
+    {
+        items[i] = RmapInitiator::BatchItem::read(
+                mRmapTarget, 0x4000 + 2 * i, outpost::asSlice(readBuffers[i]));
+    }
+    items[numberOfReads] = RmapInitiator::BatchItem::write(
+            mRmapTarget, 0x4000 + 2 * numberOfReads, outpost::asSlice(dataToSend));
+
+    bool result = false;
+    std::atomic<bool> finished(false);
+    std::thread batch([&]() {
+        result = mRmapInitiator.transferBatch(outpost::asSlice(items), outpost::time::Seconds(10));
+        finished = true;
+    });
+
+    size_t forwarded = 0;
+    while (!finished)
+    {
+        if (mTestingRmap.forwardToTarget(mRmapInitiator, mSpaceWire, target, targetSpaceWire))
+        {
+            forwarded++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    batch.join();
+
+    EXPECT_TRUE(result);
+    EXPECT_EQ(numberOfReads + 1, forwarded);
+    for (size_t i = 0; i < numberOfReads; i++)
+    {
+        EXPECT_EQ(RmapTransactionHandle::success, items[i].mHandle.getResult());
+        EXPECT_EQ(2U, items[i].mHandle.getDataLength());
+        EXPECT_EQ(2 * i, readBuffers[i][0]);
+        EXPECT_EQ(2 * i + 1, readBuffers[i][1]);
+    }
+    EXPECT_EQ(RmapTransactionHandle::success, items[numberOfReads].mHandle.getResult());
+    EXPECT_EQ(0xAA, memory[2 * numberOfReads]);
+    EXPECT_EQ(0xBB, memory[2 * numberOfReads + 1]);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldReportStatusOfEachBatchItem)
+{
+    unittest::hal::SpaceWireStub targetSpaceWire(100);
+    targetSpaceWire.open();
+    targetSpaceWire.up(outpost::time::Duration::zero());
+
+    uint8_t memory[4] = {1, 2, 3, 4};
+    RmapMemoryRegion region(0x4000, outpost::asSlice(memory), RmapMemoryRegion::read);
+    RmapTarget target(targetSpaceWire,
+                      targetLogicalAddress,
+                      key,
+                      100,
+                      4096,
+                      outpost::support::parameter::HeartbeatSource::default0);
+    ASSERT_TRUE(target.addMemoryRegion(&region));
+    mRmapInitiator.setIncrementMode();
+
+    uint8_t readBuffer[4] = {0};
+    uint8_t dataToSend[1] = {0xFF};
+    RmapInitiator::BatchItem items[3] = {
+            RmapInitiator::BatchItem::read(mRmapTarget, 0x4000, outpost::asSlice(readBuffer)),
+            // Region is read-only
+            RmapInitiator::BatchItem::write(mRmapTarget, 0x4000, outpost::asSlice(dataToSend)),
+            // No target node given
+            RmapInitiator::BatchItem()};
+
+    bool result = true;
+    std::atomic<bool> finished(false);
+    std::thread batch([&]() {
+        result = mRmapInitiator.transferBatch(outpost::asSlice(items), outpost::time::Seconds(10));
+        finished = true;
+    });
+
+    while (!finished)
+    {
+        if (!mTestingRmap.forwardToTarget(mRmapInitiator, mSpaceWire, target, targetSpaceWire))
+        {
+            std::this_thread::yield();
+        }
+    }
+    batch.join();
+
+    EXPECT_FALSE(result);
+    EXPECT_EQ(RmapTransactionHandle::success, items[0].mHandle.getResult());
+    EXPECT_EQ(0, memcmp(readBuffer, memory, sizeof(memory)));
+    EXPECT_EQ(RmapTransactionHandle::failure, items[1].mHandle.getResult());
+    EXPECT_EQ(RmapReplyStatus::rmapCommandNotImplemented, items[1].mHandle.getReplyStatus());
+    EXPECT_EQ(RmapTransactionHandle::invalid, items[2].mHandle.getResult());
+    EXPECT_EQ(1, memory[0]);
+}
+
+TEST_F(RmapTest, shouldTimeOutBatchWithoutReplies)
+{
+    uint8_t readBuffers[3][4] = {};
+    RmapInitiator::BatchItem items[3];
+    for (size_t i = 0; i < 3; i++)
+    {
+        items[i] = RmapInitiator::BatchItem::read(
+                mRmapTarget, 0x1000 + 4 * i, outpost::asSlice(readBuffers[i]));
+    }
+
+    EXPECT_FALSE(
+            mRmapInitiator.transferBatch(outpost::asSlice(items), outpost::time::Milliseconds(10)));
+
+    // All commands have been sent before waiting for the replies
+    EXPECT_EQ(3U, mSpaceWire.mSentPackets.size());
+    for (size_t i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(RmapTransactionHandle::timeout, items[i].mHandle.getResult());
+    }
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldExpireTransactionsInOrderOfTheirDeadline)
+{
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handles[3];
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x1000,
+                                         outpost::asSlice(readBuffer),
+                                         handles[0],
+                                         outpost::time::Seconds(10)));
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x2000,
+                                         outpost::asSlice(readBuffer),
+                                         handles[1],
+                                         outpost::time::Milliseconds(2)));
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x3000,
+                                         outpost::asSlice(readBuffer),
+                                         handles[2],
+                                         outpost::time::Milliseconds(1)));
+
+    // The receiving thread waits at most until the earliest deadline
+    EXPECT_LE(mTestingRmap.getReceiveTimeout(mRmapInitiator), outpost::time::Milliseconds(1));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(outpost::time::Duration::zero(), mTestingRmap.getReceiveTimeout(mRmapInitiator));
+    mTestingRmap.expireTransactions(mRmapInitiator);
+
+    EXPECT_EQ(2U, mRmapInitiator.getErrorCounters().mExpiredTransactions);
+    EXPECT_EQ(RmapTransactionHandle::pending, mRmapInitiator.poll(handles[0]));
+    EXPECT_EQ(RmapTransactionHandle::timeout, mRmapInitiator.poll(handles[1]));
+    EXPECT_EQ(RmapTransactionHandle::timeout, mRmapInitiator.poll(handles[2]));
+
+    // The slots of the expired transactions are available again
+    EXPECT_EQ(1, mTestingRmap.getActiveTransactions(mRmapInitiator));
+    EXPECT_GT(mTestingRmap.getReceiveTimeout(mRmapInitiator), outpost::time::Milliseconds(50));
+
+    mRmapInitiator.cancel(handles[0]);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldCountLateReplyOfExpiredTransaction)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handle;
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x1000,
+                                         outpost::asSlice(readBuffer),
+                                         handle,
+                                         outpost::time::Milliseconds(1)));
+    uint16_t transactionId = handle.getTransactionId();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    mTestingRmap.expireTransactions(mRmapInitiator);
+    EXPECT_EQ(RmapTransactionHandle::timeout, mRmapInitiator.poll(handle));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(transactionId, outpost::asSlice(expected)), SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mLateReplies);
+    EXPECT_EQ(0U, mRmapInitiator.getErrorCounters().mDiscardedReceivedPackets);
+    EXPECT_EQ(0, readBuffer[0]);
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+}
+
+TEST_F(RmapTest, shouldRepeatReadWithoutReply)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+
+    mRmapInitiator.setRetryPolicy(RmapInitiator::RetryPolicy(1, false));
+
+    bool result = false;
+    std::thread reader([&]() {
+        result = mRmapInitiator.read(mRmapTarget,
+                                     0x1000,
+                                     readBuffer,
+                                     sizeof(readBuffer),
+                                     outpost::time::Milliseconds(100));
+    });
+
+    // The first command is lost
+    std::vector<uint8_t> packet;
+    while (!mTestingRmap.takeSentPacket(mRmapInitiator, mSpaceWire, packet))
+    {
+        std::this_thread::yield();
+    }
+    SentCommand first(packet);
+
+    while (!mTestingRmap.takeSentPacket(mRmapInitiator, mSpaceWire, packet))
+    {
+        std::this_thread::yield();
+    }
+    SentCommand second(packet);
+    EXPECT_EQ(first.address, second.address);
+    EXPECT_NE(first.transactionId, second.transactionId);
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(second.transactionId, outpost::asSlice(expected)), SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    reader.join();
+
+    EXPECT_TRUE(result);
+    EXPECT_EQ(0x11, readBuffer[0]);
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mRetries);
+    EXPECT_EQ(1U, mRmapInitiator.getErrorCounters().mExpiredTransactions);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldNotRepeatWriteWithoutReplyByDefault)
+{
+    uint8_t dataToSend[4] = {0x01, 0x02, 0x03, 0x04};
+
+    mRmapInitiator.setReplyMode();
+    mRmapInitiator.setRetryPolicy(RmapInitiator::RetryPolicy(2, false));
+
+    EXPECT_FALSE(mRmapInitiator.write(
+            mRmapTarget, 0x1000, outpost::asSlice(dataToSend), outpost::time::Milliseconds(5)));
+
+    EXPECT_EQ(1U, mSpaceWire.mSentPackets.size());
+    EXPECT_EQ(0U, mRmapInitiator.getErrorCounters().mRetries);
+    EXPECT_EQ(0, mTestingRmap.getActiveTransactions(mRmapInitiator));
+}
+
+TEST_F(RmapTest, shouldCollectStatisticsOfTarget)
+{
+    uint8_t expected[4] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t readBuffer[4] = {0};
+
+    RmapTransactionHandle handles[3];
+    EXPECT_TRUE(mRmapInitiator.readAsync(
+            mRmapTarget, 0x1000, outpost::asSlice(readBuffer), handles[0]));
+    EXPECT_TRUE(mRmapInitiator.readAsync(mRmapTarget,
+                                         0x2000,
+                                         outpost::asSlice(readBuffer),
+                                         handles[1],
+                                         outpost::time::Milliseconds(1)));
+    EXPECT_TRUE(mRmapInitiator.readAsync(
+            mRmapTarget, 0x3000, outpost::asSlice(readBuffer), handles[2]));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(unittest::hal::SpaceWireStub::Packet{
+            createReadReply(handles[0].getTransactionId(), outpost::asSlice(expected)),
+            SpaceWire::eop});
+
+    EXPECT_TRUE(mTestingRmap.receiveReply(mRmapInitiator));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    mTestingRmap.expireTransactions(mRmapInitiator);
+    mRmapInitiator.cancel(handles[2]);
+
+    RmapTargetStatistics statistics;
+    ASSERT_TRUE(mRmapInitiator.getStatistics().getSnapshot(mRmapTarget.getId(), statistics));
+    EXPECT_EQ(3U, statistics.mCommands);
+    EXPECT_EQ(1U, statistics.mReplies);
+    EXPECT_EQ(1U, statistics.mTimeouts);
+    EXPECT_EQ(sizeof(expected), statistics.mBytesRead);
+    EXPECT_EQ(0, statistics.mInFlight);
+    EXPECT_EQ(3, statistics.mMaxInFlight);
+
+    uint32_t latencies = 0;
+    for (uint8_t i = 0; i < rmap::latencyHistogramBins; i++)
+    {
+        latencies += statistics.mLatency[i];
+    }
+    EXPECT_EQ(1U, latencies);
+
+    mRmapInitiator.resetStatistics();
+    ASSERT_TRUE(mRmapInitiator.getStatistics().getSnapshot(mRmapTarget.getId(), statistics));
+    EXPECT_EQ(0U, statistics.mCommands);
+}
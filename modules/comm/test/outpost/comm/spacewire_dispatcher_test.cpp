@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/comm/rmap/rmap_target.h>
+#include <outpost/comm/spacewire_dispatcher.h>
+#include <outpost/utils/coding/crc.h>
+
+#include <unittest/hal/spacewire_stub.h>
+#include <unittest/harness.h>
+
+#include <vector>
+
+using namespace outpost::comm;
+using outpost::hal::SpaceWire;
+
+namespace
+{
+class HandlerTest : public SpaceWireProtocolHandler
+{
+public:
+    HandlerTest() : mAccept(true), mCalls(0), mLastPacket()
+    {
+    }
+
+    virtual bool
+    handlePacket(const outpost::utils::SharedChildPointer& packet) override
+    {
+        mCalls++;
+        mLastPacket = packet;
+        return mAccept;
+    }
+
+    bool mAccept;
+    size_t mCalls;
+    outpost::utils::SharedChildPointer mLastPacket;
+};
+}  // namespace
+
+class SpaceWireDispatcherTest : public testing::Test
+{
+public:
+    static constexpr size_t bufferSize = 32;
+    static constexpr size_t numberOfBuffers = 4;
+
+    SpaceWireDispatcherTest() :
+        mSpaceWire(100),
+        mPool(),
+        mDispatcher(mSpaceWire,
+                    mPool,
+                    100,
+                    4096,
+                    outpost::support::parameter::HeartbeatSource::default0)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        mSpaceWire.open();
+        mSpaceWire.up(outpost::time::Duration::zero());
+    }
+
+    void
+    receive(std::vector<uint8_t> packet, SpaceWire::EndMarker end = SpaceWire::eop)
+    {
+        mSpaceWire.mPacketsToReceive.emplace_back(
+                unittest::hal::SpaceWireStub::Packet{packet, end});
+    }
+
+    size_t
+    dispatch()
+    {
+        return mDispatcher.dispatchPackets(outpost::time::Duration::zero());
+    }
+
+    unittest::hal::SpaceWireStub mSpaceWire;
+    outpost::utils::SharedBufferPool<bufferSize, numberOfBuffers> mPool;
+    SpaceWireDispatcher mDispatcher;
+};
+
+constexpr size_t SpaceWireDispatcherTest::bufferSize;
+constexpr size_t SpaceWireDispatcherTest::numberOfBuffers;
+
+TEST_F(SpaceWireDispatcherTest, shouldDispatchByProtocolIdentifier)
+{
+    HandlerTest rmap;
+    HandlerTest ccsds;
+    EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, rmap));
+    EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolCcsdsPacketTransfer, ccsds));
+
+    receive({0x20, SpaceWireDispatcher::protocolCcsdsPacketTransfer, 0x00, 0xAA});
+    receive({0x30, SpaceWireDispatcher::protocolRmap, 0x08});
+    EXPECT_EQ(2U, dispatch());
+
+    EXPECT_EQ(1U, rmap.mCalls);
+    ASSERT_EQ(1U, ccsds.mCalls);
+    ASSERT_EQ(4U, ccsds.mLastPacket.getLength());
+    EXPECT_EQ(0xAA, ccsds.mLastPacket[3]);
+    EXPECT_EQ(SpaceWireDispatcher::protocolCcsdsPacketTransfer, ccsds.mLastPacket.getType());
+
+    EXPECT_EQ(2U, mDispatcher.getCounters().mDispatchedPackets);
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldPreferHandlerForLogicalAddress)
+{
+    HandlerTest any;
+    HandlerTest specific;
+    EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, any));
+    EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, 0xFE, specific));
+
+    receive({0xFE, SpaceWireDispatcher::protocolRmap, 0x08});
+    receive({0xFD, SpaceWireDispatcher::protocolRmap, 0x08});
+    EXPECT_EQ(2U, dispatch());
+
+    EXPECT_EQ(1U, specific.mCalls);
+    EXPECT_EQ(1U, any.mCalls);
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldSkipPathAddress)
+{
+    HandlerTest handler;
+    EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, 0xFE, handler));
+
+    receive({0x03, 0x01, 0xFE, SpaceWireDispatcher::protocolRmap, 0x08});
+    EXPECT_EQ(1U, dispatch());
+
+    // The path address is kept for the handler
+    ASSERT_EQ(1U, handler.mCalls);
+    EXPECT_EQ(5U, handler.mLastPacket.getLength());
+    EXPECT_EQ(0x03, handler.mLastPacket[0]);
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldUseDefaultHandlerForUnknownProtocol)
+{
+    HandlerTest handler;
+    receive({0xFE, 0xEE, 0x00});
+    EXPECT_EQ(1U, dispatch());
+    EXPECT_EQ(1U, mDispatcher.getCounters().mUnhandledPackets);
+
+    mDispatcher.setDefaultHandler(&handler);
+    receive({0xFE, 0xEE, 0x00});
+    EXPECT_EQ(1U, dispatch());
+    EXPECT_EQ(1U, handler.mCalls);
+    EXPECT_EQ(1U, mDispatcher.getCounters().mDispatchedPackets);
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldDiscardInvalidPackets)
+{
+    HandlerTest handler;
+    mDispatcher.setDefaultHandler(&handler);
+
+    receive({0xFE, 0x01, 0x00}, SpaceWire::eep);
+    receive({0xFE});
+    receive(std::vector<uint8_t>(bufferSize + 1, 0xFE));
+    EXPECT_EQ(3U, dispatch());
+
+    EXPECT_EQ(0U, handler.mCalls);
+    EXPECT_EQ(3U, mDispatcher.getCounters().mInvalidPackets);
+    EXPECT_EQ(numberOfBuffers, mPool.numberOfFreeElements());
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldKeepBufferWhileReferenced)
+{
+    SpaceWireProtocolQueue<numberOfBuffers + 1> queue;
+    HandlerTest rejecting;
+    rejecting.mAccept = false;
+    EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, queue));
+    EXPECT_TRUE(
+            mDispatcher.addHandler(SpaceWireDispatcher::protocolCcsdsPacketTransfer, rejecting));
+
+    for (uint8_t i = 0; i < numberOfBuffers + 1; i++)
+    {
+        receive({0xFE, SpaceWireDispatcher::protocolRmap, i});
+    }
+    EXPECT_EQ(numberOfBuffers + 1, dispatch());
+
+    EXPECT_EQ(numberOfBuffers, mDispatcher.getCounters().mDispatchedPackets);
+    EXPECT_EQ(1U, mDispatcher.getCounters().mNoBufferAvailable);
+    EXPECT_EQ(0U, mPool.numberOfFreeElements());
+
+    outpost::utils::SharedBufferPointer packet;
+    ASSERT_TRUE(queue.receive(packet, outpost::time::Duration::zero()));
+    EXPECT_EQ(0, packet[2]);
+    packet = outpost::utils::SharedBufferPointer();
+    EXPECT_EQ(1U, mPool.numberOfFreeElements());
+
+    // Buffer of a rejected packet is released immediately
+    receive({0xFE, SpaceWireDispatcher::protocolCcsdsPacketTransfer, 0x00});
+    EXPECT_EQ(1U, dispatch());
+    EXPECT_EQ(1U, mDispatcher.getCounters().mDroppedPackets);
+    rejecting.mLastPacket = outpost::utils::SharedChildPointer();
+    EXPECT_EQ(1U, mPool.numberOfFreeElements());
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldLimitNumberOfHandlers)
+{
+    HandlerTest handler;
+    for (uint8_t i = 0; i < SpaceWireDispatcher::maxHandlers; i++)
+    {
+        EXPECT_TRUE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, i, handler));
+    }
+    EXPECT_FALSE(mDispatcher.addHandler(SpaceWireDispatcher::protocolRmap, handler));
+}
+
+TEST_F(SpaceWireDispatcherTest, shouldForwardCommandsToAttachedRmapTarget)
+{
+    uint8_t memory[8] = {0};
+    RmapMemoryRegion region(0x1000, outpost::asSlice(memory), RmapMemoryRegion::readWrite);
+    RmapTarget target(mSpaceWire,
+                      0xFE,
+                      0x20,
+                      100,
+                      4096,
+                      outpost::support::parameter::HeartbeatSource::default0);
+    target.addMemoryRegion(&region);
+    EXPECT_TRUE(target.attachTo(mDispatcher));
+
+    // Write with reply from initiator 0x67
+    std::vector<uint8_t> command = {0xFE, rmap::protocolIdentifier, 0x6C, 0x20, 0x67, 0x00,
+                                    0x01, 0x00, 0x00, 0x00, 0x10, 0x02, 0x00, 0x00, 0x02};
+    command.push_back(outpost::Crc8CcittReversed::calculate(outpost::asSlice(command)));
+    std::vector<uint8_t> data = {0xA1, 0xA2};
+    command.insert(command.end(), data.begin(), data.end());
+    command.push_back(outpost::Crc8CcittReversed::calculate(outpost::asSlice(data)));
+    receive(command);
+
+    EXPECT_EQ(1U, dispatch());
+    EXPECT_EQ(0, memory[2]);
+    EXPECT_EQ(1U, target.processCommands(outpost::time::Duration::zero()));
+
+    EXPECT_EQ(0xA1, memory[2]);
+    EXPECT_EQ(0xA2, memory[3]);
+    ASSERT_EQ(1U, mSpaceWire.mSentPackets.size());
+    EXPECT_EQ(0x67, mSpaceWire.mSentPackets.front().data[0]);
+    EXPECT_EQ(numberOfBuffers, mPool.numberOfFreeElements());
+}
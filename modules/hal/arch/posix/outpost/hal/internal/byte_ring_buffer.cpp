@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "byte_ring_buffer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+using outpost::hal::ByteRingBuffer;
+
+// The positions increase monotonically, the index into the storage is the
+// position modulo the capacity. This allows to distinguish a full from an
+// empty buffer without wasting a byte.
+ByteRingBuffer::ByteRingBuffer(size_t capacity) :
+    mCapacity(capacity),
+    mStorage(new uint8_t[capacity]),
+    mWritePosition(0),
+    mReadPosition(0)
+{
+}
+
+size_t
+ByteRingBuffer::write(const uint8_t* data, size_t length)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        uint8_t* region;
+        size_t regionLength = std::min(getWriteRegion(region), length - written);
+        if (regionLength == 0)
+        {
+            break;
+        }
+        memcpy(region, data + written, regionLength);
+        commit(regionLength);
+        written += regionLength;
+    }
+    return written;
+}
+
+size_t
+ByteRingBuffer::read(uint8_t* data, size_t length)
+{
+    size_t copied = 0;
+    while (copied < length)
+    {
+        const uint8_t* region;
+        size_t regionLength = std::min(getReadRegion(region), length - copied);
+        if (regionLength == 0)
+        {
+            break;
+        }
+        memcpy(data + copied, region, regionLength);
+        consume(regionLength);
+        copied += regionLength;
+    }
+    return copied;
+}
+
+size_t
+ByteRingBuffer::getWriteRegion(uint8_t*& data)
+{
+    size_t writePosition = mWritePosition.load(std::memory_order_relaxed);
+    size_t used = writePosition - mReadPosition.load(std::memory_order_acquire);
+    size_t index = writePosition % mCapacity;
+
+    data = &mStorage[index];
+    return std::min(mCapacity - used, mCapacity - index);
+}
+
+void
+ByteRingBuffer::commit(size_t length)
+{
+    mWritePosition.store(mWritePosition.load(std::memory_order_relaxed) + length,
+                         std::memory_order_release);
+}
+
+size_t
+ByteRingBuffer::getReadRegion(const uint8_t*& data) const
+{
+    size_t readPosition = mReadPosition.load(std::memory_order_relaxed);
+    size_t used = mWritePosition.load(std::memory_order_acquire) - readPosition;
+    size_t index = readPosition % mCapacity;
+
+    data = &mStorage[index];
+    return std::min(used, mCapacity - index);
+}
+
+void
+ByteRingBuffer::consume(size_t length)
+{
+    mReadPosition.store(mReadPosition.load(std::memory_order_relaxed) + length,
+                        std::memory_order_release);
+}
+
+void
+ByteRingBuffer::clear()
+{
+    mReadPosition.store(mWritePosition.load(std::memory_order_acquire),
+                        std::memory_order_release);
+}
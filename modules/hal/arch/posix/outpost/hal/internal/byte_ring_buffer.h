@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_HAL_POSIX_BYTE_RING_BUFFER_H
+#define OUTPOST_HAL_POSIX_BYTE_RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace outpost
+{
+namespace hal
+{
+/**
+ * Lock-free ring buffer for bytes with a single producer and a single
+ * consumer.
+ *
+ * The producer only modifies the write position and the consumer only
+ * the read position, both may run in different threads without further
+ * synchronization. Besides copying blocks of bytes the buffer gives
+ * direct access to its contiguous free and used regions, e.g. to pass
+ * them to read() and write() system calls without an intermediate copy.
+ */
+class ByteRingBuffer
+{
+public:
+    explicit ByteRingBuffer(size_t capacity);
+
+    inline size_t
+    getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    /**
+     * Number of bytes stored in the buffer.
+     *
+     * The read position is loaded first. Both positions only increase,
+     * therefore the write position loaded afterwards is never behind it.
+     * If the other side advances in between, the result may be larger
+     * than the current number of bytes and is limited to the capacity.
+     * This makes the value exact for the consumer and a lower bound of
+     * the free space for the producer.
+     */
+    inline size_t
+    getNumberOfElements() const
+    {
+        const size_t readPosition = mReadPosition.load(std::memory_order_acquire);
+        const size_t writePosition = mWritePosition.load(std::memory_order_acquire);
+        return std::min(writePosition - readPosition, mCapacity);
+    }
+
+    inline size_t
+    getFreeSpace() const
+    {
+        return mCapacity - getNumberOfElements();
+    }
+
+    /**
+     * Append bytes, producer only.
+     *
+     * \return
+     *      Number of bytes appended, limited by the free space.
+     */
+    size_t
+    write(const uint8_t* data, size_t length);
+
+    /**
+     * Remove bytes from the front, consumer only.
+     *
+     * \return
+     *      Number of bytes copied to \p data.
+     */
+    size_t
+    read(uint8_t* data, size_t length);
+
+    /**
+     * Access the contiguous free region behind the stored data, producer
+     * only. Bytes written there are appended with commit().
+     *
+     * \return
+     *      Length of the region.
+     */
+    size_t
+    getWriteRegion(uint8_t*& data);
+
+    void
+    commit(size_t length);
+
+    /**
+     * Access the contiguous region at the front of the stored data,
+     * consumer only. The bytes are removed with consume().
+     *
+     * \return
+     *      Length of the region.
+     */
+    size_t
+    getReadRegion(const uint8_t*& data) const;
+
+    void
+    consume(size_t length);
+
+    /**
+     * Discard all stored bytes, consumer only.
+     */
+    void
+    clear();
+
+private:
+    const size_t mCapacity;
+    std::unique_ptr<uint8_t[]> mStorage;
+
+    std::atomic<size_t> mWritePosition;
+    std::atomic<size_t> mReadPosition;
+};
+
+}  // namespace hal
+}  // namespace outpost
+
+#endif
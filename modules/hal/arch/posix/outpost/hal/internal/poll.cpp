@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "poll.h"
+
+#include <outpost/rtos/internal/time.h>
+
+#include <errno.h>
+#include <poll.h>
+
+namespace outpost
+{
+namespace hal
+{
+bool
+waitForDescriptor(int descriptor, short events, time::Duration timeout)
+{
+    pollfd request;
+    request.fd = descriptor;
+    request.events = events;
+
+    const bool infinite = (timeout >= time::Duration::infinity());
+    timespec deadline = rtos::toAbsoluteTime(CLOCK_MONOTONIC,
+                                              infinite ? time::Duration::zero() : timeout);
+
+    int result;
+    do
+    {
+        request.revents = 0;
+        if (infinite)
+        {
+            result = ppoll(&request, 1, nullptr, nullptr);
+        }
+        else
+        {
+            // Recalculate the remaining time after every interruption
+            timespec remaining = {0, 0};
+            timespec now = rtos::getTime(CLOCK_MONOTONIC);
+            if (!rtos::isBigger(now, deadline))
+            {
+                timespec elapsed = {-now.tv_sec, -now.tv_nsec};
+                remaining = deadline;
+                rtos::addTime(remaining, elapsed);
+            }
+            result = ppoll(&request, 1, &remaining, nullptr);
+        }
+    } while ((result < 0) && (errno == EINTR));
+
+    return (result > 0) && ((request.revents & events) != 0);
+}
+
+}  // namespace hal
+}  // namespace outpost
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_HAL_POSIX_POLL_H
+#define OUTPOST_HAL_POSIX_POLL_H
+
+#include <outpost/time/duration.h>
+
+namespace outpost
+{
+namespace hal
+{
+/**
+ * Wait until a file descriptor is ready for the requested operations.
+ *
+ * The timeout is measured with the monotonic clock. Interruptions by a
+ * signal restart the wait for the remaining time.
+ *
+ * \param descriptor
+ *      File descriptor to wait for.
+ * \param events
+ *      Events to wait for, e.g. `POLLIN` or `POLLOUT`.
+ * \param timeout
+ *      Maximum time to wait. `Duration::infinity()` waits without limit,
+ *      a zero duration only checks the current state.
+ *
+ * \retval true     At least one of the requested events is signaled.
+ * \retval false    Timeout or error.
+ */
+bool
+waitForDescriptor(int descriptor, short events, time::Duration timeout);
+
+}  // namespace hal
+}  // namespace outpost
+
+#endif
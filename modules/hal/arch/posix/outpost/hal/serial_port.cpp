@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "serial_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <outpost/rtos/mutex_guard.h>
+
+#include <algorithm>
+
+using outpost::hal::SerialPort;
+
+namespace
+{
+struct BaudrateMapping
+{
+    uint32_t baudrate;
+    speed_t speed;
+};
+
+const BaudrateMapping baudrates[] = {{1200, B1200},
+                                     {2400, B2400},
+                                     {4800, B4800},
+                                     {9600, B9600},
+                                     {19200, B19200},
+                                     {38400, B38400},
+                                     {57600, B57600},
+                                     {115200, B115200},
+                                     {230400, B230400},
+                                     {460800, B460800},
+                                     {921600, B921600}};
+
+bool
+getSpeed(uint32_t baudrate, speed_t& speed)
+{
+    for (const BaudrateMapping& mapping : baudrates)
+    {
+        if (mapping.baudrate == baudrate)
+        {
+            speed = mapping.speed;
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+SerialPort::SerialPort(size_t bufferSize) :
+    mReceiveBuffer(bufferSize),
+    mTransmitBuffer(bufferSize),
+    mDevice(-1),
+    mEvent(-1),
+    mRunning(false),
+    mClock(),
+    mWriteMutex(),
+    mReceiveSignal(outpost::rtos::BinarySemaphore::State::acquired),
+    mTransmitSignal(outpost::rtos::BinarySemaphore::State::acquired),
+    mStartSignal(outpost::rtos::BinarySemaphore::State::acquired),
+    mStopSignal(outpost::rtos::BinarySemaphore::State::acquired),
+    mThreadStarted(false),
+    mThread(*this)
+{
+}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+bool
+SerialPort::open(const char* device, uint32_t baudrate)
+{
+    speed_t speed;
+    if (mRunning || !getSpeed(baudrate, speed))
+    {
+        return false;
+    }
+
+    mDevice = ::open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (mDevice < 0)
+    {
+        return false;
+    }
+
+    termios attributes;
+    bool configured = (tcgetattr(mDevice, &attributes) == 0);
+    if (configured)
+    {
+        cfmakeraw(&attributes);
+        attributes.c_cflag |= CLOCAL | CREAD;
+        attributes.c_cflag &= ~(CSTOPB | CRTSCTS);
+        cfsetispeed(&attributes, speed);
+        cfsetospeed(&attributes, speed);
+        configured = (tcsetattr(mDevice, TCSANOW, &attributes) == 0);
+    }
+
+    mEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!configured || (mEvent < 0))
+    {
+        close();
+        return false;
+    }
+
+    mReceiveBuffer.clear();
+    mRunning = true;
+    if (!mThreadStarted)
+    {
+        mThreadStarted = true;
+        mThread.start();
+    }
+    mStartSignal.release();
+    return true;
+}
+
+void
+SerialPort::close()
+{
+    if (mRunning)
+    {
+        mRunning = false;
+        notifyTransfer();
+        mStopSignal.acquire();
+
+        // Release threads waiting in read(), write() or flushTransmitter()
+        mReceiveSignal.release();
+        mTransmitSignal.release();
+    }
+
+    if (mEvent >= 0)
+    {
+        ::close(mEvent);
+        mEvent = -1;
+    }
+    if (mDevice >= 0)
+    {
+        ::close(mDevice);
+        mDevice = -1;
+    }
+}
+
+bool
+SerialPort::isAvailable()
+{
+    return mReceiveBuffer.getNumberOfElements() > 0;
+}
+
+size_t
+SerialPort::getNumberOfBytesAvailable()
+{
+    return mReceiveBuffer.getNumberOfElements();
+}
+
+size_t
+SerialPort::read(outpost::Slice<uint8_t> data, outpost::time::Duration timeout)
+{
+    size_t requested = std::min(data.getNumberOfElements(), mReceiveBuffer.getCapacity());
+    if (mReceiveBuffer.getNumberOfElements() < requested)
+    {
+        waitFor(mReceiveSignal, timeout, [this, requested]() {
+            return !mRunning || (mReceiveBuffer.getNumberOfElements() >= requested);
+        });
+    }
+
+    bool full = (mReceiveBuffer.getFreeSpace() == 0);
+    size_t length = mReceiveBuffer.read(data.begin(), data.getNumberOfElements());
+    if (full && (length > 0))
+    {
+        // The background thread stopped reading from the device
+        notifyTransfer();
+    }
+    return length;
+}
+
+size_t
+SerialPort::write(outpost::Slice<const uint8_t> data, outpost::time::Duration timeout)
+{
+    outpost::rtos::MutexGuard lock(mWriteMutex);
+
+    size_t written = 0;
+    while (mRunning && (written < data.getNumberOfElements()))
+    {
+        bool empty = (mTransmitBuffer.getNumberOfElements() == 0);
+        written += mTransmitBuffer.write(&data[written], data.getNumberOfElements() - written);
+
+        // Further writes are collected until the background thread wakes up
+        if (empty)
+        {
+            notifyTransfer();
+        }
+
+        if ((written < data.getNumberOfElements())
+            && !waitFor(mTransmitSignal, timeout, [this]() {
+                   return !mRunning || (mTransmitBuffer.getFreeSpace() > 0);
+               }))
+        {
+            break;
+        }
+    }
+    return written;
+}
+
+void
+SerialPort::flushReceiver()
+{
+    if (mDevice >= 0)
+    {
+        tcflush(mDevice, TCIFLUSH);
+    }
+
+    bool full = (mReceiveBuffer.getFreeSpace() == 0);
+    mReceiveBuffer.clear();
+    if (full)
+    {
+        notifyTransfer();
+    }
+}
+
+void
+SerialPort::flushTransmitter()
+{
+    outpost::rtos::MutexGuard lock(mWriteMutex);
+    waitFor(mTransmitSignal, outpost::time::Duration::infinity(), [this]() {
+        return !mRunning || (mTransmitBuffer.getNumberOfElements() == 0);
+    });
+}
+
+//------------------------------------------------------------------------------
+SerialPort::TransferThread::TransferThread(SerialPort& port) :
+    // Priority and stack size are not used for POSIX
+    outpost::rtos::Thread(0, outpost::rtos::Thread::defaultStackSize, "SERP"),
+    mPort(port)
+{
+}
+
+void
+SerialPort::TransferThread::run()
+{
+    while (true)
+    {
+        mPort.mStartSignal.acquire();
+        mPort.transfer();
+        mPort.mStopSignal.release();
+    }
+}
+
+void
+SerialPort::transfer()
+{
+    bool connected = true;
+    while (mRunning)
+    {
+        pollfd descriptors[2];
+        descriptors[0].fd = mEvent;
+        descriptors[0].events = POLLIN;
+        descriptors[1].fd = mDevice;
+        descriptors[1].events = 0;
+        if (connected && (mReceiveBuffer.getFreeSpace() > 0))
+        {
+            descriptors[1].events |= POLLIN;
+        }
+        if (connected && (mTransmitBuffer.getNumberOfElements() > 0))
+        {
+            descriptors[1].events |= POLLOUT;
+        }
+
+        if (poll(descriptors, 2, -1) < 0)
+        {
+            continue;
+        }
+
+        if (descriptors[0].revents & POLLIN)
+        {
+            uint64_t value;
+            if (::read(mEvent, &value, sizeof(value)) < 0)
+            {
+                // Counter already reset, nothing to do
+            }
+        }
+
+        if (descriptors[1].revents & POLLIN)
+        {
+            uint8_t* region;
+            size_t length = mReceiveBuffer.getWriteRegion(region);
+            ssize_t result = ::read(mDevice, region, length);
+            if (result > 0)
+            {
+                mReceiveBuffer.commit(result);
+                mReceiveSignal.release();
+            }
+            else if ((result == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+            {
+                connected = false;
+            }
+        }
+
+        if (descriptors[1].revents & POLLOUT)
+        {
+            // Everything written since the last wake up goes out at once
+            const uint8_t* region;
+            size_t length = mTransmitBuffer.getReadRegion(region);
+            ssize_t result = ::write(mDevice, region, length);
+            if (result > 0)
+            {
+                mTransmitBuffer.consume(result);
+                mTransmitSignal.release();
+            }
+        }
+
+        if (!connected
+            || ((descriptors[1].revents & (POLLHUP | POLLERR))
+                && !(descriptors[1].revents & POLLIN)))
+        {
+            // The other end has been closed, e.g. the master of a pseudo
+            // terminal. Wait for close() instead of polling the device.
+            connected = false;
+            mTransmitBuffer.clear();
+            mTransmitSignal.release();
+        }
+    }
+}
+
+void
+SerialPort::notifyTransfer()
+{
+    uint64_t value = 1;
+    if (::write(mEvent, &value, sizeof(value)) < 0)
+    {
+        // Counter is already set, the background thread wakes up anyway
+    }
+}
+
+template <typename Predicate>
+bool
+SerialPort::waitFor(outpost::rtos::BinarySemaphore& signal,
+                    outpost::time::Duration timeout,
+                    Predicate predicate)
+{
+    outpost::time::SpacecraftElapsedTime start = mClock.now();
+    while (!predicate())
+    {
+        outpost::time::Duration remaining = timeout;
+        if (timeout != outpost::time::Duration::infinity())
+        {
+            outpost::time::Duration elapsed = mClock.now() - start;
+            if (elapsed >= timeout)
+            {
+                return false;
+            }
+            remaining = timeout - elapsed;
+        }
+
+        if (!signal.acquire(remaining))
+        {
+            return predicate();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_HAL_SERIAL_PORT_H
+#define OUTPOST_HAL_SERIAL_PORT_H
+
+#include "internal/byte_ring_buffer.h"
+
+#include <outpost/hal/serial.h>
+#include <outpost/rtos/clock.h>
+#include <outpost/rtos/mutex.h>
+#include <outpost/rtos/semaphore.h>
+#include <outpost/rtos/thread.h>
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace outpost
+{
+namespace hal
+{
+/**
+ * Serial interface for POSIX terminal devices, e.g. UARTs or pseudo
+ * terminals.
+ *
+ * A background thread transfers the data between the device and a receive
+ * and a transmit ring buffer. The application only accesses the ring
+ * buffers, checking for and reading already received bytes does not need
+ * a system call.
+ *
+ * Data passed to write() is collected in the transmit buffer and written
+ * to the device by the background thread. Small writes issued while the
+ * device is busy are combined into a single system call.
+ *
+ * One thread may read while other threads write.
+ */
+class SerialPort : public Serial
+{
+public:
+    /**
+     * \param bufferSize
+     *      Size of the receive and of the transmit ring buffer in bytes.
+     */
+    explicit SerialPort(size_t bufferSize = 4096);
+
+    virtual ~SerialPort();
+
+    /**
+     * Open and configure a terminal device.
+     *
+     * The device is set to raw mode with 8 data bits, no parity and one
+     * stop bit.
+     *
+     * \param device
+     *      Path of the device, e.g. "/dev/ttyUSB0".
+     * \param baudrate
+     *      Baudrate in bit/s, must be one of the standard POSIX rates.
+     *
+     * \retval true     Device opened and background thread started.
+     * \retval false    Device could not be opened or configured.
+     */
+    bool
+    open(const char* device, uint32_t baudrate);
+
+    virtual void
+    close() override;
+
+    virtual bool
+    isAvailable() override;
+
+    /**
+     * Number of bytes in the receive buffer.
+     *
+     * Only reads the fill level of the ring buffer, the device itself is
+     * not queried.
+     */
+    virtual size_t
+    getNumberOfBytesAvailable() override;
+
+    virtual size_t
+    read(outpost::Slice<uint8_t> data,
+         outpost::time::Duration timeout = outpost::time::Duration::maximum()) override;
+
+    virtual size_t
+    write(outpost::Slice<const uint8_t> data,
+          outpost::time::Duration timeout = outpost::time::Duration::maximum()) override;
+
+    virtual void
+    flushReceiver() override;
+
+    /**
+     * Wait until the transmit buffer has been handed over to the device.
+     */
+    virtual void
+    flushTransmitter() override;
+
+private:
+    /**
+     * Background thread, started with the first call of open() and
+     * reused after the device has been closed and opened again.
+     */
+    class TransferThread : public outpost::rtos::Thread
+    {
+    public:
+        explicit TransferThread(SerialPort& port);
+
+    private:
+        virtual void
+        run() override;
+
+        SerialPort& mPort;
+    };
+
+    /**
+     * Transfer data until close() is called.
+     */
+    void
+    transfer();
+
+    /**
+     * Wake up the background thread to update the events it waits for.
+     */
+    void
+    notifyTransfer();
+
+    /**
+     * Wait on \p signal until \p predicate becomes true.
+     *
+     * The signal only indicates that the state may have changed, the
+     * predicate is checked again after every wake up. Only one thread may
+     * wait on a signal at a time.
+     *
+     * \retval true     Predicate is true.
+     * \retval false    Timeout.
+     */
+    template <typename Predicate>
+    bool
+    waitFor(outpost::rtos::BinarySemaphore& signal,
+            outpost::time::Duration timeout,
+            Predicate predicate);
+
+    ByteRingBuffer mReceiveBuffer;
+    ByteRingBuffer mTransmitBuffer;
+
+    int mDevice;
+
+    /// Event file descriptor to wake up the background thread
+    int mEvent;
+    std::atomic<bool> mRunning;
+    outpost::rtos::SystemClock mClock;
+
+    /// Serializes the producers of the transmit buffer and
+    /// flushTransmitter(), so that only one thread waits for the
+    /// transmit signal
+    outpost::rtos::Mutex mWriteMutex;
+
+    /// Released by the background thread after data has been received
+    outpost::rtos::BinarySemaphore mReceiveSignal;
+
+    /// Released by the background thread after data has been transmitted
+    outpost::rtos::BinarySemaphore mTransmitSignal;
+
+    /// Handshake between open()/close() and the background thread
+    outpost::rtos::BinarySemaphore mStartSignal;
+    outpost::rtos::BinarySemaphore mStopSignal;
+    bool mThreadStarted;
+
+    // Declared last, the thread has to be stopped before the
+    // semaphores are destroyed
+    TransferThread mThread;
+};
+
+}  // namespace hal
+}  // namespace outpost
+
+#endif
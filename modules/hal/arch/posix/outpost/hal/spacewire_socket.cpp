@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spacewire_socket.h"
+
+#include "internal/poll.h"
+
+#include <outpost/rtos/mutex_guard.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using outpost::hal::SpaceWireSocket;
+
+constexpr size_t SpaceWireSocket::headerLength;
+
+//------------------------------------------------------------------------------
+SpaceWireSocket::Address::Address() : mAddress(), mLength(0)
+{
+}
+
+SpaceWireSocket::Address
+SpaceWireSocket::Address::unixDomain(const char* path)
+{
+    Address address;
+    sockaddr_un* unixAddress = reinterpret_cast<sockaddr_un*>(&address.mAddress);
+    unixAddress->sun_family = AF_UNIX;
+    strncpy(unixAddress->sun_path, path, sizeof(unixAddress->sun_path) - 1);
+    size_t length = offsetof(sockaddr_un, sun_path) + strlen(unixAddress->sun_path) + 1;
+    address.mLength = static_cast<socklen_t>(length);
+    return address;
+}
+
+SpaceWireSocket::Address
+SpaceWireSocket::Address::udp(uint16_t port)
+{
+    Address address;
+    sockaddr_in* inetAddress = reinterpret_cast<sockaddr_in*>(&address.mAddress);
+    inetAddress->sin_family = AF_INET;
+    inetAddress->sin_port = htons(port);
+    inetAddress->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.mLength = sizeof(sockaddr_in);
+    return address;
+}
+
+//------------------------------------------------------------------------------
+SpaceWireSocket::SpaceWireSocket(const Address& local,
+                                 const Address& remote,
+                                 size_t maximumPacketLength,
+                                 size_t numberOfBuffers) :
+    mLocal(local),
+    mRemote(remote),
+    mMaximumPacketLength(maximumPacketLength),
+    mNumberOfBuffers(numberOfBuffers),
+    mBufferStride(maximumPacketLength + headerLength),
+    mSocket(-1),
+    mUp(false),
+    mClock(),
+    mTransmitStorage(new uint8_t[numberOfBuffers * mBufferStride]),
+    mTransmitBuffers(new TransmitBuffer[numberOfBuffers]),
+    mTransmitBufferUsed(new bool[numberOfBuffers]),
+    mTransmitMutex(),
+    mFreeTransmitBuffers(static_cast<uint32_t>(numberOfBuffers)),
+    mReceiveStorage(new uint8_t[numberOfBuffers * mBufferStride]),
+    mFreeReceiveBuffers(new size_t[numberOfBuffers]),
+    mNumberOfFreeReceiveBuffers(numberOfBuffers),
+    mPendingIndex(new size_t[numberOfBuffers]),
+    mPendingLength(new size_t[numberOfBuffers]),
+    mPendingStart(0),
+    mNumberOfPending(0),
+    mReceiveMutex(),
+    mTransmitMessages(new mmsghdr[numberOfBuffers]),
+    mTransmitVectors(new iovec[numberOfBuffers]),
+    mTransmitMessageIndex(new size_t[numberOfBuffers]),
+    mSendMutex(),
+    mReceiveMessages(new mmsghdr[numberOfBuffers]),
+    mReceiveVectors(new iovec[numberOfBuffers]),
+    mReceiveMessageIndex(new size_t[numberOfBuffers])
+{
+    for (size_t i = 0; i < numberOfBuffers; ++i)
+    {
+        mTransmitBufferUsed[i] = false;
+        mFreeReceiveBuffers[i] = i;
+    }
+}
+
+SpaceWireSocket::~SpaceWireSocket()
+{
+    close();
+}
+
+size_t
+SpaceWireSocket::getMaximumPacketLength() const
+{
+    return mMaximumPacketLength;
+}
+
+bool
+SpaceWireSocket::open()
+{
+    if (mSocket >= 0)
+    {
+        return true;
+    }
+
+    mSocket = socket(mLocal.getFamily(), SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (mSocket < 0)
+    {
+        return false;
+    }
+
+    if (mLocal.getFamily() == AF_UNIX)
+    {
+        // Remove a stale socket file of an earlier run
+        unlink(reinterpret_cast<const sockaddr_un*>(mLocal.get())->sun_path);
+    }
+
+    if (bind(mSocket, mLocal.get(), mLocal.getLength()) != 0)
+    {
+        ::close(mSocket);
+        mSocket = -1;
+        return false;
+    }
+    return true;
+}
+
+void
+SpaceWireSocket::close()
+{
+    mUp = false;
+    if (mSocket >= 0)
+    {
+        ::close(mSocket);
+        mSocket = -1;
+
+        if (mLocal.getFamily() == AF_UNIX)
+        {
+            unlink(reinterpret_cast<const sockaddr_un*>(mLocal.get())->sun_path);
+        }
+    }
+}
+
+bool
+SpaceWireSocket::up(outpost::time::Duration /*timeout*/)
+{
+    mUp = (mSocket >= 0);
+    return mUp;
+}
+
+void
+SpaceWireSocket::down(outpost::time::Duration /*timeout*/)
+{
+    mUp = false;
+}
+
+bool
+SpaceWireSocket::isUp()
+{
+    return mUp;
+}
+
+SpaceWireSocket::Result::Type
+SpaceWireSocket::requestBuffer(TransmitBuffer*& buffer, outpost::time::Duration timeout)
+{
+    buffer = nullptr;
+    if (!mFreeTransmitBuffers.acquire(timeout))
+    {
+        return Result::timeout;
+    }
+
+    outpost::rtos::MutexGuard lock(mTransmitMutex);
+    for (size_t i = 0; i < mNumberOfBuffers; ++i)
+    {
+        if (!mTransmitBufferUsed[i])
+        {
+            mTransmitBufferUsed[i] = true;
+            mTransmitBuffers[i] = TransmitBuffer(outpost::Slice<uint8_t>::unsafe(
+                    getTransmitStorage(i) + headerLength, mMaximumPacketLength));
+            buffer = &mTransmitBuffers[i];
+            return Result::success;
+        }
+    }
+
+    // Not reachable, the semaphore counts the free buffers
+    mFreeTransmitBuffers.release();
+    return Result::failure;
+}
+
+SpaceWireSocket::Result::Type
+SpaceWireSocket::send(TransmitBuffer* buffer, outpost::time::Duration timeout)
+{
+    size_t sent = sendBuffers(outpost::Slice<TransmitBuffer* const>::unsafe(&buffer, 1), timeout);
+    return (sent == 1) ? Result::success : Result::failure;
+}
+
+size_t
+SpaceWireSocket::sendBuffers(outpost::Slice<TransmitBuffer* const> buffers,
+                             outpost::time::Duration timeout)
+{
+    if (buffers.getNumberOfElements() > mNumberOfBuffers)
+    {
+        // Would overflow the transmit descriptors, every buffer can only
+        // be part of the batch once
+        return 0;
+    }
+
+    // The descriptors are shared by all threads sending on this link
+    outpost::rtos::MutexGuard lock(mSendMutex);
+
+    size_t numberOfMessages = 0;
+    for (size_t i = 0; i < buffers.getNumberOfElements(); ++i)
+    {
+        TransmitBuffer* buffer = buffers[i];
+        if ((buffer < &mTransmitBuffers[0]) || (buffer >= &mTransmitBuffers[mNumberOfBuffers]))
+        {
+            // Not one of our buffers
+            continue;
+        }
+
+        size_t index = static_cast<size_t>(buffer - &mTransmitBuffers[0]);
+        uint8_t* storage = getTransmitStorage(index);
+        storage[0] = static_cast<uint8_t>(buffer->getEndMarker());
+
+        mTransmitVectors[numberOfMessages].iov_base = storage;
+        mTransmitVectors[numberOfMessages].iov_len = buffer->getLength() + headerLength;
+
+        msghdr& header = mTransmitMessages[numberOfMessages].msg_hdr;
+        memset(&header, 0, sizeof(header));
+        header.msg_name = const_cast<sockaddr*>(mRemote.get());
+        header.msg_namelen = mRemote.getLength();
+        header.msg_iov = &mTransmitVectors[numberOfMessages];
+        header.msg_iovlen = 1;
+
+        mTransmitMessageIndex[numberOfMessages] = index;
+        numberOfMessages++;
+    }
+
+    // The timeout applies to the whole batch, not to every retry
+    const outpost::time::SpacecraftElapsedTime start = mClock.now();
+    size_t sent = 0;
+    size_t position = 0;
+    while (mUp && (position < numberOfMessages))
+    {
+        int result = sendmmsg(mSocket,
+                              &mTransmitMessages[position],
+                              static_cast<unsigned int>(numberOfMessages - position),
+                              MSG_DONTWAIT);
+        if (result > 0)
+        {
+            sent += static_cast<size_t>(result);
+            position += static_cast<size_t>(result);
+        }
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+        {
+            outpost::time::Duration remaining = timeout;
+            if (timeout != outpost::time::Duration::infinity())
+            {
+                outpost::time::Duration elapsed = mClock.now() - start;
+                remaining = (elapsed < timeout) ? (timeout - elapsed)
+                                                : outpost::time::Duration::zero();
+            }
+            if (!waitForDescriptor(mSocket, POLLOUT, remaining))
+            {
+                break;
+            }
+        }
+        else if (errno != EINTR)
+        {
+            // Skip the datagram which could not be delivered, e.g. because
+            // the remote Unix-domain socket does not exist
+            position++;
+        }
+    }
+
+    // All buffers are released, independent of the result
+    for (size_t i = 0; i < numberOfMessages; ++i)
+    {
+        releaseTransmitBuffer(mTransmitMessageIndex[i]);
+    }
+    return sent;
+}
+
+SpaceWireSocket::Result::Type
+SpaceWireSocket::receive(ReceiveBuffer& buffer, outpost::time::Duration timeout)
+{
+    if (!mUp)
+    {
+        return Result::failure;
+    }
+
+    {
+        outpost::rtos::MutexGuard lock(mReceiveMutex);
+        if (takePending(outpost::Slice<ReceiveBuffer>::unsafe(&buffer, 1)) == 1)
+        {
+            return Result::success;
+        }
+        if (mNumberOfFreeReceiveBuffers == 0)
+        {
+            return Result::failure;
+        }
+    }
+
+    if (!waitForDescriptor(mSocket, POLLIN, timeout))
+    {
+        return Result::timeout;
+    }
+
+    if (!fetchDatagrams())
+    {
+        return Result::failure;
+    }
+
+    outpost::rtos::MutexGuard lock(mReceiveMutex);
+    if (takePending(outpost::Slice<ReceiveBuffer>::unsafe(&buffer, 1)) == 1)
+    {
+        return Result::success;
+    }
+    return Result::timeout;
+}
+
+size_t
+SpaceWireSocket::receiveBuffers(outpost::Slice<ReceiveBuffer> buffers,
+                                outpost::time::Duration timeout)
+{
+    if (!mUp)
+    {
+        return 0;
+    }
+
+    {
+        outpost::rtos::MutexGuard lock(mReceiveMutex);
+        size_t count = takePending(buffers);
+        if ((count > 0) || (mNumberOfFreeReceiveBuffers == 0))
+        {
+            return count;
+        }
+    }
+
+    if (!waitForDescriptor(mSocket, POLLIN, timeout) || !fetchDatagrams())
+    {
+        return 0;
+    }
+
+    outpost::rtos::MutexGuard lock(mReceiveMutex);
+    return takePending(buffers);
+}
+
+void
+SpaceWireSocket::releaseBuffer(const ReceiveBuffer& buffer)
+{
+    releaseBuffers(outpost::Slice<const ReceiveBuffer>::unsafe(&buffer, 1));
+}
+
+void
+SpaceWireSocket::releaseBuffers(outpost::Slice<const ReceiveBuffer> buffers)
+{
+    outpost::rtos::MutexGuard lock(mReceiveMutex);
+    for (size_t i = 0; i < buffers.getNumberOfElements(); ++i)
+    {
+        size_t index = getIndex(buffers[i].getData().begin());
+        if (index < mNumberOfBuffers)
+        {
+            mFreeReceiveBuffers[mNumberOfFreeReceiveBuffers] = index;
+            mNumberOfFreeReceiveBuffers++;
+        }
+    }
+}
+
+void
+SpaceWireSocket::flushReceiveBuffer()
+{
+    outpost::rtos::MutexGuard lock(mReceiveMutex);
+    while (mNumberOfPending > 0)
+    {
+        mFreeReceiveBuffers[mNumberOfFreeReceiveBuffers] = mPendingIndex[mPendingStart];
+        mNumberOfFreeReceiveBuffers++;
+        mPendingStart = (mPendingStart + 1) % mNumberOfBuffers;
+        mNumberOfPending--;
+    }
+
+    if (mSocket >= 0)
+    {
+        // Discard all datagrams waiting in the socket
+        while (recv(mSocket, nullptr, 0, MSG_DONTWAIT | MSG_TRUNC) >= 0)
+        {
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+size_t
+SpaceWireSocket::getIndex(const uint8_t* data) const
+{
+    const uint8_t* start = mReceiveStorage.get() + headerLength;
+    if ((data < start) || (data >= (start + mNumberOfBuffers * mBufferStride)))
+    {
+        return mNumberOfBuffers;
+    }
+    return static_cast<size_t>(data - start) / mBufferStride;
+}
+
+uint8_t*
+SpaceWireSocket::getTransmitStorage(size_t index) const
+{
+    return mTransmitStorage.get() + index * mBufferStride;
+}
+
+uint8_t*
+SpaceWireSocket::getReceiveStorage(size_t index) const
+{
+    return mReceiveStorage.get() + index * mBufferStride;
+}
+
+void
+SpaceWireSocket::releaseTransmitBuffer(size_t index)
+{
+    {
+        outpost::rtos::MutexGuard lock(mTransmitMutex);
+        mTransmitBufferUsed[index] = false;
+    }
+    mFreeTransmitBuffers.release();
+}
+
+bool
+SpaceWireSocket::fetchDatagrams()
+{
+    outpost::rtos::MutexGuard lock(mReceiveMutex);
+
+    // Hand all free buffers to the kernel at once
+    size_t numberOfMessages = mNumberOfFreeReceiveBuffers;
+    for (size_t i = 0; i < numberOfMessages; ++i)
+    {
+        size_t index = mFreeReceiveBuffers[mNumberOfFreeReceiveBuffers - 1 - i];
+        mReceiveMessageIndex[i] = index;
+
+        mReceiveVectors[i].iov_base = getReceiveStorage(index);
+        mReceiveVectors[i].iov_len = mBufferStride;
+
+        msghdr& header = mReceiveMessages[i].msg_hdr;
+        memset(&header, 0, sizeof(header));
+        header.msg_iov = &mReceiveVectors[i];
+        header.msg_iovlen = 1;
+    }
+
+    int result;
+    do
+    {
+        result = recvmmsg(mSocket,
+                          &mReceiveMessages[0],
+                          static_cast<unsigned int>(numberOfMessages),
+                          MSG_DONTWAIT,
+                          nullptr);
+    } while ((result < 0) && (errno == EINTR));
+
+    if (result < 0)
+    {
+        return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+    }
+
+    mNumberOfFreeReceiveBuffers -= numberOfMessages;
+    for (size_t i = 0; i < numberOfMessages; ++i)
+    {
+        size_t index = mReceiveMessageIndex[i];
+        size_t length = mReceiveMessages[i].msg_len;
+        if ((i >= static_cast<size_t>(result)) || (length < headerLength))
+        {
+            // Unused or empty datagram without an end marker
+            mFreeReceiveBuffers[mNumberOfFreeReceiveBuffers] = index;
+            mNumberOfFreeReceiveBuffers++;
+            continue;
+        }
+
+        uint8_t* storage = getReceiveStorage(index);
+        if (((mReceiveMessages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) || (storage[0] > unknown))
+        {
+            // Packet longer than the receive buffer or invalid end marker
+            storage[0] = eep;
+        }
+
+        size_t position = (mPendingStart + mNumberOfPending) % mNumberOfBuffers;
+        mPendingIndex[position] = index;
+        mPendingLength[position] = length - headerLength;
+        mNumberOfPending++;
+    }
+    return true;
+}
+
+size_t
+SpaceWireSocket::takePending(outpost::Slice<ReceiveBuffer> buffers)
+{
+    size_t count = 0;
+    while ((count < buffers.getNumberOfElements()) && (mNumberOfPending > 0))
+    {
+        uint8_t* storage = getReceiveStorage(mPendingIndex[mPendingStart]);
+        buffers[count] = ReceiveBuffer(
+                outpost::Slice<const uint8_t>::unsafe(storage + headerLength,
+                                                      mPendingLength[mPendingStart]),
+                static_cast<EndMarker>(storage[0]));
+
+        mPendingStart = (mPendingStart + 1) % mNumberOfBuffers;
+        mNumberOfPending--;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_HAL_SPACEWIRE_SOCKET_H
+#define OUTPOST_HAL_SPACEWIRE_SOCKET_H
+
+#include <outpost/hal/spacewire.h>
+#include <outpost/rtos/clock.h>
+#include <outpost/rtos/mutex.h>
+#include <outpost/rtos/semaphore.h>
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <memory>
+
+namespace outpost
+{
+namespace hal
+{
+/**
+ * SpaceWire interface tunneled over datagram sockets.
+ *
+ * Every SpaceWire packet is transmitted as one datagram over a Unix-domain
+ * socket or a UDP socket on the loopback interface. The first byte of each
+ * datagram carries the end marker, the packet data follows. Packets sent
+ * with a partial end marker are forwarded as they are, the receiver gets
+ * the parts with the partial end marker.
+ *
+ * The transmit and receive buffers are allocated when the object is
+ * created. Received datagrams are fetched with recvmmsg() into all free
+ * receive buffers at once, the following calls to receive() are then
+ * served without a system call. sendBuffers() transmits a batch of
+ * packets with one call to sendmmsg().
+ *
+ * Datagram sockets are connectionless, therefore the link is up as soon
+ * as the socket is open and started. Sending fails if no socket is bound
+ * to the remote address of a Unix-domain socket.
+ */
+class SpaceWireSocket : public SpaceWire
+{
+public:
+    /**
+     * Socket address of a SpaceWire endpoint.
+     */
+    class Address
+    {
+    public:
+        /**
+         * Unix-domain socket bound to a file system path.
+         */
+        static Address
+        unixDomain(const char* path);
+
+        /**
+         * UDP socket on the loopback interface.
+         */
+        static Address
+        udp(uint16_t port);
+
+        inline const sockaddr*
+        get() const
+        {
+            return reinterpret_cast<const sockaddr*>(&mAddress);
+        }
+
+        inline socklen_t
+        getLength() const
+        {
+            return mLength;
+        }
+
+        inline int
+        getFamily() const
+        {
+            return mAddress.ss_family;
+        }
+
+    private:
+        Address();
+
+        sockaddr_storage mAddress;
+        socklen_t mLength;
+    };
+
+    /**
+     * \param local
+     *      Address the socket is bound to.
+     * \param remote
+     *      Address of the other end of the link.
+     * \param maximumPacketLength
+     *      Maximum length of a single SpaceWire packet, at most 65506 bytes
+     *      for UDP sockets.
+     * \param numberOfBuffers
+     *      Number of transmit and of receive buffers.
+     */
+    SpaceWireSocket(const Address& local,
+                    const Address& remote,
+                    size_t maximumPacketLength = 4096,
+                    size_t numberOfBuffers = 16);
+
+    virtual ~SpaceWireSocket();
+
+    virtual size_t
+    getMaximumPacketLength() const override;
+
+    virtual bool
+    open() override;
+
+    virtual void
+    close() override;
+
+    virtual bool
+    up(outpost::time::Duration timeout) override;
+
+    virtual void
+    down(outpost::time::Duration timeout) override;
+
+    virtual bool
+    isUp() override;
+
+    virtual Result::Type
+    requestBuffer(TransmitBuffer*& buffer, outpost::time::Duration timeout) override;
+
+    virtual Result::Type
+    send(TransmitBuffer* buffer, outpost::time::Duration timeout) override;
+
+    virtual Result::Type
+    receive(ReceiveBuffer& buffer, outpost::time::Duration timeout) override;
+
+    virtual void
+    releaseBuffer(const ReceiveBuffer& buffer) override;
+
+    virtual void
+    flushReceiveBuffer() override;
+
+    /**
+     * Send several buffers with a single system call.
+     *
+     * Batches with more entries than there are transmit buffers are
+     * rejected without sending or releasing any buffer.
+     */
+    virtual size_t
+    sendBuffers(outpost::Slice<TransmitBuffer* const> buffers,
+                outpost::time::Duration timeout) override;
+
+    virtual size_t
+    receiveBuffers(outpost::Slice<ReceiveBuffer> buffers,
+                   outpost::time::Duration timeout) override;
+
+    virtual void
+    releaseBuffers(outpost::Slice<const ReceiveBuffer> buffers) override;
+
+private:
+    /// Length of the end marker in front of the packet data
+    static constexpr size_t headerLength = 1;
+
+    size_t
+    getIndex(const uint8_t* data) const;
+
+    uint8_t*
+    getTransmitStorage(size_t index) const;
+
+    uint8_t*
+    getReceiveStorage(size_t index) const;
+
+    void
+    releaseTransmitBuffer(size_t index);
+
+    /**
+     * Fetch all available datagrams into the free receive buffers.
+     *
+     * \return
+     *      False if the socket reported an error.
+     */
+    bool
+    fetchDatagrams();
+
+    /**
+     * Hand out already fetched packets.
+     *
+     * Must be called with the receive mutex held.
+     */
+    size_t
+    takePending(outpost::Slice<ReceiveBuffer> buffers);
+
+    const Address mLocal;
+    const Address mRemote;
+    const size_t mMaximumPacketLength;
+    const size_t mNumberOfBuffers;
+    const size_t mBufferStride;
+
+    int mSocket;
+
+    /// Read by the sending and receiving threads without a lock
+    std::atomic<bool> mUp;
+
+    outpost::rtos::SystemClock mClock;
+
+    std::unique_ptr<uint8_t[]> mTransmitStorage;
+    std::unique_ptr<TransmitBuffer[]> mTransmitBuffers;
+    std::unique_ptr<bool[]> mTransmitBufferUsed;
+    outpost::rtos::Mutex mTransmitMutex;
+    outpost::rtos::Semaphore mFreeTransmitBuffers;
+
+    std::unique_ptr<uint8_t[]> mReceiveStorage;
+    std::unique_ptr<size_t[]> mFreeReceiveBuffers;
+    size_t mNumberOfFreeReceiveBuffers;
+
+    /// Ring of received packets which have not been handed out yet
+    std::unique_ptr<size_t[]> mPendingIndex;
+    std::unique_ptr<size_t[]> mPendingLength;
+    size_t mPendingStart;
+    size_t mNumberOfPending;
+    outpost::rtos::Mutex mReceiveMutex;
+
+    /// Scatter-gather descriptors for sendmmsg() and recvmmsg()
+    std::unique_ptr<mmsghdr[]> mTransmitMessages;
+    std::unique_ptr<iovec[]> mTransmitVectors;
+    std::unique_ptr<size_t[]> mTransmitMessageIndex;
+
+    /// Protects the transmit descriptors while a batch is sent
+    outpost::rtos::Mutex mSendMutex;
+    std::unique_ptr<mmsghdr[]> mReceiveMessages;
+    std::unique_ptr<iovec[]> mReceiveVectors;
+    std::unique_ptr<size_t[]> mReceiveMessageIndex;
+};
+
+}  // namespace hal
+}  // namespace outpost
+
+#endif
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "udp_transport.h"
+
+#include "internal/poll.h"
+
+#include <outpost/rtos/mutex_guard.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+using outpost::hal::UdpTransport;
+
+constexpr size_t UdpTransport::maximumDatagramSize;
+
+UdpTransport::UdpTransport(const Address& address, size_t maximumBatchSize) :
+    mAddress(address),
+    mSocket(-1),
+    mMaximumBatchSize(maximumBatchSize),
+    mTransmitMutex(),
+    mTransmitMessages(new mmsghdr[maximumBatchSize]),
+    mTransmitVectors(new iovec[maximumBatchSize]),
+    mTransmitAddresses(new sockaddr_in[maximumBatchSize]),
+    mReceiveMutex(),
+    mReceiveMessages(new mmsghdr[maximumBatchSize]),
+    mReceiveVectors(new iovec[maximumBatchSize]),
+    mReceiveAddresses(new sockaddr_in[maximumBatchSize])
+{
+    // The descriptors only change in the buffer and address they point to
+    for (size_t i = 0; i < maximumBatchSize; ++i)
+    {
+        memset(&mTransmitMessages[i], 0, sizeof(mmsghdr));
+        mTransmitMessages[i].msg_hdr.msg_name = &mTransmitAddresses[i];
+        mTransmitMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        mTransmitMessages[i].msg_hdr.msg_iov = &mTransmitVectors[i];
+        mTransmitMessages[i].msg_hdr.msg_iovlen = 1;
+
+        memset(&mReceiveMessages[i], 0, sizeof(mmsghdr));
+        mReceiveMessages[i].msg_hdr.msg_name = &mReceiveAddresses[i];
+        mReceiveMessages[i].msg_hdr.msg_iov = &mReceiveVectors[i];
+        mReceiveMessages[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+UdpTransport::~UdpTransport()
+{
+    close();
+}
+
+bool
+UdpTransport::connect()
+{
+    if (mSocket >= 0)
+    {
+        return true;
+    }
+
+    mSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (mSocket < 0)
+    {
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in local = toSocketAddress(mAddress);
+    socklen_t length = sizeof(local);
+    if ((bind(mSocket, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+        || (getsockname(mSocket, reinterpret_cast<sockaddr*>(&local), &length) != 0))
+    {
+        ::close(mSocket);
+        mSocket = -1;
+        return false;
+    }
+
+    // Keep the port selected by the operating system
+    mAddress = fromSocketAddress(local);
+    return true;
+}
+
+void
+UdpTransport::close()
+{
+    if (mSocket >= 0)
+    {
+        // Wakes up threads blocked in a receive call
+        shutdown(mSocket, SHUT_RDWR);
+        ::close(mSocket);
+        mSocket = -1;
+    }
+}
+
+UdpTransport::Address
+UdpTransport::getAddress() const
+{
+    return mAddress;
+}
+
+void
+UdpTransport::setAddress(const Address& newAddress)
+{
+    close();
+    mAddress = newAddress;
+}
+
+bool
+UdpTransport::isAvailable()
+{
+    return (mSocket >= 0) && waitForDescriptor(mSocket, POLLIN, outpost::time::Duration::zero());
+}
+
+size_t
+UdpTransport::getNumberOfBytesAvailable()
+{
+    if (!isAvailable())
+    {
+        return 0;
+    }
+
+    // With MSG_TRUNC the real length of the datagram is returned
+    ssize_t length = recv(mSocket, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+    return (length > 0) ? static_cast<size_t>(length) : 0;
+}
+
+size_t
+UdpTransport::getMaximumDatagramSize() const
+{
+    return maximumDatagramSize;
+}
+
+size_t
+UdpTransport::sendTo(outpost::Slice<const uint8_t> data,
+                     const Address& address,
+                     outpost::time::Duration timeout)
+{
+    outpost::rtos::MutexGuard lock(mTransmitMutex);
+    setTransmitMessage(0, data, address);
+    if (sendMessages(1, timeout) == 0)
+    {
+        return 0;
+    }
+    return mTransmitMessages[0].msg_len;
+}
+
+size_t
+UdpTransport::receiveFrom(outpost::Slice<uint8_t>& data,
+                          Address& address,
+                          outpost::time::Duration timeout)
+{
+    if ((mSocket < 0) || !waitForDescriptor(mSocket, POLLIN, timeout))
+    {
+        return 0;
+    }
+
+    sockaddr_in remote;
+    socklen_t length = sizeof(remote);
+    ssize_t result = recvfrom(mSocket,
+                              data.begin(),
+                              data.getNumberOfElements(),
+                              MSG_DONTWAIT,
+                              reinterpret_cast<sockaddr*>(&remote),
+                              &length);
+    if (result <= 0)
+    {
+        return 0;
+    }
+
+    address = fromSocketAddress(remote);
+    return static_cast<size_t>(result);
+}
+
+size_t
+UdpTransport::sendToMany(outpost::Slice<const Datagram> datagrams,
+                         outpost::time::Duration timeout)
+{
+    outpost::rtos::MutexGuard lock(mTransmitMutex);
+
+    size_t sent = 0;
+    while (sent < datagrams.getNumberOfElements())
+    {
+        size_t count = std::min(datagrams.getNumberOfElements() - sent, mMaximumBatchSize);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Datagram& datagram = datagrams[sent + i];
+            setTransmitMessage(i, datagram.getData(), datagram.getAddress());
+        }
+
+        // Only the first datagram may wait for the socket
+        outpost::time::Duration wait = (sent == 0) ? timeout : outpost::time::Duration::zero();
+        size_t result = sendMessages(count, wait);
+        sent += result;
+        if (result < count)
+        {
+            break;
+        }
+    }
+    return sent;
+}
+
+size_t
+UdpTransport::receiveMany(outpost::Slice<Datagram> datagrams, outpost::time::Duration timeout)
+{
+    if ((mSocket < 0) || (datagrams.getNumberOfElements() == 0)
+        || !waitForDescriptor(mSocket, POLLIN, timeout))
+    {
+        return 0;
+    }
+
+    outpost::rtos::MutexGuard lock(mReceiveMutex);
+
+    size_t received = 0;
+    while (received < datagrams.getNumberOfElements())
+    {
+        size_t count = std::min(datagrams.getNumberOfElements() - received, mMaximumBatchSize);
+        for (size_t i = 0; i < count; ++i)
+        {
+            outpost::Slice<uint8_t> buffer = datagrams[received + i].getBuffer();
+            mReceiveVectors[i].iov_base = buffer.begin();
+            mReceiveVectors[i].iov_len = buffer.getNumberOfElements();
+            mReceiveMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        int result;
+        do
+        {
+            result = recvmmsg(mSocket,
+                              &mReceiveMessages[0],
+                              static_cast<unsigned int>(count),
+                              MSG_DONTWAIT,
+                              nullptr);
+        } while ((result < 0) && (errno == EINTR));
+
+        if (result <= 0)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(result); ++i)
+        {
+            Datagram& datagram = datagrams[received + i];
+            datagram.setLength(mReceiveMessages[i].msg_len);
+            datagram.setAddress(fromSocketAddress(mReceiveAddresses[i]));
+        }
+
+        received += result;
+        if (static_cast<size_t>(result) < count)
+        {
+            // No further datagrams available
+            break;
+        }
+    }
+    return received;
+}
+
+void
+UdpTransport::clearReceiveBuffer()
+{
+    if (mSocket >= 0)
+    {
+        while (recv(mSocket, nullptr, 0, MSG_DONTWAIT | MSG_TRUNC) >= 0)
+        {
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+size_t
+UdpTransport::sendMessages(size_t count, outpost::time::Duration timeout)
+{
+    size_t sent = 0;
+    while ((mSocket >= 0) && (sent < count))
+    {
+        int result = sendmmsg(mSocket,
+                              &mTransmitMessages[sent],
+                              static_cast<unsigned int>(count - sent),
+                              MSG_DONTWAIT);
+        if (result > 0)
+        {
+            sent += result;
+        }
+        else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+        {
+            // Send buffer of the socket is full
+            if ((sent > 0) || !waitForDescriptor(mSocket, POLLOUT, timeout))
+            {
+                break;
+            }
+        }
+        else if (errno != EINTR)
+        {
+            break;
+        }
+    }
+    return sent;
+}
+
+void
+UdpTransport::setTransmitMessage(size_t index,
+                                 outpost::Slice<const uint8_t> data,
+                                 const Address& address)
+{
+    mTransmitAddresses[index] = toSocketAddress(address);
+    mTransmitVectors[index].iov_base = const_cast<uint8_t*>(data.begin());
+    mTransmitVectors[index].iov_len = data.getNumberOfElements();
+}
+
+sockaddr_in
+UdpTransport::toSocketAddress(const Address& address)
+{
+    sockaddr_in socketAddress;
+    memset(&socketAddress, 0, sizeof(socketAddress));
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons(address.getPort());
+
+    // The IP address is already stored in network byte order
+    std::array<uint8_t, 4> ip = address.getIpAddress().getArray();
+    memcpy(&socketAddress.sin_addr.s_addr, ip.data(), ip.size());
+    return socketAddress;
+}
+
+UdpTransport::Address
+UdpTransport::fromSocketAddress(const sockaddr_in& address)
+{
+    std::array<uint8_t, 4> ip;
+    memcpy(ip.data(), &address.sin_addr.s_addr, ip.size());
+    return Address(IpAddress(ip), ntohs(address.sin_port));
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_HAL_UDP_TRANSPORT_H
+#define OUTPOST_HAL_UDP_TRANSPORT_H
+
+#include <outpost/hal/datagram_transport.h>
+#include <outpost/rtos/mutex.h>
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <memory>
+
+namespace outpost
+{
+namespace hal
+{
+/**
+ * UDP implementation of the datagram transport based on POSIX sockets.
+ *
+ * The batched operations sendToMany() and receiveMany() transfer up to
+ * `maximumBatchSize` datagrams with a single call to sendmmsg() or
+ * recvmmsg(). The message descriptors for these calls are allocated when
+ * the object is created, the datagram data is read from and written to the
+ * buffers supplied by the caller. No memory is allocated while sending or
+ * receiving.
+ *
+ * One thread may send while another one receives. Concurrent calls in the
+ * same direction are serialized.
+ */
+class UdpTransport : public DatagramTransport
+{
+public:
+    /// Largest payload of an UDP datagram over IPv4
+    static constexpr size_t maximumDatagramSize = 65507;
+
+    /**
+     * \param address
+     *      Local address the socket is bound to. An IP address of 0.0.0.0
+     *      binds to all interfaces, a port of zero selects a free port
+     *      when connecting.
+     * \param maximumBatchSize
+     *      Maximum number of datagrams handed to the kernel with one
+     *      system call. Larger batches are split.
+     */
+    explicit UdpTransport(const Address& address, size_t maximumBatchSize = 32);
+
+    virtual ~UdpTransport();
+
+    virtual bool
+    connect() override;
+
+    virtual void
+    close() override;
+
+    /**
+     * Return the address of the device.
+     *
+     * After connecting a socket with port zero the port selected by the
+     * operating system is returned.
+     */
+    virtual Address
+    getAddress() const override;
+
+    virtual void
+    setAddress(const Address& newAddress) override;
+
+    virtual bool
+    isAvailable() override;
+
+    virtual size_t
+    getNumberOfBytesAvailable() override;
+
+    virtual size_t
+    getMaximumDatagramSize() const override;
+
+    virtual size_t
+    sendTo(outpost::Slice<const uint8_t> data,
+           const Address& address,
+           outpost::time::Duration timeout = outpost::time::Duration::maximum()) override;
+
+    virtual size_t
+    receiveFrom(outpost::Slice<uint8_t>& data,
+                Address& address,
+                outpost::time::Duration timeout = outpost::time::Duration::maximum()) override;
+
+    virtual size_t
+    sendToMany(outpost::Slice<const Datagram> datagrams,
+               outpost::time::Duration timeout = outpost::time::Duration::maximum()) override;
+
+    virtual size_t
+    receiveMany(outpost::Slice<Datagram> datagrams,
+                outpost::time::Duration timeout = outpost::time::Duration::maximum()) override;
+
+    virtual void
+    clearReceiveBuffer() override;
+
+private:
+    /**
+     * Send the first \p count prepared transmit messages.
+     *
+     * Must be called with the transmit mutex held.
+     *
+     * \return
+     *      Number of messages sent.
+     */
+    size_t
+    sendMessages(size_t count, outpost::time::Duration timeout);
+
+    /**
+     * Prepare a transmit message.
+     */
+    void
+    setTransmitMessage(size_t index, outpost::Slice<const uint8_t> data, const Address& address);
+
+    static sockaddr_in
+    toSocketAddress(const Address& address);
+
+    static Address
+    fromSocketAddress(const sockaddr_in& address);
+
+    Address mAddress;
+    int mSocket;
+    const size_t mMaximumBatchSize;
+
+    outpost::rtos::Mutex mTransmitMutex;
+    std::unique_ptr<mmsghdr[]> mTransmitMessages;
+    std::unique_ptr<iovec[]> mTransmitVectors;
+    std::unique_ptr<sockaddr_in[]> mTransmitAddresses;
+
+    outpost::rtos::Mutex mReceiveMutex;
+    std::unique_ptr<mmsghdr[]> mReceiveMessages;
+    std::unique_ptr<iovec[]> mReceiveVectors;
+    std::unique_ptr<sockaddr_in[]> mReceiveAddresses;
+};
+
+}  // namespace hal
+}  // namespace outpost
+
+#endif
@@ -14,6 +14,56 @@
 
 #include "datagram_transport.h"
 
-outpost::hal::DatagramTransport::~DatagramTransport()
+using outpost::hal::DatagramTransport;
+
+DatagramTransport::~DatagramTransport()
+{
+}
+
+size_t
+DatagramTransport::sendToMany(outpost::Slice<const Datagram> datagrams,
+                              outpost::time::Duration timeout)
+{
+    size_t count = 0;
+    while (count < datagrams.getNumberOfElements())
+    {
+        const Datagram& datagram = datagrams[count];
+        if (sendTo(datagram.getData(), datagram.getAddress(), timeout) != datagram.getLength())
+        {
+            break;
+        }
+
+        count++;
+        timeout = outpost::time::Duration::zero();
+    }
+    return count;
+}
+
+size_t
+DatagramTransport::receiveMany(outpost::Slice<Datagram> datagrams,
+                               outpost::time::Duration timeout)
 {
+    size_t count = 0;
+    while (count < datagrams.getNumberOfElements())
+    {
+        if ((count > 0) && !isAvailable())
+        {
+            break;
+        }
+
+        Datagram& datagram = datagrams[count];
+        outpost::Slice<uint8_t> buffer = datagram.getBuffer();
+        Address address;
+        size_t length = receiveFrom(buffer, address, timeout);
+        if (length == 0)
+        {
+            // Timeout, empty datagrams can not be distinguished from it
+            break;
+        }
+
+        datagram.setLength(length);
+        datagram.setAddress(address);
+        count++;
+    }
+    return count;
 }
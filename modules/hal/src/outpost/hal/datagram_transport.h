@@ -136,6 +136,84 @@ public:
         uint16_t mPort;
     };
 
+    /**
+     * Datagram for the batched operations \ref sendToMany and
+     * \ref receiveMany.
+     *
+     * Refers to a buffer owned by the caller, the datagram itself does not
+     * hold any data. The same datagram objects can therefore be reused for
+     * every batch without allocating memory.
+     */
+    class Datagram
+    {
+    public:
+        Datagram() : mBuffer(outpost::Slice<uint8_t>::empty()), mLength(0), mAddress()
+        {
+        }
+
+        /**
+         * \param buffer
+         *      Buffer holding the datagram data. For receiving the size of
+         *      the buffer limits the length of the received datagram.
+         * \param length
+         *      Number of bytes of the buffer used by the datagram.
+         * \param address
+         *      Remote address the datagram is sent to or received from.
+         */
+        explicit Datagram(outpost::Slice<uint8_t> buffer,
+                          size_t length = 0,
+                          const Address& address = Address()) :
+            mBuffer(buffer),
+            mLength(length),
+            mAddress(address)
+        {
+        }
+
+        inline outpost::Slice<uint8_t>
+        getBuffer() const
+        {
+            return mBuffer;
+        }
+
+        /**
+         * Access the used part of the buffer.
+         */
+        inline outpost::Slice<const uint8_t>
+        getData() const
+        {
+            return outpost::Slice<const uint8_t>(mBuffer).first(mLength);
+        }
+
+        inline size_t
+        getLength() const
+        {
+            return mLength;
+        }
+
+        inline void
+        setLength(size_t length)
+        {
+            mLength = length;
+        }
+
+        inline const Address&
+        getAddress() const
+        {
+            return mAddress;
+        }
+
+        inline void
+        setAddress(const Address& address)
+        {
+            mAddress = address;
+        }
+
+    private:
+        outpost::Slice<uint8_t> mBuffer;
+        size_t mLength;
+        Address mAddress;
+    };
+
     /**
      * Destructor
      */
@@ -242,6 +320,50 @@ public:
                 Address& address,
                 outpost::time::Duration timeout = outpost::time::Duration::maximum()) = 0;
 
+    /**
+     * Send several datagrams.
+     *
+     * Sends the datagrams in the given order, each to the address stored
+     * with it. The default implementation calls \ref sendTo for every
+     * datagram, implementations should override it to hand over the whole
+     * batch at once.
+     *
+     * \param datagrams
+     *      Datagrams to send, the length of each datagram should not exceed
+     *      \ref getMaximumDatagramSize.
+     * \param timeout
+     *      Time to wait for the first datagram to be sent. The remaining
+     *      datagrams are only sent if this is possible without waiting
+     *      further.
+     * \return
+     *      Number of datagrams sent completely. The datagrams following
+     *      the last sent one have not been sent.
+     */
+    virtual size_t
+    sendToMany(outpost::Slice<const Datagram> datagrams,
+               outpost::time::Duration timeout = outpost::time::Duration::maximum());
+
+    /**
+     * Receive several datagrams.
+     *
+     * Waits for the first datagram up to the timeout, afterwards all
+     * datagrams which are already available are received until all given
+     * buffers are filled. The default implementation calls
+     * \ref receiveFrom for every datagram.
+     *
+     * \param datagrams
+     *      Datagrams with the buffers to receive into. On return the length
+     *      and address of the received datagrams are set. Datagrams longer
+     *      than their buffer are truncated.
+     * \param timeout
+     *      Time to wait for the first datagram.
+     * \return
+     *      Number of datagrams received, zero after a timeout.
+     */
+    virtual size_t
+    receiveMany(outpost::Slice<Datagram> datagrams,
+                outpost::time::Duration timeout = outpost::time::Duration::maximum());
+
     /**
      * Drop all datagrams which are currently in the receive buffer
      */
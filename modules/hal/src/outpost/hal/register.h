@@ -18,10 +18,61 @@
 
 #include <stdint.h>
 
+#include <type_traits>
+
 namespace outpost
 {
 namespace hal
 {
+namespace internal
+{
+/**
+ * Common register type and address of a list of register fields.
+ *
+ * Fails to compile if the fields belong to different registers.
+ */
+template <typename... Fields>
+struct RegisterFieldList;
+
+template <typename Field>
+struct RegisterFieldList<Field>
+{
+    typedef typename Field::Type Type;
+    static const uint32_t address = Field::address;
+};
+
+template <typename Field, typename... Others>
+struct RegisterFieldList<Field, Others...>
+{
+    typedef typename Field::Type Type;
+    static const uint32_t address = Field::address;
+
+    static_assert(address == RegisterFieldList<Others...>::address,
+                  "All fields must belong to the same register address!");
+    static_assert(std::is_same<Type, typename RegisterFieldList<Others...>::Type>::value,
+                  "All fields must use the same register type!");
+};
+
+/**
+ * Check if a field is part of a list of register fields.
+ */
+template <typename Field, typename... Fields>
+struct ContainsRegisterField;
+
+template <typename Field>
+struct ContainsRegisterField<Field>
+{
+    static const bool value = false;
+};
+
+template <typename Field, typename First, typename... Others>
+struct ContainsRegisterField<Field, First, Others...>
+{
+    static const bool value =
+            std::is_same<Field, First>::value || ContainsRegisterField<Field, Others...>::value;
+};
+}  // namespace internal
+
 /**
  * Register access.
  *
@@ -119,6 +170,9 @@ public:
     static inline uint32_t
     getMask();
 
+    template <typename... Fields>
+    class Shadow;
+
 private:
     // Disable destructor, copy-constructor and copy assignment operator
     Register();
@@ -131,6 +185,108 @@ private:
     operator=(const Register&);
 };
 
+/**
+ * Local copy of a register for accessing multiple fields at once.
+ *
+ * Every call to Register::write() performs a read-modify-write cycle on
+ * the register. Modifying several fields that way results in several
+ * accesses to the peripheral bus. The shadow instead collects the
+ * modifications in a local value which is then written with a single
+ * access. Reading the register into a shadow allows to evaluate several
+ * fields from a single read access.
+ *
+ * All fields have to belong to the same register, this is checked at
+ * compile-time. Only the listed fields can be accessed. Example:
+ * \code
+ * typedef Register::Shadow<General::Prescaler, General::Enable> Control;
+ *
+ * // One read and one write access
+ * Control::read().set<General::Prescaler>(100).set<General::Enable>(1).write();
+ *
+ * // Single write access, all other bits are set to zero
+ * Control().set<General::Prescaler>(100).set<General::Enable>(1).write();
+ *
+ * // Single read access
+ * Control control = Control::read();
+ * uint32_t prescaler = control.get<General::Prescaler>();
+ * bool enabled = control.get<General::Enable>();
+ * \endcode
+ *
+ * \tparam Fields
+ *      List of Register::Bitfield or Register::SingleBit descriptors.
+ */
+template <typename... Fields>
+class Register::Shadow
+{
+public:
+    typedef typename internal::RegisterFieldList<Fields...>::Type Type;
+    static const uint32_t address = internal::RegisterFieldList<Fields...>::address;
+
+    /**
+     * Create a shadow with all bits set to zero.
+     */
+    inline Shadow() : mValue(0)
+    {
+    }
+
+    inline explicit Shadow(Type value) : mValue(value)
+    {
+    }
+
+    /**
+     * Create a shadow from the current register content.
+     *
+     * Performs a single read access.
+     */
+    static inline Shadow
+    read();
+
+    static inline Shadow
+    readFromMemory(const Type& memory);
+
+    /**
+     * Write the shadow value to the register.
+     *
+     * Performs a single write access. The complete register is written,
+     * bits outside of the listed fields keep the value they had when
+     * the shadow was created.
+     */
+    inline void
+    write() const;
+
+    inline void
+    writeToMemory(Type& memory) const;
+
+    /**
+     * Modify a field in the shadow value.
+     *
+     * \return Reference to the shadow to allow chaining.
+     */
+    template <typename Field>
+    inline Shadow&
+    set(uint32_t value);
+
+    /**
+     * Read a field from the shadow value.
+     */
+    template <typename Field>
+    inline uint32_t
+    get() const;
+
+    inline Type
+    getValue() const
+    {
+        return mValue;
+    }
+
+private:
+    template <typename Field>
+    static inline void
+    checkField();
+
+    Type mValue;
+};
+
 }  // namespace hal
 }  // namespace outpost
 
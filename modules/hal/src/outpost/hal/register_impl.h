@@ -117,4 +117,64 @@ outpost::hal::Register::getMask()
     return mask;
 }
 
+// ----------------------------------------------------------------------------
+template <typename... Fields>
+const uint32_t outpost::hal::Register::Shadow<Fields...>::address;
+
+template <typename... Fields>
+outpost::hal::Register::Shadow<Fields...>
+outpost::hal::Register::Shadow<Fields...>::read()
+{
+    return Shadow(access<Type>(address));
+}
+
+template <typename... Fields>
+outpost::hal::Register::Shadow<Fields...>
+outpost::hal::Register::Shadow<Fields...>::readFromMemory(const Type& memory)
+{
+    return Shadow(memory);
+}
+
+template <typename... Fields>
+void
+outpost::hal::Register::Shadow<Fields...>::write() const
+{
+    access<Type>(address) = mValue;
+}
+
+template <typename... Fields>
+void
+outpost::hal::Register::Shadow<Fields...>::writeToMemory(Type& memory) const
+{
+    memory = mValue;
+}
+
+template <typename... Fields>
+template <typename Field>
+outpost::hal::Register::Shadow<Fields...>&
+outpost::hal::Register::Shadow<Fields...>::set(uint32_t value)
+{
+    checkField<Field>();
+    outpost::BitAccess::set<Type, Field::start, Field::end>(mValue, static_cast<Type>(value));
+    return *this;
+}
+
+template <typename... Fields>
+template <typename Field>
+uint32_t
+outpost::hal::Register::Shadow<Fields...>::get() const
+{
+    checkField<Field>();
+    return outpost::BitAccess::get<Type, Field::start, Field::end>(mValue);
+}
+
+template <typename... Fields>
+template <typename Field>
+void
+outpost::hal::Register::Shadow<Fields...>::checkField()
+{
+    static_assert(internal::ContainsRegisterField<Field, Fields...>::value,
+                  "Field is not part of the register shadow!");
+}
+
 #endif
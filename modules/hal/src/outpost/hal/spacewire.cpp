@@ -13,6 +13,139 @@
 
 #include "spacewire.h"
 
+#include <outpost/utils/container/shared_object_pool.h>
+
+#include <string.h>
+
+constexpr size_t outpost::hal::SpaceWire::TransmitDescriptor::maxSegments;
+
+outpost::hal::SpaceWire::SpaceWire() : mReceiveBufferPool(nullptr)
+{
+}
+
 outpost::hal::SpaceWire::~SpaceWire()
 {
 }
+
+outpost::hal::SpaceWire::Result::Type
+outpost::hal::SpaceWire::sendSegments(const TransmitDescriptor& packet,
+                                      outpost::time::Duration timeout)
+{
+    if (packet.getLength() > getMaximumPacketLength())
+    {
+        return Result::failure;
+    }
+
+    TransmitBuffer* buffer = nullptr;
+    Result::Type result = requestBuffer(buffer, timeout);
+    if (result != Result::success)
+    {
+        return result;
+    }
+
+    uint8_t* destination = buffer->getData().begin();
+    for (size_t i = 0; i < packet.getNumberOfSegments(); ++i)
+    {
+        outpost::Slice<const uint8_t> segment = packet.getSegment(i);
+        if (segment.getNumberOfElements() > 0)
+        {
+            memcpy(destination, segment.begin(), segment.getNumberOfElements());
+            destination += segment.getNumberOfElements();
+        }
+    }
+    buffer->setLength(packet.getLength());
+    buffer->setEndMarker(packet.getEndMarker());
+
+    return send(buffer, timeout);
+}
+
+size_t
+outpost::hal::SpaceWire::requestBuffers(outpost::Slice<TransmitBuffer*> buffers,
+                                        outpost::time::Duration timeout)
+{
+    size_t count = 0;
+    while ((count < buffers.getNumberOfElements())
+           && (requestBuffer(buffers[count], timeout) == Result::success))
+    {
+        count++;
+        timeout = outpost::time::Duration::zero();
+    }
+    return count;
+}
+
+size_t
+outpost::hal::SpaceWire::sendBuffers(outpost::Slice<TransmitBuffer* const> buffers,
+                                     outpost::time::Duration timeout)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < buffers.getNumberOfElements(); ++i)
+    {
+        if (send(buffers[i], timeout) == Result::success)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t
+outpost::hal::SpaceWire::receiveBuffers(outpost::Slice<ReceiveBuffer> buffers,
+                                        outpost::time::Duration timeout)
+{
+    size_t count = 0;
+    while ((count < buffers.getNumberOfElements())
+           && (receive(buffers[count], timeout) == Result::success))
+    {
+        count++;
+        timeout = outpost::time::Duration::zero();
+    }
+    return count;
+}
+
+void
+outpost::hal::SpaceWire::releaseBuffers(outpost::Slice<const ReceiveBuffer> buffers)
+{
+    for (size_t i = 0; i < buffers.getNumberOfElements(); ++i)
+    {
+        releaseBuffer(buffers[i]);
+    }
+}
+
+void
+outpost::hal::SpaceWire::setReceiveBufferPool(outpost::utils::SharedBufferPoolBase& pool)
+{
+    mReceiveBufferPool = &pool;
+}
+
+outpost::hal::SpaceWire::Result::Type
+outpost::hal::SpaceWire::receiveShared(outpost::utils::SharedChildPointer& packet,
+                                       EndMarker& end,
+                                       outpost::time::Duration timeout)
+{
+    if (mReceiveBufferPool == nullptr)
+    {
+        return Result::failure;
+    }
+
+    ReceiveBuffer rxBuffer;
+    Result::Type result = receive(rxBuffer, timeout);
+    if (result != Result::success)
+    {
+        return result;
+    }
+
+    outpost::utils::SharedBufferPointer buffer;
+    if (mReceiveBufferPool->allocate(buffer)
+        && buffer.getChild(packet, 0, 0, rxBuffer.getLength()))
+    {
+        memcpy(packet.asSlice().begin(), rxBuffer.getData().begin(), rxBuffer.getLength());
+        end = rxBuffer.getEndMarker();
+    }
+    else
+    {
+        result = Result::failure;
+    }
+
+    releaseBuffer(rxBuffer);
+    return result;
+}
@@ -24,6 +24,12 @@
 
 namespace outpost
 {
+namespace utils
+{
+class SharedBufferPoolBase;
+class SharedChildPointer;
+}  // namespace utils
+
 namespace hal
 {
 /**
@@ -191,6 +197,111 @@ public:
         EndMarker mEnd;
     };
 
+    /**
+     * Send descriptor for a packet made of several memory segments.
+     *
+     * Allows to transmit a packet whose parts are located in different
+     * buffers, e.g. a protocol header in a small local buffer followed by
+     * the payload in the memory of the caller, without copying them into
+     * one contiguous buffer first. Drivers with DMA support can hand the
+     * segments directly to the hardware as a gather list.
+     *
+     * The descriptor only references the segments, the referenced memory
+     * must stay valid until the packet has been sent.
+     */
+    class TransmitDescriptor
+    {
+    public:
+        /// Maximum number of segments of one packet
+        static constexpr size_t maxSegments = 4;
+
+        inline TransmitDescriptor() :
+            mSegmentData(),
+            mSegmentLength(),
+            mNumberOfSegments(0),
+            mLength(0),
+            mEnd(eop)
+        {
+        }
+
+        /**
+         * Append a segment to the packet.
+         *
+         * \retval true     Segment added.
+         * \retval false    Maximum number of segments reached.
+         */
+        inline bool
+        addSegment(outpost::Slice<const uint8_t> segment)
+        {
+            if (mNumberOfSegments >= maxSegments)
+            {
+                return false;
+            }
+            mSegmentData[mNumberOfSegments] = segment.begin();
+            mSegmentLength[mNumberOfSegments] = segment.getNumberOfElements();
+            mNumberOfSegments++;
+            mLength += segment.getNumberOfElements();
+            return true;
+        }
+
+        inline void
+        clear()
+        {
+            mNumberOfSegments = 0;
+            mLength = 0;
+            mEnd = eop;
+        }
+
+        inline size_t
+        getNumberOfSegments() const
+        {
+            return mNumberOfSegments;
+        }
+
+        /**
+         * Access a segment.
+         *
+         * \warning
+         *      No out-of-bound error checking is performed.
+         */
+        inline outpost::Slice<const uint8_t>
+        getSegment(size_t index) const
+        {
+            return outpost::Slice<const uint8_t>::unsafe(mSegmentData[index],
+                                                         mSegmentLength[index]);
+        }
+
+        /**
+         * Get the total length of all segments.
+         */
+        inline size_t
+        getLength() const
+        {
+            return mLength;
+        }
+
+        inline EndMarker
+        getEndMarker() const
+        {
+            return mEnd;
+        }
+
+        inline void
+        setEndMarker(EndMarker end)
+        {
+            mEnd = end;
+        }
+
+    private:
+        const uint8_t* mSegmentData[maxSegments];
+        size_t mSegmentLength[maxSegments];
+        size_t mNumberOfSegments;
+        size_t mLength;
+        EndMarker mEnd;
+    };
+
+    SpaceWire();
+
     virtual ~SpaceWire();
 
     /**
@@ -250,6 +361,23 @@ public:
     virtual Result::Type
     send(TransmitBuffer* buffer, outpost::time::Duration timeout) = 0;
 
+    /**
+     * Send a packet made of several segments.
+     *
+     * Drivers able to transmit from a gather list should override this
+     * function. The default implementation requests a send buffer, copies
+     * the segments into it and sends the buffer.
+     *
+     * \param[in]   packet
+     *      Segments of the packet. The segments are not accessed after the
+     *      function has returned.
+     * \param[in]   timeout
+     *      Time to wait for a free transmit buffer and again for the
+     *      packet to be sent.
+     */
+    virtual Result::Type
+    sendSegments(const TransmitDescriptor& packet, outpost::time::Duration timeout);
+
     /**
      * Receive data.
      *
@@ -271,11 +399,128 @@ public:
     virtual void
     releaseBuffer(const ReceiveBuffer& buffer) = 0;
 
+    /**
+     * Request several send buffers at once.
+     *
+     * Only waits for the first buffer, the following buffers are only
+     * provided if they are available immediately. Drivers with a
+     * descriptor ring may override this to reserve the buffers in one
+     * step, the default implementation calls requestBuffer() for each
+     * buffer.
+     *
+     * \param[out]  buffers
+     *      Filled with pointers to the send buffers.
+     * \param[in]   timeout
+     *      Time to wait for the first free transmit buffer.
+     *
+     * \return
+     *      Number of provided buffers, stored at the beginning of
+     *      \p buffers.
+     */
+    virtual size_t
+    requestBuffers(outpost::Slice<TransmitBuffer*> buffers, outpost::time::Duration timeout);
+
+    /**
+     * Send several configured buffers.
+     *
+     * All buffers are released, independent of the result. The default
+     * implementation calls send() for each buffer.
+     *
+     * \param[in]   buffers
+     *      Send buffers previously requested via requestBuffer() or
+     *      requestBuffers().
+     * \param[in]   timeout
+     *      Time to wait for each SpaceWire message to be sent.
+     *
+     * \return
+     *      Number of successfully sent buffers.
+     */
+    virtual size_t
+    sendBuffers(outpost::Slice<TransmitBuffer* const> buffers, outpost::time::Duration timeout);
+
+    /**
+     * Receive several packets.
+     *
+     * Only waits for the first packet, afterwards all packets already
+     * received are returned up to the size of \p buffers. The default
+     * implementation calls receive() for each packet.
+     *
+     * \param[out]  buffers
+     *      Receive buffers.
+     * \param[in]   timeout
+     *      Time to wait for the first SpaceWire message to arrive.
+     *
+     * \return
+     *      Number of received packets, stored at the beginning of
+     *      \p buffers.
+     */
+    virtual size_t
+    receiveBuffers(outpost::Slice<ReceiveBuffer> buffers, outpost::time::Duration timeout);
+
+    /**
+     * Release several receive buffers.
+     *
+     * The default implementation calls releaseBuffer() for each buffer.
+     */
+    virtual void
+    releaseBuffers(outpost::Slice<const ReceiveBuffer> buffers);
+
     /**
      * Discard all messages currently waiting in the receive buffers.
      */
     virtual void
     flushReceiveBuffer() = 0;
+
+    /**
+     * Set the pool providing the buffers for receiveShared().
+     *
+     * Drivers receiving directly into shared buffers, e.g. by refilling
+     * their DMA descriptors from the pool, may override this function to
+     * set up the receive ring. Must be called before the first call to
+     * receiveShared().
+     */
+    virtual void
+    setReceiveBufferPool(outpost::utils::SharedBufferPoolBase& pool);
+
+    /**
+     * Receive a packet into a shared buffer.
+     *
+     * In contrast to receive() the packet is owned by the caller and does
+     * not have to be released. The buffer is returned to the receive
+     * buffer pool when the last reference to it is destroyed. This allows
+     * packets to be queued or handed over to other threads without
+     * copying them.
+     *
+     * The default implementation receives the packet via receive(), copies
+     * it into a buffer from the pool and releases the receive buffer.
+     *
+     * \param[out] packet
+     *      Covers exactly the received data.
+     * \param[out] end
+     *      End marker of the packet.
+     * \param[in]  timeout
+     *      Time to wait for a SpaceWire message to arrive.
+     *
+     * \retval success     Packet received.
+     * \retval timeout     No packet received within the timeout.
+     * \retval failure     Link down, no pool set, no free pool buffer, or the
+     *                      packet is empty or larger than a pool buffer.
+     *                      The packet is discarded in the last three cases.
+     */
+    virtual Result::Type
+    receiveShared(outpost::utils::SharedChildPointer& packet,
+                  EndMarker& end,
+                  outpost::time::Duration timeout);
+
+protected:
+    inline outpost::utils::SharedBufferPoolBase*
+    getReceiveBufferPool() const
+    {
+        return mReceiveBufferPool;
+    }
+
+private:
+    outpost::utils::SharedBufferPoolBase* mReceiveBufferPool;
 };
 
 }  // namespace hal
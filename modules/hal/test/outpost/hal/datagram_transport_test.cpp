@@ -15,9 +15,146 @@
 
 #include <unittest/harness.h>
 
+#include <algorithm>
+#include <deque>
+#include <vector>
+
 using outpost::hal::DatagramTransport;
 
 TEST(DatagramTransportTest, shouldAllowToComposeAddressConstants)
 {
     constexpr DatagramTransport::Address address(DatagramTransport::IpAddress(127, 0, 0, 1), 8080);
 }
+
+namespace
+{
+class DatagramTransportFake : public DatagramTransport
+{
+public:
+    DatagramTransportFake() : mReceived(), mSent(), mMaximumNumberOfSentDatagrams(100)
+    {
+    }
+
+    virtual bool
+    connect() override
+    {
+        return true;
+    }
+
+    virtual void
+    close() override
+    {
+    }
+
+    virtual Address
+    getAddress() const override
+    {
+        return Address();
+    }
+
+    virtual void
+    setAddress(const Address& /*newAddress*/) override
+    {
+    }
+
+    virtual bool
+    isAvailable() override
+    {
+        return !mReceived.empty();
+    }
+
+    virtual size_t
+    getNumberOfBytesAvailable() override
+    {
+        return mReceived.empty() ? 0 : mReceived.front().size();
+    }
+
+    virtual size_t
+    getMaximumDatagramSize() const override
+    {
+        return 100;
+    }
+
+    virtual size_t
+    sendTo(outpost::Slice<const uint8_t> data,
+           const Address& /*address*/,
+           outpost::time::Duration /*timeout*/) override
+    {
+        if (mSent.size() >= mMaximumNumberOfSentDatagrams)
+        {
+            return 0;
+        }
+        mSent.emplace_back(data.begin(), data.end());
+        return data.getNumberOfElements();
+    }
+
+    virtual size_t
+    receiveFrom(outpost::Slice<uint8_t>& data,
+                Address& address,
+                outpost::time::Duration /*timeout*/) override
+    {
+        if (mReceived.empty())
+        {
+            return 0;
+        }
+        size_t length = std::min(mReceived.front().size(), data.getNumberOfElements());
+        std::copy(mReceived.front().begin(), mReceived.front().begin() + length, data.begin());
+        mReceived.pop_front();
+        address = Address(IpAddress(10, 0, 0, 1), 1234);
+        return length;
+    }
+
+    virtual void
+    clearReceiveBuffer() override
+    {
+        mReceived.clear();
+    }
+
+    std::deque<std::vector<uint8_t>> mReceived;
+    std::vector<std::vector<uint8_t>> mSent;
+    size_t mMaximumNumberOfSentDatagrams;
+};
+}  // namespace
+
+TEST(DatagramTransportTest, shouldSendBatchDatagramByDatagram)
+{
+    DatagramTransportFake transport;
+    transport.mMaximumNumberOfSentDatagrams = 2;
+
+    uint8_t data[3] = {1, 2, 3};
+    DatagramTransport::Datagram datagrams[3] = {
+            DatagramTransport::Datagram(outpost::asSlice(data), 1),
+            DatagramTransport::Datagram(outpost::asSlice(data), 3),
+            DatagramTransport::Datagram(outpost::asSlice(data), 2)};
+
+    EXPECT_EQ(2U, transport.sendToMany(outpost::asSlice(datagrams)));
+    ASSERT_EQ(2U, transport.mSent.size());
+    EXPECT_EQ(std::vector<uint8_t>({1}), transport.mSent[0]);
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), transport.mSent[1]);
+}
+
+TEST(DatagramTransportTest, shouldReceiveAvailableDatagramsIntoBatch)
+{
+    DatagramTransportFake transport;
+    transport.mReceived.push_back({1, 2});
+    transport.mReceived.push_back({3, 4, 5});
+
+    uint8_t first[4];
+    uint8_t second[2];
+    uint8_t third[4];
+    DatagramTransport::Datagram datagrams[3] = {
+            DatagramTransport::Datagram(outpost::asSlice(first)),
+            DatagramTransport::Datagram(outpost::asSlice(second)),
+            DatagramTransport::Datagram(outpost::asSlice(third))};
+
+    ASSERT_EQ(2U, transport.receiveMany(outpost::asSlice(datagrams)));
+    EXPECT_EQ(2U, datagrams[0].getLength());
+    EXPECT_EQ(2, datagrams[0].getData()[1]);
+    EXPECT_EQ(1234, datagrams[0].getAddress().getPort());
+
+    // Truncated to the length of the buffer
+    EXPECT_EQ(2U, datagrams[1].getLength());
+    EXPECT_EQ(4, datagrams[1].getData()[1]);
+
+    EXPECT_EQ(0U, transport.receiveMany(outpost::asSlice(datagrams)));
+}
@@ -15,6 +15,8 @@
 
 #include <unittest/harness.h>
 
+#include <type_traits>
+
 struct TestRegister
 {
     static const uint32_t baseAddress = 0xE0000000;
@@ -70,6 +72,19 @@ TEST(RegisterTest, shouldCompile)
 
         // Read complete value to memory and extract needed bits
         value = Register::read<TestRegister::General::All>();
+
+        // Modify multiple fields with a single read and a single write
+        typedef Register::Shadow<TestRegister::General::Prescaler, TestRegister::General::Enable>
+                Control;
+        Control::read()
+                .set<TestRegister::General::Prescaler>(100)
+                .set<TestRegister::General::Enable>(1)
+                .write();
+
+        // Read multiple fields with a single read
+        Control control = Control::read();
+        value = control.get<TestRegister::General::Prescaler>()
+                + control.get<TestRegister::General::Enable>();
     }
 }
 
@@ -94,3 +109,84 @@ TEST(RegisterTest, shouldCastToPointer)
             TestRegister::General::address + 4 * sizeof(uint32_t));
     EXPECT_EQ(expected, output);
 }
+
+// ----------------------------------------------------------------------------
+typedef Register::Shadow<TestRegister::General::Prescaler,
+                         TestRegister::General::Polarity,
+                         TestRegister::General::Enable,
+                         TestRegister::General::DecoderEnable>
+        GeneralShadow;
+
+static_assert(GeneralShadow::address == TestRegister::General::address,
+              "Shadow must use the address of its fields");
+static_assert(std::is_same<GeneralShadow::Type, uint32_t>::value,
+              "Shadow must use the type of its fields");
+
+TEST(RegisterShadowTest, shouldStartWithZero)
+{
+    GeneralShadow shadow;
+    EXPECT_EQ(0U, shadow.getValue());
+}
+
+TEST(RegisterShadowTest, shouldCollectFieldsBeforeWriting)
+{
+    uint32_t memory = 0xFFFFFFFF;
+
+    GeneralShadow()
+            .set<TestRegister::General::Prescaler>(100)
+            .set<TestRegister::General::Enable>(1)
+            .set<TestRegister::General::DecoderEnable>(1)
+            .writeToMemory(memory);
+
+    // Bits outside of the fields are overwritten with zero
+    EXPECT_EQ(0x64010001U, memory);
+}
+
+TEST(RegisterShadowTest, shouldKeepOtherBitsWhenStartingFromRegisterContent)
+{
+    uint32_t memory = 0x00000016;
+
+    GeneralShadow::readFromMemory(memory)
+            .set<TestRegister::General::Prescaler>(0xAB)
+            .set<TestRegister::General::Polarity>(1)
+            .writeToMemory(memory);
+    EXPECT_EQ(0xAB800016U, memory);
+
+    GeneralShadow::readFromMemory(memory)
+            .set<TestRegister::General::Prescaler>(0x1FF)
+            .set<TestRegister::General::Polarity>(0)
+            .writeToMemory(memory);
+
+    // Values are truncated to the width of the field
+    EXPECT_EQ(0xFF000016U, memory);
+}
+
+TEST(RegisterShadowTest, shouldReadFieldsFromSnapshot)
+{
+    uint32_t memory = 0x64810011;
+    GeneralShadow shadow = GeneralShadow::readFromMemory(memory);
+
+    // Later changes of the register are not visible in the snapshot
+    memory = 0;
+
+    EXPECT_EQ(100U, shadow.get<TestRegister::General::Prescaler>());
+    EXPECT_EQ(1U, shadow.get<TestRegister::General::Polarity>());
+    EXPECT_EQ(1U, shadow.get<TestRegister::General::Enable>());
+    EXPECT_EQ(1U, shadow.get<TestRegister::General::DecoderEnable>());
+    EXPECT_EQ(0x64810011U, shadow.getValue());
+}
+
+TEST(RegisterShadowTest, shouldMatchSingleFieldAccess)
+{
+    uint32_t expected = 0x12345678;
+    uint32_t memory = expected;
+
+    Register::writeToMemory<TestRegister::General::Prescaler>(0x42, expected);
+    Register::writeToMemory<TestRegister::General::Enable>(0, expected);
+
+    GeneralShadow::readFromMemory(memory)
+            .set<TestRegister::General::Prescaler>(0x42)
+            .set<TestRegister::General::Enable>(0)
+            .writeToMemory(memory);
+    EXPECT_EQ(expected, memory);
+}
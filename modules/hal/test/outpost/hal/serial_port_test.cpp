@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/hal/serial_port.h>
+
+#include <unittest/harness.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using outpost::hal::SerialPort;
+
+namespace
+{
+const outpost::time::Duration timeout = outpost::time::Seconds(1);
+}  // namespace
+
+/**
+ * Connects the serial port to the slave side of a pseudo terminal, the
+ * test accesses the master side directly.
+ */
+class SerialPortTest : public testing::Test
+{
+public:
+    SerialPortTest() : mMaster(-1), mSerial(16)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        mMaster = posix_openpt(O_RDWR | O_NOCTTY);
+        ASSERT_LE(0, mMaster);
+        ASSERT_EQ(0, grantpt(mMaster));
+        ASSERT_EQ(0, unlockpt(mMaster));
+        ASSERT_TRUE(mSerial.open(ptsname(mMaster), 115200));
+    }
+
+    virtual void
+    TearDown() override
+    {
+        mSerial.close();
+        if (mMaster >= 0)
+        {
+            close(mMaster);
+        }
+    }
+
+    void
+    writeMaster(std::vector<uint8_t> data)
+    {
+        ASSERT_EQ(static_cast<ssize_t>(data.size()), ::write(mMaster, data.data(), data.size()));
+    }
+
+    std::vector<uint8_t>
+    readMaster(size_t length)
+    {
+        std::vector<uint8_t> data;
+        while (data.size() < length)
+        {
+            pollfd descriptor = {mMaster, POLLIN, 0};
+            if (poll(&descriptor, 1, 1000) <= 0)
+            {
+                break;
+            }
+
+            uint8_t buffer[64];
+            ssize_t result = ::read(mMaster, buffer, sizeof(buffer));
+            if (result <= 0)
+            {
+                break;
+            }
+            data.insert(data.end(), buffer, buffer + result);
+        }
+        return data;
+    }
+
+    /**
+     * Wait until the receive thread has fetched the expected number of
+     * bytes, the pseudo terminal may deliver them in several chunks.
+     */
+    size_t
+    waitForAvailable(size_t expected)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        size_t available = mSerial.getNumberOfBytesAvailable();
+        while (available < expected && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            available = mSerial.getNumberOfBytesAvailable();
+        }
+        return available;
+    }
+
+    int mMaster;
+    SerialPort mSerial;
+};
+
+// ----------------------------------------------------------------------------
+TEST(SerialPortOpenTest, shouldFailForMissingDeviceOrUnsupportedBaudrate)
+{
+    SerialPort serial;
+    EXPECT_FALSE(serial.open("/dev/outpost-does-not-exist", 115200));
+    EXPECT_FALSE(serial.open("/dev/null", 12345));
+}
+
+TEST_F(SerialPortTest, shouldReadReceivedBytesInOneBlock)
+{
+    EXPECT_FALSE(mSerial.isAvailable());
+
+    writeMaster({1, 2, 3, 4, 5});
+
+    uint8_t buffer[5];
+    ASSERT_EQ(5U, mSerial.read(outpost::asSlice(buffer), timeout));
+    EXPECT_EQ(1, buffer[0]);
+    EXPECT_EQ(5, buffer[4]);
+    EXPECT_EQ(0U, mSerial.getNumberOfBytesAvailable());
+}
+
+TEST_F(SerialPortTest, shouldReturnAvailableBytesAfterTimeout)
+{
+    writeMaster({1, 2});
+
+    uint8_t buffer[8];
+    EXPECT_EQ(2U, mSerial.read(outpost::asSlice(buffer), outpost::time::Milliseconds(50)));
+    EXPECT_EQ(0U, mSerial.read(outpost::asSlice(buffer), outpost::time::Duration::zero()));
+}
+
+TEST_F(SerialPortTest, shouldCountAvailableBytes)
+{
+    writeMaster({4, 5, 6});
+    uint8_t first[1];
+    ASSERT_EQ(1U, mSerial.read(outpost::asSlice(first), timeout));
+    EXPECT_EQ(4, first[0]);
+
+    EXPECT_EQ(2U, waitForAvailable(2));
+    EXPECT_TRUE(mSerial.isAvailable());
+}
+
+TEST_F(SerialPortTest, shouldContinueReceivingAfterRingBufferWasFull)
+{
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < 40; ++i)
+    {
+        data.push_back(static_cast<uint8_t>(i));
+    }
+    writeMaster(data);
+
+    std::vector<uint8_t> received;
+    while (received.size() < data.size())
+    {
+        uint8_t buffer[16];
+        size_t length = mSerial.read(outpost::asSlice(buffer), outpost::time::Milliseconds(200));
+        ASSERT_LT(0U, length);
+        received.insert(received.end(), buffer, buffer + length);
+    }
+    EXPECT_EQ(data, received);
+}
+
+TEST_F(SerialPortTest, shouldTransmitWrittenBytes)
+{
+    std::vector<uint8_t> data;
+    for (uint8_t i = 0; i < 50; ++i)
+    {
+        // Many small writes, larger than the transmit buffer in total
+        EXPECT_EQ(1U, mSerial.write(outpost::Slice<const uint8_t>::unsafe(&i, 1), timeout));
+        data.push_back(i);
+    }
+    mSerial.flushTransmitter();
+
+    EXPECT_EQ(data, readMaster(data.size()));
+}
+
+TEST_F(SerialPortTest, shouldDiscardReceivedBytesOnFlush)
+{
+    writeMaster({1, 2, 3});
+
+    uint8_t buffer[3];
+    ASSERT_EQ(1U, mSerial.read(outpost::asSlice(buffer).first(1), timeout));
+    mSerial.flushReceiver();
+
+    EXPECT_EQ(0U, mSerial.getNumberOfBytesAvailable());
+    EXPECT_EQ(0U, mSerial.read(outpost::asSlice(buffer), outpost::time::Milliseconds(20)));
+
+    writeMaster({4});
+    ASSERT_EQ(1U, mSerial.read(outpost::asSlice(buffer).first(1), timeout));
+    EXPECT_EQ(4, buffer[0]);
+}
+
+TEST_F(SerialPortTest, shouldStopWaitingAfterClose)
+{
+    mSerial.close();
+
+    uint8_t buffer[4];
+    EXPECT_EQ(0U, mSerial.read(outpost::asSlice(buffer)));
+    EXPECT_EQ(0U, mSerial.write(outpost::asSlice(buffer)));
+}
+
+TEST_F(SerialPortTest, shouldTransferAfterReopen)
+{
+    mSerial.close();
+    ASSERT_TRUE(mSerial.open(ptsname(mMaster), 115200));
+
+    writeMaster({7, 8});
+    uint8_t buffer[2];
+    ASSERT_EQ(2U, mSerial.read(outpost::asSlice(buffer), timeout));
+    EXPECT_EQ(7, buffer[0]);
+    EXPECT_EQ(8, buffer[1]);
+
+    EXPECT_EQ(2U, mSerial.write(outpost::asSlice(buffer), timeout));
+    mSerial.flushTransmitter();
+    EXPECT_EQ(std::vector<uint8_t>({7, 8}), readMaster(2));
+}
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <unittest/hal/spacewire_emulator.h>
+#include <unittest/harness.h>
+
+#include <chrono>
+
+using outpost::hal::SpaceWire;
+using unittest::hal::SpaceWireEmulator;
+using unittest::hal::SpaceWireEmulatorPort;
+using unittest::hal::SpaceWireRouterEmulator;
+
+namespace
+{
+SpaceWire::Result::Type
+sendPacket(SpaceWire& spw,
+           std::vector<uint8_t> data,
+           SpaceWire::EndMarker end = SpaceWire::eop,
+           outpost::time::Duration timeout = outpost::time::Duration::zero())
+{
+    SpaceWire::TransmitBuffer* buffer = nullptr;
+    SpaceWire::Result::Type result = spw.requestBuffer(buffer, timeout);
+    if (result == SpaceWire::Result::success)
+    {
+        std::copy(data.begin(), data.end(), buffer->getData().begin());
+        buffer->setLength(data.size());
+        buffer->setEndMarker(end);
+        result = spw.send(buffer, timeout);
+    }
+    return result;
+}
+
+std::vector<uint8_t>
+receivePacket(SpaceWire& spw,
+              SpaceWire::EndMarker& end,
+              outpost::time::Duration timeout = outpost::time::Duration::zero())
+{
+    std::vector<uint8_t> data;
+    SpaceWire::ReceiveBuffer buffer;
+    end = SpaceWire::unknown;
+    if (spw.receive(buffer, timeout) == SpaceWire::Result::success)
+    {
+        data.assign(buffer.getData().begin(), buffer.getData().end());
+        end = buffer.getEndMarker();
+        spw.releaseBuffer(buffer);
+    }
+    return data;
+}
+}  // namespace
+
+class SpaceWireEmulatorTest : public testing::Test
+{
+public:
+    SpaceWireEmulatorTest() : mFirst(), mSecond()
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        SpaceWireEmulatorPort::connect(mFirst, mSecond);
+        mFirst.open();
+        mSecond.open();
+        mFirst.up(outpost::time::Duration::zero());
+        mSecond.up(outpost::time::Duration::zero());
+    }
+
+    SpaceWireEmulator mFirst;
+    SpaceWireEmulator mSecond;
+};
+
+// ----------------------------------------------------------------------------
+TEST(SpaceWireEmulatorConnectionTest, shouldBringLinkUpAfterBothEndsAreStarted)
+{
+    SpaceWireEmulator first;
+    SpaceWireEmulator second;
+    SpaceWireEmulatorPort::connect(first, second);
+
+    EXPECT_TRUE(first.open());
+    EXPECT_TRUE(second.open());
+    EXPECT_FALSE(first.up(outpost::time::Duration::zero()));
+    EXPECT_FALSE(first.isUp());
+
+    EXPECT_TRUE(second.up(outpost::time::Duration::zero()));
+    EXPECT_TRUE(first.isUp());
+    EXPECT_TRUE(second.isUp());
+}
+
+TEST(SpaceWireEmulatorConnectionTest, shouldNotStartUnconnectedLink)
+{
+    SpaceWireEmulator spw;
+    spw.open();
+
+    EXPECT_FALSE(spw.up(outpost::time::Duration::zero()));
+    EXPECT_EQ(SpaceWire::Result::failure, sendPacket(spw, {1, 2, 3}));
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldTransferPacketsInBothDirections)
+{
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1, 2, 3}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mSecond, {4, 5}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::eop, end);
+    EXPECT_EQ(std::vector<uint8_t>({4, 5}), receivePacket(mFirst, end));
+
+    SpaceWire::ReceiveBuffer buffer;
+    EXPECT_EQ(SpaceWire::Result::timeout,
+              mFirst.receive(buffer, outpost::time::Duration::zero()));
+
+    EXPECT_EQ(1U, mFirst.getStatistics().mSentPackets);
+    EXPECT_EQ(3U, mFirst.getStatistics().mSentBytes);
+    EXPECT_EQ(1U, mFirst.getStatistics().mReceivedPackets);
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldCombinePartialPackets)
+{
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1, 2}, SpaceWire::partial));
+    EXPECT_EQ(0U, mSecond.getNumberOfPendingPackets());
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {3}, SpaceWire::eop));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), receivePacket(mSecond, end));
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldBlockSenderWithoutFreeReceiveBuffers)
+{
+    SpaceWireEmulator::Configuration configuration;
+    configuration.numberOfReceiveBuffers = 1;
+    SpaceWireEmulator receiver(configuration);
+    SpaceWireEmulatorPort::connect(mFirst, receiver);
+    receiver.open();
+    receiver.up(outpost::time::Duration::zero());
+
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1}));
+    EXPECT_EQ(SpaceWire::Result::timeout, sendPacket(mFirst, {2}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1}), receivePacket(receiver, end));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {3}));
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldLimitNumberOfTransmitBuffers)
+{
+    SpaceWire::TransmitBuffer* buffers[5];
+    for (size_t i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(SpaceWire::Result::success,
+                  mFirst.requestBuffer(buffers[i], outpost::time::Duration::zero()));
+    }
+    EXPECT_EQ(SpaceWire::Result::timeout,
+              mFirst.requestBuffer(buffers[4], outpost::time::Duration::zero()));
+
+    buffers[0]->setLength(0);
+    EXPECT_EQ(SpaceWire::Result::success,
+              mFirst.send(buffers[0], outpost::time::Duration::zero()));
+    EXPECT_EQ(SpaceWire::Result::success,
+              mFirst.requestBuffer(buffers[4], outpost::time::Duration::zero()));
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldReceiveArrivedPacketsAsBatch)
+{
+    SpaceWire::TransmitBuffer* transmitBuffers[3] = {};
+    ASSERT_EQ(3U,
+              mFirst.requestBuffers(outpost::asSlice(transmitBuffers),
+                                    outpost::time::Duration::zero()));
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        (*transmitBuffers[i])[0] = i;
+        transmitBuffers[i]->setLength(1);
+    }
+    EXPECT_EQ(3U,
+              mFirst.sendBuffers(outpost::asSlice(transmitBuffers),
+                                 outpost::time::Duration::zero()));
+
+    SpaceWire::ReceiveBuffer buffers[2];
+    ASSERT_EQ(2U, mSecond.receiveBuffers(outpost::asSlice(buffers), outpost::time::Seconds(1)));
+    EXPECT_EQ(0, buffers[0][0]);
+    EXPECT_EQ(1, buffers[1][0]);
+    mSecond.releaseBuffers(outpost::asSlice(buffers));
+
+    ASSERT_EQ(1U, mSecond.receiveBuffers(outpost::asSlice(buffers), outpost::time::Seconds(1)));
+    EXPECT_EQ(2, buffers[0][0]);
+    mSecond.releaseBuffers(outpost::asSlice(buffers).first(1));
+
+    EXPECT_EQ(0U,
+              mSecond.receiveBuffers(outpost::asSlice(buffers), outpost::time::Duration::zero()));
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldGatherSegmentsWithoutTransmitBuffer)
+{
+    uint8_t header[2] = {0xFE, 0x01};
+    uint8_t payload[3] = {1, 2, 3};
+
+    SpaceWire::TransmitBuffer* buffers[4] = {};
+    ASSERT_EQ(4U,
+              mFirst.requestBuffers(outpost::asSlice(buffers), outpost::time::Duration::zero()));
+
+    SpaceWire::TransmitDescriptor packet;
+    packet.addSegment(outpost::asSlice(header));
+    packet.addSegment(outpost::asSlice(payload));
+    EXPECT_EQ(SpaceWire::Result::success,
+              mFirst.sendSegments(packet, outpost::time::Duration::zero()));
+    mFirst.sendBuffers(outpost::asSlice(buffers), outpost::time::Duration::zero());
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({0xFE, 0x01, 1, 2, 3}), receivePacket(mSecond, end));
+}
+
+TEST(SpaceWireEmulatorTimingTest, shouldDelayPacketsByTransmissionTimeAndLatency)
+{
+    SpaceWireEmulator::Configuration configuration;
+    configuration.link.bitRate = 10000000;
+    configuration.link.latency = outpost::time::Milliseconds(2);
+    SpaceWireEmulator first(configuration);
+    SpaceWireEmulator second(configuration);
+    SpaceWireEmulatorPort::connect(first, second);
+    first.open();
+    second.open();
+    first.up(outpost::time::Duration::zero());
+    second.up(outpost::time::Duration::zero());
+
+    // 1000 data characters and the end marker take 1.0004 ms at 10 Mbit/s
+    EXPECT_EQ(std::chrono::nanoseconds(1000400), first.getTransmissionTime(1000));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(first, std::vector<uint8_t>(1000, 0xAA)));
+
+    SpaceWire::ReceiveBuffer buffer;
+    EXPECT_EQ(SpaceWire::Result::timeout, second.receive(buffer, outpost::time::Duration::zero()));
+    ASSERT_EQ(SpaceWire::Result::success, second.receive(buffer, outpost::time::Seconds(1)));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    second.releaseBuffer(buffer);
+
+    EXPECT_GE(elapsed, std::chrono::microseconds(3000));
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldInjectFaults)
+{
+    mFirst.injectFault(SpaceWireEmulatorPort::Fault::drop);
+    mFirst.injectFault(SpaceWireEmulatorPort::Fault::eep);
+
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1, 2, 3}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {4, 5, 6}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {7, 8, 9}));
+
+    SpaceWire::EndMarker end;
+    std::vector<uint8_t> truncated = receivePacket(mSecond, end);
+    EXPECT_EQ(SpaceWire::eep, end);
+    EXPECT_LT(truncated.size(), 3U);
+    EXPECT_EQ(std::vector<uint8_t>({7, 8, 9}), receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::eop, end);
+
+    EXPECT_EQ(1U, mFirst.getStatistics().mDroppedPackets);
+    EXPECT_EQ(1U, mFirst.getStatistics().mErrorPackets);
+}
+
+TEST(SpaceWireEmulatorFaultTest, shouldInjectRandomFaultsReproducibly)
+{
+    SpaceWireEmulator::Configuration configuration;
+    configuration.link.dropProbability = 0.5;
+    configuration.link.seed = 42;
+
+    size_t received[2] = {};
+    for (size_t run = 0; run < 2; run++)
+    {
+        SpaceWireEmulator first(configuration);
+        SpaceWireEmulator second;
+        SpaceWireEmulatorPort::connect(first, second);
+        first.open();
+        second.open();
+        first.up(outpost::time::Duration::zero());
+        second.up(outpost::time::Duration::zero());
+
+        for (uint8_t i = 0; i < 100; i++)
+        {
+            sendPacket(first, {i});
+            SpaceWire::EndMarker end;
+            if (!receivePacket(second, end).empty())
+            {
+                received[run]++;
+            }
+        }
+    }
+
+    EXPECT_EQ(received[0], received[1]);
+    EXPECT_GT(received[0], 0U);
+    EXPECT_LT(received[0], 100U);
+}
+
+TEST_F(SpaceWireEmulatorTest, shouldTakeLinkDownOnDisconnect)
+{
+    mFirst.disconnect();
+
+    EXPECT_FALSE(mFirst.isUp());
+    EXPECT_FALSE(mSecond.isUp());
+    EXPECT_EQ(SpaceWire::Result::failure, sendPacket(mFirst, {1}));
+}
+
+// ----------------------------------------------------------------------------
+class SpaceWireRouterEmulatorTest : public testing::Test
+{
+public:
+    SpaceWireRouterEmulatorTest() : mRouter(3)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            SpaceWireEmulatorPort::connect(mNodes[i], mRouter.getPort(i + 1));
+            mNodes[i].open();
+            mNodes[i].up(outpost::time::Duration::zero());
+        }
+    }
+
+    SpaceWireEmulator mNodes[3];
+    SpaceWireRouterEmulator mRouter;
+};
+
+TEST_F(SpaceWireRouterEmulatorTest, shouldRemovePathAddress)
+{
+    EXPECT_TRUE(mNodes[0].isUp());
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mNodes[0], {3, 0xFE, 0x01}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({0xFE, 0x01}), receivePacket(mNodes[2], end));
+    EXPECT_EQ(0U, mNodes[1].getNumberOfPendingPackets());
+}
+
+TEST_F(SpaceWireRouterEmulatorTest, shouldForwardLogicalAddressAccordingToRoutingTable)
+{
+    EXPECT_TRUE(mRouter.setRoute(0x42, 2));
+    EXPECT_FALSE(mRouter.setRoute(0x10, 2));
+    EXPECT_FALSE(mRouter.setRoute(0x43, 4));
+
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mNodes[0], {0x42, 0x01}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({0x42, 0x01}), receivePacket(mNodes[1], end));
+}
+
+TEST_F(SpaceWireRouterEmulatorTest, shouldDiscardPacketsWithoutRoute)
+{
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mNodes[0], {0x43, 0x01}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mNodes[0], {0, 0x01}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mNodes[0], {7, 0x01}));
+
+    EXPECT_EQ(3U, mRouter.getNumberOfDiscardedPackets());
+    for (auto& node : mNodes)
+    {
+        EXPECT_EQ(0U, node.getNumberOfPendingPackets());
+    }
+}
+
+TEST_F(SpaceWireRouterEmulatorTest, shouldRouteThroughSeveralRouters)
+{
+    SpaceWireRouterEmulator second(2);
+    SpaceWireEmulator node;
+    SpaceWireEmulatorPort::connect(mRouter.getPort(3), second.getPort(1));
+    SpaceWireEmulatorPort::connect(node, second.getPort(2));
+    node.open();
+    node.up(outpost::time::Duration::zero());
+
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mNodes[0], {3, 2, 0xFE}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({0xFE}), receivePacket(node, end));
+}
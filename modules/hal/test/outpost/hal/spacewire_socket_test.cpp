@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/hal/spacewire_socket.h>
+
+#include <unittest/harness.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using outpost::hal::SpaceWire;
+using outpost::hal::SpaceWireSocket;
+
+namespace
+{
+const outpost::time::Duration receiveTimeout = outpost::time::Seconds(1);
+
+std::string
+getSocketPath(const char* name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/outpost_spw_%d_%s", static_cast<int>(getpid()), name);
+    return path;
+}
+
+SpaceWire::Result::Type
+sendPacket(SpaceWire& spw, std::vector<uint8_t> data, SpaceWire::EndMarker end = SpaceWire::eop)
+{
+    SpaceWire::TransmitBuffer* buffer = nullptr;
+    SpaceWire::Result::Type result = spw.requestBuffer(buffer, outpost::time::Duration::zero());
+    if (result == SpaceWire::Result::success)
+    {
+        std::copy(data.begin(), data.end(), buffer->getData().begin());
+        buffer->setLength(data.size());
+        buffer->setEndMarker(end);
+        result = spw.send(buffer, outpost::time::Duration::zero());
+    }
+    return result;
+}
+
+std::vector<uint8_t>
+receivePacket(SpaceWire& spw,
+              SpaceWire::EndMarker& end,
+              outpost::time::Duration timeout = receiveTimeout)
+{
+    std::vector<uint8_t> data;
+    SpaceWire::ReceiveBuffer buffer;
+    end = SpaceWire::unknown;
+    if (spw.receive(buffer, timeout) == SpaceWire::Result::success)
+    {
+        data.assign(buffer.getData().begin(), buffer.getData().end());
+        end = buffer.getEndMarker();
+        spw.releaseBuffer(buffer);
+    }
+    return data;
+}
+}  // namespace
+
+class SpaceWireSocketTest : public testing::Test
+{
+public:
+    SpaceWireSocketTest() :
+        mFirstPath(getSocketPath("first")),
+        mSecondPath(getSocketPath("second")),
+        mFirst(SpaceWireSocket::Address::unixDomain(mFirstPath.c_str()),
+               SpaceWireSocket::Address::unixDomain(mSecondPath.c_str()),
+               64,
+               4),
+        mSecond(SpaceWireSocket::Address::unixDomain(mSecondPath.c_str()),
+                SpaceWireSocket::Address::unixDomain(mFirstPath.c_str()),
+                64,
+                4)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        ASSERT_TRUE(mFirst.open());
+        ASSERT_TRUE(mSecond.open());
+        ASSERT_TRUE(mFirst.up(outpost::time::Duration::zero()));
+        ASSERT_TRUE(mSecond.up(outpost::time::Duration::zero()));
+    }
+
+    std::string mFirstPath;
+    std::string mSecondPath;
+    SpaceWireSocket mFirst;
+    SpaceWireSocket mSecond;
+};
+
+// ----------------------------------------------------------------------------
+TEST(SpaceWireSocketConnectionTest, shouldOnlyStartOpenSocket)
+{
+    std::string path = getSocketPath("single");
+    SpaceWireSocket spw(SpaceWireSocket::Address::unixDomain(path.c_str()),
+                        SpaceWireSocket::Address::unixDomain(path.c_str()));
+
+    EXPECT_FALSE(spw.up(outpost::time::Duration::zero()));
+    EXPECT_FALSE(spw.isUp());
+
+    EXPECT_TRUE(spw.open());
+    EXPECT_TRUE(spw.up(outpost::time::Duration::zero()));
+    EXPECT_TRUE(spw.isUp());
+
+    spw.down(outpost::time::Duration::zero());
+    EXPECT_FALSE(spw.isUp());
+
+    SpaceWire::ReceiveBuffer buffer;
+    EXPECT_EQ(SpaceWire::Result::failure, spw.receive(buffer, outpost::time::Duration::zero()));
+}
+
+TEST_F(SpaceWireSocketTest, shouldTransferPacketsInBothDirections)
+{
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1, 2, 3}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mSecond, {4, 5}, SpaceWire::eep));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::eop, end);
+    EXPECT_EQ(std::vector<uint8_t>({4, 5}), receivePacket(mFirst, end));
+    EXPECT_EQ(SpaceWire::eep, end);
+}
+
+TEST_F(SpaceWireSocketTest, shouldTimeoutWithoutPackets)
+{
+    SpaceWire::ReceiveBuffer buffer;
+    EXPECT_EQ(SpaceWire::Result::timeout, mFirst.receive(buffer, outpost::time::Duration::zero()));
+    EXPECT_EQ(SpaceWire::Result::timeout,
+              mFirst.receive(buffer, outpost::time::Milliseconds(10)));
+}
+
+TEST_F(SpaceWireSocketTest, shouldForwardPartialPackets)
+{
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1, 2}, SpaceWire::partial));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {3}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1, 2}), receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::partial, end);
+    EXPECT_EQ(std::vector<uint8_t>({3}), receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::eop, end);
+}
+
+TEST_F(SpaceWireSocketTest, shouldLimitNumberOfTransmitBuffers)
+{
+    SpaceWire::TransmitBuffer* buffers[5];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_EQ(SpaceWire::Result::success,
+                  mFirst.requestBuffer(buffers[i], outpost::time::Duration::zero()));
+        EXPECT_EQ(64U, buffers[i]->getData().getNumberOfElements());
+    }
+    EXPECT_EQ(SpaceWire::Result::timeout,
+              mFirst.requestBuffer(buffers[4], outpost::time::Duration::zero()));
+
+    buffers[0]->setLength(1);
+    EXPECT_EQ(SpaceWire::Result::success, mFirst.send(buffers[0], outpost::time::Duration::zero()));
+    EXPECT_EQ(SpaceWire::Result::success,
+              mFirst.requestBuffer(buffers[4], outpost::time::Duration::zero()));
+}
+
+TEST_F(SpaceWireSocketTest, shouldSendAndReceiveBatches)
+{
+    SpaceWire::TransmitBuffer* transmitBuffers[3];
+    ASSERT_EQ(3U,
+              mFirst.requestBuffers(outpost::asSlice(transmitBuffers),
+                                    outpost::time::Duration::zero()));
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        transmitBuffers[i]->getData()[0] = i;
+        transmitBuffers[i]->setLength(1);
+    }
+    EXPECT_EQ(3U, mFirst.sendBuffers(outpost::asSlice(transmitBuffers),
+                                     outpost::time::Duration::zero()));
+
+    SpaceWire::ReceiveBuffer receiveBuffers[4];
+    ASSERT_EQ(3U, mSecond.receiveBuffers(outpost::asSlice(receiveBuffers), receiveTimeout));
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(1U, receiveBuffers[i].getLength());
+        EXPECT_EQ(i, receiveBuffers[i].getData()[0]);
+        EXPECT_EQ(SpaceWire::eop, receiveBuffers[i].getEndMarker());
+    }
+    mSecond.releaseBuffers(outpost::asSlice(receiveBuffers).first(3));
+}
+
+TEST_F(SpaceWireSocketTest, shouldRejectBatchLongerThanTransmitBuffers)
+{
+    SpaceWire::TransmitBuffer* transmitBuffers[5];
+    ASSERT_EQ(4U,
+              mFirst.requestBuffers(outpost::asSlice(transmitBuffers).first(4),
+                                    outpost::time::Duration::zero()));
+    transmitBuffers[4] = transmitBuffers[0];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        transmitBuffers[i]->setLength(1);
+    }
+    EXPECT_EQ(0U, mFirst.sendBuffers(outpost::asSlice(transmitBuffers),
+                                     outpost::time::Duration::zero()));
+
+    EXPECT_EQ(4U, mFirst.sendBuffers(outpost::asSlice(transmitBuffers).first(4),
+                                     outpost::time::Duration::zero()));
+}
+
+TEST_F(SpaceWireSocketTest, shouldSendFromConcurrentThreads)
+{
+    const size_t numberOfThreads = 2;
+    const size_t packetsPerThread = 200;
+
+    std::vector<std::thread> senders;
+    for (size_t t = 0; t < numberOfThreads; ++t)
+    {
+        senders.emplace_back([this, t]() {
+            for (size_t i = 0; i < packetsPerThread; ++i)
+            {
+                SpaceWire::TransmitBuffer* buffer = nullptr;
+                ASSERT_EQ(SpaceWire::Result::success,
+                          mFirst.requestBuffer(buffer, receiveTimeout));
+                buffer->getData()[0] = static_cast<uint8_t>(t);
+                buffer->getData()[1] = static_cast<uint8_t>(i);
+                buffer->setLength(2);
+                ASSERT_EQ(SpaceWire::Result::success, mFirst.send(buffer, receiveTimeout));
+            }
+        });
+    }
+
+    // Every packet arrives exactly once and in order per sender
+    std::vector<size_t> expected(numberOfThreads, 0);
+    for (size_t i = 0; i < numberOfThreads * packetsPerThread; ++i)
+    {
+        SpaceWire::EndMarker end;
+        std::vector<uint8_t> data = receivePacket(mSecond, end);
+        ASSERT_EQ(2U, data.size());
+        ASSERT_LT(data[0], numberOfThreads);
+        EXPECT_EQ(static_cast<uint8_t>(expected[data[0]]), data[1]);
+        expected[data[0]]++;
+    }
+
+    for (std::thread& sender : senders)
+    {
+        sender.join();
+    }
+    EXPECT_EQ(std::vector<size_t>(numberOfThreads, packetsPerThread), expected);
+}
+
+TEST_F(SpaceWireSocketTest, shouldKeepPacketsInSocketWhileReceiveBuffersAreInUse)
+{
+    for (uint8_t i = 0; i < 5; ++i)
+    {
+        ASSERT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {i}));
+    }
+
+    SpaceWire::ReceiveBuffer buffers[5];
+    ASSERT_EQ(4U, mSecond.receiveBuffers(outpost::asSlice(buffers), receiveTimeout));
+    EXPECT_EQ(SpaceWire::Result::failure,
+              mSecond.receive(buffers[4], outpost::time::Duration::zero()));
+
+    mSecond.releaseBuffer(buffers[0]);
+    ASSERT_EQ(SpaceWire::Result::success, mSecond.receive(buffers[4], receiveTimeout));
+    EXPECT_EQ(4, buffers[4].getData()[0]);
+}
+
+TEST_F(SpaceWireSocketTest, shouldMarkTruncatedPacketsWithEep)
+{
+    std::vector<uint8_t> data(64, 0xAB);
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, data));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(data, receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::eop, end);
+
+    // Datagram larger than the receive buffer
+    std::string path = getSocketPath("large");
+    SpaceWireSocket large(SpaceWireSocket::Address::unixDomain(path.c_str()),
+                          SpaceWireSocket::Address::unixDomain(mSecondPath.c_str()),
+                          128,
+                          1);
+    ASSERT_TRUE(large.open());
+    ASSERT_TRUE(large.up(outpost::time::Duration::zero()));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(large, std::vector<uint8_t>(100, 1)));
+
+    EXPECT_EQ(64U, receivePacket(mSecond, end).size());
+    EXPECT_EQ(SpaceWire::eep, end);
+}
+
+TEST_F(SpaceWireSocketTest, shouldFlushReceivedPackets)
+{
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {1}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {2}));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1}), receivePacket(mSecond, end));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(mFirst, {3}));
+
+    mSecond.flushReceiveBuffer();
+
+    SpaceWire::ReceiveBuffer buffer;
+    EXPECT_EQ(SpaceWire::Result::timeout, mSecond.receive(buffer, outpost::time::Duration::zero()));
+}
+
+TEST(SpaceWireSocketUdpTest, shouldTransferPacketsOverLoopback)
+{
+    uint16_t firstPort = static_cast<uint16_t>(40000 + (getpid() % 10000) * 2);
+    uint16_t secondPort = firstPort + 1;
+    SpaceWireSocket first(SpaceWireSocket::Address::udp(firstPort),
+                          SpaceWireSocket::Address::udp(secondPort));
+    SpaceWireSocket second(SpaceWireSocket::Address::udp(secondPort),
+                           SpaceWireSocket::Address::udp(firstPort));
+
+    ASSERT_TRUE(first.open());
+    ASSERT_TRUE(second.open());
+    first.up(outpost::time::Duration::zero());
+    second.up(outpost::time::Duration::zero());
+
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(first, {1, 2, 3}));
+    EXPECT_EQ(SpaceWire::Result::success, sendPacket(second, {4}, SpaceWire::eep));
+
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), receivePacket(second, end));
+    EXPECT_EQ(SpaceWire::eop, end);
+    EXPECT_EQ(std::vector<uint8_t>({4}), receivePacket(first, end));
+    EXPECT_EQ(SpaceWire::eep, end);
+}
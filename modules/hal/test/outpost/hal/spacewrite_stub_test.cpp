@@ -12,6 +12,8 @@
  * - 2017, Muhammad Bassam (DLR RY-AVS)
  */
 
+#include <outpost/utils/container/shared_object_pool.h>
+
 #include <unittest/hal/spacewire_stub.h>
 #include <unittest/harness.h>
 
@@ -150,3 +152,166 @@ TEST_F(SpaceWireStubTest, shouldReceiveData)
     EXPECT_TRUE(mSpaceWire.mPacketsToReceive.empty());
     EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
 }
+
+TEST_F(SpaceWireStubTest, shouldTransmitBatch)
+{
+    SpaceWire::TransmitBuffer* buffers[3] = {};
+    ASSERT_EQ(3U,
+              mSpaceWire.requestBuffers(outpost::asSlice(buffers),
+                                        outpost::time::Duration::zero()));
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        (*buffers[i])[0] = i;
+        buffers[i]->setLength(1);
+    }
+    EXPECT_EQ(3U,
+              mSpaceWire.sendBuffers(outpost::asSlice(buffers), outpost::time::Duration::zero()));
+
+    ASSERT_EQ(3U, mSpaceWire.mSentPackets.size());
+    EXPECT_EQ(std::vector<uint8_t>({2}), mSpaceWire.mSentPackets.back().data);
+    EXPECT_TRUE(mSpaceWire.noUsedTransmitBuffers());
+}
+
+TEST_F(SpaceWireStubTest, shouldReceiveAvailablePacketsAsBatch)
+{
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        mSpaceWire.mPacketsToReceive.emplace_back(
+                unittest::hal::SpaceWireStub::Packet{{i}, SpaceWire::eop});
+    }
+
+    SpaceWire::ReceiveBuffer buffers[3];
+    ASSERT_EQ(2U,
+              mSpaceWire.receiveBuffers(outpost::asSlice(buffers),
+                                        outpost::time::Duration::zero()));
+    EXPECT_EQ(0, buffers[0][0]);
+    EXPECT_EQ(1, buffers[1][0]);
+
+    mSpaceWire.releaseBuffers(outpost::asSlice(buffers).first(2));
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+
+    EXPECT_EQ(0U,
+              mSpaceWire.receiveBuffers(outpost::asSlice(buffers),
+                                        outpost::time::Duration::zero()));
+}
+
+TEST_F(SpaceWireStubTest, shouldCopySegmentsIntoTransmitBuffer)
+{
+    uint8_t header[2] = {0xFE, 0x01};
+    uint8_t payload[3] = {1, 2, 3};
+
+    SpaceWire::TransmitDescriptor packet;
+    EXPECT_TRUE(packet.addSegment(outpost::asSlice(header)));
+    EXPECT_TRUE(packet.addSegment(outpost::Slice<const uint8_t>::empty()));
+    EXPECT_TRUE(packet.addSegment(outpost::asSlice(payload)));
+    packet.setEndMarker(SpaceWire::eep);
+    EXPECT_EQ(5U, packet.getLength());
+
+    ASSERT_EQ(SpaceWire::Result::success,
+              mSpaceWire.sendSegments(packet, outpost::time::Duration::zero()));
+
+    ASSERT_EQ(1U, mSpaceWire.mSentPackets.size());
+    EXPECT_EQ(std::vector<uint8_t>({0xFE, 0x01, 1, 2, 3}), mSpaceWire.mSentPackets.front().data);
+    EXPECT_EQ(SpaceWire::eep, mSpaceWire.mSentPackets.front().end);
+    EXPECT_TRUE(mSpaceWire.noUsedTransmitBuffers());
+}
+
+TEST_F(SpaceWireStubTest, shouldRejectSegmentsExceedingMaximumPacketLength)
+{
+    uint8_t payload[60] = {};
+
+    SpaceWire::TransmitDescriptor packet;
+    packet.addSegment(outpost::asSlice(payload));
+    packet.addSegment(outpost::asSlice(payload));
+
+    EXPECT_EQ(SpaceWire::Result::failure,
+              mSpaceWire.sendSegments(packet, outpost::time::Duration::zero()));
+    EXPECT_TRUE(mSpaceWire.mSentPackets.empty());
+    EXPECT_TRUE(mSpaceWire.noUsedTransmitBuffers());
+}
+
+TEST(SpaceWireTransmitDescriptorTest, shouldLimitNumberOfSegments)
+{
+    uint8_t data[1] = {};
+
+    SpaceWire::TransmitDescriptor packet;
+    for (size_t i = 0; i < SpaceWire::TransmitDescriptor::maxSegments; i++)
+    {
+        EXPECT_TRUE(packet.addSegment(outpost::asSlice(data)));
+    }
+    EXPECT_FALSE(packet.addSegment(outpost::asSlice(data)));
+    EXPECT_EQ(SpaceWire::TransmitDescriptor::maxSegments, packet.getNumberOfSegments());
+
+    packet.clear();
+    EXPECT_EQ(0U, packet.getNumberOfSegments());
+    EXPECT_EQ(0U, packet.getLength());
+}
+
+TEST_F(SpaceWireStubTest, shouldRequireReceiveBufferPoolForSharedReceive)
+{
+    mSpaceWire.mPacketsToReceive.emplace_back(
+            unittest::hal::SpaceWireStub::Packet{{0x01}, SpaceWire::eop});
+
+    outpost::utils::SharedChildPointer packet;
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(SpaceWire::Result::failure,
+              mSpaceWire.receiveShared(packet, end, outpost::time::Duration::zero()));
+    EXPECT_EQ(1U, mSpaceWire.mPacketsToReceive.size());
+}
+
+TEST_F(SpaceWireStubTest, shouldReceiveIntoSharedBuffer)
+{
+    outpost::utils::SharedBufferPool<16, 1> pool;
+    mSpaceWire.setReceiveBufferPool(pool);
+
+    std::vector<uint8_t> expectedData = {0x01, 0x02, 0x03};
+    mSpaceWire.mPacketsToReceive.emplace_back(
+            unittest::hal::SpaceWireStub::Packet{expectedData, SpaceWire::eep});
+
+    outpost::utils::SharedChildPointer packet;
+    SpaceWire::EndMarker end;
+    ASSERT_EQ(SpaceWire::Result::success,
+              mSpaceWire.receiveShared(packet, end, outpost::time::Duration::zero()));
+
+    // Receive buffer of the driver is released immediately
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+    EXPECT_EQ(SpaceWire::eep, end);
+    ASSERT_EQ(expectedData.size(), packet.getLength());
+    EXPECT_THAT(expectedData, testing::ElementsAreArray(&packet[0], packet.getLength()));
+    EXPECT_EQ(0U, pool.numberOfFreeElements());
+
+    // Shared buffer is returned to the pool with its last reference
+    outpost::utils::SharedBufferPointer copy(packet);
+    packet = outpost::utils::SharedChildPointer();
+    EXPECT_EQ(0U, pool.numberOfFreeElements());
+    copy = outpost::utils::SharedBufferPointer();
+    EXPECT_EQ(1U, pool.numberOfFreeElements());
+}
+
+TEST_F(SpaceWireStubTest, shouldDiscardPacketWithoutFreeSharedBuffer)
+{
+    outpost::utils::SharedBufferPool<16, 1> pool;
+    mSpaceWire.setReceiveBufferPool(pool);
+
+    outpost::utils::SharedBufferPointer used;
+    ASSERT_TRUE(pool.allocate(used));
+
+    mSpaceWire.mPacketsToReceive.emplace_back(
+            unittest::hal::SpaceWireStub::Packet{{0x01}, SpaceWire::eop});
+    mSpaceWire.mPacketsToReceive.emplace_back(
+            unittest::hal::SpaceWireStub::Packet{std::vector<uint8_t>(17, 0), SpaceWire::eop});
+
+    outpost::utils::SharedChildPointer packet;
+    SpaceWire::EndMarker end;
+    EXPECT_EQ(SpaceWire::Result::failure,
+              mSpaceWire.receiveShared(packet, end, outpost::time::Duration::zero()));
+
+    used = outpost::utils::SharedBufferPointer();
+    EXPECT_EQ(SpaceWire::Result::failure,
+              mSpaceWire.receiveShared(packet, end, outpost::time::Duration::zero()));
+
+    EXPECT_TRUE(mSpaceWire.mPacketsToReceive.empty());
+    EXPECT_TRUE(mSpaceWire.noUsedReceiveBuffers());
+    EXPECT_EQ(1U, pool.numberOfFreeElements());
+}
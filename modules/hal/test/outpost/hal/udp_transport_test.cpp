@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/hal/udp_transport.h>
+#include <outpost/rtos/clock.h>
+
+#include <unittest/harness.h>
+
+using outpost::hal::DatagramTransport;
+using outpost::hal::UdpTransport;
+
+namespace
+{
+const DatagramTransport::IpAddress loopback(127, 0, 0, 1);
+const outpost::time::Duration receiveTimeout = outpost::time::Seconds(1);
+}  // namespace
+
+class UdpTransportTest : public testing::Test
+{
+public:
+    UdpTransportTest() :
+        mFirst(DatagramTransport::Address(loopback, 0), 4),
+        mSecond(DatagramTransport::Address(loopback, 0), 4)
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        ASSERT_TRUE(mFirst.connect());
+        ASSERT_TRUE(mSecond.connect());
+    }
+
+    UdpTransport mFirst;
+    UdpTransport mSecond;
+};
+
+// ----------------------------------------------------------------------------
+TEST_F(UdpTransportTest, shouldSelectPortWhenConnecting)
+{
+    EXPECT_NE(0, mFirst.getAddress().getPort());
+    EXPECT_NE(mFirst.getAddress().getPort(), mSecond.getAddress().getPort());
+    EXPECT_EQ(127, mFirst.getAddress().getIpAddress()[0]);
+}
+
+TEST_F(UdpTransportTest, shouldSendAndReceiveSingleDatagram)
+{
+    uint8_t data[3] = {1, 2, 3};
+    EXPECT_EQ(3U, mFirst.sendTo(outpost::asSlice(data), mSecond.getAddress()));
+
+    uint8_t buffer[8];
+    outpost::Slice<uint8_t> slice = outpost::asSlice(buffer);
+    DatagramTransport::Address address;
+    ASSERT_EQ(3U, mSecond.receiveFrom(slice, address, receiveTimeout));
+    EXPECT_EQ(3, buffer[2]);
+    EXPECT_EQ(mFirst.getAddress().getPort(), address.getPort());
+}
+
+TEST_F(UdpTransportTest, shouldReportLengthOfNextDatagram)
+{
+    EXPECT_FALSE(mSecond.isAvailable());
+    EXPECT_EQ(0U, mSecond.getNumberOfBytesAvailable());
+
+    uint8_t data[100] = {};
+    mFirst.sendTo(outpost::asSlice(data), mSecond.getAddress());
+
+    uint8_t buffer[1];
+    outpost::Slice<uint8_t> slice = outpost::asSlice(buffer);
+    DatagramTransport::Address address;
+    mSecond.receiveFrom(slice, address, outpost::time::Duration::zero());
+    mFirst.sendTo(outpost::asSlice(data).first(20), mSecond.getAddress());
+
+    EXPECT_TRUE(mSecond.isAvailable());
+    EXPECT_EQ(20U, mSecond.getNumberOfBytesAvailable());
+
+    mSecond.clearReceiveBuffer();
+    EXPECT_FALSE(mSecond.isAvailable());
+}
+
+TEST_F(UdpTransportTest, shouldTimeoutWithoutDatagram)
+{
+    uint8_t buffer[8];
+    outpost::Slice<uint8_t> slice = outpost::asSlice(buffer);
+    DatagramTransport::Address address;
+
+    outpost::rtos::SystemClock clock;
+    outpost::time::SpacecraftElapsedTime start = clock.now();
+    EXPECT_EQ(0U, mSecond.receiveFrom(slice, address, outpost::time::Milliseconds(20)));
+    EXPECT_LE(outpost::time::Milliseconds(20), clock.now() - start);
+}
+
+TEST_F(UdpTransportTest, shouldTransferBatchesLargerThanTheMaximumBatchSize)
+{
+    uint8_t data[10][2];
+    DatagramTransport::Datagram transmit[10];
+    for (uint8_t i = 0; i < 10; ++i)
+    {
+        data[i][0] = i;
+        data[i][1] = 0xA5;
+        transmit[i] =
+                DatagramTransport::Datagram(outpost::asSlice(data[i]), 2, mSecond.getAddress());
+    }
+    EXPECT_EQ(10U, mFirst.sendToMany(outpost::asSlice(transmit)));
+
+    uint8_t buffers[12][4];
+    DatagramTransport::Datagram receive[12];
+    for (size_t i = 0; i < 12; ++i)
+    {
+        receive[i] = DatagramTransport::Datagram(outpost::asSlice(buffers[i]));
+    }
+
+    size_t count = 0;
+    while (count < 10)
+    {
+        size_t received =
+                mSecond.receiveMany(outpost::asSlice(receive).skipFirst(count), receiveTimeout);
+        ASSERT_LT(0U, received);
+        count += received;
+    }
+    EXPECT_EQ(10U, count);
+
+    for (uint8_t i = 0; i < 10; ++i)
+    {
+        ASSERT_EQ(2U, receive[i].getLength());
+        EXPECT_EQ(i, receive[i].getData()[0]);
+        EXPECT_EQ(mFirst.getAddress().getPort(), receive[i].getAddress().getPort());
+    }
+
+    EXPECT_EQ(0U, mSecond.receiveMany(outpost::asSlice(receive), outpost::time::Duration::zero()));
+}
+
+TEST_F(UdpTransportTest, shouldTruncateDatagramsLargerThanTheBuffer)
+{
+    uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+    DatagramTransport::Datagram transmit(outpost::asSlice(data), 6, mSecond.getAddress());
+    EXPECT_EQ(1U,
+              mFirst.sendToMany(
+                      outpost::Slice<const DatagramTransport::Datagram>::unsafe(&transmit, 1)));
+
+    uint8_t buffer[4];
+    DatagramTransport::Datagram receive(outpost::asSlice(buffer));
+    ASSERT_EQ(1U,
+              mSecond.receiveMany(outpost::Slice<DatagramTransport::Datagram>::unsafe(&receive, 1),
+                                  receiveTimeout));
+    EXPECT_EQ(4U, receive.getLength());
+    EXPECT_EQ(4, receive.getData()[3]);
+}
+
+TEST_F(UdpTransportTest, shouldNotReceiveAfterClose)
+{
+    mSecond.close();
+
+    uint8_t buffer[4];
+    DatagramTransport::Datagram receive(outpost::asSlice(buffer));
+    EXPECT_EQ(0U,
+              mSecond.receiveMany(outpost::Slice<DatagramTransport::Datagram>::unsafe(&receive, 1),
+                                  outpost::time::Duration::zero()));
+}
@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "spacewire_emulator.h"
+
+#include <algorithm>
+#include <thread>
+
+using unittest::hal::SpaceWireEmulator;
+using unittest::hal::SpaceWireEmulatorPort;
+using unittest::hal::SpaceWireRouterEmulator;
+
+constexpr uint8_t SpaceWireRouterEmulator::maximumNumberOfPorts;
+
+namespace
+{
+/// Highest SpaceWire path address, higher values are logical addresses
+static constexpr uint8_t maximumPathAddress = 31;
+
+/// Interval for checking the other end of a link while waiting for it to start
+static constexpr std::chrono::microseconds linkPollInterval(100);
+}  // namespace
+
+//------------------------------------------------------------------------------
+SpaceWireEmulatorPort::SpaceWireEmulatorPort(const LinkConfiguration& configuration) :
+    mConfiguration(configuration),
+    mPeer(nullptr),
+    mLinkMutex(),
+    mLinkFreeAt(),
+    mInjectedFaults(),
+    mRandom(configuration.seed),
+    mStatistics()
+{
+}
+
+SpaceWireEmulatorPort::~SpaceWireEmulatorPort()
+{
+    disconnect();
+}
+
+void
+SpaceWireEmulatorPort::connect(SpaceWireEmulatorPort& first, SpaceWireEmulatorPort& second)
+{
+    first.disconnect();
+    second.disconnect();
+    first.mPeer = &second;
+    second.mPeer = &first;
+}
+
+void
+SpaceWireEmulatorPort::disconnect()
+{
+    SpaceWireEmulatorPort* peer = mPeer.exchange(nullptr);
+    if (peer != nullptr)
+    {
+        SpaceWireEmulatorPort* self = this;
+        peer->mPeer.compare_exchange_strong(self, nullptr);
+    }
+}
+
+void
+SpaceWireEmulatorPort::injectFault(Fault fault)
+{
+    std::lock_guard<std::mutex> lock(mLinkMutex);
+    mInjectedFaults.push_back(fault);
+}
+
+SpaceWireEmulatorPort::Statistics
+SpaceWireEmulatorPort::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(mLinkMutex);
+    return mStatistics;
+}
+
+SpaceWireEmulatorPort::Clock::duration
+SpaceWireEmulatorPort::getTransmissionTime(size_t length) const
+{
+    if (mConfiguration.bitRate == 0)
+    {
+        return Clock::duration::zero();
+    }
+
+    uint64_t bits = length * 10 + 4;
+    std::chrono::nanoseconds time(bits * 1000000000ULL / mConfiguration.bitRate);
+    return std::chrono::duration_cast<Clock::duration>(time);
+}
+
+SpaceWireEmulatorPort::Result::Type
+SpaceWireEmulatorPort::transmit(Frame&& frame, Clock::time_point ready, Clock::time_point deadline)
+{
+    SpaceWireEmulatorPort* peer = mPeer;
+    if ((peer == nullptr) || !isRunning())
+    {
+        return Result::failure;
+    }
+
+    bool drop = false;
+    {
+        std::lock_guard<std::mutex> lock(mLinkMutex);
+
+        // Packets queue up behind each other on the link
+        Clock::time_point start = std::max(ready, mLinkFreeAt);
+        mLinkFreeAt = start + getTransmissionTime(frame.data.size());
+        frame.arrival = mLinkFreeAt
+                        + std::chrono::microseconds(mConfiguration.latency.microseconds());
+
+        mStatistics.mSentPackets++;
+        mStatistics.mSentBytes += frame.data.size();
+
+        Fault fault;
+        if (selectFault(fault))
+        {
+            if (fault == Fault::drop)
+            {
+                mStatistics.mDroppedPackets++;
+                drop = true;
+            }
+            else
+            {
+                mStatistics.mErrorPackets++;
+                if (!frame.data.empty())
+                {
+                    frame.data.resize(mRandom() % frame.data.size());
+                }
+                frame.end = outpost::hal::SpaceWire::eep;
+            }
+        }
+    }
+
+    if (drop)
+    {
+        // The sender does not notice a packet lost on the link
+        return Result::success;
+    }
+    return peer->deliver(std::move(frame), deadline);
+}
+
+bool
+SpaceWireEmulatorPort::isRunning() const
+{
+    SpaceWireEmulatorPort* peer = mPeer;
+    return (peer != nullptr) && isStarted() && peer->isStarted();
+}
+
+void
+SpaceWireEmulatorPort::countReceived(size_t length)
+{
+    std::lock_guard<std::mutex> lock(mLinkMutex);
+    mStatistics.mReceivedPackets++;
+    mStatistics.mReceivedBytes += length;
+}
+
+SpaceWireEmulatorPort::Clock::time_point
+SpaceWireEmulatorPort::getDeadline(outpost::time::Duration timeout)
+{
+    if (timeout == outpost::time::Duration::infinity())
+    {
+        // Far enough in the future without overflowing the clock
+        return Clock::now() + std::chrono::hours(24 * 365);
+    }
+    return Clock::now() + std::chrono::microseconds(timeout.microseconds());
+}
+
+bool
+SpaceWireEmulatorPort::selectFault(Fault& fault)
+{
+    if (!mInjectedFaults.empty())
+    {
+        fault = mInjectedFaults.front();
+        mInjectedFaults.pop_front();
+        return true;
+    }
+
+    if ((mConfiguration.dropProbability > 0.0) || (mConfiguration.eepProbability > 0.0))
+    {
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        double value = distribution(mRandom);
+        if (value < mConfiguration.dropProbability)
+        {
+            fault = Fault::drop;
+            return true;
+        }
+        else if (value < (mConfiguration.dropProbability + mConfiguration.eepProbability))
+        {
+            fault = Fault::eep;
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+SpaceWireEmulator::SpaceWireEmulator(const Configuration& configuration) :
+    SpaceWireEmulatorPort(configuration.link),
+    mMaximumLength(configuration.maximumPacketLength),
+    mNumberOfReceiveBuffers(configuration.numberOfReceiveBuffers),
+    mOpen(false),
+    mStarted(false),
+    mMutex(),
+    mTransmitCondition(),
+    mReceiveCondition(),
+    mTransmitBuffers(),
+    mPartialPacket(),
+    mReceiveQueue(),
+    mReceiveBuffers()
+{
+    for (size_t i = 0; i < configuration.numberOfTransmitBuffers; i++)
+    {
+        mTransmitBuffers.emplace_back(new TransmitBufferEntry(mMaximumLength));
+    }
+}
+
+SpaceWireEmulator::~SpaceWireEmulator()
+{
+    disconnect();
+}
+
+size_t
+SpaceWireEmulator::getMaximumPacketLength() const
+{
+    return mMaximumLength;
+}
+
+bool
+SpaceWireEmulator::open()
+{
+    mOpen = true;
+    return true;
+}
+
+void
+SpaceWireEmulator::close()
+{
+    down(outpost::time::Duration::zero());
+    mOpen = false;
+}
+
+bool
+SpaceWireEmulator::up(outpost::time::Duration timeout)
+{
+    if (!mOpen)
+    {
+        return false;
+    }
+    mStarted = true;
+
+    // The link only comes up after the other end has been started as well
+    Clock::time_point deadline = getDeadline(timeout);
+    while (!isRunning() && (Clock::now() < deadline))
+    {
+        std::this_thread::sleep_for(linkPollInterval);
+    }
+    return isRunning();
+}
+
+void
+SpaceWireEmulator::down(outpost::time::Duration /*timeout*/)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStarted = false;
+
+    // Wake up waiting threads, they will notice the link being down
+    mTransmitCondition.notify_all();
+    mReceiveCondition.notify_all();
+}
+
+bool
+SpaceWireEmulator::isUp()
+{
+    return isRunning();
+}
+
+SpaceWireEmulator::Result::Type
+SpaceWireEmulator::requestBuffer(TransmitBuffer*& buffer, outpost::time::Duration timeout)
+{
+    Clock::time_point deadline = getDeadline(timeout);
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mStarted)
+    {
+        for (auto& entry : mTransmitBuffers)
+        {
+            if (!entry->used)
+            {
+                entry->used = true;
+                entry->header = TransmitBuffer(outpost::asSlice(entry->buffer));
+                buffer = &entry->header;
+                return Result::success;
+            }
+        }
+
+        if (mTransmitCondition.wait_until(lock, deadline) == std::cv_status::timeout)
+        {
+            buffer = nullptr;
+            return Result::timeout;
+        }
+    }
+
+    buffer = nullptr;
+    return Result::failure;
+}
+
+SpaceWireEmulator::Result::Type
+SpaceWireEmulator::send(TransmitBuffer* buffer, outpost::time::Duration timeout)
+{
+    Frame frame;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = std::find_if(mTransmitBuffers.begin(),
+                               mTransmitBuffers.end(),
+                               [buffer](const std::unique_ptr<TransmitBufferEntry>& entry) {
+                                   return entry->used && (&entry->header == buffer);
+                               });
+        if (it == mTransmitBuffers.end())
+        {
+            return Result::failure;
+        }
+
+        TransmitBufferEntry& entry = **it;
+        mPartialPacket.insert(mPartialPacket.end(),
+                              entry.buffer.begin(),
+                              entry.buffer.begin() + entry.header.getLength());
+        frame.end = entry.header.getEndMarker();
+
+        // The buffer is released independent of the result
+        entry.used = false;
+        mTransmitCondition.notify_all();
+
+        if (frame.end == partial)
+        {
+            return mStarted ? Result::success : Result::failure;
+        }
+        frame.data.swap(mPartialPacket);
+    }
+
+    return transmit(std::move(frame), Clock::now(), getDeadline(timeout));
+}
+
+SpaceWireEmulator::Result::Type
+SpaceWireEmulator::sendSegments(const TransmitDescriptor& packet, outpost::time::Duration timeout)
+{
+    if (packet.getLength() > mMaximumLength)
+    {
+        return Result::failure;
+    }
+
+    Frame frame;
+    {
+        // Segments are gathered directly, like by a DMA engine, without
+        // occupying a transmit buffer
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (size_t i = 0; i < packet.getNumberOfSegments(); ++i)
+        {
+            outpost::Slice<const uint8_t> segment = packet.getSegment(i);
+            mPartialPacket.insert(mPartialPacket.end(), segment.begin(), segment.end());
+        }
+
+        frame.end = packet.getEndMarker();
+        if (frame.end == partial)
+        {
+            return mStarted ? Result::success : Result::failure;
+        }
+        frame.data.swap(mPartialPacket);
+    }
+
+    return transmit(std::move(frame), Clock::now(), getDeadline(timeout));
+}
+
+SpaceWireEmulator::Result::Type
+SpaceWireEmulator::receive(ReceiveBuffer& buffer, outpost::time::Duration timeout)
+{
+    size_t count = 0;
+    return receivePackets(outpost::Slice<ReceiveBuffer>::unsafe(&buffer, 1), timeout, count);
+}
+
+size_t
+SpaceWireEmulator::receiveBuffers(outpost::Slice<ReceiveBuffer> buffers,
+                                  outpost::time::Duration timeout)
+{
+    size_t count = 0;
+    receivePackets(buffers, timeout, count);
+    return count;
+}
+
+void
+SpaceWireEmulator::releaseBuffer(const ReceiveBuffer& buffer)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    removeReceiveBuffer(buffer);
+    mReceiveCondition.notify_all();
+}
+
+void
+SpaceWireEmulator::releaseBuffers(outpost::Slice<const ReceiveBuffer> buffers)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (size_t i = 0; i < buffers.getNumberOfElements(); ++i)
+    {
+        removeReceiveBuffer(buffers[i]);
+    }
+    mReceiveCondition.notify_all();
+}
+
+void
+SpaceWireEmulator::flushReceiveBuffer()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReceiveQueue.clear();
+    mReceiveCondition.notify_all();
+}
+
+size_t
+SpaceWireEmulator::getNumberOfPendingPackets()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mReceiveQueue.size();
+}
+
+SpaceWireEmulator::Result::Type
+SpaceWireEmulator::deliver(Frame&& frame, Clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while ((mReceiveQueue.size() + mReceiveBuffers.size()) >= mNumberOfReceiveBuffers)
+    {
+        if (!mStarted)
+        {
+            return Result::failure;
+        }
+        if (mReceiveCondition.wait_until(lock, deadline) == std::cv_status::timeout)
+        {
+            return Result::timeout;
+        }
+    }
+
+    // Packets from different senders may overtake each other in a router
+    auto position = std::upper_bound(
+            mReceiveQueue.begin(),
+            mReceiveQueue.end(),
+            frame.arrival,
+            [](const Clock::time_point& arrival, const Frame& queued) {
+                return arrival < queued.arrival;
+            });
+    mReceiveQueue.insert(position, std::move(frame));
+    mReceiveCondition.notify_all();
+    return Result::success;
+}
+
+bool
+SpaceWireEmulator::isStarted() const
+{
+    return mStarted;
+}
+
+SpaceWireEmulator::Result::Type
+SpaceWireEmulator::receivePackets(outpost::Slice<ReceiveBuffer> buffers,
+                                  outpost::time::Duration timeout,
+                                  size_t& count)
+{
+    Clock::time_point deadline = getDeadline(timeout);
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (isRunning())
+    {
+        // All packets which have arrived are taken while holding the lock once
+        Clock::time_point now = Clock::now();
+        while ((count < buffers.getNumberOfElements()) && !mReceiveQueue.empty()
+               && (mReceiveQueue.front().arrival <= now))
+        {
+            Frame& frame = mReceiveQueue.front();
+            mReceiveBuffers.emplace_back();
+            ReceiveBufferEntry& entry = mReceiveBuffers.back();
+            entry.buffer.swap(frame.data);
+            entry.header = ReceiveBuffer(outpost::asSlice(entry.buffer), frame.end);
+            mReceiveQueue.pop_front();
+
+            buffers[count] = entry.header;
+            count++;
+            countReceived(entry.buffer.size());
+        }
+
+        if ((count > 0) || (buffers.getNumberOfElements() == 0))
+        {
+            return Result::success;
+        }
+        if (now >= deadline)
+        {
+            return Result::timeout;
+        }
+
+        Clock::time_point wakeup = deadline;
+        if (!mReceiveQueue.empty())
+        {
+            wakeup = std::min(wakeup, mReceiveQueue.front().arrival);
+        }
+        mReceiveCondition.wait_until(lock, wakeup);
+    }
+    return Result::failure;
+}
+
+void
+SpaceWireEmulator::removeReceiveBuffer(const ReceiveBuffer& buffer)
+{
+    for (auto it = mReceiveBuffers.begin(); it != mReceiveBuffers.end(); ++it)
+    {
+        if (it->header.getData().begin() == buffer.getData().begin())
+        {
+            mReceiveBuffers.erase(it);
+            return;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+class SpaceWireRouterEmulator::Port : public SpaceWireEmulatorPort
+{
+public:
+    Port(SpaceWireRouterEmulator& router, const LinkConfiguration& configuration) :
+        SpaceWireEmulatorPort(configuration),
+        mRouter(router)
+    {
+    }
+
+    Result::Type
+    forward(Frame&& frame, Clock::time_point deadline)
+    {
+        Clock::time_point ready = frame.arrival;
+        return transmit(std::move(frame), ready, deadline);
+    }
+
+protected:
+    virtual Result::Type
+    deliver(Frame&& frame, Clock::time_point deadline) override
+    {
+        countReceived(frame.data.size());
+        return mRouter.forward(std::move(frame), deadline);
+    }
+
+    virtual bool
+    isStarted() const override
+    {
+        // Router ports start automatically
+        return true;
+    }
+
+private:
+    SpaceWireRouterEmulator& mRouter;
+};
+
+SpaceWireRouterEmulator::SpaceWireRouterEmulator(uint8_t numberOfPorts,
+                                                 const LinkConfiguration& configuration) :
+    mPorts(),
+    mRoutes(),
+    mDiscardedPackets(0)
+{
+    numberOfPorts = std::min(numberOfPorts, maximumNumberOfPorts);
+    for (uint8_t i = 0; i < numberOfPorts; i++)
+    {
+        mPorts.emplace_back(new Port(*this, configuration));
+    }
+    for (auto& route : mRoutes)
+    {
+        route = 0;
+    }
+}
+
+SpaceWireRouterEmulator::~SpaceWireRouterEmulator()
+{
+}
+
+SpaceWireEmulatorPort&
+SpaceWireRouterEmulator::getPort(uint8_t port)
+{
+    return *mPorts.at(port - 1);
+}
+
+bool
+SpaceWireRouterEmulator::setRoute(uint8_t logicalAddress, uint8_t port)
+{
+    if ((logicalAddress <= maximumPathAddress) || (port == 0) || (port > mPorts.size()))
+    {
+        return false;
+    }
+    mRoutes[logicalAddress] = port;
+    return true;
+}
+
+size_t
+SpaceWireRouterEmulator::getNumberOfDiscardedPackets() const
+{
+    return mDiscardedPackets;
+}
+
+SpaceWireEmulatorPort::Result::Type
+SpaceWireRouterEmulator::forward(SpaceWireEmulatorPort::Frame&& frame,
+                                 SpaceWireEmulatorPort::Clock::time_point deadline)
+{
+    uint8_t port = 0;
+    if (!frame.data.empty())
+    {
+        uint8_t address = frame.data.front();
+        if (address <= maximumPathAddress)
+        {
+            // Path addresses are removed by the router
+            port = address;
+            frame.data.erase(frame.data.begin());
+        }
+        else
+        {
+            port = mRoutes[address];
+        }
+    }
+
+    if ((port == 0) || (port > mPorts.size()))
+    {
+        // Discarded packets are consumed, the sender does not notice them
+        mDiscardedPackets++;
+        return SpaceWireEmulatorPort::Result::success;
+    }
+
+    SpaceWireEmulatorPort::Result::Type result =
+            mPorts[port - 1]->forward(std::move(frame), deadline);
+    if (result == SpaceWireEmulatorPort::Result::failure)
+    {
+        // Output link not running
+        mDiscardedPackets++;
+        return SpaceWireEmulatorPort::Result::success;
+    }
+    return result;
+}
@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UNITTEST_HAL_SPACEWIRE_EMULATOR_H
+#define UNITTEST_HAL_SPACEWIRE_EMULATOR_H
+
+#include <outpost/hal/spacewire.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace unittest
+{
+namespace hal
+{
+/**
+ * Port of an emulated SpaceWire network.
+ *
+ * Each port owns the transmit direction of the link connected to it. The
+ * link characteristics (bit rate, latency and injected errors) are applied
+ * when a packet leaves the port, the packet is then handed over to the
+ * port on the other end of the link.
+ */
+class SpaceWireEmulatorPort
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef outpost::hal::SpaceWire::Result Result;
+    typedef outpost::hal::SpaceWire::EndMarker EndMarker;
+
+    struct LinkConfiguration
+    {
+        LinkConfiguration() :
+            bitRate(0),
+            latency(outpost::time::Duration::zero()),
+            dropProbability(0.0),
+            eepProbability(0.0),
+            seed(1)
+        {
+        }
+
+        /// Link bit rate in bit/s, zero disables the transmission delay
+        uint64_t bitRate;
+
+        /// Constant delay added to every packet, e.g. for cables and routers
+        outpost::time::Duration latency;
+
+        /// Probability for a packet to be lost on the link
+        double dropProbability;
+
+        /// Probability for a packet to be truncated and terminated by an EEP
+        double eepProbability;
+
+        /// Seed for the random error injection, allows reproducible runs
+        uint32_t seed;
+    };
+
+    enum class Fault
+    {
+        drop,
+        eep
+    };
+
+    struct Statistics
+    {
+        Statistics() :
+            mSentPackets(0),
+            mSentBytes(0),
+            mReceivedPackets(0),
+            mReceivedBytes(0),
+            mDroppedPackets(0),
+            mErrorPackets(0)
+        {
+        }
+
+        size_t mSentPackets;
+        size_t mSentBytes;
+        size_t mReceivedPackets;
+        size_t mReceivedBytes;
+
+        /// Packets lost on the transmit side of the link
+        size_t mDroppedPackets;
+
+        /// Packets terminated by an EEP on the transmit side of the link
+        size_t mErrorPackets;
+    };
+
+    /**
+     * Packet on its way through the network.
+     */
+    struct Frame
+    {
+        std::vector<uint8_t> data;
+        EndMarker end;
+
+        /// Point in time the last character of the packet has been received
+        Clock::time_point arrival;
+    };
+
+    explicit SpaceWireEmulatorPort(const LinkConfiguration& configuration);
+
+    virtual ~SpaceWireEmulatorPort();
+
+    /**
+     * Connect two ports with a link.
+     *
+     * Existing connections of the two ports are removed.
+     */
+    static void
+    connect(SpaceWireEmulatorPort& first, SpaceWireEmulatorPort& second);
+
+    /**
+     * Remove the link of this port, e.g. to emulate a cable failure.
+     */
+    void
+    disconnect();
+
+    /**
+     * Inject an error into the next packet sent by this port.
+     *
+     * Injected faults are queued and take precedence over the random
+     * error injection.
+     */
+    void
+    injectFault(Fault fault);
+
+    Statistics
+    getStatistics();
+
+    /**
+     * Time needed to transmit a packet with the configured bit rate.
+     *
+     * Data characters are 10 bit long, the end marker 4 bit.
+     */
+    Clock::duration
+    getTransmissionTime(size_t length) const;
+
+protected:
+    /**
+     * Send a packet over the link of this port.
+     *
+     * \param ready
+     *      Point in time the packet is ready for transmission.
+     * \param deadline
+     *      Point in time until which to wait for receive buffers on the
+     *      other end of the link.
+     */
+    Result::Type
+    transmit(Frame&& frame, Clock::time_point ready, Clock::time_point deadline);
+
+    /**
+     * Accept a packet from the link.
+     *
+     * May block until \p deadline to emulate the flow control of
+     * SpaceWire if no receive buffers are available.
+     */
+    virtual Result::Type
+    deliver(Frame&& frame, Clock::time_point deadline) = 0;
+
+    /**
+     * Check if the port accepts a link connection.
+     */
+    virtual bool
+    isStarted() const = 0;
+
+    /**
+     * Check if both ends of the link are started.
+     */
+    bool
+    isRunning() const;
+
+    void
+    countReceived(size_t length);
+
+    static Clock::time_point
+    getDeadline(outpost::time::Duration timeout);
+
+private:
+    bool
+    selectFault(Fault& fault);
+
+    const LinkConfiguration mConfiguration;
+    std::atomic<SpaceWireEmulatorPort*> mPeer;
+
+    /// Protects the transmit direction of the link
+    std::mutex mLinkMutex;
+    Clock::time_point mLinkFreeAt;
+    std::deque<Fault> mInjectedFaults;
+    std::minstd_rand mRandom;
+
+    Statistics mStatistics;
+};
+
+/**
+ * Emulated SpaceWire interface.
+ *
+ * Counterpart to the SpaceWireStub which includes the timing of a real
+ * link. Two interfaces are connected directly or through a
+ * SpaceWireRouterEmulator. The link comes up after both connected
+ * interfaces are started.
+ *
+ * Received packets are available after the transmission time and latency
+ * of all links on their way have passed. Every packet occupies a receive
+ * buffer from the time it is sent until it is released by the receiver.
+ * A sender waits for a free receive buffer up to its send timeout,
+ * emulating the flow control of SpaceWire. A send operation does not wait
+ * for the transmission itself, the link is occupied until the packet has
+ * been transmitted and further packets queue up behind it.
+ *
+ * Packets sent with a partial end marker are collected and transmitted
+ * together with the following part which carries the end marker.
+ */
+class SpaceWireEmulator : public outpost::hal::SpaceWire, public SpaceWireEmulatorPort
+{
+public:
+    using outpost::hal::SpaceWire::EndMarker;
+    using outpost::hal::SpaceWire::Result;
+
+    struct Configuration
+    {
+        Configuration() :
+            maximumPacketLength(4096),
+            numberOfTransmitBuffers(4),
+            numberOfReceiveBuffers(16),
+            link()
+        {
+        }
+
+        size_t maximumPacketLength;
+        size_t numberOfTransmitBuffers;
+        size_t numberOfReceiveBuffers;
+
+        /// Characteristics of the outgoing link
+        LinkConfiguration link;
+    };
+
+    explicit SpaceWireEmulator(const Configuration& configuration = Configuration());
+
+    virtual ~SpaceWireEmulator();
+
+    virtual size_t
+    getMaximumPacketLength() const override;
+
+    virtual bool
+    open() override;
+
+    virtual void
+    close() override;
+
+    virtual bool
+    up(outpost::time::Duration timeout) override;
+
+    virtual void
+    down(outpost::time::Duration timeout) override;
+
+    virtual bool
+    isUp() override;
+
+    virtual Result::Type
+    requestBuffer(TransmitBuffer*& buffer, outpost::time::Duration timeout) override;
+
+    virtual Result::Type
+    send(TransmitBuffer* buffer, outpost::time::Duration timeout) override;
+
+    virtual Result::Type
+    sendSegments(const TransmitDescriptor& packet, outpost::time::Duration timeout) override;
+
+    virtual Result::Type
+    receive(ReceiveBuffer& buffer, outpost::time::Duration timeout) override;
+
+    virtual void
+    releaseBuffer(const ReceiveBuffer& buffer) override;
+
+    virtual size_t
+    receiveBuffers(outpost::Slice<ReceiveBuffer> buffers,
+                   outpost::time::Duration timeout) override;
+
+    virtual void
+    releaseBuffers(outpost::Slice<const ReceiveBuffer> buffers) override;
+
+    virtual void
+    flushReceiveBuffer() override;
+
+    /**
+     * Number of packets sent to this interface which have not been received yet.
+     */
+    size_t
+    getNumberOfPendingPackets();
+
+protected:
+    virtual Result::Type
+    deliver(Frame&& frame, Clock::time_point deadline) override;
+
+    virtual bool
+    isStarted() const override;
+
+private:
+    Result::Type
+    receivePackets(outpost::Slice<ReceiveBuffer> buffers,
+                   outpost::time::Duration timeout,
+                   size_t& count);
+
+    void
+    removeReceiveBuffer(const ReceiveBuffer& buffer);
+
+    struct TransmitBufferEntry
+    {
+        explicit TransmitBufferEntry(size_t maximumLength) :
+            buffer(maximumLength, 0),
+            header(outpost::asSlice(buffer)),
+            used(false)
+        {
+        }
+
+        std::vector<uint8_t> buffer;
+        TransmitBuffer header;
+        bool used;
+    };
+
+    struct ReceiveBufferEntry
+    {
+        std::vector<uint8_t> buffer;
+        ReceiveBuffer header;
+    };
+
+    const size_t mMaximumLength;
+    const size_t mNumberOfReceiveBuffers;
+
+    std::atomic<bool> mOpen;
+    std::atomic<bool> mStarted;
+
+    std::mutex mMutex;
+    std::condition_variable mTransmitCondition;
+    std::condition_variable mReceiveCondition;
+
+    std::vector<std::unique_ptr<TransmitBufferEntry>> mTransmitBuffers;
+
+    /// Data of packets sent with a partial end marker
+    std::vector<uint8_t> mPartialPacket;
+
+    /// Packets ordered by their arrival time
+    std::deque<Frame> mReceiveQueue;
+
+    /// Packets handed out to the application
+    std::list<ReceiveBufferEntry> mReceiveBuffers;
+};
+
+/**
+ * Emulated SpaceWire router.
+ *
+ * Packets starting with a path address (1 to 31) are forwarded to the
+ * port with that number, the path address is removed. Packets starting
+ * with a logical address (32 to 255) are forwarded according to the
+ * routing table, the logical address is kept. Packets for the
+ * configuration port 0, for unknown ports and without a route are
+ * discarded.
+ *
+ * The router forwards a packet after it has been received completely
+ * (store-and-forward), the latency configured for the ports is added for
+ * every hop.
+ */
+class SpaceWireRouterEmulator
+{
+public:
+    typedef SpaceWireEmulatorPort::LinkConfiguration LinkConfiguration;
+
+    static constexpr uint8_t maximumNumberOfPorts = 31;
+
+    /**
+     * \param numberOfPorts
+     *      Number of external ports, numbered from 1.
+     * \param configuration
+     *      Characteristics of the outgoing links of all ports.
+     */
+    SpaceWireRouterEmulator(uint8_t numberOfPorts,
+                            const LinkConfiguration& configuration = LinkConfiguration());
+
+    ~SpaceWireRouterEmulator();
+
+    /**
+     * Access a port to connect it to an interface or another router.
+     *
+     * \param port
+     *      Port number from 1 to the number of ports.
+     */
+    SpaceWireEmulatorPort&
+    getPort(uint8_t port);
+
+    /**
+     * Forward packets for a logical address to a port.
+     *
+     * \retval true     Route set.
+     * \retval false    Logical address or port invalid.
+     */
+    bool
+    setRoute(uint8_t logicalAddress, uint8_t port);
+
+    /**
+     * Number of packets discarded because of an invalid address or a
+     * missing route.
+     */
+    size_t
+    getNumberOfDiscardedPackets() const;
+
+private:
+    class Port;
+
+    SpaceWireEmulatorPort::Result::Type
+    forward(SpaceWireEmulatorPort::Frame&& frame,
+            SpaceWireEmulatorPort::Clock::time_point deadline);
+
+    std::vector<std::unique_ptr<Port>> mPorts;
+
+    /// Output port for each logical address, zero if no route is set
+    std::atomic<uint8_t> mRoutes[256];
+    std::atomic<size_t> mDiscardedPackets;
+};
+
+}  // namespace hal
+}  // namespace unittest
+
+#endif
@@ -111,7 +111,11 @@ SpaceWireStub::Result::Type
 SpaceWireStub::receive(ReceiveBuffer& buffer, outpost::time::Duration /*timeout*/)
 {
     Result::Type result = Result::success;
-    if (mUp)
+    if (mUp && mPacketsToReceive.empty())
+    {
+        result = Result::timeout;
+    }
+    else if (mUp)
     {
         std::unique_ptr<ReceiveBufferEntry> entry(new ReceiveBufferEntry(
                 std::move(mPacketsToReceive.front().data), mPacketsToReceive.front().end));
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_SMPC_SUBSCRIBER_LIST_H
+#define OUTPOST_SMPC_SUBSCRIBER_LIST_H
+
+#include <stddef.h>
+
+#include <atomic>
+
+namespace outpost
+{
+namespace smpc
+{
+/**
+ * List of the subscriptions of a topic with lock-free read access.
+ *
+ * Follows the read-copy-update scheme: Publishers traverse an immutable
+ * list without taking a lock. Changes to the subscriptions build a new
+ * version of the lists of all topics, which is then activated by
+ * atomically switching the generation index. The previous version is only
+ * reused after all publishers still traversing it have finished.
+ *
+ * No memory is allocated. Instead every subscription contains one link
+ * per generation, so that a new list can be build while the old one is
+ * still in use.
+ *
+ * Changes to the lists are not thread-safe, the creation and destruction
+ * of subscriptions has to be serialized by the application.
+ *
+ * \tparam T
+ *      Subscription type.
+ */
+template <typename T>
+class SubscriberList
+{
+public:
+    /// Number of list versions which can exist at the same time
+    static constexpr size_t numberOfGenerations = 2;
+
+    /**
+     * Link to the next subscription of the same topic, embedded into
+     * the subscriptions.
+     */
+    class Link
+    {
+    public:
+        inline Link() : mNext()
+        {
+        }
+
+    private:
+        friend class SubscriberList;
+
+        T* mNext[numberOfGenerations];
+    };
+
+    /**
+     * Read access to the list during a publish operation.
+     *
+     * Pins the currently active version of the list until the reader is
+     * destroyed. Changes to the subscriptions wait until all readers of
+     * the previous version have finished.
+     */
+    class Reader
+    {
+    public:
+        inline explicit Reader(const SubscriberList& list);
+
+        inline ~Reader();
+
+        inline T*
+        getFirst() const
+        {
+            return mList.mHead[mGeneration].load(std::memory_order_acquire);
+        }
+
+        inline T*
+        getNext(const Link& link) const
+        {
+            return link.mNext[mGeneration];
+        }
+
+    private:
+        // disable copy constructor
+        Reader(const Reader&) = delete;
+
+        // disable assignment operator
+        Reader&
+        operator=(const Reader&) = delete;
+
+        const SubscriberList& mList;
+        size_t mGeneration;
+    };
+
+    inline SubscriberList() : mHead(), mReaders()
+    {
+        for (size_t i = 0; i < numberOfGenerations; ++i)
+        {
+            mHead[i] = nullptr;
+            mReaders[i] = 0;
+        }
+    }
+
+    // disable copy constructor
+    SubscriberList(const SubscriberList&) = delete;
+
+    // disable assignment operator
+    SubscriberList&
+    operator=(const SubscriberList&) = delete;
+
+    /**
+     * Get the generation which can be modified without affecting
+     * concurrent readers.
+     */
+    static inline size_t
+    getInactiveGeneration()
+    {
+        return (activeGeneration.load() + 1) % numberOfGenerations;
+    }
+
+    /**
+     * Make the given generation visible to all subsequent readers.
+     *
+     * Readers of the previous generation may still be active, use
+     * waitForReaders() before reusing it.
+     */
+    static inline void
+    activateGeneration(size_t generation)
+    {
+        // Must be sequentially consistent, see waitForReaders()
+        activeGeneration.store(generation, std::memory_order_seq_cst);
+    }
+
+    /**
+     * Remove all subscriptions from the given (inactive) generation.
+     */
+    inline void
+    clear(size_t generation)
+    {
+        mHead[generation].store(nullptr, std::memory_order_relaxed);
+    }
+
+    /**
+     * Add a subscription to the given (inactive) generation.
+     */
+    inline void
+    prepend(T* subscription, Link& link, size_t generation)
+    {
+        link.mNext[generation] = mHead[generation].load(std::memory_order_relaxed);
+        mHead[generation].store(subscription, std::memory_order_relaxed);
+    }
+
+    /**
+     * Wait until all readers of the given generation have finished.
+     *
+     * \warning
+     *      Must not be called from within a subscriber, the function
+     *      would wait for itself.
+     */
+    void
+    waitForReaders(size_t generation) const;
+
+private:
+    static std::atomic<size_t> activeGeneration;
+
+    std::atomic<T*> mHead[numberOfGenerations];
+
+    /// Number of readers currently accessing the lists of each generation
+    mutable std::atomic<size_t> mReaders[numberOfGenerations];
+};
+
+}  // namespace smpc
+}  // namespace outpost
+
+#include "subscriber_list_impl.h"
+
+#endif
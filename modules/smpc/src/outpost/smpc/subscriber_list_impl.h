@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef OUTPOST_SMPC_SUBSCRIBER_LIST_IMPL_H
+#define OUTPOST_SMPC_SUBSCRIBER_LIST_IMPL_H
+
+#include "subscriber_list.h"
+
+#include <outpost/rtos/thread.h>
+#include <outpost/time/duration.h>
+
+template <typename T>
+constexpr size_t outpost::smpc::SubscriberList<T>::numberOfGenerations;
+
+template <typename T>
+std::atomic<size_t> outpost::smpc::SubscriberList<T>::activeGeneration(0);
+
+// ----------------------------------------------------------------------------
+template <typename T>
+outpost::smpc::SubscriberList<T>::Reader::Reader(const SubscriberList& list) :
+    mList(list),
+    mGeneration(0)
+{
+    // The generation may change between loading it and registering the
+    // reader. In that case the writer might not have seen the reader and
+    // already modifies the lists, therefore the check is repeated.
+    bool registered = false;
+    while (!registered)
+    {
+        mGeneration = activeGeneration.load();
+        // Sequentially consistent, see waitForReaders()
+        mList.mReaders[mGeneration].fetch_add(1, std::memory_order_seq_cst);
+        if (activeGeneration.load(std::memory_order_seq_cst) == mGeneration)
+        {
+            registered = true;
+        }
+        else
+        {
+            mList.mReaders[mGeneration].fetch_sub(1);
+        }
+    }
+}
+
+template <typename T>
+outpost::smpc::SubscriberList<T>::Reader::~Reader()
+{
+    mList.mReaders[mGeneration].fetch_sub(1, std::memory_order_release);
+}
+
+template <typename T>
+void
+outpost::smpc::SubscriberList<T>::waitForReaders(size_t generation) const
+{
+    // The load has to be sequentially consistent. Together with the
+    // sequentially consistent store in activateGeneration() and the
+    // reader's increment followed by a reload of the generation, this
+    // forms a store-buffering pattern: only a total order over these
+    // four operations ensures that the writer cannot see no readers while
+    // a reader still sees the previous generation. An acquire load would
+    // allow both, and the list could be rebuilt during a traversal.
+    while (mReaders[generation].load(std::memory_order_seq_cst) != 0)
+    {
+        // Sleep instead of yield, the reader might run with a lower
+        // priority than the thread changing the subscriptions.
+        outpost::rtos::Thread::sleep(outpost::time::Milliseconds(1));
+    }
+}
+
+#endif
@@ -19,31 +19,31 @@ outpost::smpc::Subscription::~Subscription()
 {
     removeFromList(&Subscription::listOfAllSubscriptions, this);
 
-    // TODO
-    releaseAllSubscriptions();
+    // Replaces the lists without interrupting the delivery to the
+    // remaining subscriptions
     connectSubscriptionsToTopics();
 }
 
 void
 outpost::smpc::Subscription::connectSubscriptionsToTopics()
 {
-    // Reset the lists in the topics
-    TopicBase::clearSubscriptions();
+    // Build new lists in the topics while publishers may still use the
+    // active ones
+    const size_t generation = SubscriberList<Subscription>::getInactiveGeneration();
+    TopicBase::clearSubscriptions(generation);
 
     for (Subscription* it = Subscription::listOfAllSubscriptions; it != 0; it = it->getNext())
     {
-        it->mNextTopicSubscription = it->mTopic->mSubscriptions;
-        it->mTopic->mSubscriptions = it;
+        it->mTopic->mSubscriptions.prepend(it, it->mNextTopicSubscription, generation);
     }
+
+    TopicBase::activateSubscriptions(generation);
 }
 
 void
 outpost::smpc::Subscription::releaseAllSubscriptions()
 {
-    for (Subscription* it = Subscription::listOfAllSubscriptions; it != 0; it = it->getNext())
-    {
-        it->mNextTopicSubscription = 0;
-    }
-
-    TopicBase::clearSubscriptions();
+    const size_t generation = SubscriberList<Subscription>::getInactiveGeneration();
+    TopicBase::clearSubscriptions(generation);
+    TopicBase::activateSubscriptions(generation);
 }
@@ -77,6 +77,10 @@ public:
      *     destroyed outside the initialization of the application
      *     it is necessary to hold all other threads which
      *     might also create or destroy topics and/or subscriptions.
+     *
+     *     Waits until all running publish operations have finished.
+     *     A subscription must therefore not be destroyed from within
+     *     a subscriber function.
      */
     ~Subscription();
 
@@ -87,7 +91,9 @@ public:
      * Publisher<>Subscriber protocol.
      *
      * \internal
-     * Builds the internal linked lists.
+     * Builds a new version of the internal linked lists and waits until
+     * all publishers still using the previous version have finished.
+     * Must not be called from within a subscriber function.
      */
     static void
     connectSubscriptionsToTopics();
@@ -134,7 +140,7 @@ private:
      * subscriptions to their corresponding topics.
      */
     TopicBase* const mTopic;
-    Subscription* mNextTopicSubscription;
+    SubscriberList<Subscription>::Link mNextTopicSubscription;
 
     /**
      * Base-type to cast all member function pointers to. The correct type
@@ -159,7 +165,7 @@ outpost::smpc::Subscription::Subscription(Topic<T>& topic,
                                           typename SubscriberFunction<T, S>::Type function) :
     ImplicitList<Subscription>(listOfAllSubscriptions, this),
     mTopic(&topic),
-    mNextTopicSubscription(0),
+    mNextTopicSubscription(),
     mFunctor(*reinterpret_cast<Subscriber*>(subscriber), reinterpret_cast<Function>(function))
 {
 }
@@ -19,29 +19,29 @@ outpost::smpc::SubscriptionRaw::~SubscriptionRaw()
 {
     removeFromList(&SubscriptionRaw::listOfAllSubscriptions, this);
 
-    releaseAllSubscriptions();
+    // Replaces the lists without interrupting the delivery to the
+    // remaining subscriptions
     connectSubscriptionsToTopics();
 }
 
 void
 outpost::smpc::SubscriptionRaw::connectSubscriptionsToTopics()
 {
-    TopicRaw::clearSubscriptions();
+    const size_t generation = SubscriberList<SubscriptionRaw>::getInactiveGeneration();
+    TopicRaw::clearSubscriptions(generation);
 
     for (SubscriptionRaw* it = listOfAllSubscriptions; it != 0; it = it->getNext())
     {
-        it->mNextTopicSubscription = it->mTopic->mSubscriptions;
-        it->mTopic->mSubscriptions = it;
+        it->mTopic->mSubscriptions.prepend(it, it->mNextTopicSubscription, generation);
     }
+
+    TopicRaw::activateSubscriptions(generation);
 }
 
 void
 outpost::smpc::SubscriptionRaw::releaseAllSubscriptions()
 {
-    for (SubscriptionRaw* it = listOfAllSubscriptions; it != 0; it = it->getNext())
-    {
-        it->mNextTopicSubscription = 0;
-    }
-
-    TopicRaw::clearSubscriptions();
+    const size_t generation = SubscriberList<SubscriptionRaw>::getInactiveGeneration();
+    TopicRaw::clearSubscriptions(generation);
+    TopicRaw::activateSubscriptions(generation);
 }
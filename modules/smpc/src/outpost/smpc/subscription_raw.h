@@ -69,6 +69,10 @@ public:
      *             destroyed outside the initialization of the application
      *             it is necessary to hold all other threads which
      *             might also create or destroy topics and/or subscriptions.
+     *
+     *             Waits until all running publish operations have
+     *             finished. A subscription must therefore not be destroyed
+     *             from within a subscriber function.
      */
     ~SubscriptionRaw();
 
@@ -79,7 +83,9 @@ public:
      * Publisher<>Subscriber protocol.
      *
      * \internal
-     * Builds the internal linked lists.
+     * Builds a new version of the internal linked lists and waits until
+     * all publishers still using the previous version have finished.
+     * Must not be called from within a subscriber function.
      */
     static void
     connectSubscriptionsToTopics();
@@ -112,7 +118,7 @@ private:
     // Used by Subscription::connect to map the subscriptions to
     // their corresponding topics.
     TopicRaw* const mTopic;
-    SubscriptionRaw* mNextTopicSubscription;
+    SubscriberList<SubscriptionRaw>::Link mNextTopicSubscription;
 };
 
 // ----------------------------------------------------------------------------
@@ -124,7 +130,7 @@ SubscriptionRaw::SubscriptionRaw(TopicRaw& topic,
     ImplicitList<SubscriptionRaw>(listOfAllSubscriptions, this),
     Functor2<void(const void* message, size_t length)>(*subscriber, function),
     mTopic(&topic),
-    mNextTopicSubscription(0)
+    mNextTopicSubscription()
 {
 }
 
@@ -15,13 +15,11 @@
 
 #include "subscription.h"
 
-#include <outpost/rtos/mutex_guard.h>
-
 outpost::smpc::TopicBase* outpost::smpc::TopicBase::listOfAllTopics = nullptr;
 
 outpost::smpc::TopicBase::TopicBase() :
     ImplicitList<TopicBase>(listOfAllTopics, this),
-    mSubscriptions(nullptr)
+    mSubscriptions()
 {
 }
 
@@ -33,20 +31,34 @@ outpost::smpc::TopicBase::~TopicBase()
 void
 outpost::smpc::TopicBase::publishTypeUnsafe(void* message) const
 {
-    rtos::MutexGuard lock(mMutex);
+    SubscriberList<Subscription>::Reader reader(mSubscriptions);
 
-    for (Subscription* subscription = mSubscriptions; subscription != nullptr;
-         subscription = subscription->mNextTopicSubscription)
+    for (Subscription* subscription = reader.getFirst(); subscription != nullptr;
+         subscription = reader.getNext(subscription->mNextTopicSubscription))
     {
         subscription->execute(message);
     }
 }
 
 void
-outpost::smpc::TopicBase::clearSubscriptions()
+outpost::smpc::TopicBase::clearSubscriptions(size_t generation)
 {
     for (TopicBase* it = listOfAllTopics; it != nullptr; it = it->getNext())
     {
-        it->mSubscriptions = nullptr;
+        it->mSubscriptions.clear(generation);
+    }
+}
+
+void
+outpost::smpc::TopicBase::activateSubscriptions(size_t generation)
+{
+    const size_t previousGeneration =
+            (generation + SubscriberList<Subscription>::numberOfGenerations - 1)
+            % SubscriberList<Subscription>::numberOfGenerations;
+
+    SubscriberList<Subscription>::activateGeneration(generation);
+    for (TopicBase* it = listOfAllTopics; it != nullptr; it = it->getNext())
+    {
+        it->mSubscriptions.waitForReaders(previousGeneration);
     }
 }
@@ -14,7 +14,8 @@
 #ifndef OUTPOST_SMPC_TOPIC_H
 #define OUTPOST_SMPC_TOPIC_H
 
-#include <outpost/rtos/mutex.h>
+#include "subscriber_list.h"
+
 #include <outpost/utils/container/implicit_list.h>
 #include <outpost/utils/meta.h>
 
@@ -74,7 +75,8 @@ public:
      * Publish new data.
      *
      * Forwards the pointer to all connected subscribers. This
-     * function is thread safe.
+     * function is thread safe and does not block, multiple threads
+     * may publish to the same topic concurrently.
      */
     void
     publishTypeUnsafe(void* message) const;
@@ -84,14 +86,23 @@ protected:
     static TopicBase* listOfAllTopics;
 
 private:
+    /**
+     * Remove all subscriptions from the given generation of the
+     * subscription lists of all topics.
+     */
     static void
-    clearSubscriptions();
+    clearSubscriptions(size_t generation);
 
-    /// Used to protect the publish() method
-    mutable rtos::Mutex mMutex;
+    /**
+     * Make the given generation of the subscription lists visible to
+     * publishers and wait until all publishers using the previous
+     * generation have finished.
+     */
+    static void
+    activateSubscriptions(size_t generation);
 
-    /// Pointer to the list of subscriptions
-    Subscription* mSubscriptions;
+    /// List of the subscriptions, read without locking by publish()
+    SubscriberList<Subscription> mSubscriptions;
 };
 
 /**
@@ -15,13 +15,11 @@
 
 #include "subscription_raw.h"
 
-#include <outpost/rtos/mutex_guard.h>
-
 outpost::smpc::TopicRaw* outpost::smpc::TopicRaw::listOfAllTopics = 0;
 
 outpost::smpc::TopicRaw::TopicRaw() :
     ImplicitList<TopicRaw>(listOfAllTopics, this),
-    mSubscriptions(0)
+    mSubscriptions()
 {
 }
 
@@ -33,20 +31,34 @@ outpost::smpc::TopicRaw::~TopicRaw()
 void
 outpost::smpc::TopicRaw::publish(const void* message, size_t length)
 {
-    rtos::MutexGuard lock(mMutex);
+    SubscriberList<SubscriptionRaw>::Reader reader(mSubscriptions);
 
-    for (SubscriptionRaw* subscription = mSubscriptions; subscription != 0;
-         subscription = subscription->mNextTopicSubscription)
+    for (SubscriptionRaw* subscription = reader.getFirst(); subscription != 0;
+         subscription = reader.getNext(subscription->mNextTopicSubscription))
     {
         subscription->execute(message, length);
     }
 }
 
 void
-outpost::smpc::TopicRaw::clearSubscriptions()
+outpost::smpc::TopicRaw::clearSubscriptions(size_t generation)
 {
     for (TopicRaw* it = listOfAllTopics; it != 0; it = it->getNext())
     {
-        it->mSubscriptions = 0;
+        it->mSubscriptions.clear(generation);
+    }
+}
+
+void
+outpost::smpc::TopicRaw::activateSubscriptions(size_t generation)
+{
+    const size_t previousGeneration =
+            (generation + SubscriberList<SubscriptionRaw>::numberOfGenerations - 1)
+            % SubscriberList<SubscriptionRaw>::numberOfGenerations;
+
+    SubscriberList<SubscriptionRaw>::activateGeneration(generation);
+    for (TopicRaw* it = listOfAllTopics; it != 0; it = it->getNext())
+    {
+        it->mSubscriptions.waitForReaders(previousGeneration);
     }
 }
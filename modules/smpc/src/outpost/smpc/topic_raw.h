@@ -14,7 +14,8 @@
 #ifndef OUTPOST_SMPC_TOPIC_RAW_H
 #define OUTPOST_SMPC_TOPIC_RAW_H
 
-#include <outpost/rtos/mutex.h>
+#include "subscriber_list.h"
+
 #include <outpost/utils/container/implicit_list.h>
 #include <outpost/utils/meta.h>
 
@@ -72,7 +73,9 @@ public:
     /**
      * Publish new data.
      *
-     * Forwards the pointer to all connected subscribers.
+     * Forwards the pointer to all connected subscribers. Does not
+     * block, multiple threads may publish to the same topic
+     * concurrently.
      */
     void
     publish(const void* message, size_t length);
@@ -86,16 +89,16 @@ private:
     operator=(const TopicRaw&);
 
     static void
-    clearSubscriptions();
+    clearSubscriptions(size_t generation);
+
+    static void
+    activateSubscriptions(size_t generation);
 
     /// List of all raw topics currently active.
     static TopicRaw* listOfAllTopics;
 
-    /// Mutex used to protect the publish() method.
-    rtos::Mutex mMutex;
-
-    /// Pointer to the list of mSubscriptions
-    SubscriptionRaw* mSubscriptions;
+    /// List of the subscriptions, read without locking by publish()
+    SubscriberList<SubscriptionRaw> mSubscriptions;
 };
 
 }  // namespace smpc
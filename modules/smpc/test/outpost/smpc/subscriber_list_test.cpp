@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/smpc/subscriber_list.h>
+#include <outpost/smpc/subscription.h>
+#include <outpost/smpc/topic.h>
+
+#include <unittest/harness.h>
+#include <unittest/smpc/testing_subscription.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using outpost::smpc::SubscriberList;
+
+namespace
+{
+struct Element
+{
+    explicit Element(int v) : value(v), link()
+    {
+    }
+
+    int value;
+    SubscriberList<Element>::Link link;
+};
+
+std::vector<int>
+getValues(const SubscriberList<Element>& list)
+{
+    std::vector<int> values;
+    SubscriberList<Element>::Reader reader(list);
+    for (Element* element = reader.getFirst(); element != nullptr;
+         element = reader.getNext(element->link))
+    {
+        values.push_back(element->value);
+    }
+    return values;
+}
+
+void
+activate(SubscriberList<Element>& list, size_t generation)
+{
+    size_t previous = (generation + 1) % SubscriberList<Element>::numberOfGenerations;
+    SubscriberList<Element>::activateGeneration(generation);
+    list.waitForReaders(previous);
+}
+}  // namespace
+
+TEST(SubscriberListTest, shouldKeepActiveListWhileBuildingNewOne)
+{
+    SubscriberList<Element> list;
+    Element first(1);
+    Element second(2);
+
+    size_t generation = SubscriberList<Element>::getInactiveGeneration();
+    list.clear(generation);
+    list.prepend(&first, first.link, generation);
+    list.prepend(&second, second.link, generation);
+    activate(list, generation);
+    EXPECT_EQ(std::vector<int>({2, 1}), getValues(list));
+
+    // The new list is not visible before it is activated
+    generation = SubscriberList<Element>::getInactiveGeneration();
+    list.clear(generation);
+    list.prepend(&first, first.link, generation);
+    EXPECT_EQ(std::vector<int>({2, 1}), getValues(list));
+
+    activate(list, generation);
+    EXPECT_EQ(std::vector<int>({1}), getValues(list));
+}
+
+TEST(SubscriberListTest, readerShouldUsePinnedList)
+{
+    SubscriberList<Element> list;
+    Element first(1);
+
+    size_t generation = SubscriberList<Element>::getInactiveGeneration();
+    list.clear(generation);
+    list.prepend(&first, first.link, generation);
+    activate(list, generation);
+
+    std::atomic<bool> finished(false);
+    std::thread writer;
+    {
+        SubscriberList<Element>::Reader reader(list);
+
+        generation = SubscriberList<Element>::getInactiveGeneration();
+        list.clear(generation);
+        writer = std::thread([&]() {
+            activate(list, generation);
+            finished = true;
+        });
+
+        // Writer has to wait for the reader of the previous list
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_FALSE(finished);
+        EXPECT_EQ(&first, reader.getFirst());
+    }
+
+    writer.join();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(std::vector<int>(), getValues(list));
+}
+
+// ----------------------------------------------------------------------------
+namespace
+{
+class BlockingComponent : public outpost::smpc::Subscriber
+{
+public:
+    BlockingComponent() : mBlock(false), mEntered(0), mReceived(0)
+    {
+    }
+
+    void
+    onReceive(const uint32_t*)
+    {
+        mEntered++;
+        while (mBlock)
+        {
+            std::this_thread::yield();
+        }
+        mReceived++;
+    }
+
+    std::atomic<bool> mBlock;
+    std::atomic<uint32_t> mEntered;
+    std::atomic<uint32_t> mReceived;
+};
+}  // namespace
+
+class ConcurrentPublishTest : public ::testing::Test
+{
+public:
+    virtual void
+    TearDown() override
+    {
+        unittest::smpc::TestingSubscription::releaseAllSubscriptions();
+    }
+
+    BlockingComponent mComponent;
+    outpost::smpc::Topic<const uint32_t> mTopic;
+};
+
+TEST_F(ConcurrentPublishTest, shouldNotBlockOtherPublishers)
+{
+    outpost::smpc::Subscription subscription(mTopic, &mComponent, &BlockingComponent::onReceive);
+    unittest::smpc::TestingSubscription::connectSubscriptionsToTopics();
+
+    // All publishers are inside the subscriber at the same time, none
+    // of them waits for the others
+    const uint32_t value = 1;
+    const uint32_t numberOfPublishers = 5;
+    mComponent.mBlock = true;
+
+    std::vector<std::thread> publishers;
+    for (size_t i = 0; i < numberOfPublishers; ++i)
+    {
+        publishers.emplace_back([&]() { mTopic.publish(value); });
+    }
+    while (mComponent.mEntered < numberOfPublishers)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(0U, mComponent.mReceived);
+
+    mComponent.mBlock = false;
+    for (std::thread& thread : publishers)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(numberOfPublishers, mComponent.mReceived);
+}
+
+TEST_F(ConcurrentPublishTest, shouldWaitForRunningPublishersWhenUnsubscribing)
+{
+    outpost::smpc::Subscription* subscription = new outpost::smpc::Subscription(
+            mTopic, &mComponent, &BlockingComponent::onReceive);
+    unittest::smpc::TestingSubscription::connectSubscriptionsToTopics();
+
+    const uint32_t value = 1;
+    mComponent.mBlock = true;
+    std::thread blocked([&]() { mTopic.publish(value); });
+    while (mComponent.mEntered == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    std::atomic<bool> deleted(false);
+    std::thread remover([&]() {
+        delete subscription;
+        deleted = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(deleted);
+
+    mComponent.mBlock = false;
+    blocked.join();
+    remover.join();
+    EXPECT_TRUE(deleted);
+
+    // Removed subscription is no longer called
+    mTopic.publish(value);
+    EXPECT_EQ(1U, mComponent.mReceived);
+}
@@ -34,8 +34,9 @@ TestingTopicBase::dumpConnectedSubscriptions(outpost::smpc::TopicBase& base)
 {
     printf("topic %p\n", reinterpret_cast<void*>(this));
 
-    for (Subscription* topic = base.mSubscriptions; topic != 0;
-         topic = topic->mNextTopicSubscription)
+    SubscriberList<Subscription>::Reader reader(base.mSubscriptions);
+    for (Subscription* topic = reader.getFirst(); topic != 0;
+         topic = reader.getNext(topic->mNextTopicSubscription))
     {
         printf("- %p\n", reinterpret_cast<void*>(topic));
     }
@@ -135,8 +135,119 @@ public:
     decode(outpost::Slice<const uint8_t> input, uint8_t* output);
 };
 
+/**
+ * Incremental COBS decoder for a stream of frames separated by zero bytes.
+ *
+ * The input stream can be passed in chunks of arbitrary size, e.g. as
+ * received from a serial interface. Every byte is inspected only once and
+ * the decoded data is written directly into the output buffer of the
+ * current frame. Zero bytes delimit the frames, consecutive delimiters are
+ * skipped.
+ *
+ * \code
+ * decoder.reset(frameBuffer);
+ * while (...)
+ * {
+ *     size_t consumed = decoder.decode(chunk);
+ *     if (decoder.isFrameComplete())
+ *     {
+ *         if (decoder.isValid())
+ *         {
+ *             // decoder.getLength() bytes decoded in frameBuffer
+ *         }
+ *         decoder.reset(nextFrameBuffer);
+ *     }
+ *     chunk = chunk.skipFirst(consumed);
+ * }
+ * \endcode
+ */
+template <uint8_t blockLength>
+class CobsStreamDecoderBase
+{
+public:
+    /**
+     * Create a decoder without an output buffer.
+     *
+     * reset() has to be called before decoding data.
+     */
+    CobsStreamDecoderBase();
+
+    /**
+     * Start decoding the next frame.
+     *
+     * \param output
+     *      Buffer for the decoded data. Frames longer than the buffer are
+     *      marked as invalid.
+     */
+    void
+    reset(outpost::Slice<uint8_t> output);
+
+    /**
+     * Decode a chunk of the input stream.
+     *
+     * Stops after the delimiter which completes the current frame. The
+     * remaining input belongs to the following frames and has to be passed
+     * again after calling reset().
+     *
+     * \return
+     *      Number of bytes consumed from \p input.
+     */
+    size_t
+    decode(outpost::Slice<const uint8_t> input);
+
+    /**
+     * Check if the delimiter of the current frame has been received.
+     */
+    inline bool
+    isFrameComplete() const
+    {
+        return mComplete;
+    }
+
+    /**
+     * Check if the current frame is complete and has been decoded without
+     * an error.
+     *
+     * A frame is invalid if it does not fit into the output buffer or if
+     * it is terminated before the end of a COBS block.
+     */
+    inline bool
+    isValid() const
+    {
+        return mComplete && !mError;
+    }
+
+    /**
+     * Number of decoded bytes of the current frame.
+     */
+    inline size_t
+    getLength() const
+    {
+        return mLength;
+    }
+
+private:
+    void
+    append(const uint8_t* data, size_t length);
+
+    uint8_t* mOutput;
+    size_t mCapacity;
+    size_t mLength;
+
+    /// Number of data bytes remaining in the current block
+    uint8_t mRemaining;
+
+    /// The current block is followed by a zero if another block follows
+    bool mPendingZero;
+
+    bool mStarted;
+    bool mComplete;
+    bool mError;
+};
+
 typedef CobsEncodingGeneratorBase<254> CobsEncodingGenerator;
 typedef CobsBase<254> Cobs;
+typedef CobsStreamDecoderBase<254> CobsStreamDecoder;
 
 }  // namespace utils
 }  // namespace outpost
@@ -18,6 +18,8 @@
 
 #include <string.h>  // for memcpy
 
+#include <algorithm>
+
 namespace outpost
 {
 namespace utils
@@ -226,6 +228,113 @@ CobsBase<blockLength>::decode(outpost::Slice<const uint8_t> input, uint8_t* outp
     return outputPosition;
 }
 
+// ----------------------------------------------------------------------------
+template <uint8_t blockLength>
+CobsStreamDecoderBase<blockLength>::CobsStreamDecoderBase() :
+    mOutput(nullptr),
+    mCapacity(0),
+    mLength(0),
+    mRemaining(0),
+    mPendingZero(false),
+    mStarted(false),
+    mComplete(false),
+    mError(false)
+{
+}
+
+template <uint8_t blockLength>
+void
+CobsStreamDecoderBase<blockLength>::reset(outpost::Slice<uint8_t> output)
+{
+    mOutput = output.begin();
+    mCapacity = output.getNumberOfElements();
+    mLength = 0;
+    mRemaining = 0;
+    mPendingZero = false;
+    mStarted = false;
+    mComplete = false;
+    mError = false;
+}
+
+template <uint8_t blockLength>
+size_t
+CobsStreamDecoderBase<blockLength>::decode(outpost::Slice<const uint8_t> input)
+{
+    const uint8_t* data = input.begin();
+    const size_t length = input.getNumberOfElements();
+    size_t position = 0;
+
+    while ((position < length) && !mComplete)
+    {
+        if (mRemaining > 0)
+        {
+            // Copy as much of the current block as available. A zero
+            // inside of a block is the delimiter of a truncated frame.
+            size_t count = std::min(static_cast<size_t>(mRemaining), length - position);
+            const uint8_t* delimiter =
+                    static_cast<const uint8_t*>(memchr(&data[position], 0, count));
+            if (delimiter != nullptr)
+            {
+                count = static_cast<size_t>(delimiter - &data[position]);
+            }
+
+            append(&data[position], count);
+            position += count;
+            mRemaining = static_cast<uint8_t>(mRemaining - count);
+
+            if (delimiter != nullptr)
+            {
+                position++;
+                mError = true;
+                mComplete = true;
+            }
+        }
+        else
+        {
+            uint8_t code = data[position++];
+            if (code == 0)
+            {
+                // Delimiters before the first block are skipped
+                mComplete = mStarted;
+            }
+            else if ((code - 1) > blockLength)
+            {
+                mError = true;
+                mStarted = true;
+            }
+            else
+            {
+                if (mPendingZero)
+                {
+                    const uint8_t zero = 0;
+                    append(&zero, 1);
+                }
+                mStarted = true;
+                mRemaining = code - 1;
+                mPendingZero = (mRemaining < blockLength);
+            }
+        }
+    }
+
+    return position;
+}
+
+template <uint8_t blockLength>
+void
+CobsStreamDecoderBase<blockLength>::append(const uint8_t* data, size_t length)
+{
+    if ((mCapacity - mLength) < length)
+    {
+        // Continue without storing data until the end of the frame
+        mError = true;
+    }
+    else if (!mError)
+    {
+        memcpy(&mOutput[mLength], data, length);
+        mLength += length;
+    }
+}
+
 }  // namespace utils
 }  // namespace outpost
 
@@ -117,6 +117,17 @@ public:
     {
     }
 
+    /**
+     * Continue a CRC calculation from an intermediate value, e.g. the
+     * value calculated for a constant prefix of the data.
+     *
+     * \param partialCrc
+     *     Value returned by getValue() after the prefix has been processed
+     */
+    explicit inline Crc8CcittReversed(uint8_t partialCrc) : mCrc(partialCrc)
+    {
+    }
+
     inline ~Crc8CcittReversed()
     {
     }
@@ -108,7 +108,6 @@ public:
     {
         outpost::rtos::MutexGuard lock(mMutex);
         bool res = false;
-        size_t searchLastIndex = (mLastIndex - 1) % N;
         size_t i = mLastIndex;
         do
         {
@@ -119,7 +118,7 @@ public:
                 mLastIndex = i;
             }
             i = (i + 1) % N;
-        } while (i != searchLastIndex && !res);
+        } while (i != mLastIndex && !res);
         return res;
     }
 
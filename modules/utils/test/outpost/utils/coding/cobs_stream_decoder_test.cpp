@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2019, German Aerospace Center (DLR)
+ *
+ * This file is part of the development version of OUTPOST.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <outpost/utils/coding/cobs.h>
+
+#include <unittest/harness.h>
+
+#include <vector>
+
+using outpost::utils::Cobs;
+using outpost::utils::CobsStreamDecoder;
+
+class CobsStreamDecoderTest : public ::testing::Test
+{
+public:
+    CobsStreamDecoderTest() : mDecoder()
+    {
+    }
+
+    virtual void
+    SetUp() override
+    {
+        mDecoder.reset(outpost::asSlice(mOutput));
+    }
+
+    std::vector<uint8_t>
+    encode(std::vector<uint8_t> input)
+    {
+        std::vector<uint8_t> encoded(Cobs::getMaximumSizeOfEncodedData(input.size()) + 1);
+        size_t length = Cobs::encode(outpost::Slice<const uint8_t>::unsafe(input.data(),
+                                                                           input.size()),
+                                     outpost::asSlice(encoded));
+        encoded.resize(length);
+        encoded.push_back(0);
+        return encoded;
+    }
+
+    std::vector<uint8_t>
+    getDecoded() const
+    {
+        return std::vector<uint8_t>(mOutput, mOutput + mDecoder.getLength());
+    }
+
+    CobsStreamDecoder mDecoder;
+    uint8_t mOutput[300];
+};
+
+// ----------------------------------------------------------------------------
+TEST_F(CobsStreamDecoderTest, shouldDecodeCompleteFrame)
+{
+    std::vector<uint8_t> input = {0x11, 0x00, 0x00, 0x22, 0x33};
+    std::vector<uint8_t> encoded = encode(input);
+
+    EXPECT_EQ(encoded.size(), mDecoder.decode(outpost::asSlice(encoded)));
+    ASSERT_TRUE(mDecoder.isFrameComplete());
+    EXPECT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(input, getDecoded());
+}
+
+TEST_F(CobsStreamDecoderTest, shouldDecodeByteByByte)
+{
+    std::vector<uint8_t> input(299, 0x55);
+    input[0] = 0;
+    input[100] = 0;
+    std::vector<uint8_t> encoded = encode(input);
+
+    for (size_t i = 0; i < encoded.size(); ++i)
+    {
+        EXPECT_FALSE(mDecoder.isFrameComplete());
+        EXPECT_EQ(1U, mDecoder.decode(outpost::asSlice(encoded).skipFirst(i).first(1)));
+    }
+    ASSERT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(input, getDecoded());
+}
+
+TEST_F(CobsStreamDecoderTest, shouldDecodeFullBlockAtTheEnd)
+{
+    std::vector<uint8_t> input(254, 0x01);
+    std::vector<uint8_t> encoded = encode(input);
+
+    mDecoder.decode(outpost::asSlice(encoded));
+    ASSERT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(input, getDecoded());
+}
+
+TEST_F(CobsStreamDecoderTest, shouldStopAfterEndOfFrame)
+{
+    std::vector<uint8_t> stream = encode({1, 2});
+    std::vector<uint8_t> second = encode({3});
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    size_t consumed = mDecoder.decode(outpost::asSlice(stream));
+    EXPECT_EQ(4U, consumed);
+    ASSERT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(std::vector<uint8_t>({1, 2}), getDecoded());
+
+    mDecoder.reset(outpost::asSlice(mOutput));
+    EXPECT_EQ(stream.size() - consumed,
+              mDecoder.decode(outpost::asSlice(stream).skipFirst(consumed)));
+    ASSERT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(std::vector<uint8_t>({3}), getDecoded());
+}
+
+TEST_F(CobsStreamDecoderTest, shouldSkipLeadingDelimiters)
+{
+    std::vector<uint8_t> stream = {0, 0, 0x02, 0x07, 0};
+
+    EXPECT_EQ(5U, mDecoder.decode(outpost::asSlice(stream)));
+    ASSERT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(std::vector<uint8_t>({7}), getDecoded());
+}
+
+TEST_F(CobsStreamDecoderTest, shouldMarkTruncatedFrameAsInvalid)
+{
+    // Block announces three data bytes, but the frame ends after one
+    std::vector<uint8_t> stream = {0x04, 0x01, 0x00, 0x02, 0x09, 0x00};
+
+    EXPECT_EQ(3U, mDecoder.decode(outpost::asSlice(stream)));
+    EXPECT_TRUE(mDecoder.isFrameComplete());
+    EXPECT_FALSE(mDecoder.isValid());
+
+    // Decoder resynchronizes on the delimiter
+    mDecoder.reset(outpost::asSlice(mOutput));
+    mDecoder.decode(outpost::asSlice(stream).skipFirst(3));
+    ASSERT_TRUE(mDecoder.isValid());
+    EXPECT_EQ(std::vector<uint8_t>({9}), getDecoded());
+}
+
+TEST_F(CobsStreamDecoderTest, shouldMarkFrameLargerThanOutputAsInvalid)
+{
+    std::vector<uint8_t> encoded = encode({1, 2, 3, 4});
+
+    uint8_t small[3];
+    mDecoder.reset(outpost::asSlice(small));
+    EXPECT_EQ(encoded.size(), mDecoder.decode(outpost::asSlice(encoded)));
+    EXPECT_TRUE(mDecoder.isFrameComplete());
+    EXPECT_FALSE(mDecoder.isValid());
+}
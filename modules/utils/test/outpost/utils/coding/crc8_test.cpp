@@ -90,6 +90,20 @@ TEST(Crc8CcittReversedTest, rmapTestPattern1)
     EXPECT_EQ(0xB0U, Crc8CcittReversed::calculate(outpost::asSlice(data)));
 }
 
+TEST(Crc8CcittReversedTest, shouldContinueFromPartialValue)
+{
+    uint8_t data[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+
+    uint8_t partial = Crc8CcittReversed::calculate(outpost::Slice<const uint8_t>::unsafe(data, 3));
+    Crc8CcittReversed crc(partial);
+    for (size_t i = 3; i < sizeof(data); i++)
+    {
+        crc.update(data[i]);
+    }
+
+    EXPECT_EQ(0xB0U, crc.getValue());
+}
+
 /**
  * The test is based on the example given in
  * ECSS-E-50-11 Draft F (Version from December 2006)
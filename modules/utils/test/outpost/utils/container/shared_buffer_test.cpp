@@ -189,6 +189,36 @@ TEST_F(SharedBufferTest, allocateFullPool)
     EXPECT_FALSE(p_false.isValid());
 }
 
+TEST(SharedBufferPoolTest, allocateAllBuffersAfterWrapAround)
+{
+    static constexpr size_t smallPoolSize = 4;
+    outpost::utils::SharedBufferPool<objectSize, smallPoolSize> pool;
+    outpost::utils::SharedBufferPointer p[smallPoolSize];
+
+    for (size_t round = 0; round < 3; round++)
+    {
+        for (size_t i = 0; i < smallPoolSize; i++)
+        {
+            EXPECT_TRUE(pool.allocate(p[i]));
+        }
+        EXPECT_EQ(pool.numberOfFreeElements(), 0U);
+
+        // The only free buffer precedes the one allocated last
+        p[smallPoolSize - 2] = outpost::utils::SharedBufferPointer();
+        EXPECT_TRUE(pool.allocate(p[smallPoolSize - 2]));
+        EXPECT_EQ(pool.numberOfFreeElements(), 0U);
+
+        // Free all buffers, the next round starts at a different index
+        for (size_t i = 0; i < smallPoolSize; i++)
+        {
+            p[i] = outpost::utils::SharedBufferPointer();
+        }
+        EXPECT_TRUE(pool.allocate(p[0]));
+        p[0] = outpost::utils::SharedBufferPointer();
+        EXPECT_EQ(pool.numberOfFreeElements(), smallPoolSize);
+    }
+}
+
 TEST_F(SharedBufferTest, queueBuffer)
 {
     unittest::utils::SharedBufferQueue<2> q;